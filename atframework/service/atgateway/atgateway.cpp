@@ -21,9 +21,14 @@
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
-#include "session_manager.h"  // NOLINT: build/include_subdir
+#include "core/mpsc_queue.h"
+
+#include "session_manager.h"         // NOLINT: build/include_subdir
+#include "session_shard.h"           // NOLINT: build/include_subdir
+#include "session_shard_dispatch.h"  // NOLINT: build/include_subdir
 
 static int app_handle_on_forward_response(atfw::atapp::app &app, const atfw::atapp::app::message_sender_t &source,
                                           const atfw::atapp::app::message_t &m, int32_t error_code) {
@@ -38,7 +43,7 @@ static int app_handle_on_forward_response(atfw::atapp::app &app, const atfw::ata
 
 class gateway_module : public ::atfw::atapp::module_impl {
  public:
-  gateway_module() {}
+  gateway_module() : shard_messages_async_inited_(false) {}
   virtual ~gateway_module() {}
 
  public:
@@ -58,6 +63,12 @@ class gateway_module : public ::atfw::atapp::module_impl {
                                          bool *is_done) -> int {
         return this->proto_inner_callback_on_write(proto, buffer, sz, is_done);
       };
+      proto_callbacks_.write_vector_fn =
+          [this](::atframework::gateway::libatgw_protocol_api *proto, void *header,
+                 const ::atframework::gateway::libatgw_protocol_api::write_buffer_t *buffers, size_t count,
+                 bool *is_done) -> int {
+        return this->proto_inner_callback_on_write_vector(proto, header, buffers, count, is_done);
+      };
 
       proto_callbacks_.message_fn = [this](::atframework::gateway::libatgw_protocol_api *proto, const void *buffer,
                                            size_t sz) -> int {
@@ -95,7 +106,11 @@ class gateway_module : public ::atfw::atapp::module_impl {
     }
 
     // init limits
-    res = gw_mgr_.listen_all();
+    if (gw_mgr_.get_conf().origin_conf.listen().worker_threads() > 0) {
+      res = start_shards(gw_mgr_.get_conf().origin_conf.listen().worker_threads());
+    } else {
+      res = gw_mgr_.listen_all();
+    }
     if (res <= 0) {
       FWLOGERROR("nothing listened for client, please see log for more details.");
       return -1;
@@ -129,6 +144,40 @@ class gateway_module : public ::atfw::atapp::module_impl {
       }
     }
 
+    // compression
+    {
+      const auto &compression_cfg = gw_mgr_.get_conf().origin_conf.client().compression();
+      crypt_conf.compression.types.clear();
+      crypt_conf.compression.threshold = static_cast<size_t>(compression_cfg.threshold());
+      crypt_conf.compression.level = compression_cfg.level();
+      crypt_conf.compression.dictionary.clear();
+
+      std::stringstream compression_types(compression_cfg.type());
+      std::string compression_type;
+      while (std::getline(compression_types, compression_type, ',')) {
+        std::stringstream compression_type_words(compression_type);
+        std::string compression_type_word;
+        while (compression_type_words >> compression_type_word) {
+          if (0 == UTIL_STRFUNC_STRCASE_CMP("zstd", compression_type_word.c_str())) {
+            crypt_conf.compression.types.push_back(
+                ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_ZSTD));
+          } else if (0 == UTIL_STRFUNC_STRCASE_CMP("lz4", compression_type_word.c_str())) {
+            crypt_conf.compression.types.push_back(
+                ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_LZ4));
+          } else {
+            FWLOGWARNING("unknown compression type {}, ignored", compression_type_word);
+          }
+        }
+      }
+
+      if (!compression_cfg.dictionary().empty() &&
+          !atfw::util::file_system::get_file_content(crypt_conf.compression.dictionary,
+                                                     compression_cfg.dictionary().c_str(), true)) {
+        FWLOGERROR("load compression dictionary {} failed, dictionary disabled", compression_cfg.dictionary());
+        crypt_conf.compression.dictionary.clear();
+      }
+    }
+
     // protocol reload
     if ("inner" == gw_mgr_.get_conf().origin_conf.listen().type()) {
       int res = ::atframework::gateway::libatgw_protocol_sdk::global_reload(crypt_conf);
@@ -138,10 +187,17 @@ class gateway_module : public ::atfw::atapp::module_impl {
       }
     }
 
+    // worker shards use their own copy of configure
+    for (auto &shard : shards_) {
+      ::atframework::gateway::session_manager::conf_t conf = gw_mgr_.get_conf();
+      shard->post([conf](::atframework::gateway::session_manager &mgr) { mgr.get_conf() = conf; });
+    }
+
     return 0;
   }
 
   int stop() override {
+    stop_shards();
     gw_mgr_.reset();
     return 0;
   }
@@ -157,7 +213,187 @@ class gateway_module : public ::atfw::atapp::module_impl {
   inline ::atframework::gateway::session_manager &get_session_manager() { return gw_mgr_; }
   inline const ::atframework::gateway::session_manager &get_session_manager() const { return gw_mgr_; }
 
+  inline bool is_sharded() const noexcept { return !shards_.empty(); }
+
+  /**
+   * @brief dispatch message from server to the shards which own the sessions
+   * @param source_id server id
+   * @param msg message, it's shared by all shards and must not be modified
+   */
+  void dispatch_to_shards(::atbus::bus_id_t source_id, std::shared_ptr<const ::atframework::gw::ss_msg> msg) {
+    uint32_t shard_count = static_cast<uint32_t>(shards_.size());
+    ::atframework::gateway::session_shard_dispatch_t dispatch;
+    dispatch.build(*msg, shard_count);
+
+    if (::atframework::gateway::session_shard_dispatch_t::mode_t::kMulticast == dispatch.mode) {
+      for (uint32_t i = 0; i < shard_count; ++i) {
+        if (!dispatch.shard_sessions[i]) {
+          continue;
+        }
+
+        std::shared_ptr<::atframework::gateway::session_shard_dispatch_t::id_list_t> sess_ids =
+            dispatch.shard_sessions[i];
+        shards_[i]->post([source_id, msg, sess_ids](::atframework::gateway::session_manager &mgr) {
+          const ::atframework::gw::ss_body_post &post = msg->body().post();
+          int res = mgr.multicast_data(sess_ids->data(), sess_ids->size(), post.content().data(),
+                                       post.content().size());
+          if (0 != res) {
+            FWLOGERROR("from server {}: multicast data to {} sessions in shard {} failed, res: {}", source_id,
+                       sess_ids->size(), mgr.get_shard_index(), res);
+          }
+        });
+      }
+      return;
+    }
+
+    if (::atframework::gateway::session_shard_dispatch_t::mode_t::kBroadcast == dispatch.mode) {
+      for (auto &shard : shards_) {
+        shard->post([source_id, msg](::atframework::gateway::session_manager &mgr) {
+          dispatch_server_message(mgr, source_id, *msg);
+        });
+      }
+      return;
+    }
+
+    shards_[dispatch.shard_index]->post([source_id, msg](::atframework::gateway::session_manager &mgr) {
+      dispatch_server_message(mgr, source_id, *msg);
+    });
+  }
+
+  /**
+   * @brief close session in the main thread or the shard which owns it
+   */
+  int close_session(::atframework::gateway::session::id_t sess_id, int reason, bool allow_reconnect) {
+    if (!is_sharded()) {
+      return gw_mgr_.close(sess_id, reason, allow_reconnect);
+    }
+
+    uint32_t shard_index =
+        ::atframework::gateway::session_manager::get_shard_index(sess_id, static_cast<uint32_t>(shards_.size()));
+    return shards_[shard_index]->post(
+        [sess_id, reason, allow_reconnect](::atframework::gateway::session_manager &mgr) {
+          int res = mgr.close(sess_id, reason, allow_reconnect);
+          if (0 != res) {
+            FWLOGERROR("close session {} in shard {} failed, res: {}", sess_id, mgr.get_shard_index(), res);
+          }
+        });
+  }
+
+  static int dispatch_server_message(::atframework::gateway::session_manager &mgr, ::atbus::bus_id_t source_id,
+                                     const ::atframework::gw::ss_msg &msg);
+
  private:
+  int start_shards(uint32_t shard_count) {
+    if (0 != uv_async_init(get_app()->get_evloop(), &shard_messages_async_, on_evt_shard_messages)) {
+      FWLOGERROR("init async handle for {} shards failed", shard_count);
+      return -1;
+    }
+    shard_messages_async_.data = this;
+    shard_messages_async_inited_ = true;
+
+    ::atframework::gateway::session_manager::create_proto_fn_t create_proto_fn = [this]() {
+      return this->gateway_module::create_proto_inner();
+    };
+    ::atframework::gateway::session_manager::on_create_session_fn_t on_create_session_fn =
+        [this](::atframework::gateway::session *sess, uv_stream_t *handle) -> int {
+      return this->proto_inner_callback_on_create_session(sess, handle);
+    };
+    // called in worker threads
+    ::atframework::gateway::session_manager::post_message_fn_t post_fn =
+        [this](std::unique_ptr<::atframework::gateway::session_manager::post_message_t> &&msg) -> int {
+      shard_messages_.push(std::move(msg));
+      uv_async_send(&shard_messages_async_);
+      return 0;
+    };
+
+    int ret = 0;
+    for (uint32_t i = 0; i < shard_count; ++i) {
+      std::unique_ptr<::atframework::gateway::session_shard> shard{
+          new ::atframework::gateway::session_shard(i, shard_count)};
+      int res = shard->start(gw_mgr_.get_conf(), create_proto_fn, on_create_session_fn, post_fn);
+      if (res <= 0) {
+        FWLOGERROR("start shard {}/{} failed, res: {}", i, shard_count, res);
+        stop_shards();
+        return res < 0 ? res : -1;
+      }
+
+      ret += res;
+      shards_.emplace_back(std::move(shard));
+    }
+
+    FWLOGINFO("start {} shards and listen {} address(es)", shard_count, ret);
+    return ret;
+  }
+
+  void stop_shards() {
+    for (auto &shard : shards_) {
+      shard->stop();
+    }
+    shards_.clear();
+
+    // send remove notifies of closed sessions
+    process_shard_messages();
+    shard_default_routers_.clear();
+
+    if (shard_messages_async_inited_) {
+      shard_messages_async_inited_ = false;
+      uv_close(reinterpret_cast<uv_handle_t *>(&shard_messages_async_), nullptr);
+    }
+  }
+
+  static void on_evt_shard_messages(uv_async_t *handle) {
+    gateway_module *self = reinterpret_cast<gateway_module *>(handle->data);
+    assert(self);
+    if (nullptr != self) {
+      self->process_shard_messages();
+    }
+  }
+
+  void process_shard_messages() {
+    std::unique_ptr<::atframework::gateway::session_manager::post_message_t> msg;
+    while (shard_messages_.pop(msg)) {
+      if (msg) {
+        send_shard_message(*msg);
+      }
+    }
+  }
+
+  int send_shard_message(const ::atframework::gateway::session_manager::post_message_t &msg) {
+    ::atbus::bus_id_t target_id = msg.target_id;
+    const std::string *target_name = &msg.target_name;
+    if (msg.use_default_router) {
+      // select once and keep using the same server until session removed
+      auto iter = shard_default_routers_.find(msg.session_id);
+      if (iter == shard_default_routers_.end()) {
+        shard_router_t &router = shard_default_routers_[msg.session_id];
+        gw_mgr_.select_default_router(msg.session_id, router.node_id, router.node_name);
+        iter = shard_default_routers_.find(msg.session_id);
+      }
+      target_id = iter->second.node_id;
+      target_name = &iter->second.node_name;
+    }
+
+    int ret;
+    if (0 != target_id) {
+      ret = gw_mgr_.post_data(target_id, msg.type, msg.data.data(), msg.data.size());
+    } else if (!target_name->empty()) {
+      ret = gw_mgr_.post_data(*target_name, msg.type, msg.data.data(), msg.data.size());
+    } else {
+      FWLOGERROR("session {} in shard {} has not configure router", msg.session_id, msg.shard_index);
+      ret = ::atframework::gateway::error_code_t::EN_ECT_INVALID_ROUTER;
+    }
+
+    if (0 != ret) {
+      FWLOGERROR("send {} bytes data of session {} in shard {} to {}({}) failed, res: {}", msg.data.size(),
+                 msg.session_id, msg.shard_index, target_id, *target_name, ret);
+    }
+
+    if (msg.is_remove_session) {
+      shard_default_routers_.erase(msg.session_id);
+    }
+    return ret;
+  }
+
   std::unique_ptr<::atframework::gateway::libatgw_protocol_api> create_proto_inner() {
     ::atframework::gateway::libatgw_protocol_sdk *ret =
         new (std::nothrow)::atframework::gateway::libatgw_protocol_sdk();
@@ -306,40 +542,66 @@ class gateway_module : public ::atfw::atapp::module_impl {
     return ret;
   }
 
-  int proto_inner_callback_on_message(::atframework::gateway::libatgw_protocol_api *proto, const void *buffer,
-                                      size_t sz) {
+  int proto_inner_callback_on_write_vector(::atframework::gateway::libatgw_protocol_api *proto, void *header,
+                                           const ::atframework::gateway::libatgw_protocol_api::write_buffer_t *buffers,
+                                           size_t count, bool *is_done) {
+    if (nullptr == proto || nullptr == header || nullptr == buffers || 0 == count) {
+      if (nullptr != is_done) {
+        *is_done = true;
+      }
+      return ::atframework::gateway::error_code_t::EN_ECT_PARAM;
+    }
+
     ::atframework::gateway::session *sess =
         reinterpret_cast<::atframework::gateway::session *>(proto->get_private_data());
     if (nullptr == sess) {
-      FWLOGERROR("recv message from proto object {} length, but has no session", reinterpret_cast<const void *>(proto));
+      if (nullptr != is_done) {
+        *is_done = true;
+      }
       return -1;
     }
-    ::atframework::gateway::session::ptr_t sess_holder = sess->shared_from_this();
-
-    ::atframework::gw::ss_msg post_msg;
-    post_msg.mutable_head()->set_session_id(sess_holder->get_id());
 
-    ::atframework::gw::ss_body_post *post = post_msg.mutable_body()->mutable_post();
-    if (nullptr != post) {
-      post->add_session_ids(sess_holder->get_id());
-      post->set_content(buffer, sz);
+    // uv_write_t is stored in the headspace of the first block, uv_write will copy the uv_buf_t array
+    uv_write_t *req = reinterpret_cast<uv_write_t *>(header);
+    req->data = proto->get_private_data();
+    assert(sizeof(uv_write_t) <= proto->get_write_header_offset());
+
+    // sessions may run in worker threads
+    static thread_local std::vector<uv_buf_t> write_vector_bufs;
+    write_vector_bufs.clear();
+    write_vector_bufs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      write_vector_bufs.push_back(
+          uv_buf_init(reinterpret_cast<char *>(buffers[i].data), static_cast<unsigned int>(buffers[i].size)));
     }
+    sess->set_flag(::atframework::gateway::session::flag_t::EN_FT_WRITING_FD, true);
 
-    // send to router
-    if (0 != sess_holder->get_router_id()) {
-      FWLOGDEBUG("session {} send {} bytes data to server {}({})", sess_holder->get_id(), sz,
-                 sess_holder->get_router_id(), sess_holder->get_router_name());
+    int ret = uv_write(req, sess->get_uv_stream(), write_vector_bufs.data(),
+                       static_cast<unsigned int>(write_vector_bufs.size()), proto_inner_callback_on_written_fn);
+    if (0 != ret) {
+      sess->set_flag(::atframework::gateway::session::flag_t::EN_FT_WRITING_FD, false);
+      FWLOGERROR("send {} buffers to proto {} failed, res: {}", count, reinterpret_cast<const void *>(proto), ret);
+    }
 
-      return gw_mgr_.post_data(sess_holder->get_router_id(), post_msg);
-    } else if (!sess_holder->get_router_name().empty()) {
-      FWLOGDEBUG("session {} send {} bytes data to server {}({})", sess_holder->get_id(), sz,
-                 sess_holder->get_router_id(), sess_holder->get_router_name());
+    if (nullptr != is_done) {
+      // if not writting, notify write finished
+      *is_done = !sess->check_flag(::atframework::gateway::session::flag_t::EN_FT_WRITING_FD);
+    }
+    return ret;
+  }
 
-      return gw_mgr_.post_data(sess_holder->get_router_name(), post_msg);
+  int proto_inner_callback_on_message(::atframework::gateway::libatgw_protocol_api *proto, const void *buffer,
+                                      size_t sz) {
+    ::atframework::gateway::session *sess =
+        reinterpret_cast<::atframework::gateway::session *>(proto->get_private_data());
+    if (nullptr == sess) {
+      FWLOGERROR("recv message from proto object {} length, but has no session", reinterpret_cast<const void *>(proto));
+      return -1;
     }
+    ::atframework::gateway::session::ptr_t sess_holder = sess->shared_from_this();
 
-    FWLOGERROR("session {} send {} bytes data failed, not router", sess_holder->get_id(), sz);
-    return -1;
+    FWLOGDEBUG("session {} recv {} bytes data from client", sess_holder->get_id(), sz);
+    return sess_holder->post_to_server(buffer, sz);
   }
 
   int proto_inner_callback_on_new_session(::atframework::gateway::libatgw_protocol_api *proto, uint64_t &sess_id) {
@@ -357,7 +619,9 @@ class gateway_module : public ::atfw::atapp::module_impl {
     if (0 != ret) {
       FWLOGERROR("create new session failed, ret: {}", ret);
     }
-    gw_mgr_.assign_default_router(*sess_holder);
+    if (nullptr != sess_holder->get_manager()) {
+      sess_holder->get_manager()->assign_default_router(*sess_holder);
+    }
 
     return ret;
   }
@@ -384,7 +648,13 @@ class gateway_module : public ::atfw::atapp::module_impl {
       return -1;
     }
 
-    int res = gw_mgr_.reconnect(*sess_holder, sess_id);
+    if (nullptr == sess_holder->get_manager()) {
+      FWLOGERROR("try to reconnect session {}({}) from {}, but lost manager", sess_holder->get_id(),
+                 reinterpret_cast<const void *>(sess), sess_id);
+      return -1;
+    }
+
+    int res = sess_holder->get_manager()->reconnect(*sess_holder, sess_id);
     if (0 != res) {
       if (::atframework::gateway::error_code_t::EN_ECT_SESSION_NOT_FOUND != res &&
           ::atframework::gateway::error_code_t::EN_ECT_REFUSE_RECONNECT != res) {
@@ -458,7 +728,13 @@ class gateway_module : public ::atfw::atapp::module_impl {
       FWLOGINFO("session {}({}) handshake done\n{}", sess_holder->get_id(), reinterpret_cast<const void *>(sess),
                 proto->get_info());
 
-      int res = gw_mgr_.active_session(sess_holder);
+      if (nullptr == sess_holder->get_manager()) {
+        FWLOGERROR("session {}({}) handshake done, but lost manager", sess_holder->get_id(),
+                   reinterpret_cast<const void *>(sess));
+        return -1;
+      }
+
+      int res = sess_holder->get_manager()->active_session(sess_holder);
       if (0 != res) {
         FWLOGERROR("session {} send new session to router server failed, res: {}", sess->get_id(), res);
         return -1;
@@ -525,7 +801,7 @@ class gateway_module : public ::atfw::atapp::module_impl {
     }
 
     // do not allow reconnect
-    int res = gw_mgr_.close(sess_id, reason, false);
+    int res = close_session(sess_id, reason, false);
     if (0 != res) {
       FWLOGERROR("command kickoff session {} failed, res: {}", sess_id, res);
     } else {
@@ -550,7 +826,7 @@ class gateway_module : public ::atfw::atapp::module_impl {
     }
 
     // do not allow reconnect
-    int res = gw_mgr_.close(sess_id, reason, true);
+    int res = close_session(sess_id, reason, true);
     if (0 != res) {
       FWLOGERROR("command disconnect session {} failed, res: {}", sess_id, res);
     } else {
@@ -561,10 +837,110 @@ class gateway_module : public ::atfw::atapp::module_impl {
   }
 
  private:
+  struct shard_router_t {
+    ::atbus::bus_id_t node_id = 0;
+    std::string node_name;
+  };
+
   ::atframework::gateway::session_manager gw_mgr_;
   ::atframework::gateway::libatgw_protocol_api::proto_callbacks_t proto_callbacks_;
+
+  // worker shards, empty if all sessions run in the main thread
+  std::vector<std::unique_ptr<::atframework::gateway::session_shard>> shards_;
+  ::atframework::component::mpsc_queue<std::unique_ptr<::atframework::gateway::session_manager::post_message_t>>
+      shard_messages_;
+  uv_async_t shard_messages_async_;
+  bool shard_messages_async_inited_;
+  std::unordered_map<::atframework::gateway::session::id_t, shard_router_t> shard_default_routers_;
 };
 
+int gateway_module::dispatch_server_message(::atframework::gateway::session_manager &mgr, ::atbus::bus_id_t source_id,
+                                            const ::atframework::gw::ss_msg &msg) {
+  switch (msg.body().cmd_case()) {
+    case ::atframework::gw::ss_msg_body::kPost: {
+      // post to single client
+      if (0 != msg.head().session_id() && 0 == msg.body().post().session_ids_size()) {
+        FWLOGDEBUG("from server {}: session {} send {} bytes data to client", source_id, msg.head().session_id(),
+                   msg.body().post().content().size());
+
+        int res = mgr.push_data(msg.head().session_id(), msg.body().post().content().data(),
+                                msg.body().post().content().size());
+        for (int i = 0; 0 == res && i < msg.body().post().contents_size(); ++i) {
+          res = mgr.push_data(msg.head().session_id(), msg.body().post().contents(i).data(),
+                              msg.body().post().contents(i).size());
+        }
+        if (0 != res) {
+          FWLOGERROR("from server {}: session {} push data failed, res: {}", source_id, msg.head().session_id(), res);
+
+          // session not found, maybe gateway has restarted or server cache expired without remove
+          // notify to remove the expired session
+          if (::atframework::gateway::error_code_t::EN_ECT_SESSION_NOT_FOUND == res) {
+            ::atframework::gw::ss_msg rsp;
+            rsp.mutable_head()->set_session_id(msg.head().session_id());
+            rsp.mutable_body()->mutable_remove_session();
+            res = mgr.post_data(source_id, rsp);
+            if (0 != res) {
+              FWLOGERROR("send remove notify to server {} failed, res: {}", source_id, res);
+            }
+          }
+        }
+      } else if (0 == msg.body().post().session_ids_size()) {  // broadcast to all actived session
+        int res = mgr.broadcast_data(msg.body().post().content().data(), msg.body().post().content().size());
+        if (0 != res) {
+          FWLOGERROR("from server {}: broadcast data failed, res: {}", source_id, res);
+        }
+      } else {  // multicast to more than one client
+        const ::atframework::gw::ss_body_post &post = msg.body().post();
+        FWLOGDEBUG("from server {}: multicast {} bytes data to {} sessions", source_id, post.content().size(),
+                   post.session_ids_size());
+
+        int res = mgr.multicast_data(post.session_ids().data(), static_cast<size_t>(post.session_ids_size()),
+                                     post.content().data(), post.content().size());
+        if (0 != res) {
+          FWLOGERROR("from server {}: multicast data to {} sessions failed, res: {}", source_id,
+                     post.session_ids_size(), res);
+        }
+      }
+      break;
+    }
+    case ::atframework::gw::ss_msg_body::kKickoffSession: {
+      FWLOGINFO("from server {}: session {} kickoff by server", source_id, msg.head().session_id());
+      if (0 == msg.head().error_code()) {
+        mgr.close(msg.head().session_id(), ::atframework::gateway::close_reason_t::EN_CRT_KICKOFF);
+      } else {
+        mgr.close(msg.head().session_id(), msg.head().error_code(),
+                  msg.head().error_code() > 0 &&
+                      msg.head().error_code() < ::atframework::gateway::close_reason_t::EN_CRT_RECONNECT_BOUND);
+      }
+      break;
+    }
+    case ::atframework::gw::ss_msg_body::kSetRouterReq: {
+      int res = mgr.set_session_router(msg.head().session_id(), msg.body().set_router_req().target_service_id(),
+                                       msg.body().set_router_req().target_service_name());
+      FWLOGINFO("from server {}: session {} set router to {}({}) by server, res: {}", source_id,
+                msg.head().session_id(), msg.body().set_router_req().target_service_id(),
+                msg.body().set_router_req().target_service_name(), res);
+
+      ::atframework::gw::ss_msg rsp;
+      rsp.mutable_head()->set_session_id(msg.head().session_id());
+      rsp.mutable_head()->set_error_code(res);
+      *rsp.mutable_body()->mutable_set_router_rsp() = msg.body().set_router_req();
+
+      res = mgr.post_data(source_id, rsp);
+      if (0 != res) {
+        FWLOGERROR("send set router response to server {} failed, res: {}", source_id, res);
+      }
+      break;
+    }
+    default: {
+      FWLOGERROR("from server {}: session {} recv invalid cmd {}", source_id, msg.head().session_id(),
+                 static_cast<int>(msg.body().cmd_case()));
+      break;
+    }
+  }
+  return 0;
+}
+
 struct app_handle_on_recv {
   std::reference_wrapper<gateway_module> mod_;
   app_handle_on_recv(gateway_module &mod) : mod_(mod) {}
@@ -575,6 +951,19 @@ struct app_handle_on_recv {
       return 0;
     }
 
+    // message will be shared by worker shards, so it can not be allocated on the arena of this function
+    if (mod_.get().is_sharded()) {
+      std::shared_ptr<::atframework::gw::ss_msg> msg = std::make_shared<::atframework::gw::ss_msg>();
+      if (false == msg->ParseFromArray(message.data, static_cast<int>(message.data_size))) {
+        FWLOGDEBUG("from server {}: session {} parse {} bytes data failed: {}", source.id, msg->head().session_id(),
+                   message.data_size, msg->InitializationErrorString());
+        return 0;
+      }
+
+      mod_.get().dispatch_to_shards(source.id, std::move(msg));
+      return 0;
+    }
+
     ::google::protobuf::ArenaOptions arena_options;
     arena_options.initial_block_size = (message.data_size + 256) & 255;
     ::google::protobuf::Arena arena(arena_options);
@@ -593,89 +982,7 @@ struct app_handle_on_recv {
       return 0;
     }
 
-    switch (msg->body().cmd_case()) {
-      case ::atframework::gw::ss_msg_body::kPost: {
-        // post to single client
-        if (0 != msg->head().session_id() && 0 == msg->body().post().session_ids_size()) {
-          FWLOGDEBUG("from server {}: session {} send {} bytes data to client", source.id, msg->head().session_id(),
-                     msg->body().post().content().size());
-
-          int res = mod_.get().get_session_manager().push_data(
-              msg->head().session_id(), msg->body().post().content().data(), msg->body().post().content().size());
-          if (0 != res) {
-            FWLOGERROR("from server {}: session {} push data failed, res: {}", source.id, msg->head().session_id(),
-                       res);
-
-            // session not found, maybe gateway has restarted or server cache expired without remove
-            // notify to remove the expired session
-            if (::atframework::gateway::error_code_t::EN_ECT_SESSION_NOT_FOUND == res) {
-              ::atframework::gw::ss_msg rsp;
-              rsp.mutable_head()->set_session_id(msg->head().session_id());
-              rsp.mutable_body()->mutable_remove_session();
-              res = mod_.get().get_session_manager().post_data(source.id, rsp);
-              if (0 != res) {
-                FWLOGERROR("send remove notify to server {} failed, res: {}", source.id, res);
-              }
-            }
-          }
-        } else if (0 == msg->body().post().session_ids_size()) {  // broadcast to all actived session
-          int res = mod_.get().get_session_manager().broadcast_data(msg->body().post().content().data(),
-                                                                    msg->body().post().content().size());
-          if (0 != res) {
-            FWLOGERROR("from server {}: broadcast data failed, res: {}", source.id, res);
-          }
-        } else {  // multicast to more than one client
-          for (int i = 0; i < msg->body().post().session_ids_size(); ++i) {
-            int res = mod_.get().get_session_manager().push_data(msg->body().post().session_ids(i),
-                                                                 msg->body().post().content().data(),
-                                                                 msg->body().post().content().size());
-            if (0 != res) {
-              FWLOGERROR("from server {}: session {} push data failed, res: {}", source.id,
-                         msg->body().post().session_ids(i), res);
-            }
-          }
-        }
-        break;
-      }
-      case ::atframework::gw::ss_msg_body::kKickoffSession: {
-        FWLOGINFO("from server {}: session {} kickoff by server", source.id, msg->head().session_id());
-        if (0 == msg->head().error_code()) {
-          mod_.get().get_session_manager().close(msg->head().session_id(),
-                                                 ::atframework::gateway::close_reason_t::EN_CRT_KICKOFF);
-        } else {
-          mod_.get().get_session_manager().close(
-              msg->head().session_id(), msg->head().error_code(),
-              msg->head().error_code() > 0 &&
-                  msg->head().error_code() < ::atframework::gateway::close_reason_t::EN_CRT_RECONNECT_BOUND);
-        }
-        break;
-      }
-      case ::atframework::gw::ss_msg_body::kSetRouterReq: {
-        int res = mod_.get().get_session_manager().set_session_router(
-            msg->head().session_id(), msg->body().set_router_req().target_service_id(),
-            msg->body().set_router_req().target_service_name());
-        FWLOGINFO("from server {}: session {} set router to {}({}) by server, res: {}", source.id,
-                  msg->head().session_id(), msg->body().set_router_req().target_service_id(),
-                  msg->body().set_router_req().target_service_name(), res);
-
-        ::atframework::gw::ss_msg rsp;
-        rsp.mutable_head()->set_session_id(msg->head().session_id());
-        rsp.mutable_head()->set_error_code(res);
-        *rsp.mutable_body()->mutable_set_router_rsp() = msg->body().set_router_req();
-
-        res = mod_.get().get_session_manager().post_data(source.id, rsp);
-        if (0 != res) {
-          FWLOGERROR("send set router response to server {} failed, res: {}", source.id, res);
-        }
-        break;
-      }
-      default: {
-        FWLOGERROR("from server {}: session {} recv invalid cmd {}", source.id, msg->head().session_id(),
-                   static_cast<int>(msg->body().cmd_case()));
-        break;
-      }
-    }
-    return 0;
+    return gateway_module::dispatch_server_message(mod_.get().get_session_manager(), source.id, *msg);
   }
 };
 
@@ -120,6 +120,11 @@ LIBATGW_PROTOCOL_API size_t libatgw_protocol_api::get_tls_length(tls_buffer_t::t
   return ATFRAMEWORK_ATGATEWAY_TLS_BUFFER_SIZE;
 }
 
+LIBATGW_PROTOCOL_API int libatgw_protocol_api::write_broadcast(const void *buffer, size_t len,
+                                                               broadcast_cache_t & /*cache*/) {
+  return write(buffer, len);
+}
+
 LIBATGW_PROTOCOL_API int libatgw_protocol_api::write_done(int /*status*/) {
   if (!check_flag(flag_t::EN_PFT_WRITING)) {
     return 0;
@@ -7,7 +7,10 @@
 #include <stdint.h>
 #include <cstddef>
 #include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #ifndef LIBATGW_PROTOCOL_API
 #  define LIBATGW_PROTOCOL_API ATFW_UTIL_SYMBOL_VISIBLE
@@ -49,6 +52,8 @@ struct error_code_t {
     EN_ECT_CRYPT_INIT_DHPARAM = -1212,
     EN_ECT_CRYPT_READ_RSA_PUBKEY = -1221,
     EN_ECT_CRYPT_READ_RSA_PRIKEY = -1222,
+    EN_ECT_COMPRESSION_NOT_SUPPORTED = -1301,
+    EN_ECT_COMPRESSION_OPERATION = -1302,
   };
 };
 
@@ -87,6 +92,28 @@ class ATFW_UTIL_SYMBOL_VISIBLE libatgw_protocol_api {
    */
   using on_write_start_fn_t = std::function<int(libatgw_protocol_api *, void *, size_t, bool *)>;
 
+  struct write_buffer_t {
+    void *data;
+    size_t size;
+  };
+
+  /**
+   * SPECIFY: callback when write several blocks at once. the last boolean return false means async write, you must
+   * call write_done(status) when the writing finished.
+   * PARAMETER:
+   *   0: proto object
+   *   1: headspace of write_header_offset_ bytes, it's available until write_done(status) is called
+   *   2: buffers to write, without headspace
+   *   3: buffer count
+   *   4: output if it's already done
+   * RETURN: 0 or error code
+   * OPTIONAL
+   * PROTOCOL: if provided, protocol should gather queued data blocks and call this instead of merging them into one
+   * buffer and calling **on_write_start_fn_t**.
+   */
+  using on_write_vector_start_fn_t =
+      std::function<int(libatgw_protocol_api *, void *, const write_buffer_t *, size_t, bool *)>;
+
   /**
    * SPECIFY: callback when receive any custom message
    * PARAMETER:
@@ -186,6 +213,19 @@ class ATFW_UTIL_SYMBOL_VISIBLE libatgw_protocol_api {
     flag_guard_t &operator=(const flag_guard_t &other) = delete;
   };
 
+  /**
+   * @brief cache of encoded frames during one broadcast.
+   * @note protocol object which do not depend on per-connection state to encode a message can put the whole encoded
+   *       frame here, and other protocol objects with the same encoding key will reuse it instead of encoding again.
+   *       It must only be used for one message.
+   */
+  struct broadcast_cache_t {
+    std::unordered_map<std::string, std::shared_ptr<std::vector<unsigned char> > > frames;
+    size_t reuse_count;
+
+    ATFW_UTIL_FORCEINLINE broadcast_cache_t() : reuse_count(0) {}
+  };
+
   struct proto_callbacks_t {
     on_write_start_fn_t write_fn;
     on_message_fn_t message_fn;
@@ -195,6 +235,7 @@ class ATFW_UTIL_SYMBOL_VISIBLE libatgw_protocol_api {
     on_handshake_done_fn_t on_handshake_done_fn;
     on_handshake_done_fn_t on_handshake_update_fn;
     on_error_fn_t on_error_fn;
+    on_write_vector_start_fn_t write_vector_fn;
   };
 
  protected:
@@ -234,6 +275,16 @@ class ATFW_UTIL_SYMBOL_VISIBLE libatgw_protocol_api {
    */
   virtual int write(const void *buffer, size_t len) = 0;
 
+  /**
+   * @brief call this when need to write the same custom message to many peers.
+   * @note default implementation is just the same as write(buffer, len)
+   * @param buffer written buffer address
+   * @param len written buffer length
+   * @param cache encoded frame cache shared by all protocol objects which receive this message
+   * @return 0 or error code
+   */
+  LIBATGW_PROTOCOL_API virtual int write_broadcast(const void *buffer, size_t len, broadcast_cache_t &cache);
+
   /**
    * @biref call this to notify protocol object last write is finished.
    * @param status written status
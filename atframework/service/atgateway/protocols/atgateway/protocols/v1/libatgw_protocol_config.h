@@ -3,4 +3,32 @@
 
 #pragma once
 
-#endif
\ No newline at end of file
+// Data smaller than this size will not be compressed, the compressed data of small message is usually larger than
+// the origin one.
+#ifndef ATFRAMEWORK_GATEWAY_MACRO_COMPRESSION_DEFAULT_THRESHOLD
+#  define ATFRAMEWORK_GATEWAY_MACRO_COMPRESSION_DEFAULT_THRESHOLD 512
+#endif
+
+// Max length of data after decompression, message with larger origin_length will be treated as bad data.
+#ifndef ATFRAMEWORK_GATEWAY_MACRO_COMPRESSION_MAX_ORIGIN_SIZE
+#  define ATFRAMEWORK_GATEWAY_MACRO_COMPRESSION_MAX_ORIGIN_SIZE (16 * 1024 * 1024)
+#endif
+
+// Max buffer count of one vectored write. libuv will allocate buffer array when there are more than 4 buffers, and
+// most system limit the iovec count to IOV_MAX(1024 on linux).
+#ifndef ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_COUNT
+#  define ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_COUNT 64
+#endif
+
+// Max bytes of one vectored write, a single block larger than this will still be written alone.
+#ifndef ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_SIZE
+#  define ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_SIZE (256 * 1024)
+#endif
+
+// Count of small read buffers allocated in one slab. Small read buffers are shared by connections in the same thread and
+// only held when there is unfinished data, so idle connections do not pin any read buffer.
+#ifndef ATFRAMEWORK_GATEWAY_MACRO_RECV_BUFFER_SLAB_BLOCK_COUNT
+#  define ATFRAMEWORK_GATEWAY_MACRO_RECV_BUFFER_SLAB_BLOCK_COUNT 64
+#endif
+
+#endif
@@ -4,6 +4,7 @@
 
 #include <gsl/select-gsl.h>
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include <memory>
 #include <sstream>
@@ -15,6 +16,14 @@
 #include "lock/seq_alloc.h"
 #include "lock/spin_lock.h"
 
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+#  include <zstd.h>
+#endif
+
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+#  include <lz4.h>
+#endif
+
 namespace atframework {
 namespace gateway {
 inline namespace v1 {
@@ -43,17 +52,129 @@ static uint64_t alloc_seq() {
   return ret;
 }
 
+static bool is_compression_type_supported(libatgw_protocol_sdk::compression_type_t compression_type) {
+  switch (compression_type) {
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+    case ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_ZSTD):
+      return true;
+#endif
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+    case ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_LZ4):
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+// compression contexts can not be shared between threads, and create them for every message is expensive
+struct compression_tls_context_t {
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+  ZSTD_CCtx *zstd_cctx = nullptr;
+  ZSTD_DCtx *zstd_dctx = nullptr;
+#endif
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+  LZ4_stream_t *lz4_stream = nullptr;
+#endif
+
+  ~compression_tls_context_t() {
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+    if (nullptr != zstd_cctx) {
+      ZSTD_freeCCtx(zstd_cctx);
+    }
+    if (nullptr != zstd_dctx) {
+      ZSTD_freeDCtx(zstd_dctx);
+    }
+#endif
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+    if (nullptr != lz4_stream) {
+      LZ4_freeStream(lz4_stream);
+    }
+#endif
+  }
+
+  static compression_tls_context_t &get() {
+    static thread_local compression_tls_context_t ret;
+    return ret;
+  }
+};
+
+// small read buffers are only held by connections with unfinished data, so they are shared by all connections in the
+// same thread. blocks are allocated by slabs and slabs will be freed when thread exit.
+struct recv_buffer_pool_t {
+  std::vector<std::unique_ptr<char[]>> slabs;
+  std::vector<char *> free_blocks;
+
+  ~recv_buffer_pool_t() {
+    free_blocks.clear();
+    slabs.clear();
+    destroyed_ = true;
+  }
+
+  char *allocate() {
+    if (free_blocks.empty()) {
+      const size_t block_count = ATFRAMEWORK_GATEWAY_MACRO_RECV_BUFFER_SLAB_BLOCK_COUNT;
+      std::unique_ptr<char[]> slab{new char[ATFRAMEWORK_GATEWAY_MACRO_DATA_SMALL_SIZE * block_count]};
+      free_blocks.reserve(block_count * (slabs.size() + 1));
+      for (size_t i = block_count; i > 0; --i) {
+        free_blocks.push_back(slab.get() + (i - 1) * ATFRAMEWORK_GATEWAY_MACRO_DATA_SMALL_SIZE);
+      }
+      slabs.emplace_back(std::move(slab));
+    }
+
+    char *ret = free_blocks.back();
+    free_blocks.pop_back();
+    return ret;
+  }
+
+  void deallocate(char *block) {
+    if (nullptr == block) {
+      return;
+    }
+    free_blocks.push_back(block);
+  }
+
+  /**
+   * @brief get the pool of current thread
+   * @note thread_local objects may be destroyed before protocol objects which are released at thread exit,
+   *       so we must not touch the pool any more after it's destroyed.
+   * @return pool of current thread, or nullptr if it's already destroyed
+   */
+  static recv_buffer_pool_t *get_current() noexcept {
+    if (destroyed_) {
+      return nullptr;
+    }
+
+    static thread_local recv_buffer_pool_t ret;
+    return &ret;
+  }
+
+ private:
+  static thread_local bool destroyed_;
+};
+
+thread_local bool recv_buffer_pool_t::destroyed_ = false;
+
 struct crypt_global_configure_t {
   using ptr_t = std::shared_ptr<crypt_global_configure_t>;
 
-  crypt_global_configure_t(const libatgw_protocol_sdk::crypt_conf_t &conf) : conf_(conf), inited_(false) {
+  crypt_global_configure_t(const libatgw_protocol_sdk::crypt_conf_t &conf)
+      : conf_(conf), inited_(false), compression_dictionary_id_(0) {
     shared_dh_context_ = atfw::util::crypto::dh::shared_context::create();
   }
-  ~crypt_global_configure_t() { close(); }
+  ~crypt_global_configure_t() {
+    close();
+    close_compression();
+  }
 
   int init() {
     int ret = 0;
     close();
+    ret = init_compression();
+    if (ret < 0) {
+      return ret;
+    }
+
     if (conf_.type.empty()) {
       inited_ = true;
       return ret;
@@ -122,6 +243,95 @@ struct crypt_global_configure_t {
     shared_dh_context_->reset();
   }
 
+  int init_compression() {
+    close_compression();
+
+    std::unordered_set<int> selected_types;
+    for (auto &compression_type : conf_.compression.types) {
+      if (!is_compression_type_supported(compression_type)) {
+        continue;
+      }
+      if (selected_types.insert(static_cast<int>(compression_type)).second) {
+        available_compression_types_.push_back(compression_type);
+      }
+    }
+
+    if (available_compression_types_.empty() || conf_.compression.dictionary.empty()) {
+      return 0;
+    }
+
+    // client and server use the hash of dictionary to check if they are using the same one
+    compression_dictionary_id_ = atfw::util::hash::murmur_hash3_x86_32(
+        conf_.compression.dictionary.data(), static_cast<int>(conf_.compression.dictionary.size()), 0);
+    if (0 == compression_dictionary_id_) {
+      compression_dictionary_id_ = 1;
+    }
+
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+    zstd_cdict_ = ZSTD_createCDict(conf_.compression.dictionary.data(), conf_.compression.dictionary.size(),
+                                   get_zstd_level());
+    zstd_ddict_ = ZSTD_createDDict(conf_.compression.dictionary.data(), conf_.compression.dictionary.size());
+    if (nullptr == zstd_cdict_ || nullptr == zstd_ddict_) {
+      return error_code_t::EN_ECT_MALLOC;
+    }
+#endif
+
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+    // lz4 only use the last 64KB of dictionary
+    lz4_dictionary_size_ = conf_.compression.dictionary.size();
+    if (lz4_dictionary_size_ > 64 * 1024) {
+      lz4_dictionary_size_ = 64 * 1024;
+    }
+    lz4_dictionary_ = conf_.compression.dictionary.data() + conf_.compression.dictionary.size() - lz4_dictionary_size_;
+    lz4_dict_stream_ = LZ4_createStream();
+    if (nullptr == lz4_dict_stream_) {
+      return error_code_t::EN_ECT_MALLOC;
+    }
+    LZ4_loadDict(lz4_dict_stream_, lz4_dictionary_, static_cast<int>(lz4_dictionary_size_));
+#endif
+
+    return 0;
+  }
+
+  void close_compression() {
+    available_compression_types_.clear();
+    compression_dictionary_id_ = 0;
+
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+    if (nullptr != zstd_cdict_) {
+      ZSTD_freeCDict(zstd_cdict_);
+      zstd_cdict_ = nullptr;
+    }
+    if (nullptr != zstd_ddict_) {
+      ZSTD_freeDDict(zstd_ddict_);
+      zstd_ddict_ = nullptr;
+    }
+#endif
+
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+    if (nullptr != lz4_dict_stream_) {
+      LZ4_freeStream(lz4_dict_stream_);
+      lz4_dict_stream_ = nullptr;
+    }
+    lz4_dictionary_ = nullptr;
+    lz4_dictionary_size_ = 0;
+#endif
+  }
+
+  bool check_compression_type(libatgw_protocol_sdk::compression_type_t compression_type) const {
+    return available_compression_types_.end() !=
+           std::find(available_compression_types_.begin(), available_compression_types_.end(), compression_type);
+  }
+
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+  int get_zstd_level() const {
+    if (0 == conf_.compression.level) {
+      return ZSTD_CLEVEL_DEFAULT;
+    }
+    return conf_.compression.level;
+  }
+#endif
+
   bool check_type(std::string &crypt_type) {
     if (crypt_type.empty()) {
       return true;
@@ -139,6 +349,11 @@ struct crypt_global_configure_t {
     dconf.type.clear();
     dconf.update_interval = 1200;
     dconf.client_mode = false;
+
+    dconf.compression.types.clear();
+    dconf.compression.threshold = ATFRAMEWORK_GATEWAY_MACRO_COMPRESSION_DEFAULT_THRESHOLD;
+    dconf.compression.level = 0;
+    dconf.compression.dictionary.clear();
   }
 
   libatgw_protocol_sdk::crypt_conf_t conf_;
@@ -146,11 +361,92 @@ struct crypt_global_configure_t {
   std::unordered_set<std::string> available_types_;
   atfw::util::crypto::dh::shared_context::ptr_t shared_dh_context_;
 
-  static ptr_t &current() {
-    static ptr_t ret;
+  std::vector<libatgw_protocol_sdk::compression_type_t> available_compression_types_;
+  uint32_t compression_dictionary_id_;
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+  ZSTD_CDict *zstd_cdict_ = nullptr;
+  ZSTD_DDict *zstd_ddict_ = nullptr;
+#endif
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+  LZ4_stream_t *lz4_dict_stream_ = nullptr;
+  const char *lz4_dictionary_ = nullptr;
+  size_t lz4_dictionary_size_ = 0;
+#endif
+
+  // every thread has its own instance, because the random engine and dh context in it are not thread-safe.
+  // instances of other threads will be rebuilt from the latest configure the next time they are used.
+  static ptr_t current() {
+    local_holder_t &local = local_holder();
+    global_holder_t &global = global_holder();
+    if (local.version == global.version.load(std::memory_order_acquire)) {
+      return local.inst;
+    }
+
+    std::shared_ptr<const libatgw_protocol_sdk::crypt_conf_t> conf;
+    uint64_t version;
+    {
+      atfw::util::lock::lock_holder<atfw::util::lock::spin_lock> lh(global.lock);
+      conf = global.conf;
+      version = global.version.load(std::memory_order_acquire);
+    }
+
+    if (conf) {
+      ptr_t inst = std::make_shared<crypt_global_configure_t>(*conf);
+      // keep the old one if failed, the same configure has already been checked by global_reload
+      if (inst && 0 == inst->init()) {
+        local.inst.swap(inst);
+      }
+    }
+    local.version = version;
+    return local.inst;
+  }
+
+  static void reset_current(const ptr_t &inst) {
+    local_holder_t &local = local_holder();
+    global_holder_t &global = global_holder();
+
+    atfw::util::lock::lock_holder<atfw::util::lock::spin_lock> lh(global.lock);
+    global.conf = std::make_shared<const libatgw_protocol_sdk::crypt_conf_t>(inst->conf_);
+    local.inst = inst;
+    local.version = global.version.fetch_add(1, std::memory_order_acq_rel) + 1;
+  }
+
+ private:
+  struct global_holder_t {
+    atfw::util::lock::spin_lock lock;
+    std::shared_ptr<const libatgw_protocol_sdk::crypt_conf_t> conf;
+    std::atomic<uint64_t> version;
+
+    global_holder_t() : version(0) {}
+  };
+
+  struct local_holder_t {
+    ptr_t inst;
+    uint64_t version;
+
+    local_holder_t() : version(0) {}
+  };
+
+  static global_holder_t &global_holder() {
+    static global_holder_t ret;
+    return ret;
+  }
+
+  static local_holder_t &local_holder() {
+    static thread_local local_holder_t ret;
     return ret;
   }
 };
+
+// the server put the selected compression type in the first element of compression_type in response
+static libatgw_protocol_sdk::compression_type_t get_selected_compression_type(
+    const ::atframework::gw::v1::cs_body_handshake &body_handshake) {
+  if (nullptr == body_handshake.compression_type() || 0 == body_handshake.compression_type()->size()) {
+    return ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE);
+  }
+
+  return static_cast<libatgw_protocol_sdk::compression_type_t>(body_handshake.compression_type()->Get(0));
+}
 }  // namespace detail
 
 LIBATGW_PROTOCOL_API libatgw_protocol_sdk::crypt_session_t::crypt_session_t() : is_inited_(false) {}
@@ -258,9 +554,14 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::crypt_session_t::swap_secret(
 }
 
 LIBATGW_PROTOCOL_API libatgw_protocol_sdk::libatgw_protocol_sdk()
-    : session_id_(0), last_write_ptr_(nullptr), close_reason_(0) {
+    : session_id_(0),
+      write_vector_max_count_(ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_COUNT),
+      write_vector_max_size_(ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_SIZE),
+      last_write_ptr_(nullptr),
+      close_reason_(0) {
   crypt_handshake_ = std::make_shared<crypt_session_t>();
 
+  read_head_.buffer = nullptr;
   read_head_.len = 0;
 
   ping_.last_ping = ping_data_t::clk_t::from_time_t(0);
@@ -269,11 +570,44 @@ LIBATGW_PROTOCOL_API libatgw_protocol_sdk::libatgw_protocol_sdk()
   handshake_.switch_secret_type = static_cast<decltype(handshake_.switch_secret_type)>(0);
   handshake_.has_data = false;
   handshake_.ext_data = nullptr;
+
+  compression_.type = ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE);
+  compression_.use_dictionary = false;
 }
 
 LIBATGW_PROTOCOL_API libatgw_protocol_sdk::~libatgw_protocol_sdk() {
   close(close_reason_t::EN_CRT_UNKNOWN, false);
   close_handshake(error_code_t::EN_ECT_SESSION_EXPIRED);
+
+  read_head_.len = 0;
+  release_read_head();
+}
+
+bool libatgw_protocol_sdk::acquire_read_head() {
+  if (nullptr == read_head_.buffer) {
+    detail::recv_buffer_pool_t *pool = detail::recv_buffer_pool_t::get_current();
+    if (nullptr == pool) {
+      return false;
+    }
+    read_head_.buffer = pool->allocate();
+    read_head_.len = 0;
+  }
+
+  return nullptr != read_head_.buffer;
+}
+
+void libatgw_protocol_sdk::release_read_head() {
+  // keep unfinished data
+  if (nullptr == read_head_.buffer || read_head_.len > 0) {
+    return;
+  }
+
+  // slabs are already freed if the pool is destroyed at thread exit
+  detail::recv_buffer_pool_t *pool = detail::recv_buffer_pool_t::get_current();
+  if (nullptr != pool) {
+    pool->deallocate(read_head_.buffer);
+  }
+  read_head_.buffer = nullptr;
 }
 
 LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::alloc_recv_buffer(size_t /*suggested_size*/, char *&out_buf,
@@ -293,7 +627,12 @@ LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::alloc_recv_buffer(size_t /*sugge
 
   // reading length and hash code, use small buffer block
   if (nullptr == data || 0 == swrite) {
-    out_len = sizeof(read_head_.buffer) - read_head_.len;
+    if (!acquire_read_head()) {
+      out_buf = nullptr;
+      out_len = 0;
+      return;
+    }
+    out_len = ATFRAMEWORK_GATEWAY_MACRO_DATA_SMALL_SIZE - read_head_.len;
 
     if (0 == out_len) {
       // hash code and length shouldn't be greater than small buffer block
@@ -330,7 +669,8 @@ LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::read(int /*ssz*/, const char * /
   if (nullptr == data || 0 == swrite) {
     // first, read from small buffer block
     // read header
-    assert(nread_s <= sizeof(read_head_.buffer) - read_head_.len);
+    assert(nullptr != read_head_.buffer);
+    assert(nread_s <= ATFRAMEWORK_GATEWAY_MACRO_DATA_SMALL_SIZE - read_head_.len);
     read_head_.len += nread_s;  // 写数据计数
 
     // try to unpack all messages
@@ -420,6 +760,9 @@ LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::read(int /*ssz*/, const char * /
       dispatch_data(read_head_.buffer, read_head_.len, errcode);
     }
   }
+
+  // idle connection do not hold small buffer block
+  release_read_head();
 }
 
 LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::dispatch_data(const char *buffer, size_t len, int errcode) {
@@ -462,11 +805,14 @@ LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::dispatch_data(const char *buffer
 
       const void *out;
       size_t outsz = static_cast<size_t>(msg_body->length());
-      int res = decode_post(msg_body->data()->data(), static_cast<size_t>(msg_body->data()->size()), out, outsz);
+      std::unique_ptr<unsigned char[]> decompress_buffer;
+      int res = decode_post(msg_body->data()->data(), static_cast<size_t>(msg_body->data()->size()),
+                            static_cast<size_t>(msg_body->length()), msg_body->compression_type(),
+                            static_cast<size_t>(msg_body->origin_length()), out, outsz, decompress_buffer);
       if (0 == res) {
         // on_message
         if (nullptr != callbacks_ && callbacks_->message_fn) {
-          callbacks_->message_fn(this, out, static_cast<size_t>(msg_body->length()));
+          callbacks_->message_fn(this, out, outsz);
         }
       } else {
         close(close_reason_t::EN_CRT_INVALID_DATA, false);
@@ -666,8 +1012,13 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::dispatch_handshake_start_req(
                         ::atframework::gateway::detail::alloc_seq());
   flatbuffers::Offset<cs_body_handshake> handshake_body;
 
+  uint32_t compression_dictionary_id = 0;
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t> > compression_types =
+      pack_compression_types(builder, &body_handshake, compression_dictionary_id);
+
   //
-  ret = pack_handshake_start_rsp(builder, session_id_, crypt_type, handshake_body);
+  ret = pack_handshake_start_rsp(builder, session_id_, crypt_type, handshake_body, compression_types,
+                                 compression_dictionary_id);
   if (ret < 0) {
     handshake_done(ret);
     return ret;
@@ -714,6 +1065,9 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::dispatch_handshake_start_rsp(
         global_cfg->conf_.switch_secret_type != body_handshake.switch_type()) {
       crypt_conf_t global_crypt_cfg;
       detail::crypt_global_configure_t::default_crypt_configure(global_crypt_cfg);
+      if (global_cfg) {
+        global_crypt_cfg.compression = global_cfg->conf_.compression;
+      }
       global_crypt_cfg.type = crypt_type;
       global_crypt_cfg.switch_secret_type = body_handshake.switch_type();
       global_crypt_cfg.client_mode = true;
@@ -724,6 +1078,13 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::dispatch_handshake_start_rsp(
     if (ret < 0) {
       return ret;
     }
+
+    ret = setup_compression(global_cfg, detail::get_selected_compression_type(body_handshake),
+                            body_handshake.compression_dictionary_id());
+    if (ret < 0) {
+      ATFRAME_GATEWAY_ON_ERROR(ret, "compression type selected by server is not supported");
+      return ret;
+    }
   } else {
     return error_code_t::EN_ECT_HANDSHAKE;
   }
@@ -823,14 +1184,17 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::dispatch_handshake_reconn_req(
   flatbuffers::Offset<cs_body_handshake> reconn_body;
 
   uint64_t sess_id = 0;
+  uint32_t compression_dictionary_id = 0;
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t> > compression_types;
   if (0 == ret) {
     sess_id = session_id_;
+    compression_types = pack_compression_types(builder, &body_handshake, compression_dictionary_id);
   }
 
   reconn_body = Createcs_body_handshake(
       builder, sess_id, ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(handshake_step_t, EN_HST_RECONNECT_RSP),
       static_cast< ::atframework::gw::v1::switch_secret_t>(handshake_.switch_secret_type),
-      builder.CreateString(crypt_handshake_->type));
+      builder.CreateString(crypt_handshake_->type), 0, 0, compression_types, compression_dictionary_id);
 
   builder.Finish(
       Createcs_msg(builder, header_data, ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(cs_msg_body, cs_body_handshake),
@@ -877,6 +1241,9 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::dispatch_handshake_reconn_rsp(
       global_cfg->conf_.switch_secret_type != body_handshake.switch_type()) {
     crypt_conf_t global_crypt_cfg;
     detail::crypt_global_configure_t::default_crypt_configure(global_crypt_cfg);
+    if (global_cfg) {
+      global_crypt_cfg.compression = global_cfg->conf_.compression;
+    }
     global_crypt_cfg.type = crypt_type;
     global_crypt_cfg.switch_secret_type = body_handshake.switch_type();
     global_crypt_cfg.client_mode = true;
@@ -888,6 +1255,14 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::dispatch_handshake_reconn_rsp(
     return ret;
   }
 
+  ret = setup_compression(global_cfg, detail::get_selected_compression_type(body_handshake),
+                          body_handshake.compression_dictionary_id());
+  if (ret < 0) {
+    ATFRAME_GATEWAY_ON_ERROR(ret, "compression type selected by server is not supported");
+    close_handshake(ret);
+    return ret;
+  }
+
   session_id_ = body_handshake.session_id();
   crypt_read_ = crypt_handshake_;
   crypt_write_ = crypt_handshake_;
@@ -1085,7 +1460,8 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::dispatch_handshake_verify_ntf(
 
 LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::pack_handshake_start_rsp(
     flatbuffers::FlatBufferBuilder &builder, uint64_t sess_id, std::string &crypt_type,
-    flatbuffers::Offset< ::atframework::gw::v1::cs_body_handshake> &handshake_data) {
+    flatbuffers::Offset< ::atframework::gw::v1::cs_body_handshake> &handshake_data,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t> > compression_types, uint32_t compression_dictionary_id) {
   using namespace ::atframework::gw::v1;
 
   int ret = crypt_handshake_->setup(crypt_type);
@@ -1095,7 +1471,8 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::pack_handshake_start_rsp(
     handshake_data = Createcs_body_handshake(
         builder, sess_id, ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(handshake_step_t, EN_HST_START_RSP),
         ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(switch_secret_t, EN_SST_DIRECT), builder.CreateString(crypt_type),
-        builder.CreateVector(static_cast<const int8_t *>(nullptr), 0));
+        builder.CreateVector(static_cast<const int8_t *>(nullptr), 0), 0, compression_types,
+        compression_dictionary_id);
 
     crypt_read_ = crypt_handshake_;
     crypt_write_ = crypt_handshake_;
@@ -1120,7 +1497,8 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::pack_handshake_start_rsp(
           static_cast< ::atframework::gw::v1::switch_secret_t>(handshake_.switch_secret_type),
           builder.CreateString(crypt_type),
           builder.CreateVector(reinterpret_cast<const int8_t *>(crypt_handshake_->secret.data()),
-                               crypt_handshake_->secret.size()));
+                               crypt_handshake_->secret.size()),
+          0, compression_types, compression_dictionary_id);
 
       break;
     }
@@ -1146,7 +1524,8 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::pack_handshake_start_rsp(
           static_cast< ::atframework::gw::v1::switch_secret_t>(handshake_.switch_secret_type),
           builder.CreateString(crypt_type),
           builder.CreateVector(reinterpret_cast<const int8_t *>(crypt_handshake_->param.data()),
-                               crypt_handshake_->param.size()));
+                               crypt_handshake_->param.size()),
+          0, compression_types, compression_dictionary_id);
 
       break;
     }
@@ -1274,7 +1653,7 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::try_write() {
       // }
 
       // remove all cache buffer
-      write_buffers_.pop_front(nwrite, true);
+      pop_write_block(nwrite);
     }
 
     // no need to call write_done(status) to trigger on_close_fn here
@@ -1282,6 +1661,14 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::try_write() {
     return error_code_t::EN_ECT_CLOSING;
   }
 
+  // write_blocks_ is only an index of write_buffers_, they must always start with the same block
+  assert(!write_blocks_.empty() && write_blocks_.front() == write_buffers_.front());
+
+  // gather blocks and write them at once if write_vector_fn is available, so nothing need to be copied
+  if (callbacks_->write_vector_fn && !write_blocks_.empty() && write_blocks_.front() == write_buffers_.front()) {
+    return try_write_vector();
+  }
+
   int ret = 0;
   bool is_done = false;
 
@@ -1315,11 +1702,12 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::try_write() {
       free_buffer += bb_size;
       available_bytes -= bb_size;
 
-      write_buffers_.pop_front(bb->raw_size(), true);
+      pop_write_block(bb->raw_size());
     }
 
     void *data = nullptr;
     write_buffers_.push_front(data, write_header_offset_ + static_cast<size_t>(free_buffer - buffer_start));
+    write_blocks_.push_front(write_buffers_.front());
 
     // already pop more data than write_header_offset_ + (free_buffer - buffer_start)
     // so this push_front should always success
@@ -1340,13 +1728,13 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::try_write() {
   // should always exist, empty will cause return before
   if (nullptr == writing_block) {
     assert(writing_block);
-    write_buffers_.pop_front(0, true);
+    pop_write_block(0);
     set_flag(flag_t::EN_PFT_WRITING, true);
     return write_done(error_code_t::EN_ECT_NO_DATA);
   }
 
   if (writing_block->raw_size() <= write_header_offset_) {
-    write_buffers_.pop_front(writing_block->raw_size(), true);
+    pop_write_block(writing_block->raw_size());
     return try_write();
   }
 
@@ -1361,6 +1749,71 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::try_write() {
   return ret;
 }
 
+int libatgw_protocol_sdk::try_write_vector() {
+  write_vector_.clear();
+
+  size_t total_size = 0;
+  ::atbus::detail::buffer_block *last_block = nullptr;
+  for (::atbus::detail::buffer_block *bb : write_blocks_) {
+    if (nullptr == bb || write_vector_.size() >= write_vector_max_count_) {
+      break;
+    }
+
+    // first write_header_offset_ should not be written, the rest is 32bits hash+32bits length+data
+    size_t bb_size = bb->raw_size() > write_header_offset_ ? bb->raw_size() - write_header_offset_ : 0;
+
+    // at least write one block, even if it's larger than the limit
+    if (nullptr != last_block && total_size + bb_size > write_vector_max_size_) {
+      break;
+    }
+    last_block = bb;
+
+    if (0 == bb_size) {
+      continue;
+    }
+
+    write_buffer_t buf;
+    buf.data = ::atbus::detail::fn::buffer_next(bb->raw_data(), write_header_offset_);
+    buf.size = bb_size;
+    write_vector_.push_back(buf);
+    total_size += bb_size;
+  }
+
+  // all gathered blocks are empty, just remove them
+  if (write_vector_.empty()) {
+    while (!write_buffers_.empty()) {
+      ::atbus::detail::buffer_block *bb = write_buffers_.front();
+      pop_write_block(nullptr == bb ? 0 : bb->raw_size());
+      if (bb == last_block) {
+        break;
+      }
+    }
+    return try_write();
+  }
+
+  // write_done(status) will remove all blocks until last_write_ptr_
+  bool is_done = false;
+  set_flag(flag_t::EN_PFT_WRITING, true);
+  last_write_ptr_ = last_block->raw_data();
+  int ret = callbacks_->write_vector_fn(this, write_blocks_.front()->raw_data(), write_vector_.data(),
+                                        write_vector_.size(), &is_done);
+  if (is_done) {
+    return write_done(ret);
+  }
+
+  return ret;
+}
+
+void libatgw_protocol_sdk::pop_write_block(size_t s) {
+  ::atbus::detail::buffer_block *bb = write_buffers_.front();
+  write_buffers_.pop_front(s, true);
+
+  // only remove the index when the whole block is removed
+  if (nullptr != bb && bb != write_buffers_.front() && !write_blocks_.empty() && write_blocks_.front() == bb) {
+    write_blocks_.pop_front();
+  }
+}
+
 LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::write_msg(flatbuffers::FlatBufferBuilder &builder) {
   // first 32bits is hash code, and then 32bits length
   const size_t msg_header_len = sizeof(uint32_t) + sizeof(uint32_t);
@@ -1374,31 +1827,46 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::write_msg(flatbuffers::FlatBuffer
       return error_code_t::EN_ECT_INVALID_SIZE;
     }
 
-    // get the write block size: write_header_offset_ + header + len）
-    size_t total_buffer_size = write_header_offset_ + msg_header_len + len;
+    char msg_header[msg_header_len];
+    // 32bits hash
+    uint32_t hash32 =
+        atfw::util::hash::murmur_hash3_x86_32(reinterpret_cast<const char *>(buf), static_cast<int>(len), 0);
+    memcpy(msg_header, &hash32, sizeof(uint32_t));
+
+    // length
+    flatbuffers::WriteScalar<uint32_t>(msg_header + sizeof(uint32_t), static_cast<uint32_t>(len));
 
-    // 判定内存限制
-    void *data;
-    int res = write_buffers_.push_back(data, total_buffer_size);
+    int res = push_write_block(msg_header, msg_header_len, buf, len);
     if (res < 0) {
       return res;
     }
+  }
+
+  return try_write();
+}
 
-    // skip custom write_header_offset_
-    char *buff_start = reinterpret_cast<char *>(data) + write_header_offset_;
+int libatgw_protocol_sdk::push_write_block(const void *header, size_t header_len, const void *buf, size_t len) {
+  // get the write block size: write_header_offset_ + header + len）
+  size_t total_buffer_size = write_header_offset_ + header_len + len;
 
-    // 32bits hash
-    uint32_t hash32 =
-        atfw::util::hash::murmur_hash3_x86_32(reinterpret_cast<const char *>(buf), static_cast<int>(len), 0);
-    memcpy(buff_start, &hash32, sizeof(uint32_t));
+  // 判定内存限制
+  void *data;
+  int res = write_buffers_.push_back(data, total_buffer_size);
+  if (res < 0) {
+    return res;
+  }
+  write_blocks_.push_back(write_buffers_.back());
 
-    // length
-    flatbuffers::WriteScalar<uint32_t>(buff_start + sizeof(uint32_t), static_cast<uint32_t>(len));
-    // buffer
-    memcpy(buff_start + msg_header_len, buf, len);
+  // skip custom write_header_offset_
+  char *buff_start = reinterpret_cast<char *>(data) + write_header_offset_;
+  if (header_len > 0) {
+    memcpy(buff_start, header, header_len);
+  }
+  if (len > 0) {
+    memcpy(buff_start + header_len, buf, len);
   }
 
-  return try_write();
+  return 0;
 }
 
 LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::write(const void *buffer, size_t len) {
@@ -1406,6 +1874,74 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::write(const void *buffer, size_t
                    len);
 }
 
+LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::write_broadcast(const void *buffer, size_t len,
+                                                               broadcast_cache_t &cache) {
+  if (check_flag(flag_t::EN_PFT_CLOSING)) {
+    return error_code_t::EN_ECT_CLOSING;
+  }
+
+  if (nullptr == callbacks_ || !callbacks_->write_fn || !crypt_write_) {
+    return error_code_t::EN_ECT_MISS_CALLBACKS;
+  }
+
+  // encrypted data depends on the secret and cipher state of this session, so it can not be shared
+  if (!crypt_write_->is_inited_ || !crypt_write_->type.empty()) {
+    return write(buffer, len);
+  }
+
+  // frames of sessions without encryption only depend on the compression setting
+  char encoding_key[2 + sizeof(uintptr_t)];
+  size_t encoding_key_len = 0;
+  encoding_key[encoding_key_len++] = static_cast<char>(compression_.type);
+  if (compression_.type !=
+      ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE)) {
+    // sessions created before reloading may use different compression configure
+    uintptr_t conf_addr = reinterpret_cast<uintptr_t>(compression_.shared_conf.get());
+    encoding_key[encoding_key_len++] = compression_.use_dictionary ? 1 : 0;
+    memcpy(&encoding_key[encoding_key_len], &conf_addr, sizeof(conf_addr));
+    encoding_key_len += sizeof(conf_addr);
+  }
+
+  std::shared_ptr<std::vector<unsigned char> > &frame = cache.frames[std::string(encoding_key, encoding_key_len)];
+  if (frame) {
+    ++cache.reuse_count;
+  } else {
+    flatbuffers::FlatBufferBuilder builder;
+    int res = pack_post(builder,
+                        ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(cs_msg_type_t, EN_MTT_POST),
+                        buffer, len);
+    if (0 != res) {
+      return res;
+    }
+
+    const void *buf = reinterpret_cast<const void *>(builder.GetBufferPointer());
+    size_t buf_len = static_cast<size_t>(builder.GetSize());
+    if (nullptr == buf || 0 == buf_len) {
+      return error_code_t::EN_ECT_NO_DATA;
+    }
+    if (buf_len >= std::numeric_limits<uint32_t>::max()) {
+      return error_code_t::EN_ECT_INVALID_SIZE;
+    }
+
+    // first 32bits is hash code, and then 32bits length
+    const size_t msg_header_len = sizeof(uint32_t) + sizeof(uint32_t);
+    frame = std::make_shared<std::vector<unsigned char> >(msg_header_len + buf_len);
+    unsigned char *frame_start = frame->data();
+    uint32_t hash32 =
+        atfw::util::hash::murmur_hash3_x86_32(reinterpret_cast<const char *>(buf), static_cast<int>(buf_len), 0);
+    memcpy(frame_start, &hash32, sizeof(uint32_t));
+    flatbuffers::WriteScalar<uint32_t>(frame_start + sizeof(uint32_t), static_cast<uint32_t>(buf_len));
+    memcpy(frame_start + msg_header_len, buf, buf_len);
+  }
+
+  int res = push_write_block(frame->data(), frame->size(), nullptr, 0);
+  if (res < 0) {
+    return res;
+  }
+
+  return try_write();
+}
+
 LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::write_done(int status) {
   if (!check_flag(flag_t::EN_PFT_WRITING)) {
     return status;
@@ -1428,7 +1964,7 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::write_done(int status) {
     assert(0 == nread);
 
     if (0 == nwrite) {
-      write_buffers_.pop_front(0, true);
+      pop_write_block(0);
       break;
     }
 
@@ -1456,7 +1992,7 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::write_done(int status) {
     // }
 
     // remove all cache buffer
-    write_buffers_.pop_front(nwrite, true);
+    pop_write_block(nwrite);
 
     // the end
     if (last_write_ptr_ == data) {
@@ -1464,6 +2000,7 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::write_done(int status) {
     }
   };
   last_write_ptr_ = nullptr;
+  assert(write_buffers_.empty() ? write_blocks_.empty() : write_blocks_.front() == write_buffers_.front());
 
   // unset writing mode
   set_flag(flag_t::EN_PFT_WRITING, false);
@@ -1688,6 +2225,13 @@ LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::set_recv_buffer_limit(size_t max
 
 LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::set_send_buffer_limit(size_t max_size, size_t max_number) {
   write_buffers_.set_mode(max_size, max_number);
+  // set_mode will reset all blocks
+  write_blocks_.clear();
+}
+
+LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::set_write_vector_limit(size_t max_count, size_t max_size) {
+  write_vector_max_count_ = 0 == max_count ? ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_COUNT : max_count;
+  write_vector_max_size_ = 0 == max_size ? ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_SIZE : max_size;
 }
 
 LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::handshake_update() { return send_key_syn(); }
@@ -1713,7 +2257,7 @@ LIBATGW_PROTOCOL_API std::string libatgw_protocol_sdk::get_info() const {
      << ",handshake update=" << check_flag(flag_t::EN_PFT_HANDSHAKE_UPDATE) << std::endl;
 
   if (read_buffers_.limit().limit_size_ > 0) {
-    limit_sz = read_buffers_.limit().limit_size_ + sizeof(read_head_.buffer) - read_head_.len -
+    limit_sz = read_buffers_.limit().limit_size_ + ATFRAMEWORK_GATEWAY_MACRO_DATA_SMALL_SIZE - read_head_.len -
                read_buffers_.limit().cost_size_;
     ss << "    read buffer: used size=" << (read_head_.len + read_buffers_.limit().cost_size_)
        << ", free size=" << limit_sz << std::endl;
@@ -1751,6 +2295,15 @@ LIBATGW_PROTOCOL_API std::string libatgw_protocol_sdk::get_info() const {
 
 #undef DUMP_INFO
 
+  const char *compression_name = "Unknown";
+  if (compression_.type >= ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, MIN) &&
+      compression_.type <= ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, MAX)) {
+    compression_name =
+        EnumNamecompression_type_t(static_cast< ::atframework::gw::v1::compression_type_t>(compression_.type));
+  }
+  ss << "    compression: type=" << compression_name
+     << ", dictionary=" << (compression_.use_dictionary ? "shared" : "none") << std::endl;
+
   return ss.str();
 }
 
@@ -1775,10 +2328,15 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::start_session(const std::string &
                         ::atframework::gateway::detail::alloc_seq());
   flatbuffers::Offset<cs_body_handshake> handshake_body;
 
+  uint32_t compression_dictionary_id = 0;
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t> > compression_types =
+      pack_compression_types(builder, nullptr, compression_dictionary_id);
+
   handshake_body = Createcs_body_handshake(
       builder, 0, ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(handshake_step_t, EN_HST_START_REQ),
       ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(switch_secret_t, EN_SST_DIRECT), builder.CreateString(crypt_type),
-      builder.CreateVector(static_cast<const int8_t *>(nullptr), 0));
+      builder.CreateVector(static_cast<const int8_t *>(nullptr), 0), 0, compression_types,
+      compression_dictionary_id);
 
   builder.Finish(
       Createcs_msg(builder, header_data, ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(cs_msg_body, cs_body_handshake),
@@ -1823,10 +2381,15 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::reconnect_session(uint64_t sess_i
                         ::atframework::gateway::detail::alloc_seq());
   flatbuffers::Offset<cs_body_handshake> handshake_body;
 
+  uint32_t compression_dictionary_id = 0;
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t> > compression_types =
+      pack_compression_types(builder, nullptr, compression_dictionary_id);
+
   handshake_body = Createcs_body_handshake(
       builder, sess_id, ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(handshake_step_t, EN_HST_RECONNECT_REQ),
       static_cast<switch_secret_t>(handshake_.switch_secret_type), builder.CreateString(crypt_type),
-      builder.CreateVector(reinterpret_cast<const int8_t *>(secret_buffer), secret_length));
+      builder.CreateVector(reinterpret_cast<const int8_t *>(secret_buffer), secret_length), 0, compression_types,
+      compression_dictionary_id);
 
   builder.Finish(
       Createcs_msg(builder, header_data, ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(cs_msg_body, cs_body_handshake),
@@ -1845,9 +2408,23 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::send_post(::atframework::gw::v1::
     return error_code_t::EN_ECT_MISS_CALLBACKS;
   }
 
+  flatbuffers::FlatBufferBuilder builder;
+  int res = pack_post(builder, msg_type, buffer, len);
+  if (0 != res) {
+    return res;
+  }
+
+  return write_msg(builder);
+}
+
+int libatgw_protocol_sdk::pack_post(flatbuffers::FlatBufferBuilder &builder,
+                                    ::atframework::gw::v1::cs_msg_type_t msg_type, const void *buffer, size_t len) {
   // encrypt/zip
   size_t ori_len = len;
-  int res = encode_post(buffer, len, buffer, len);
+  size_t plain_len = len;
+  compression_type_t compression_type;
+  std::unique_ptr<unsigned char[]> compress_buffer;
+  int res = encode_post(buffer, len, buffer, len, plain_len, compression_type, compress_buffer);
   if (0 != res) {
     return res;
   }
@@ -1855,17 +2432,20 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::send_post(::atframework::gw::v1::
   // pack
   using namespace ::atframework::gw::v1;
 
-  flatbuffers::FlatBufferBuilder builder;
   flatbuffers::Offset<cs_msg_head> header_data =
       Createcs_msg_head(builder, msg_type, ::atframework::gateway::detail::alloc_seq());
 
   flatbuffers::Offset<cs_body_post> post_body = Createcs_body_post(
-      builder, static_cast<uint64_t>(ori_len), builder.CreateVector(reinterpret_cast<const int8_t *>(buffer), len));
+      builder, static_cast<uint64_t>(plain_len), builder.CreateVector(reinterpret_cast<const int8_t *>(buffer), len),
+      static_cast< ::atframework::gw::v1::compression_type_t>(compression_type),
+      compression_type == ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE)
+          ? 0
+          : static_cast<uint64_t>(ori_len));
 
   builder.Finish(Createcs_msg(builder, header_data, ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(cs_msg_body, cs_body_post),
                               post_body.Union()),
                  cs_msgIdentifier());
-  return write_msg(builder);
+  return 0;
 }
 
 LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::send_post(const void *buffer, size_t len) {
@@ -2069,23 +2649,35 @@ LIBATGW_PROTOCOL_API void libatgw_protocol_sdk::set_logger(atfw::util::log::log_
   logger_ = logger;
 }
 
-int libatgw_protocol_sdk::encode_post(const void *in, size_t insz, const void *&out, size_t &outsz) {
+int libatgw_protocol_sdk::encode_post(const void *in, size_t insz, const void *&out, size_t &outsz, size_t &plainsz,
+                                      compression_type_t &compression_type,
+                                      std::unique_ptr<unsigned char[]> &holder) {
+  compression_type = ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE);
+  plainsz = insz;
   if (check_flag(flag_t::EN_PFT_CLOSING)) {
     outsz = insz;
     out = in;
     return error_code_t::EN_ECT_CLOSING;
   }
 
-  // TODO compression
-  // we should compressed data first, because encrypted data will decrease compression rate.
-
   // encrypt
   if (!crypt_write_) {
     outsz = insz;
     out = in;
     return error_code_t::EN_ECT_HANDSHAKE;
   }
-  int ret = encrypt_data(*crypt_write_, in, insz, out, outsz);
+
+  // we should compressed data first, because encrypted data will decrease compression rate.
+  const void *plain = in;
+  int ret = compress_data(in, insz, plain, plainsz, compression_type, holder);
+  if (0 != ret) {
+    // send origin data if compression failed
+    plain = in;
+    plainsz = insz;
+    compression_type = ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE);
+  }
+
+  ret = encrypt_data(*crypt_write_, plain, plainsz, out, outsz);
   // if (0 != ret) {
   //     return ret;
   // }
@@ -2093,7 +2685,9 @@ int libatgw_protocol_sdk::encode_post(const void *in, size_t insz, const void *&
   return ret;
 }
 
-int libatgw_protocol_sdk::decode_post(const void *in, size_t insz, const void *&out, size_t &outsz) {
+int libatgw_protocol_sdk::decode_post(const void *in, size_t insz, size_t plainsz, compression_type_t compression_type,
+                                      size_t originsz, const void *&out, size_t &outsz,
+                                      std::unique_ptr<unsigned char[]> &holder) {
   if (check_flag(flag_t::EN_PFT_CLOSING)) {
     outsz = insz;
     out = in;
@@ -2113,8 +2707,276 @@ int libatgw_protocol_sdk::decode_post(const void *in, size_t insz, const void *&
     return ret;
   }
 
-  // TODO decompression
-  return ret;
+  // decrypt will padding data, so use the length before encrypt
+  if (plainsz > outsz) {
+    return error_code_t::EN_ECT_BAD_DATA;
+  }
+  outsz = plainsz;
+
+  return decompress_data(compression_type, out, outsz, originsz, out, outsz, holder);
+}
+
+int libatgw_protocol_sdk::compress_data(const void *in, size_t insz, const void *&out, size_t &outsz,
+                                        compression_type_t &compression_type,
+                                        std::unique_ptr<unsigned char[]> &holder) {
+  compression_type = ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE);
+  out = in;
+  outsz = insz;
+
+  if (!compression_.shared_conf || nullptr == in ||
+      compression_.type ==
+          ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE) ||
+      insz < compression_.shared_conf->conf_.compression.threshold) {
+    return error_code_t::EN_ECT_SUCCESS;
+  }
+
+  void *buffer = get_tls_buffer(tls_buffer_t::EN_TBT_ZIP);
+  size_t len = get_tls_length(tls_buffer_t::EN_TBT_ZIP);
+  detail::compression_tls_context_t &tls_ctx = detail::compression_tls_context_t::get();
+  switch (compression_.type) {
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+    case ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_ZSTD): {
+      size_t bound = ZSTD_compressBound(insz);
+      if (len < bound) {
+        len = bound;
+        holder.reset(new unsigned char[len]);
+        buffer = reinterpret_cast<void *>(holder.get());
+      }
+
+      if (nullptr == tls_ctx.zstd_cctx) {
+        tls_ctx.zstd_cctx = ZSTD_createCCtx();
+        if (nullptr == tls_ctx.zstd_cctx) {
+          return error_code_t::EN_ECT_MALLOC;
+        }
+      }
+
+      size_t res;
+      if (compression_.use_dictionary && nullptr != compression_.shared_conf->zstd_cdict_) {
+        res = ZSTD_compress_usingCDict(tls_ctx.zstd_cctx, buffer, len, in, insz, compression_.shared_conf->zstd_cdict_);
+      } else {
+        res = ZSTD_compressCCtx(tls_ctx.zstd_cctx, buffer, len, in, insz, compression_.shared_conf->get_zstd_level());
+      }
+      if (ZSTD_isError(res)) {
+        ATFRAME_GATEWAY_ON_ERROR(static_cast<int>(ZSTD_getErrorCode(res)), "zstd compress data failed");
+        return error_code_t::EN_ECT_COMPRESSION_OPERATION;
+      }
+      len = res;
+      break;
+    }
+#endif
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+    case ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_LZ4): {
+      if (insz > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+        return error_code_t::EN_ECT_SUCCESS;
+      }
+
+      size_t bound = static_cast<size_t>(LZ4_compressBound(static_cast<int>(insz)));
+      if (len < bound) {
+        len = bound;
+        holder.reset(new unsigned char[len]);
+        buffer = reinterpret_cast<void *>(holder.get());
+      }
+
+      if (nullptr == tls_ctx.lz4_stream) {
+        tls_ctx.lz4_stream = LZ4_createStream();
+        if (nullptr == tls_ctx.lz4_stream) {
+          return error_code_t::EN_ECT_MALLOC;
+        }
+      }
+
+      int res;
+      if (compression_.use_dictionary && nullptr != compression_.shared_conf->lz4_dict_stream_) {
+        // copy the preloaded dictionary state is much cheaper than LZ4_loadDict for every message
+        memcpy(tls_ctx.lz4_stream, compression_.shared_conf->lz4_dict_stream_, sizeof(LZ4_stream_t));
+        res = LZ4_compress_fast_continue(tls_ctx.lz4_stream, reinterpret_cast<const char *>(in),
+                                         reinterpret_cast<char *>(buffer), static_cast<int>(insz),
+                                         static_cast<int>(len), 1);
+      } else {
+        res = LZ4_compress_fast_extState(tls_ctx.lz4_stream, reinterpret_cast<const char *>(in),
+                                         reinterpret_cast<char *>(buffer), static_cast<int>(insz),
+                                         static_cast<int>(len), 1);
+      }
+      if (res <= 0) {
+        ATFRAME_GATEWAY_ON_ERROR(res, "lz4 compress data failed");
+        return error_code_t::EN_ECT_COMPRESSION_OPERATION;
+      }
+      len = static_cast<size_t>(res);
+      break;
+    }
+#endif
+    default: {
+      (void)tls_ctx;
+      return error_code_t::EN_ECT_COMPRESSION_NOT_SUPPORTED;
+    }
+  }
+
+  // just send the origin data if it can not be compressed
+  if (len >= insz) {
+    return error_code_t::EN_ECT_SUCCESS;
+  }
+
+  compression_type = compression_.type;
+  out = buffer;
+  outsz = len;
+  return error_code_t::EN_ECT_SUCCESS;
+}
+
+int libatgw_protocol_sdk::decompress_data(compression_type_t compression_type, const void *in, size_t insz,
+                                          size_t originsz, const void *&out, size_t &outsz,
+                                          std::unique_ptr<unsigned char[]> &holder) {
+  if (compression_type == ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE)) {
+    out = in;
+    outsz = insz;
+    return error_code_t::EN_ECT_SUCCESS;
+  }
+
+  // only the compression type negotiated in handshake is allowed
+  if (!compression_.shared_conf || compression_type != compression_.type) {
+    ATFRAME_GATEWAY_ON_ERROR(static_cast<int>(compression_type), "compression type not negotiated");
+    return error_code_t::EN_ECT_COMPRESSION_NOT_SUPPORTED;
+  }
+
+  if (0 == originsz || originsz > ATFRAMEWORK_GATEWAY_MACRO_COMPRESSION_MAX_ORIGIN_SIZE || nullptr == in) {
+    return error_code_t::EN_ECT_INVALID_SIZE;
+  }
+
+  void *buffer = get_tls_buffer(tls_buffer_t::EN_TBT_ZIP);
+  size_t len = get_tls_length(tls_buffer_t::EN_TBT_ZIP);
+  if (len < originsz) {
+    len = originsz;
+    holder.reset(new unsigned char[len]);
+    buffer = reinterpret_cast<void *>(holder.get());
+  }
+
+  detail::compression_tls_context_t &tls_ctx = detail::compression_tls_context_t::get();
+  switch (compression_type) {
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+    case ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_ZSTD): {
+      if (nullptr == tls_ctx.zstd_dctx) {
+        tls_ctx.zstd_dctx = ZSTD_createDCtx();
+        if (nullptr == tls_ctx.zstd_dctx) {
+          return error_code_t::EN_ECT_MALLOC;
+        }
+      }
+
+      size_t res;
+      if (compression_.use_dictionary && nullptr != compression_.shared_conf->zstd_ddict_) {
+        res = ZSTD_decompress_usingDDict(tls_ctx.zstd_dctx, buffer, originsz, in, insz,
+                                         compression_.shared_conf->zstd_ddict_);
+      } else {
+        res = ZSTD_decompressDCtx(tls_ctx.zstd_dctx, buffer, originsz, in, insz);
+      }
+      if (ZSTD_isError(res) || res != originsz) {
+        ATFRAME_GATEWAY_ON_ERROR(static_cast<int>(ZSTD_getErrorCode(res)), "zstd decompress data failed");
+        return error_code_t::EN_ECT_COMPRESSION_OPERATION;
+      }
+      break;
+    }
+#endif
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+    case ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_LZ4): {
+      if (insz > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+        return error_code_t::EN_ECT_INVALID_SIZE;
+      }
+
+      int res;
+      if (compression_.use_dictionary && nullptr != compression_.shared_conf->lz4_dictionary_) {
+        res = LZ4_decompress_safe_usingDict(
+            reinterpret_cast<const char *>(in), reinterpret_cast<char *>(buffer), static_cast<int>(insz),
+            static_cast<int>(originsz), compression_.shared_conf->lz4_dictionary_,
+            static_cast<int>(compression_.shared_conf->lz4_dictionary_size_));
+      } else {
+        res = LZ4_decompress_safe(reinterpret_cast<const char *>(in), reinterpret_cast<char *>(buffer),
+                                  static_cast<int>(insz), static_cast<int>(originsz));
+      }
+      if (res < 0 || static_cast<size_t>(res) != originsz) {
+        ATFRAME_GATEWAY_ON_ERROR(res, "lz4 decompress data failed");
+        return error_code_t::EN_ECT_COMPRESSION_OPERATION;
+      }
+      break;
+    }
+#endif
+    default: {
+      (void)tls_ctx;
+      return error_code_t::EN_ECT_COMPRESSION_NOT_SUPPORTED;
+    }
+  }
+
+  out = buffer;
+  outsz = originsz;
+  return error_code_t::EN_ECT_SUCCESS;
+}
+
+int libatgw_protocol_sdk::setup_compression(const std::shared_ptr<detail::crypt_global_configure_t> &shared_conf,
+                                            compression_type_t type, uint32_t dictionary_id) {
+  compression_.shared_conf = shared_conf;
+  compression_.type = ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE);
+  compression_.use_dictionary = false;
+
+  if (type == ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE)) {
+    return error_code_t::EN_ECT_SUCCESS;
+  }
+
+  if (!shared_conf || !shared_conf->check_compression_type(type)) {
+    return error_code_t::EN_ECT_COMPRESSION_NOT_SUPPORTED;
+  }
+
+  compression_.type = type;
+  // the dictionary is used only when both sides loaded the same one
+  compression_.use_dictionary = 0 != dictionary_id && dictionary_id == shared_conf->compression_dictionary_id_;
+  return error_code_t::EN_ECT_SUCCESS;
+}
+
+flatbuffers::Offset<flatbuffers::Vector<uint8_t> > libatgw_protocol_sdk::pack_compression_types(
+    flatbuffers::FlatBufferBuilder &builder, const ::atframework::gw::v1::cs_body_handshake *peer_body,
+    uint32_t &dictionary_id) {
+  dictionary_id = 0;
+
+  // request: send all supported compression types by priority
+  if (nullptr == peer_body) {
+    std::shared_ptr<detail::crypt_global_configure_t> global_cfg = detail::crypt_global_configure_t::current();
+    if (!global_cfg || global_cfg->available_compression_types_.empty()) {
+      return 0;
+    }
+
+    std::vector<uint8_t> types;
+    types.reserve(global_cfg->available_compression_types_.size());
+    for (auto &compression_type : global_cfg->available_compression_types_) {
+      types.push_back(static_cast<uint8_t>(compression_type));
+    }
+    dictionary_id = global_cfg->compression_dictionary_id_;
+    return builder.CreateVector(types);
+  }
+
+  // response: select the first type supported by both sides, client's priority first
+  std::shared_ptr<detail::crypt_global_configure_t> shared_conf = crypt_handshake_->shared_conf;
+  if (!shared_conf) {
+    shared_conf = detail::crypt_global_configure_t::current();
+  }
+
+  compression_type_t selected_type =
+      ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE);
+  if (shared_conf && nullptr != peer_body->compression_type()) {
+    for (flatbuffers::uoffset_t i = 0; i < peer_body->compression_type()->size(); ++i) {
+      compression_type_t peer_type = static_cast<compression_type_t>(peer_body->compression_type()->Get(i));
+      if (shared_conf->check_compression_type(peer_type)) {
+        selected_type = peer_type;
+        break;
+      }
+    }
+  }
+
+  setup_compression(shared_conf, selected_type, peer_body->compression_dictionary_id());
+  if (compression_.type ==
+      ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE)) {
+    return 0;
+  }
+
+  if (compression_.use_dictionary) {
+    dictionary_id = shared_conf->compression_dictionary_id_;
+  }
+  uint8_t selected = static_cast<uint8_t>(compression_.type);
+  return builder.CreateVector(&selected, 1);
 }
 
 int libatgw_protocol_sdk::encrypt_data(crypt_session_t &crypt_info, const void *in, size_t insz, const void *&out,
@@ -2239,7 +3101,7 @@ LIBATGW_PROTOCOL_API int libatgw_protocol_sdk::global_reload(crypt_conf_t &crypt
 
   int ret = inst->init();
   if (0 == ret) {
-    detail::crypt_global_configure_t::current().swap(inst);
+    detail::crypt_global_configure_t::reset_current(inst);
   }
 
   return ret;
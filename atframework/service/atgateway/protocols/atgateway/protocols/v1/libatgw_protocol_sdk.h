@@ -5,7 +5,9 @@
 #pragma once
 
 #include <chrono>
+#include <deque>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "algorithm/crypto_cipher.h"
@@ -15,6 +17,7 @@
 #include "log/log_wrapper.h"
 
 #include "atgateway/protocols/libatgw_protocol_api.h"
+#include "atgateway/protocols/v1/libatgw_protocol_config.h"
 
 // MSVC hack
 #ifdef _MSC_VER
@@ -53,6 +56,19 @@ struct crypt_global_configure_t;
 
 class libatgw_protocol_sdk : public libatgw_protocol_api {
  public:
+  using compression_type_t = ATFRAMEWORK_GATEWAY_MACRO_ENUM_STORAGE_TYPE(::atframework::gw::v1, compression_type_t);
+
+  /**
+   * @brief compression configure
+   * @note data is compressed before encrypt, compression type and dictionary are negotiated during handshake
+   */
+  struct ATFW_UTIL_SYMBOL_VISIBLE compression_conf_t {
+    std::vector<compression_type_t> types; /** supported compression types, by priority. empty to disable **/
+    size_t threshold;                      /** data smaller than this size will not be compressed **/
+    int level;                             /** compression level, 0 means the default level of algorithm **/
+    std::string dictionary;                /** shared dictionary trained from messages, empty means not used **/
+  };
+
   /**
    * @brief crypt configure
    * @note default reuse the definition of inner protocol, if it's useful for other protocol depends other protocol's
@@ -74,6 +90,8 @@ class libatgw_protocol_sdk : public libatgw_protocol_api {
     std::string dh_param; /** DH parameter file path. **/
 
     bool client_mode; /** client mode, must be false in server when call global_reload(cfg) **/
+
+    compression_conf_t compression; /** compression configure **/
   };
 
   struct crypt_session_t {
@@ -97,6 +115,12 @@ class libatgw_protocol_sdk : public libatgw_protocol_api {
   };
   using crypt_session_ptr_t = std::shared_ptr<crypt_session_t>;
 
+  struct compression_session_t {
+    std::shared_ptr<detail::crypt_global_configure_t> shared_conf;
+    compression_type_t type;
+    bool use_dictionary;
+  };
+
   // ping/pong
   struct ATFW_UTIL_SYMBOL_VISIBLE ping_data_t {
     using clk_t = std::chrono::system_clock;
@@ -130,7 +154,8 @@ class libatgw_protocol_sdk : public libatgw_protocol_api {
 
   LIBATGW_PROTOCOL_API int pack_handshake_start_rsp(
       flatbuffers::FlatBufferBuilder &builder, uint64_t sess_id, std::string &crypt_type,
-      flatbuffers::Offset< ::atframework::gw::v1::cs_body_handshake> &handshake_body);
+      flatbuffers::Offset< ::atframework::gw::v1::cs_body_handshake> &handshake_body,
+      flatbuffers::Offset<flatbuffers::Vector<uint8_t> > compression_types, uint32_t compression_dictionary_id);
   LIBATGW_PROTOCOL_API int pack_handshake_dh_pubkey_req(
       flatbuffers::FlatBufferBuilder &builder, const ::atframework::gw::v1::cs_body_handshake &peer_body,
       flatbuffers::Offset< ::atframework::gw::v1::cs_body_handshake> &handshake_body,
@@ -139,6 +164,7 @@ class libatgw_protocol_sdk : public libatgw_protocol_api {
   LIBATGW_PROTOCOL_API int try_write();
   LIBATGW_PROTOCOL_API int write_msg(flatbuffers::FlatBufferBuilder &builder);
   LIBATGW_PROTOCOL_API int write(const void *buffer, size_t len) override;
+  LIBATGW_PROTOCOL_API int write_broadcast(const void *buffer, size_t len, broadcast_cache_t &cache) override;
   LIBATGW_PROTOCOL_API int write_done(int status) override;
 
   LIBATGW_PROTOCOL_API int close(int reason) override;
@@ -152,6 +178,13 @@ class libatgw_protocol_sdk : public libatgw_protocol_api {
   LIBATGW_PROTOCOL_API void set_recv_buffer_limit(size_t max_size, size_t max_number) override;
   LIBATGW_PROTOCOL_API void set_send_buffer_limit(size_t max_size, size_t max_number) override;
 
+  /**
+   * @brief set the limit of one vectored write, only available when write_vector_fn is set
+   * @param max_count max buffer count of one write, 0 means ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_COUNT
+   * @param max_size max bytes of one write, 0 means ATFRAMEWORK_GATEWAY_MACRO_WRITE_VECTOR_MAX_SIZE
+   */
+  LIBATGW_PROTOCOL_API void set_write_vector_limit(size_t max_count, size_t max_size);
+
   LIBATGW_PROTOCOL_API int handshake_update() override;
 
   LIBATGW_PROTOCOL_API std::string get_info() const override;
@@ -176,13 +209,37 @@ class libatgw_protocol_sdk : public libatgw_protocol_api {
 
   ATFW_UTIL_FORCEINLINE uint64_t get_session_id() const { return session_id_; }
 
+  ATFW_UTIL_FORCEINLINE compression_type_t get_compression_type() const { return compression_.type; }
+
   LIBATGW_PROTOCOL_API void set_logger(atfw::util::log::log_wrapper::ptr_t logger);
 
  private:
-  int encode_post(const void *in, size_t insz, const void *&out, size_t &outsz);
-  int decode_post(const void *in, size_t insz, const void *&out, size_t &outsz);
+  int pack_post(flatbuffers::FlatBufferBuilder &builder, ::atframework::gw::v1::cs_msg_type_t msg_type,
+                const void *buffer, size_t len);
+  int push_write_block(const void *header, size_t header_len, const void *buf, size_t len);
+
+  int encode_post(const void *in, size_t insz, const void *&out, size_t &outsz, size_t &plainsz,
+                  compression_type_t &compression_type, std::unique_ptr<unsigned char[]> &holder);
+  int decode_post(const void *in, size_t insz, size_t plainsz, compression_type_t compression_type, size_t originsz,
+                  const void *&out, size_t &outsz, std::unique_ptr<unsigned char[]> &holder);
+
+  int compress_data(const void *in, size_t insz, const void *&out, size_t &outsz,
+                    compression_type_t &compression_type, std::unique_ptr<unsigned char[]> &holder);
+  int decompress_data(compression_type_t compression_type, const void *in, size_t insz, size_t originsz,
+                      const void *&out, size_t &outsz, std::unique_ptr<unsigned char[]> &holder);
+
+  int setup_compression(const std::shared_ptr<detail::crypt_global_configure_t> &shared_conf,
+                        compression_type_t type, uint32_t dictionary_id);
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t> > pack_compression_types(
+      flatbuffers::FlatBufferBuilder &builder, const ::atframework::gw::v1::cs_body_handshake *peer_body,
+      uint32_t &dictionary_id);
 
   int encrypt_data(crypt_session_t &crypt_info, const void *in, size_t insz, const void *&out, size_t &outsz);
+
+  int try_write_vector();
+  void pop_write_block(size_t s);
+  bool acquire_read_head();
+  void release_read_head();
   int decrypt_data(crypt_session_t &crypt_info, const void *in, size_t insz, const void *&out, size_t &outsz);
 
  public:
@@ -196,12 +253,20 @@ class libatgw_protocol_sdk : public libatgw_protocol_api {
    *        当数据包比较小时和动态直接放在动态int的数据包一起，这样可以减少内存拷贝次数
    */
   struct read_head_t {
-    char buffer[ATFRAMEWORK_GATEWAY_MACRO_DATA_SMALL_SIZE];  // 小数据包存储区
-    size_t len;                                              // 小数据包存储区已使用长度
+    char *buffer;  // 小数据包存储区，从线程内共享的缓冲池分配，没有未处理完的数据时归还
+    size_t len;    // 小数据包存储区已使用长度
   };
   read_head_t read_head_;
 
   ::atbus::detail::buffer_manager write_buffers_;
+  /**
+   * @brief buffer_manager can not iterate blocks, so we keep the blocks in write_buffers_ by order here
+   *        and gather them for vectored write without copying
+   */
+  std::deque< ::atbus::detail::buffer_block *> write_blocks_;
+  std::vector<write_buffer_t> write_vector_;
+  size_t write_vector_max_count_;
+  size_t write_vector_max_size_;
   const void *last_write_ptr_;
   int close_reason_;
 
@@ -210,6 +275,9 @@ class libatgw_protocol_sdk : public libatgw_protocol_api {
   crypt_session_ptr_t crypt_write_;
   crypt_session_ptr_t crypt_handshake_;
 
+  // compression option
+  compression_session_t compression_;
+
   // ping data
   ping_data_t ping_;
 
@@ -16,12 +16,21 @@
 #include <type_traits>
 
 #include "config/atframe_service_types.h"
-#include "core/timestamp_id_allocator.h"
 
 #include "session_manager.h"
 
 namespace atframework {
 namespace gateway {
+namespace {
+static time_t session_get_now(const session_manager *mgr) noexcept {
+  if (nullptr != mgr) {
+    return mgr->get_now();
+  }
+
+  return atfw::util::time::time_utility::get_now();
+}
+}  // namespace
+
 #if defined(UTIL_CONFIG_COMPILER_CXX_STATIC_ASSERT) && UTIL_CONFIG_COMPILER_CXX_STATIC_ASSERT
 #  if ((defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)) ||                       \
       (defined(__cplusplus) && __cplusplus >= 201402L &&                        \
@@ -35,7 +44,15 @@ UTIL_CONFIG_STATIC_ASSERT(std::is_pod<session::limit_t>::value);
 #  endif
 #endif
 
-session::session() : id_(0), router_node_id_(0), owner_(nullptr), flags_(0), peer_port_(0), private_data_(nullptr) {
+session::session()
+    : id_(0),
+      router_node_id_(0),
+      owner_(nullptr),
+      flags_(0),
+      peer_port_(0),
+      private_data_(nullptr),
+      read_batch_(nullptr),
+      read_batch_count_(0) {
   memset(&limit_, 0, sizeof(limit_));
   raw_handle_.data = this;
 }
@@ -158,13 +175,11 @@ int session::accept_pipe(uv_stream_t *server) {
 }
 
 int session::init_new_session() {
-  static ::atframework::component::timestamp_id_allocator<id_t> id_alloc;
   // alloc id
-  id_ = id_alloc.allocate();
+  id_ = owner_->allocate_session_id();
   router_node_id_ = 0;
   router_node_name_.clear();
-  limit_.update_handshake_timepoint =
-      atfw::util::time::time_utility::get_now() + owner_->get_conf().crypt.update_interval;
+  limit_.update_handshake_timepoint = owner_->get_now() + owner_->get_conf().crypt.update_interval;
 
   set_flag(flag_t::EN_FT_INITED, true);
   return 0;
@@ -176,8 +191,7 @@ int session::init_reconnect(session &sess) {
   router_node_id_ = sess.router_node_id_;
   router_node_name_ = sess.router_node_name_;
   limit_ = sess.limit_;
-  limit_.update_handshake_timepoint =
-      atfw::util::time::time_utility::get_now() + owner_->get_conf().crypt.update_interval;
+  limit_.update_handshake_timepoint = owner_->get_now() + owner_->get_conf().crypt.update_interval;
 
   private_data_ = sess.private_data_;
 
@@ -256,9 +270,28 @@ void session::on_alloc_read(size_t suggested_size, char *&out_buf, size_t &out_l
 
 void session::on_read(int ssz, const char *buff, size_t len) {
   if (proto_) {
+    // 一次读回调里解出的所有消息合并成一个ss_msg发给服务器，减少总线上的包量
+    ::atframework::gw::ss_msg batch_msg;
+    bool use_batch = nullptr != owner_ && nullptr == read_batch_ &&
+                     owner_->get_conf().origin_conf.client().recv_batch_max_count() > 1;
+    ptr_t self_holder;
+    // owner_ will be reset if the session is closed in read callback, but messages received before should still be
+    // sent by the manager which owns this session
+    session_manager *batch_owner = owner_;
+    if (use_batch) {
+      self_holder = shared_from_this();
+      read_batch_ = &batch_msg;
+      read_batch_count_ = 0;
+    }
+
     int errcode = 0;
     proto_->read(ssz, buff, len, errcode);
 
+    if (use_batch) {
+      flush_read_batch(batch_owner);
+      read_batch_ = nullptr;
+    }
+
     if (errcode < 0) {
       FWLOGERROR("session {}:{} read data length={} failed and will be closed, res: {}", peer_ip_, peer_port_, len,
                  errcode);
@@ -330,7 +363,10 @@ int session::close_fd(int reason) {
   return 0;
 }
 
-int session::send_to_client(const void *data, size_t len) {
+int session::send_to_client(const void *data, size_t len) { return send_to_client(data, len, nullptr); }
+
+int session::send_to_client(const void *data, size_t len,
+                            atframework::gateway::libatgw_protocol_api::broadcast_cache_t *broadcast_cache) {
   // send to proto_
   if (check_flag(flag_t::EN_FT_CLOSING)) {
     return error_code_t::EN_ECT_CLOSING;
@@ -353,7 +389,12 @@ int session::send_to_client(const void *data, size_t len) {
   ++limit_.hour_send_times;
   ++limit_.minute_send_times;
 
-  int ret = proto_->write(data, len);
+  int ret;
+  if (nullptr != broadcast_cache) {
+    ret = proto_->write_broadcast(data, len, *broadcast_cache);
+  } else {
+    ret = proto_->write(data, len);
+  }
 
   check_hour_limit(false, true);
   check_minute_limit(false, true);
@@ -365,12 +406,6 @@ int session::send_to_client(const void *data, size_t len) {
 int session::send_to_server(::atframework::gw::ss_msg &msg) { return send_to_server(msg, owner_); }
 
 int session::send_to_server(::atframework::gw::ss_msg &msg, session_manager *mgr) {
-  // send to router_
-  if (0 == router_node_id_ && router_node_name_.empty()) {
-    FWLOGERROR("session {} has not configure router", id_);
-    return error_code_t::EN_ECT_INVALID_ROUTER;
-  }
-
   if (nullptr == mgr) {
     mgr = owner_;
   }
@@ -380,6 +415,15 @@ int session::send_to_server(::atframework::gw::ss_msg &msg, session_manager *mgr
     return error_code_t::EN_ECT_LOST_MANAGER;
   }
 
+  // 先发送已合并的数据，保证remove_session等消息在数据之后
+  flush_read_batch(mgr);
+
+  // send to router_, or let the main thread select one for worker shards
+  if (0 == router_node_id_ && router_node_name_.empty() && !mgr->is_shard_worker()) {
+    FWLOGERROR("session {} has not configure router", id_);
+    return error_code_t::EN_ECT_INVALID_ROUTER;
+  }
+
   // send to server with type = ::atframework::component::service_type::EN_ATST_GATEWAY
   std::string packed_buffer;
   if (false == msg.SerializeToString(&packed_buffer)) {
@@ -396,14 +440,8 @@ int session::send_to_server(::atframework::gw::ss_msg &msg, session_manager *mgr
   ++limit_.hour_recv_times;
   ++limit_.total_recv_times;
 
-  int ret;
-  if (0 != router_node_id_) {
-    ret = mgr->post_data(router_node_id_, ::atframework::component::service_type::EN_ATST_GATEWAY, packed_buffer.data(),
-                         len);
-  } else {
-    ret = mgr->post_data(router_node_name_, ::atframework::component::service_type::EN_ATST_GATEWAY,
-                         packed_buffer.data(), len);
-  }
+  int ret = mgr->post_session_data(id_, msg.body().cmd_case() == ::atframework::gw::ss_msg_body::kRemoveSession,
+                                   router_node_id_, router_node_name_, packed_buffer.data(), len);
 
   check_hour_limit(true, false);
   check_minute_limit(true, false);
@@ -412,6 +450,86 @@ int session::send_to_server(::atframework::gw::ss_msg &msg, session_manager *mgr
   return ret;
 }
 
+int session::post_to_server(const void *data, size_t len) {
+  if (nullptr != read_batch_) {
+    ::atframework::gw::ss_body_post *post = read_batch_->mutable_body()->mutable_post();
+    if (0 == read_batch_count_) {
+      read_batch_->mutable_head()->set_session_id(id_);
+      post->add_session_ids(id_);
+      post->set_content(data, len);
+    } else {
+      post->add_contents(data, len);
+    }
+    ++read_batch_count_;
+
+    if (nullptr != owner_ && read_batch_count_ >= owner_->get_conf().origin_conf.client().recv_batch_max_count()) {
+      return flush_read_batch(owner_);
+    }
+    return 0;
+  }
+
+  ::atframework::gw::ss_msg post_msg;
+  post_msg.mutable_head()->set_session_id(id_);
+
+  ::atframework::gw::ss_body_post *post = post_msg.mutable_body()->mutable_post();
+  if (nullptr != post) {
+    post->add_session_ids(id_);
+    post->set_content(data, len);
+  }
+
+  return post_message_to_server(post_msg, owner_);
+}
+
+int session::flush_read_batch(session_manager *mgr) {
+  if (nullptr == read_batch_ || 0 == read_batch_count_) {
+    return 0;
+  }
+
+  int ret;
+  if (nullptr == mgr) {
+    FWLOGERROR("session {} has lost manager, drop {} batched messages", id_, read_batch_count_);
+    ret = error_code_t::EN_ECT_LOST_MANAGER;
+  } else {
+    FWLOGDEBUG("session {} send {} messages to server in one batch", id_, read_batch_count_);
+    ret = post_message_to_server(*read_batch_, mgr);
+  }
+
+  // release the batched messages anyway, the batch message is only valid in current read callback
+  read_batch_->Clear();
+  read_batch_count_ = 0;
+  return ret;
+}
+
+int session::post_message_to_server(::atframework::gw::ss_msg &msg, session_manager *mgr) {
+  // sessions in worker shards must use their own manager
+  if (nullptr == mgr) {
+    FWLOGERROR("session {} send data failed, lost manager", id_);
+    return error_code_t::EN_ECT_LOST_MANAGER;
+  }
+
+  // send to router
+  if (0 != router_node_id_) {
+    FWLOGDEBUG("session {} send data to server {}({})", id_, router_node_id_, router_node_name_);
+    return mgr->post_data(router_node_id_, msg);
+  } else if (!router_node_name_.empty()) {
+    FWLOGDEBUG("session {} send data to server {}({})", id_, router_node_id_, router_node_name_);
+    return mgr->post_data(router_node_name_, msg);
+  } else if (mgr->is_shard_worker()) {
+    // the main thread will select default router
+    FWLOGDEBUG("session {} send data to server by default router", id_);
+
+    std::string packed_buffer;
+    if (false == msg.SerializeToString(&packed_buffer)) {
+      FWLOGERROR("session {} serialize failed and can not send ss message: {}", id_, msg.InitializationErrorString());
+      return error_code_t::EN_ECT_BAD_DATA;
+    }
+    return mgr->post_session_data(id_, false, 0, router_node_name_, packed_buffer.data(), packed_buffer.size());
+  }
+
+  FWLOGERROR("session {} send data failed, not router", id_);
+  return error_code_t::EN_ECT_INVALID_ROUTER;
+}
+
 atframework::gateway::libatgw_protocol_api *session::get_protocol_handle() { return proto_.get(); }
 const atframework::gateway::libatgw_protocol_api *session::get_protocol_handle() const { return proto_.get(); }
 
@@ -443,7 +561,7 @@ void session::on_evt_closed(uv_handle_t *handle) {
 }
 
 void session::check_hour_limit(bool check_recv, bool check_send) {
-  time_t now_hr = atfw::util::time::time_utility::get_now() / atfw::util::time::time_utility::DAY_SECONDS;
+  time_t now_hr = session_get_now(owner_) / atfw::util::time::time_utility::DAY_SECONDS;
   if (now_hr != limit_.hour_timepoint) {
     limit_.hour_timepoint = now_hr;
     limit_.hour_recv_bytes = 0;
@@ -483,7 +601,7 @@ void session::check_hour_limit(bool check_recv, bool check_send) {
 }
 
 void session::check_minute_limit(bool check_recv, bool check_send) {
-  time_t now_mi = atfw::util::time::time_utility::get_now() / atfw::util::time::time_utility::MINITE_SECONDS;
+  time_t now_mi = session_get_now(owner_) / atfw::util::time::time_utility::MINITE_SECONDS;
   if (now_mi != limit_.minute_timepoint) {
     limit_.minute_timepoint = now_mi;
     limit_.minute_recv_bytes = 0;
@@ -526,9 +644,8 @@ void session::check_minute_limit(bool check_recv, bool check_send) {
   }
 
   if (nullptr != owner_ && owner_->get_conf().crypt.update_interval > 0 && check_flag(flag_t::EN_FT_HAS_FD)) {
-    if (limit_.update_handshake_timepoint < atfw::util::time::time_utility::get_now()) {
-      limit_.update_handshake_timepoint =
-          atfw::util::time::time_utility::get_now() + owner_->get_conf().crypt.update_interval;
+    if (limit_.update_handshake_timepoint < owner_->get_now()) {
+      limit_.update_handshake_timepoint = owner_->get_now() + owner_->get_conf().crypt.update_interval;
       atframework::gateway::libatgw_protocol_api *proto = get_protocol_handle();
       if (nullptr != proto) {
         proto->handshake_update();
@@ -88,10 +88,22 @@ class session : public std::enable_shared_from_this<session> {
 
   int send_to_client(const void *data, size_t len);
 
+  int send_to_client(const void *data, size_t len,
+                     atframework::gateway::libatgw_protocol_api::broadcast_cache_t *broadcast_cache);
+
   int send_to_server(::atframework::gw::ss_msg &msg);
 
   int send_to_server(::atframework::gw::ss_msg &msg, session_manager *mgr);
 
+  /**
+   * @brief send data from client to the router server
+   * @note messages decoded in the same read callback are merged into one ss_msg when recv_batch_max_count > 1
+   * @param data message content
+   * @param len message length
+   * @return 0 or error code
+   */
+  int post_to_server(const void *data, size_t len);
+
   atframework::gateway::libatgw_protocol_api *get_protocol_handle();
   const atframework::gateway::libatgw_protocol_api *get_protocol_handle() const;
 
@@ -108,6 +120,10 @@ class session : public std::enable_shared_from_this<session> {
   static void on_evt_shutdown(uv_shutdown_t *req, int status);
   static void on_evt_closed(uv_handle_t *handle);
 
+  int flush_read_batch(session_manager *mgr);
+
+  int post_message_to_server(::atframework::gw::ss_msg &msg, session_manager *mgr);
+
   void check_hour_limit(bool check_recv, bool check_send);
   void check_minute_limit(bool check_recv, bool check_send);
   void check_total_limit(bool check_recv, bool check_send);
@@ -149,6 +165,10 @@ class session : public std::enable_shared_from_this<session> {
 
   std::unique_ptr<atframework::gateway::libatgw_protocol_api> proto_;
   void *private_data_;
+
+  // only available in on_read
+  ::atframework::gw::ss_msg *read_batch_;
+  size_t read_batch_count_;
 };
 }  // namespace gateway
 }  // namespace atframework
@@ -10,10 +10,12 @@
 
 #include <atframe/modules/etcd_module.h>
 
+#include <ctime>
 #include <new>
 #include <sstream>
 
 #include "config/atframe_service_types.h"
+#include "core/timestamp_id_allocator.h"
 
 #include "session_manager.h"
 
@@ -44,9 +46,39 @@ static T *session_manager_make_stream_ptr(std::shared_ptr<uv_stream_t> &res) {
   stream_conn->data = nullptr;
   return real_conn;
 }
+
+static int session_manager_enable_reuse_port(uv_tcp_t *handle) {
+#if defined(SO_REUSEPORT) && !defined(_WIN32)
+  uv_os_fd_t fd;
+  int res = uv_fileno(reinterpret_cast<uv_handle_t *>(handle), &fd);
+  if (0 != res) {
+    return res;
+  }
+
+  int opt = 1;
+  if (0 != setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt))) {
+    return uv_translate_sys_error(errno);
+  }
+  return 0;
+#else
+  (void)handle;
+  return UV_ENOTSUP;
+#endif
+}
+
+// keep enough sequence bits in session id, so that ids will not be exhausted in one second
+#ifndef ATFRAMEWORK_GATEWAY_MACRO_SHARD_MAX_BITS
+#  define ATFRAMEWORK_GATEWAY_MACRO_SHARD_MAX_BITS 8
+#endif
 }  // namespace
 
-session_manager::session_manager() : evloop_(nullptr), app_(nullptr), last_tick_time_(0), private_data_(nullptr) {}
+session_manager::session_manager()
+    : evloop_(nullptr),
+      app_(nullptr),
+      last_tick_time_(0),
+      private_data_(nullptr),
+      shard_index_(0),
+      shard_count_(1) {}
 
 session_manager::~session_manager() { reset(); }
 
@@ -61,6 +93,37 @@ int session_manager::init(::atfw::atapp::app *app_inst, create_proto_fn_t fn) {
   return 0;
 }
 
+int session_manager::init_shard(uv_loop_t *evloop, uint32_t shard_index, uint32_t shard_count, create_proto_fn_t fn,
+                                post_message_fn_t post_fn) {
+  if (nullptr == evloop || shard_index >= shard_count) {
+    FWLOGERROR("init session manager shard {}/{} with invalid parameters", shard_index, shard_count);
+    return error_code_t::EN_ECT_PARAM;
+  }
+
+  if (!fn || !post_fn) {
+    FWLOGERROR("{}", "create protocol function and post message function are required");
+    return error_code_t::EN_ECT_PARAM;
+  }
+
+  uint32_t shard_bits =
+      ::atframework::component::sharded_id_allocator<session::id_t>::get_shard_bits_by_count(shard_count);
+  if (shard_bits > ATFRAMEWORK_GATEWAY_MACRO_SHARD_MAX_BITS) {
+    FWLOGERROR("shard count {} is too large, at most {} shards are supported", shard_count,
+               static_cast<uint32_t>(1) << ATFRAMEWORK_GATEWAY_MACRO_SHARD_MAX_BITS);
+    return error_code_t::EN_ECT_PARAM;
+  }
+
+  // worker shard never access atapp directly, all messages to server are handed off to the main thread
+  evloop_ = evloop;
+  app_ = nullptr;
+  create_proto_fn_ = fn;
+  post_message_fn_ = post_fn;
+  shard_index_ = shard_index;
+  shard_count_ = shard_count;
+  shard_id_alloc_.reset(new ::atframework::component::sharded_id_allocator<session::id_t>(shard_index, shard_bits));
+  return 0;
+}
+
 int session_manager::listen_all() {
   int ret = 0;
   for (auto &listen_address : conf_.origin_conf.listen().address()) {
@@ -98,13 +161,27 @@ int session_manager::listen(const char *address) {
         break;
       }
 
-      libuv_res = uv_tcp_init(evloop_, tcp_handle);
+      // every shard listen the same address and the kernel will balance connections between them
+      if (shard_count_ > 1) {
+        libuv_res = uv_tcp_init_ex(evloop_, tcp_handle, '4' == addr.scheme[3] ? AF_INET : AF_INET6);
+      } else {
+        libuv_res = uv_tcp_init(evloop_, tcp_handle);
+      }
       if (0 != libuv_res) {
         FWLOGERROR("init listen to {} failed, libuv_res: {}({})", address, libuv_res, uv_strerror(libuv_res));
         ret = error_code_t::EN_ECT_NETWORK;
         break;
       }
 
+      if (shard_count_ > 1) {
+        libuv_res = session_manager_enable_reuse_port(tcp_handle);
+        if (0 != libuv_res) {
+          FWLOGERROR("set SO_REUSEPORT for {} failed, libuv_res: {}({})", address, libuv_res, uv_strerror(libuv_res));
+          ret = error_code_t::EN_ECT_NETWORK;
+          break;
+        }
+      }
+
       if ('4' == addr.scheme[3]) {
         sockaddr_in sock_addr;
         uv_ip4_addr(addr.host.c_str(), addr.port, &sock_addr);
@@ -148,6 +225,13 @@ int session_manager::listen(const char *address) {
       }
 
     } else if (0 == UTIL_STRFUNC_STRNCASE_CMP("unix", addr.scheme.c_str(), 4)) {
+      // unix socket can not be shared, only the first shard listen it
+      if (0 != shard_index_) {
+        FWLOGINFO("shard {} skip listening {}, unix socket is only listened by the first shard", shard_index_,
+                  address);
+        return 0;
+      }
+
       uv_pipe_t *pipe_handle = session_manager_make_stream_ptr<uv_pipe_t>(res);
       if (res) {
         uv_stream_set_blocking(res.get(), 0);
@@ -242,7 +326,7 @@ int session_manager::reset() {
 }
 
 int session_manager::tick() {
-  time_t now = atfw::util::time::time_utility::get_now();
+  time_t now = get_now();
   // 每秒只需要判定一次
   if (last_tick_time_ == now) {
     return 0;
@@ -253,9 +337,10 @@ int session_manager::tick() {
       now / atfw::util::time::time_utility::MINITE_SECONDS) {
     // std::list 在C++11以前可能是O(n)复杂度
     FWLOGINFO(
-        "[STAT] session manager: actived session {}, reconnect session {}, idle timer count {}, reconnect timer "
-        "count {}",
-        actived_sessions_.size(), reconnect_cache_.size(), first_idle_.size(), reconnect_timeout_.size());
+        "[STAT] session manager({}/{}): actived session {}, reconnect session {}, idle timer count {}, reconnect "
+        "timer count {}",
+        shard_index_, shard_count_, actived_sessions_.size(), reconnect_cache_.size(), first_idle_.size(),
+        reconnect_timeout_.size());
   }
   last_tick_time_ = now;
 
@@ -326,8 +411,7 @@ int session_manager::close(session::id_t sess_id, int reason, bool allow_reconne
     reconnect_timeout_.push_back(session_timeout_t());
     session_timeout_t &sess_timer = reconnect_timeout_.back();
     sess_timer.s = iter->second;
-    sess_timer.timeout =
-        atfw::util::time::time_utility::get_now() + conf_.origin_conf.client().reconnect_timeout().seconds();
+    sess_timer.timeout = get_now() + conf_.origin_conf.client().reconnect_timeout().seconds();
 
     reconnect_cache_[sess_timer.s->get_id()] = sess_timer.s;
     FWLOGINFO("session {:#x}({}) closed and setup reconnect timeout {}(+{})", sess_timer.s->get_id(),
@@ -368,6 +452,18 @@ int session_manager::post_data(::atbus::bus_id_t tid, int type, ::atframework::g
 }
 
 int session_manager::post_data(::atbus::bus_id_t tid, int type, const void *buffer, size_t s) {
+  if (post_message_fn_) {
+    std::unique_ptr<post_message_t> msg{new post_message_t()};
+    msg->target_id = tid;
+    msg->type = type;
+    msg->data.assign(reinterpret_cast<const char *>(buffer), s);
+    msg->session_id = 0;
+    msg->use_default_router = false;
+    msg->is_remove_session = false;
+    msg->shard_index = shard_index_;
+    return post_message_fn_(std::move(msg));
+  }
+
   // send to process
   if (nullptr == app_) {
     return error_code_t::EN_ECT_LOST_MANAGER;
@@ -392,6 +488,19 @@ int session_manager::post_data(const std::string &tname, int type, ::atframework
 }
 
 int session_manager::post_data(const std::string &tname, int type, const void *buffer, size_t s) {
+  if (post_message_fn_) {
+    std::unique_ptr<post_message_t> msg{new post_message_t()};
+    msg->target_id = 0;
+    msg->target_name = tname;
+    msg->type = type;
+    msg->data.assign(reinterpret_cast<const char *>(buffer), s);
+    msg->session_id = 0;
+    msg->use_default_router = false;
+    msg->is_remove_session = false;
+    msg->shard_index = shard_index_;
+    return post_message_fn_(std::move(msg));
+  }
+
   // send to process
   if (nullptr == app_) {
     return error_code_t::EN_ECT_LOST_MANAGER;
@@ -400,6 +509,29 @@ int session_manager::post_data(const std::string &tname, int type, const void *b
   return app_->send_message(tname, type, buffer, s);
 }
 
+int session_manager::post_session_data(session::id_t sess_id, bool is_remove_session, ::atbus::bus_id_t router_node_id,
+                                       const std::string &router_node_name, const void *buffer, size_t s) {
+  if (!post_message_fn_) {
+    if (0 != router_node_id) {
+      return post_data(router_node_id, ::atframework::component::service_type::EN_ATST_GATEWAY, buffer, s);
+    }
+    return post_data(router_node_name, ::atframework::component::service_type::EN_ATST_GATEWAY, buffer, s);
+  }
+
+  std::unique_ptr<post_message_t> msg{new post_message_t()};
+  msg->target_id = router_node_id;
+  if (0 == router_node_id) {
+    msg->target_name = router_node_name;
+  }
+  msg->type = ::atframework::component::service_type::EN_ATST_GATEWAY;
+  msg->data.assign(reinterpret_cast<const char *>(buffer), s);
+  msg->session_id = sess_id;
+  msg->use_default_router = 0 == router_node_id && router_node_name.empty();
+  msg->is_remove_session = is_remove_session;
+  msg->shard_index = shard_index_;
+  return post_message_fn_(std::move(msg));
+}
+
 int session_manager::push_data(session::id_t sess_id, const void *buffer, size_t s) {
   session_map_t::iterator iter = actived_sessions_.find(sess_id);
   if (actived_sessions_.end() == iter) {
@@ -411,9 +543,11 @@ int session_manager::push_data(session::id_t sess_id, const void *buffer, size_t
 
 int session_manager::broadcast_data(const void *buffer, size_t s) {
   int ret = error_code_t::EN_ECT_SESSION_NOT_FOUND;
+  // sessions with the same encoding share one encoded frame
+  libatgw_protocol_api::broadcast_cache_t broadcast_cache;
   for (session_map_t::iterator iter = actived_sessions_.begin(); iter != actived_sessions_.end(); ++iter) {
     if (iter->second->check_flag(session::flag_t::EN_FT_REGISTERED)) {
-      int res = iter->second->send_to_client(buffer, s);
+      int res = iter->second->send_to_client(buffer, s, &broadcast_cache);
       if (0 != res) {
         FWLOGERROR("broadcast data to session {} failed, res: {}", iter->first, res);
       }
@@ -427,6 +561,32 @@ int session_manager::broadcast_data(const void *buffer, size_t s) {
   return ret;
 }
 
+int session_manager::multicast_data(const session::id_t *sess_ids, size_t sess_count, const void *buffer, size_t s) {
+  if (nullptr == sess_ids) {
+    return error_code_t::EN_ECT_PARAM;
+  }
+
+  int ret = 0;
+  libatgw_protocol_api::broadcast_cache_t broadcast_cache;
+  for (size_t i = 0; i < sess_count; ++i) {
+    session_map_t::iterator iter = actived_sessions_.find(sess_ids[i]);
+    if (actived_sessions_.end() == iter) {
+      FWLOGDEBUG("multicast data to session {} skipped, session not found", sess_ids[i]);
+      continue;
+    }
+
+    int res = iter->second->send_to_client(buffer, s, &broadcast_cache);
+    if (0 != res) {
+      FWLOGERROR("multicast data to session {} failed, res: {}", iter->first, res);
+      if (0 == ret) {
+        ret = res;
+      }
+    }
+  }
+
+  return ret;
+}
+
 int session_manager::set_session_router(session::id_t sess_id, ::atbus::bus_id_t router_node_id,
                                         const std::string &router_node_name) {
   session_map_t::iterator iter = actived_sessions_.find(sess_id);
@@ -439,6 +599,14 @@ int session_manager::set_session_router(session::id_t sess_id, ::atbus::bus_id_t
 }
 
 int session_manager::reconnect(session &new_sess, session::id_t old_sess_id) {
+  // session can not be moved between worker threads
+  if (shard_count_ > 1 && get_shard_index(old_sess_id, shard_count_) != shard_index_) {
+    FWLOGINFO("session {}:{} try to reconnect {} which is owned by shard {}, but current shard is {}",
+              new_sess.get_peer_host(), new_sess.get_peer_port(), old_sess_id,
+              get_shard_index(old_sess_id, shard_count_), shard_index_);
+    return error_code_t::EN_ECT_REFUSE_RECONNECT;
+  }
+
   // find old session
   bool has_reconnect_checked = false;
   session_map_t::iterator iter = reconnect_cache_.find(old_sess_id);
@@ -522,6 +690,20 @@ int session_manager::active_session(session::ptr_t sess) {
 }
 
 void session_manager::assign_default_router(session &sess) const {
+  // worker shards can not access discovery, the main thread will select server when sending messages of it
+  if (post_message_fn_) {
+    sess.set_router(0, std::string());
+    return;
+  }
+
+  ::atbus::bus_id_t router_node_id = 0;
+  std::string router_node_name;
+  select_default_router(sess.get_id(), router_node_id, router_node_name);
+  sess.set_router(router_node_id, router_node_name);
+}
+
+void session_manager::select_default_router(session::id_t sess_id, ::atbus::bus_id_t &router_node_id,
+                                            std::string &router_node_name) const {
   bool by_setting = true;
   switch (conf_.origin_conf.client().default_router().policy()) {
     case ::atframework::gw::atgateway_router_policy::EN_ATGW_ROUTER_POLICY_RANDOM: {
@@ -531,7 +713,8 @@ void session_manager::assign_default_router(session &sess) const {
       auto select_node = app_->get_global_discovery().get_node_by_random(
           &conf_.origin_conf.client().default_router().policy_selector());
       if (select_node) {
-        sess.set_router(select_node->get_discovery_info().id(), select_node->get_discovery_info().name());
+        router_node_id = select_node->get_discovery_info().id();
+        router_node_name = select_node->get_discovery_info().name();
         by_setting = false;
       }
       break;
@@ -543,7 +726,8 @@ void session_manager::assign_default_router(session &sess) const {
       auto select_node = app_->get_global_discovery().get_node_by_round_robin(
           &conf_.origin_conf.client().default_router().policy_selector());
       if (select_node) {
-        sess.set_router(select_node->get_discovery_info().id(), select_node->get_discovery_info().name());
+        router_node_id = select_node->get_discovery_info().id();
+        router_node_name = select_node->get_discovery_info().name();
         by_setting = false;
       }
       break;
@@ -553,9 +737,10 @@ void session_manager::assign_default_router(session &sess) const {
         break;
       }
       auto select_node = app_->get_global_discovery().get_node_hash_by_consistent_hash(
-          sess.get_id(), &conf_.origin_conf.client().default_router().policy_selector());
+          sess_id, &conf_.origin_conf.client().default_router().policy_selector());
       if (select_node.node) {
-        sess.set_router(select_node.node->get_discovery_info().id(), select_node.node->get_discovery_info().name());
+        router_node_id = select_node.node->get_discovery_info().id();
+        router_node_name = select_node.node->get_discovery_info().name();
         by_setting = false;
       }
       break;
@@ -565,11 +750,33 @@ void session_manager::assign_default_router(session &sess) const {
   }
 
   if (by_setting) {
-    sess.set_router(conf_.origin_conf.client().default_router().node_id(),
-                    conf_.origin_conf.client().default_router().node_name());
+    router_node_id = conf_.origin_conf.client().default_router().node_id();
+    router_node_name = conf_.origin_conf.client().default_router().node_name();
   }
 }
 
+session::id_t session_manager::allocate_session_id() {
+  if (!shard_id_alloc_) {
+    static ::atframework::component::timestamp_id_allocator<session::id_t> id_alloc;
+    return id_alloc.allocate();
+  }
+
+  // every shard has its own allocator, which is only used in the shard's thread
+  return shard_id_alloc_->allocate(get_now());
+}
+
+time_t session_manager::get_now() const noexcept {
+  if (is_shard_worker()) {
+    return time(nullptr);
+  }
+
+  return atfw::util::time::time_utility::get_now();
+}
+
+uint32_t session_manager::get_shard_index(session::id_t sess_id, uint32_t shard_count) noexcept {
+  return ::atframework::component::sharded_id_allocator<session::id_t>::get_shard_index_by_count(sess_id, shard_count);
+}
+
 void session_manager::on_evt_accept_tcp(uv_stream_t *server, int status) {
   if (0 != status) {
     FWLOGERROR("accept tcp socket failed, status: {}", status);
@@ -626,8 +833,10 @@ void session_manager::on_evt_accept_tcp(uv_stream_t *server, int status) {
   }
 
   // check session number limit
+  // connections are balanced between shards, so every shard use the same part of max_client
   if (mgr->conf_.origin_conf.listen().max_client() > 0 &&
-      mgr->reconnect_cache_.size() + mgr->actived_sessions_.size() >= mgr->conf_.origin_conf.listen().max_client()) {
+      (mgr->reconnect_cache_.size() + mgr->actived_sessions_.size()) * mgr->shard_count_ >=
+          mgr->conf_.origin_conf.listen().max_client()) {
     FWLOGWARNING("accept tcp socket failed, gateway have too many sessions now");
     sess->close(close_reason_t::EN_CRT_SERVER_BUSY);
     return;
@@ -642,14 +851,13 @@ void session_manager::on_evt_accept_tcp(uv_stream_t *server, int status) {
   session_timeout_t &sess_timeout = mgr->first_idle_.back();
   sess_timeout.s = sess;
   if (mgr->conf_.origin_conf.client().first_idle_timeout().seconds() > 0) {
-    sess_timeout.timeout =
-        atfw::util::time::time_utility::get_now() + mgr->conf_.origin_conf.client().first_idle_timeout().seconds();
+    sess_timeout.timeout = mgr->get_now() + mgr->conf_.origin_conf.client().first_idle_timeout().seconds();
   } else {
-    sess_timeout.timeout = atfw::util::time::time_utility::get_now() + 1;
+    sess_timeout.timeout = mgr->get_now() + 1;
   }
   FWLOGINFO("accept a tcp socket({}:{}), create sesson {} and to wait for handshake now, expired time is {}(+{})",
             sess->get_peer_host(), sess->get_peer_port(), reinterpret_cast<const void *>(sess.get()),
-            sess_timeout.timeout, sess_timeout.timeout - atfw::util::time::time_utility::get_now());
+            sess_timeout.timeout, sess_timeout.timeout - mgr->get_now());
 }
 
 void session_manager::on_evt_accept_pipe(uv_stream_t *server, int status) {
@@ -704,8 +912,10 @@ void session_manager::on_evt_accept_pipe(uv_stream_t *server, int status) {
   }
 
   // check session number limit
+  // connections are balanced between shards, so every shard use the same part of max_client
   if (mgr->conf_.origin_conf.listen().max_client() > 0 &&
-      mgr->reconnect_cache_.size() + mgr->actived_sessions_.size() >= mgr->conf_.origin_conf.listen().max_client()) {
+      (mgr->reconnect_cache_.size() + mgr->actived_sessions_.size()) * mgr->shard_count_ >=
+          mgr->conf_.origin_conf.listen().max_client()) {
     sess->close(close_reason_t::EN_CRT_SERVER_BUSY);
     return;
   }
@@ -719,10 +929,9 @@ void session_manager::on_evt_accept_pipe(uv_stream_t *server, int status) {
   session_timeout_t &sess_timeout = mgr->first_idle_.back();
   sess_timeout.s = sess;
   if (mgr->conf_.origin_conf.client().first_idle_timeout().seconds() > 0) {
-    sess_timeout.timeout =
-        atfw::util::time::time_utility::get_now() + mgr->conf_.origin_conf.client().first_idle_timeout().seconds();
+    sess_timeout.timeout = mgr->get_now() + mgr->conf_.origin_conf.client().first_idle_timeout().seconds();
   } else {
-    sess_timeout.timeout = atfw::util::time::time_utility::get_now() + 1;
+    sess_timeout.timeout = mgr->get_now() + 1;
   }
 }
 
@@ -19,8 +19,12 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <memory>
+#include <string>
 #include <unordered_map>
 
+#include "core/sharded_id_allocator.h"
+
 #include "session.h"
 
 namespace atframework {
@@ -37,15 +41,44 @@ class session_manager {
     crypt_conf_t crypt;
   };
 
+  /**
+   * @brief message to send to server, worker shards hand off it to the main thread which owns the bus
+   */
+  struct post_message_t {
+    ::atbus::bus_id_t target_id;
+    std::string target_name;
+    int type;
+    std::string data;
+    // session which send this message, 0 if it's not sent by any session
+    session::id_t session_id;
+    // select target by default router policy in the main thread when both target_id and target_name are empty
+    bool use_default_router;
+    // remove session notify is the last message of a session
+    bool is_remove_session;
+    uint32_t shard_index;
+  };
+
   using session_map_t = std::unordered_map<session::id_t, session::ptr_t>;
   using create_proto_fn_t = std::function<std::unique_ptr< ::atframework::gateway::libatgw_protocol_api>()>;
   using on_create_session_fn_t = std::function<int(session *, uv_stream_t *)>;
+  using post_message_fn_t = std::function<int(std::unique_ptr<post_message_t> &&)>;
 
  public:
   session_manager();
   ~session_manager();
 
   int init(::atfw::atapp::app *app_inst, create_proto_fn_t fn);
+  /**
+   * @brief init as a worker shard, which run in its own event loop and thread
+   * @param evloop event loop of the worker thread
+   * @param shard_index index of this shard
+   * @param shard_count shard count
+   * @param fn function to create protocol object
+   * @param post_fn function to hand off messages to the main thread
+   * @return 0 or error code
+   */
+  int init_shard(uv_loop_t *evloop, uint32_t shard_index, uint32_t shard_count, create_proto_fn_t fn,
+                 post_message_fn_t post_fn);
   /**
    * @brief listen all address in configure
    * @return the number of listened address
@@ -68,8 +101,32 @@ class session_manager {
   int post_data(const std::string &tname, int type, ::atframework::gw::ss_msg &msg);
   int post_data(const std::string &tname, int type, const void *buffer, size_t s);
 
+  /**
+   * @brief send message of session to server
+   * @note in worker shards, the main thread will select server by default router policy if both router_node_id and
+   *       router_node_name are empty
+   * @param sess_id session id
+   * @param is_remove_session if it's the remove session notify, which is the last message of the session
+   * @param router_node_id target node id
+   * @param router_node_name target node name, only used when router_node_id is 0
+   * @param buffer packed message
+   * @param s message length
+   * @return 0 or error code
+   */
+  int post_session_data(session::id_t sess_id, bool is_remove_session, ::atbus::bus_id_t router_node_id,
+                        const std::string &router_node_name, const void *buffer, size_t s);
+
   int push_data(session::id_t sess_id, const void *buffer, size_t s);
   int broadcast_data(const void *buffer, size_t s);
+  /**
+   * @brief send the same data to a list of sessions
+   * @param sess_ids session id list
+   * @param sess_count session id count
+   * @param buffer data buffer
+   * @param s data length
+   * @return 0 or the first error code
+   */
+  int multicast_data(const session::id_t *sess_ids, size_t sess_count, const void *buffer, size_t s);
 
   int set_session_router(session::id_t sess_id, ::atbus::bus_id_t router_node_id, const std::string &router_node_name);
 
@@ -85,6 +142,40 @@ class session_manager {
 
   void assign_default_router(session &sess) const;
 
+  /**
+   * @brief select server by default router policy
+   * @param sess_id session id
+   * @param router_node_id output the selected node id
+   * @param router_node_name output the selected node name
+   */
+  void select_default_router(session::id_t sess_id, ::atbus::bus_id_t &router_node_id,
+                             std::string &router_node_name) const;
+
+  /**
+   * @brief allocate a new session id, the shard index is encoded in the low bits
+   * @return session id
+   */
+  session::id_t allocate_session_id();
+
+  /**
+   * @brief get current timestamp in seconds
+   * @note worker shards must not read the time cache of atapp, which is updated by the main thread
+   * @return current timestamp
+   */
+  time_t get_now() const noexcept;
+
+  inline uint32_t get_shard_index() const noexcept { return shard_index_; }
+  inline uint32_t get_shard_count() const noexcept { return shard_count_; }
+  inline bool is_shard_worker() const noexcept { return !!post_message_fn_; }
+
+  /**
+   * @brief get the index of shard which own the session
+   * @param sess_id session id
+   * @param shard_count shard count
+   * @return shard index
+   */
+  static uint32_t get_shard_index(session::id_t sess_id, uint32_t shard_count) noexcept;
+
  private:
   static void on_evt_accept_tcp(uv_stream_t *server, int status);
   static void on_evt_accept_pipe(uv_stream_t *server, int status);
@@ -112,6 +203,11 @@ class session_manager {
   std::list<session_timeout_t> reconnect_timeout_;
   time_t last_tick_time_;
   void *private_data_;
+
+  uint32_t shard_index_;
+  uint32_t shard_count_;
+  post_message_fn_t post_message_fn_;
+  std::unique_ptr<::atframework::component::sharded_id_allocator<session::id_t>> shard_id_alloc_;
 };
 }  // namespace gateway
 }  // namespace atframework
@@ -0,0 +1,165 @@
+// Copyright 2025 atframework
+//
+
+#include "session_shard.h"
+
+#include <log/log_wrapper.h>
+
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+// session manager only do its job once per second, so we need not tick too frequently
+#ifndef ATFRAMEWORK_GATEWAY_MACRO_SHARD_TICK_INTERVAL_MS
+#  define ATFRAMEWORK_GATEWAY_MACRO_SHARD_TICK_INTERVAL_MS 100
+#endif
+
+namespace atframework {
+namespace gateway {
+
+session_shard::session_shard(uint32_t shard_index, uint32_t shard_count)
+    : shard_index_(shard_index), shard_count_(shard_count), handle_closed_(true), running_(false) {
+  memset(&loop_, 0, sizeof(loop_));
+  memset(&async_handle_, 0, sizeof(async_handle_));
+  memset(&tick_timer_, 0, sizeof(tick_timer_));
+}
+
+session_shard::~session_shard() { stop(); }
+
+int session_shard::start(const session_manager::conf_t &conf, session_manager::create_proto_fn_t create_proto_fn,
+                         session_manager::on_create_session_fn_t on_create_session_fn,
+                         session_manager::post_message_fn_t post_fn) {
+  if (thread_.joinable()) {
+    return error_code_t::EN_ECT_BUSY;
+  }
+
+  std::promise<int> listen_result;
+  std::future<int> listen_future = listen_result.get_future();
+
+  // all handles are created and used in the worker thread
+  thread_ = std::thread([this, &conf, create_proto_fn, on_create_session_fn, post_fn, &listen_result]() {
+    run(conf, create_proto_fn, on_create_session_fn, post_fn, &listen_result);
+  });
+
+  int ret = listen_future.get();
+  if (ret <= 0) {
+    thread_.join();
+    return ret;
+  }
+
+  running_ = true;
+  return ret;
+}
+
+void session_shard::stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+
+  if (running_) {
+    // close all sessions and handles, the event loop will exit after all sessions are closed
+    post([this](session_manager &mgr) {
+      mgr.reset();
+      close_handles();
+    });
+    running_ = false;
+  }
+
+  thread_.join();
+}
+
+int session_shard::post(task_fn_t fn) {
+  if (!running_) {
+    return error_code_t::EN_ECT_CLOSING;
+  }
+
+  tasks_.push(std::move(fn));
+  uv_async_send(&async_handle_);
+  return 0;
+}
+
+void session_shard::run(const session_manager::conf_t &conf, session_manager::create_proto_fn_t create_proto_fn,
+                        session_manager::on_create_session_fn_t on_create_session_fn,
+                        session_manager::post_message_fn_t post_fn, std::promise<int> *listen_result) {
+  int res = uv_loop_init(&loop_);
+  if (0 != res) {
+    FWLOGERROR("shard {} init event loop failed, libuv_res: {}({})", shard_index_, res, uv_strerror(res));
+    listen_result->set_value(error_code_t::EN_ECT_NETWORK);
+    return;
+  }
+
+  uv_async_init(&loop_, &async_handle_, on_evt_async);
+  async_handle_.data = this;
+  uv_timer_init(&loop_, &tick_timer_);
+  tick_timer_.data = this;
+  handle_closed_ = false;
+
+  mgr_.get_conf() = conf;
+  mgr_.set_on_create_session(on_create_session_fn);
+  int ret = mgr_.init_shard(&loop_, shard_index_, shard_count_, create_proto_fn, post_fn);
+  if (0 == ret) {
+    ret = mgr_.listen_all();
+  }
+
+  if (ret > 0) {
+    uv_timer_start(&tick_timer_, on_evt_tick, ATFRAMEWORK_GATEWAY_MACRO_SHARD_TICK_INTERVAL_MS,
+                   ATFRAMEWORK_GATEWAY_MACRO_SHARD_TICK_INTERVAL_MS);
+    FWLOGINFO("shard {}/{} started and listened {} address(es)", shard_index_, shard_count_, ret);
+  } else {
+    FWLOGERROR("shard {}/{} listen failed, res: {}", shard_index_, shard_count_, ret);
+    mgr_.reset();
+    close_handles();
+  }
+
+  // conf and listen_result are not available after this
+  listen_result->set_value(ret);
+
+  uv_run(&loop_, UV_RUN_DEFAULT);
+
+  // tasks posted after closing will never be run
+  task_fn_t ignore;
+  while (tasks_.pop(ignore)) {
+  }
+
+  mgr_.cleanup();
+  uv_loop_close(&loop_);
+  FWLOGINFO("shard {}/{} stopped", shard_index_, shard_count_);
+}
+
+void session_shard::process_tasks() {
+  task_fn_t fn;
+  while (tasks_.pop(fn)) {
+    if (fn) {
+      fn(mgr_);
+    }
+  }
+}
+
+void session_shard::close_handles() {
+  if (handle_closed_) {
+    return;
+  }
+  handle_closed_ = true;
+
+  uv_timer_stop(&tick_timer_);
+  uv_close(reinterpret_cast<uv_handle_t *>(&tick_timer_), nullptr);
+  uv_close(reinterpret_cast<uv_handle_t *>(&async_handle_), nullptr);
+}
+
+void session_shard::on_evt_async(uv_async_t *handle) {
+  session_shard *self = reinterpret_cast<session_shard *>(handle->data);
+  assert(self);
+  if (nullptr != self) {
+    self->process_tasks();
+  }
+}
+
+void session_shard::on_evt_tick(uv_timer_t *handle) {
+  session_shard *self = reinterpret_cast<session_shard *>(handle->data);
+  assert(self);
+  if (nullptr != self) {
+    self->mgr_.tick();
+  }
+}
+}  // namespace gateway
+}  // namespace atframework
@@ -0,0 +1,87 @@
+// Copyright 2025 atframework
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "uv.h"
+
+#include "core/mpsc_queue.h"
+
+#include "session_manager.h"
+
+namespace atframework {
+namespace gateway {
+/**
+ * @brief a worker thread with its own event loop and session manager
+ * @note all sessions accepted by this shard are only accessed in the worker thread, the main thread can only access
+ *       them by post(task). messages to server are handed off to the main thread by post_message_fn_t.
+ */
+class session_shard {
+ public:
+  using task_fn_t = std::function<void(session_manager &)>;
+
+ public:
+  session_shard(uint32_t shard_index, uint32_t shard_count);
+  ~session_shard();
+
+  session_shard(const session_shard &) = delete;
+  session_shard &operator=(const session_shard &) = delete;
+
+  /**
+   * @brief start the worker thread and wait for listening finished
+   * @param conf configure of session manager
+   * @param create_proto_fn function to create protocol object
+   * @param on_create_session_fn callback when a session is created
+   * @param post_fn function to hand off messages to the main thread
+   * @return the number of listened address or error code
+   */
+  int start(const session_manager::conf_t &conf, session_manager::create_proto_fn_t create_proto_fn,
+            session_manager::on_create_session_fn_t on_create_session_fn, session_manager::post_message_fn_t post_fn);
+
+  /**
+   * @brief close all sessions and wait for the worker thread to exit
+   */
+  void stop();
+
+  /**
+   * @brief run task in the worker thread, can only be called in the main thread
+   * @param fn task
+   * @return 0 or error code
+   */
+  int post(task_fn_t fn);
+
+  inline uint32_t get_shard_index() const noexcept { return shard_index_; }
+
+ private:
+  void run(const session_manager::conf_t &conf, session_manager::create_proto_fn_t create_proto_fn,
+           session_manager::on_create_session_fn_t on_create_session_fn, session_manager::post_message_fn_t post_fn,
+           std::promise<int> *listen_result);
+
+  void process_tasks();
+  void close_handles();
+
+  static void on_evt_async(uv_async_t *handle);
+  static void on_evt_tick(uv_timer_t *handle);
+
+ private:
+  uint32_t shard_index_;
+  uint32_t shard_count_;
+
+  uv_loop_t loop_;
+  uv_async_t async_handle_;
+  uv_timer_t tick_timer_;
+  bool handle_closed_;
+
+  std::thread thread_;
+  bool running_;
+  ::atframework::component::mpsc_queue<task_fn_t> tasks_;
+  session_manager mgr_;
+};
+}  // namespace gateway
+}  // namespace atframework
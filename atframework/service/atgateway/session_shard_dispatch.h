@@ -0,0 +1,72 @@
+// Copyright 2026 atframework
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "atgateway/protocols/libatgw_server_protocol.h"
+
+#include "core/sharded_id_allocator.h"
+
+namespace atframework {
+namespace gateway {
+/**
+ * @brief how a message from server is dispatched to the shards which own the sessions
+ * @note it only decides the target shards, so it can be used without worker threads and event loops
+ */
+struct session_shard_dispatch_t {
+  using id_t = uint64_t;
+  using id_list_t = std::vector<id_t>;
+
+  enum class mode_t : int32_t {
+    kSingle = 0,     // only the shard at shard_index
+    kMulticast = 1,  // every shard with a non-null shard_sessions[i], with only its own sessions
+    kBroadcast = 2,  // every shard, with the whole message
+  };
+
+  mode_t mode = mode_t::kSingle;
+  uint32_t shard_index = 0;
+  // session id lists are shared by the tasks posted to shards, nullptr means the shard own none of the sessions
+  std::vector<std::shared_ptr<id_list_t>> shard_sessions;
+
+  /**
+   * @brief decide the target shards of a message
+   * @param msg message from server
+   * @param shard_count shard count, must be greater than 0
+   */
+  void build(const ::atframework::gw::ss_msg &msg, uint32_t shard_count) {
+    using allocator_type = ::atframework::component::sharded_id_allocator<id_t>;
+
+    shard_sessions.clear();
+    shard_index = 0;
+
+    if (::atframework::gw::ss_msg_body::kPost == msg.body().cmd_case() && msg.body().post().session_ids_size() > 0) {
+      // multicast, split session ids into shards
+      mode = mode_t::kMulticast;
+      shard_sessions.resize(shard_count);
+      for (auto &sess_id : msg.body().post().session_ids()) {
+        uint32_t index = allocator_type::get_shard_index_by_count(sess_id, shard_count);
+        if (!shard_sessions[index]) {
+          shard_sessions[index] = std::make_shared<id_list_t>();
+        }
+        shard_sessions[index]->push_back(sess_id);
+      }
+      return;
+    }
+
+    if (::atframework::gw::ss_msg_body::kPost == msg.body().cmd_case() && 0 == msg.head().session_id()) {
+      // broadcast, all shards share the same message
+      mode = mode_t::kBroadcast;
+      return;
+    }
+
+    mode = mode_t::kSingle;
+    shard_index = allocator_type::get_shard_index_by_count(msg.head().session_id(), shard_count);
+  }
+};
+}  // namespace gateway
+}  // namespace atframework
@@ -0,0 +1,85 @@
+// Copyright 2025 atframework.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <config/atframe_services_build_feature.h>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace atframework {
+namespace component {
+
+/**
+ * @brief lock-free multiple producer single consumer queue
+ * @note push can be called in any thread, but pop can only be called in one thread at the same time.
+ * @note pop may return false for a short time when a producer is just pushing, so producers should notify the consumer
+ *       after push(for example, by uv_async_send) and the consumer should try again when notified.
+ */
+template <typename T>
+class ATFRAME_SERVICE_COMPONENT_MACRO_API_HEAD_ONLY mpsc_queue {
+ public:
+  using value_type = T;
+
+ private:
+  struct node_type {
+    std::atomic<node_type *> next;
+    value_type value;
+
+    node_type() : next(nullptr), value() {}
+    explicit node_type(value_type &&v) : next(nullptr), value(std::move(v)) {}
+  };
+
+ public:
+  mpsc_queue() : head_(nullptr), tail_(nullptr) {
+    node_type *stub = new node_type();
+    head_.store(stub, std::memory_order_relaxed);
+    tail_ = stub;
+  }
+
+  ~mpsc_queue() {
+    value_type ignore;
+    while (pop(ignore)) {
+    }
+
+    delete tail_;
+  }
+
+  mpsc_queue(const mpsc_queue &) = delete;
+  mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+  void push(value_type &&v) {
+    node_type *n = new node_type(std::move(v));
+    node_type *prev = head_.exchange(n, std::memory_order_acq_rel);
+    prev->next.store(n, std::memory_order_release);
+  }
+
+  bool pop(value_type &out) {
+    node_type *tail = tail_;
+    node_type *next = tail->next.load(std::memory_order_acquire);
+    if (nullptr == next) {
+      return false;
+    }
+
+    out = std::move(next->value);
+    // next becomes the new stub node
+    next->value = value_type();
+    tail_ = next;
+    delete tail;
+    return true;
+  }
+
+  /**
+   * @brief check if queue is empty, can only be called in consumer's thread
+   */
+  bool empty() const { return nullptr == tail_->next.load(std::memory_order_acquire); }
+
+ private:
+  std::atomic<node_type *> head_;
+  node_type *tail_;
+};
+}  // namespace component
+}  // namespace atframework
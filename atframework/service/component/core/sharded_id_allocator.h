@@ -0,0 +1,123 @@
+// Copyright 2025 atframework.
+
+#pragma once
+
+#include <stdint.h>
+#include <ctime>
+
+#include <config/atframe_services_build_feature.h>
+
+namespace atframework {
+namespace component {
+
+/**
+ * @brief allocate ids in a shard, the shard index is encoded in the low bits
+ * @note layout from high bits to low bits: [timestamp][sequence][shard index].
+ *       every shard own its allocator and can only use it in its own thread, so no synchronization is needed.
+ *       if the sequence of current second is exhausted, we borrow the next second instead of wrapping sequence,
+ *       so ids allocated by one allocator are always increasing and never repeated.
+ */
+template <typename TKey = uint64_t>
+class ATFRAME_SERVICE_COMPONENT_MACRO_API_HEAD_ONLY sharded_id_allocator {
+ public:
+  using value_type = TKey;
+
+  static constexpr const value_type npos = 0; /** invalid key **/
+  static constexpr const uint32_t time_bits = sizeof(value_type) * 4;
+  static constexpr const uint32_t low_bits = sizeof(value_type) * 8 - time_bits;
+
+ public:
+  /**
+   * @brief constructor
+   * @param shard_index index of this shard, must be less than 2^shard_bits
+   * @param shard_bits bits used to store shard index, must be less than the sequence part
+   */
+  sharded_id_allocator(uint32_t shard_index, uint32_t shard_bits) noexcept
+      : shard_bits_(shard_bits < low_bits ? shard_bits : low_bits - 1),
+        shard_index_(static_cast<value_type>(shard_index) & ((static_cast<value_type>(1) << shard_bits_) - 1)),
+        last_time_(0),
+        last_sequence_(0) {}
+
+  /**
+   * @brief allocate a new id
+   * @param now current timestamp in seconds
+   * @return new id, never be npos
+   */
+  value_type allocate(time_t now) noexcept {
+    value_type time_part = static_cast<value_type>(now) & get_time_mask();
+    if (time_part > last_time_) {
+      last_time_ = time_part;
+      last_sequence_ = 0;
+    } else if (last_sequence_ >= get_max_sequence()) {
+      // sequence of this second is exhausted, borrow the next second
+      last_time_ = (last_time_ + 1) & get_time_mask();
+      last_sequence_ = 0;
+    } else {
+      ++last_sequence_;
+    }
+
+    value_type ret = (last_time_ << low_bits) | (last_sequence_ << shard_bits_) | shard_index_;
+    if (npos == ret) {
+      ++last_sequence_;
+      ret = (last_sequence_ << shard_bits_) | shard_index_;
+    }
+    return ret;
+  }
+
+  inline value_type get_max_sequence() const noexcept {
+    return (static_cast<value_type>(1) << (low_bits - shard_bits_)) - 1;
+  }
+
+  inline uint32_t get_shard_bits() const noexcept { return shard_bits_; }
+
+  /**
+   * @brief get the shard index encoded in a id
+   * @param id id allocated by sharded_id_allocator
+   * @param shard_bits bits used to store shard index
+   * @return shard index
+   */
+  static inline uint32_t get_shard_index(value_type id, uint32_t shard_bits) noexcept {
+    if (0 == shard_bits) {
+      return 0;
+    }
+    return static_cast<uint32_t>(id & ((static_cast<value_type>(1) << shard_bits) - 1));
+  }
+
+  /**
+   * @brief get the minimal bits to store shard index of shard_count shards
+   * @param shard_count shard count
+   * @return bits used to store shard index
+   */
+  static inline uint32_t get_shard_bits_by_count(uint32_t shard_count) noexcept {
+    uint32_t ret = 0;
+    while (ret < 32 && (static_cast<uint32_t>(1) << ret) < shard_count) {
+      ++ret;
+    }
+    return ret;
+  }
+
+  /**
+   * @brief get the shard index encoded in a id by shard count
+   * @param id id allocated by sharded_id_allocator
+   * @param shard_count shard count
+   * @return shard index, always less than shard_count
+   */
+  static inline uint32_t get_shard_index_by_count(value_type id, uint32_t shard_count) noexcept {
+    if (shard_count <= 1) {
+      return 0;
+    }
+
+    return get_shard_index(id, get_shard_bits_by_count(shard_count)) % shard_count;
+  }
+
+ private:
+  static constexpr value_type get_time_mask() noexcept { return (static_cast<value_type>(1) << time_bits) - 1; }
+
+ private:
+  uint32_t shard_bits_;
+  value_type shard_index_;
+  value_type last_time_;
+  value_type last_sequence_;
+};
+}  // namespace component
+}  // namespace atframework
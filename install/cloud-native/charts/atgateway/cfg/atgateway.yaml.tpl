@@ -9,6 +9,7 @@ atgateway:
     type: inner                     # protocol type
     max_client: 65536               # max client number, more client will be closed
     backlog: 128
+    worker_threads: 0               # worker threads to run sessions, 0 means run in main thread
 
   client:
     default_router:
@@ -18,6 +19,7 @@ atgateway:
     send_buffer_size: 4MB           # send buffer limit
     reconnect_timeout: 180          # reconnect timeout
     first_idle_timeout: 10          # first idle timeout
+    recv_batch_max_count: 0         # max messages in one read to merge into one upstream message, 0 or 1 to disable
     limit:
       total_send_bytes: 0           # total send limit (bytes)
       total_recv_bytes: 0           # total recv limit (bytes)
@@ -37,4 +39,10 @@ atgateway:
       key: gateway-default                          # default key
       type: "XXTEA:AES-256-CFB:AES-128-CFB"         # encrypt algorithm(support XXTEA,AES when listen.type=inner)
       update_interval: 300                          # generate a new key by every 5 minutes
-      dhparam: ../cfg/dhparam.pem                   # dynamic key
\ No newline at end of file
+      dhparam: ../cfg/dhparam.pem                   # dynamic key
+    # compress data before encrypt, compression type is negotiated with client when listen.type=inner
+    compression:
+      type: ""                                      # compression algorithms by priority(zstd,lz4), empty to disable
+      threshold: 512                                # message smaller than this size will not be compressed
+      level: 0                                      # zstd compression level, 0 means default level
+      dictionary: ""                                # shared dictionary file, used only when client has the same one
\ No newline at end of file
@@ -12,7 +12,13 @@ ranksvr-ranking:
   rank_tree_degree: {{ .Values.rank_tree_degree}}
   rank_save_interval: {{ .Values.rank_save_interval}}
   rank_btree_degree: {{ .Values.rank_btree_degree}}
+  rank_mirror_load_pipeline_num: {{ .Values.rank_mirror_load_pipeline_num}}
+  rank_mirror_delta_max_percent: {{ .Values.rank_mirror_delta_max_percent}}
+  rank_slave_max_stale_duration: {{ .Values.rank_slave_max_stale_duration}}
   pushlisher_congihure:
     gc_expire_duration:  {{ .Values.pushlisher_congihure.rank_save_interval}}
     gc_log_size:  {{ .Values.pushlisher_congihure.rank_save_interval}}
-    max_log_size:  {{ .Values.pushlisher_congihure.rank_save_interval}}
\ No newline at end of file
+    max_log_size:  {{ .Values.pushlisher_congihure.rank_save_interval}}
+    broadcast_interval: {{ .Values.pushlisher_congihure.broadcast_interval }}
+    broadcast_max_log_count: {{ .Values.pushlisher_congihure.broadcast_max_log_count }}
+    max_unconfirmed_log_count: {{ .Values.pushlisher_congihure.max_unconfirmed_log_count }}
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <protocol/config/com.const.config.pb.h>
 #include <protocol/config/com.struct.rank.config.pb.h>
 #include <protocol/pbdesc/com.const.pb.h>
+#include <protocol/pbdesc/com.struct.rank.pb.h>
 #include <protocol/pbdesc/svr.const.err.pb.h>
 
 #include <config/compiler/protobuf_suffix.h>
@@ -398,7 +399,9 @@ RANK_SDK_API rpc::rpc_result<rank_ret_t> logic_rank_handle_self_impl::get_top_ra
     ret = RPC_AWAIT_TYPE_RESULT(
         rpc::rank::get_top_from_mirror(ctx, *rank, zone_id_, start, count, image->mirror_id(), output));
   } else {
-    ret = RPC_AWAIT_TYPE_RESULT(rpc::rank::get_top(ctx, *rank, start, count, output));
+    ret = RPC_AWAIT_TYPE_RESULT(
+        rpc::rank::get_top(ctx, *rank, start, count, output,
+                           logic_config::me()->get_server_cfg().rank().query_max_staleness_version()));
   }
 
   if (ret != 0) {
@@ -442,6 +445,46 @@ RANK_SDK_API rpc::rpc_result<rank_ret_t> logic_rank_handle_self_impl::upload_sco
   RPC_RETURN_TYPE(rank_ret_t(ret));
 }
 
+RANK_SDK_API rpc::rpc_result<rank_ret_t> logic_rank_handle_self_impl::batch_upload_score(
+    rpc::context& ctx, const logic_rank_handle_key& key, gsl::span<const logic_rank_batch_upload_data> scores,
+    std::vector<int32_t>* results) {
+  if (nullptr != results) {
+    results->clear();
+  }
+  if (scores.empty()) {
+    RPC_RETURN_TYPE(rank_ret_t(0));
+  }
+
+  rpc::context::message_holder<PROJECT_NAMESPACE_ID::DRankKey> rank{ctx};
+  rank->set_rank_type(key.get_rank_type());
+  rank->set_rank_instance_id(key.get_instance_id());
+  rank->set_sub_rank_type(key.get_sub_rank_type());
+  rank->set_sub_rank_instance_id(key.get_sub_instance_id());
+
+  google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore> updates;
+  updates.Reserve(static_cast<int>(scores.size()));
+  for (auto& unit : scores) {
+    PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore* update = updates.Add();
+    if (nullptr == update) {
+      RPC_RETURN_TYPE(rank_ret_t(PROJECT_NAMESPACE_ID::err::EN_SYS_MALLOC));
+    }
+    gsl::string_view openid = unit.openid;
+    fetch_current_rank_key(openid, zone_id_, *update->mutable_user_key());
+    fetch_self_rank_custom_data(unit.callback_data, unit.user_extend_data, *update->mutable_custom_data());
+    update->set_score(unit.score);
+  }
+
+  uint32_t update_count = 0;
+  auto ret = RPC_AWAIT_TYPE_RESULT(rpc::rank::batch_update_score(ctx, *rank, updates, &update_count, results));
+  if (ret != 0) {
+    FWLOGERROR("batch_upload_score {},{},{},{} with {} users failed, updated {}, res: {}({})", world_id_, zone_id_,
+               key.get_rank_type(), key.get_instance_id(), scores.size(), update_count, ret,
+               protobuf_mini_dumper_get_error_msg(ret));
+  }
+
+  RPC_RETURN_TYPE(rank_ret_t(ret));
+}
+
 RANK_SDK_API rpc::rpc_result<rank_ret_t> logic_rank_handle_self_impl::clear_all(
     rpc::context& ctx, const logic_rank_handle_key& key, PROJECT_NAMESPACE_ID::DRankImageData* /*image*/) {
   rpc::context::message_holder<PROJECT_NAMESPACE_ID::DRankKey> rank{ctx};
@@ -537,7 +580,9 @@ RANK_SDK_API rpc::rpc_result<rank_ret_t> logic_rank_handle_self_impl::get_specia
 
   rpc::context::message_holder<PROJECT_NAMESPACE_ID::DRankUserBoardData> board_data{ctx};
 
-  auto ret = RPC_AWAIT_TYPE_RESULT(rpc::rank::get_special_one(ctx, *user_rank_key, *rank, *board_data));
+  auto ret = RPC_AWAIT_TYPE_RESULT(
+      rpc::rank::get_special_one(ctx, *user_rank_key, *rank, *board_data,
+                                 logic_config::me()->get_server_cfg().rank().query_max_staleness_version()));
   if (ret) {
     RPC_RETURN_TYPE(rank_ret_t(ret));
   }
@@ -660,6 +705,12 @@ RANK_SDK_API rpc::rpc_result<rank_ret_t> logic_rank_handle_variant::upload_score
   return delegate_->upload_score(ctx, key, openid, score, callback_data, user_extend_data);
 }
 
+RANK_SDK_API rpc::rpc_result<rank_ret_t> logic_rank_handle_variant::batch_upload_score(
+    rpc::context& ctx, const logic_rank_handle_key& key, gsl::span<const logic_rank_batch_upload_data> scores,
+    std::vector<int32_t>* results) {
+  return delegate_->batch_upload_score(ctx, key, scores, results);
+}
+
 RANK_SDK_API rpc::rpc_result<rank_ret_t> logic_rank_handle_variant::clear_all(
     rpc::context& ctx, const logic_rank_handle_key& key, PROJECT_NAMESPACE_ID::DRankImageData* image) {
   return delegate_->clear_all(ctx, key, image);
@@ -69,6 +69,16 @@ struct logic_rank_user_extend_span {
   inline logic_rank_user_extend_span() : sort_fields({}), ext_fields({}) {}
 };
 
+// 批量上报的单个玩家数据
+struct logic_rank_batch_upload_data {
+  gsl::string_view openid;
+  uint32_t score;
+  rank_callback_private_data callback_data;
+  logic_rank_user_extend_span user_extend_data;
+
+  inline logic_rank_batch_upload_data() : score(0), callback_data{} {}
+};
+
 
 
 std::string rank_user_key_to_openid(uint32_t user_zone_id, uint64_t user_id, int32_t instance_type, int64_t instance_id);
@@ -210,6 +220,14 @@ class logic_rank_handle_decl {
       const rank_callback_private_data& callback_data,
       logic_rank_user_extend_span user_extend_data = {}) = 0;
 
+  /**
+   * @brief 批量上报分数，一次RPC完成，同一个玩家出现多次时以最后一次为准
+   * @param results 输出和scores一一对应的错误码，不需要时传nullptr。RPC失败时为空
+   */
+  virtual rpc::rpc_result<rank_ret_t> batch_upload_score(rpc::context& ctx, const logic_rank_handle_key& key,
+                                                         gsl::span<const logic_rank_batch_upload_data> scores,
+                                                         std::vector<int32_t>* results = nullptr) = 0;
+
   virtual rpc::rpc_result<rank_ret_t> clear_all(rpc::context& ctx, const logic_rank_handle_key& key,
                                                              PROJECT_NAMESPACE_ID::DRankImageData* image = nullptr) = 0;
 
@@ -270,6 +288,10 @@ class logic_rank_handle_self_impl : public logic_rank_handle_decl {
       const rank_callback_private_data& callback_data,
       logic_rank_user_extend_span user_extend_data = {}) override;
 
+  EXPLICIT_NODISCARD_ATTR RANK_SDK_API rpc::rpc_result<rank_ret_t> batch_upload_score(
+      rpc::context& ctx, const logic_rank_handle_key& key, gsl::span<const logic_rank_batch_upload_data> scores,
+      std::vector<int32_t>* results = nullptr) override;
+
   EXPLICIT_NODISCARD_ATTR RANK_SDK_API rpc::rpc_result<rank_ret_t> clear_all(
       rpc::context& ctx, const logic_rank_handle_key& key,
       PROJECT_NAMESPACE_ID::DRankImageData* image = nullptr) override;
@@ -340,6 +362,10 @@ class logic_rank_handle_variant {
       rpc::context& ctx, const logic_rank_handle_key& key, gsl::string_view openid, uint32_t score,
       const rank_callback_private_data& callback_data, logic_rank_user_extend_span user_extend_data = {});
 
+  EXPLICIT_NODISCARD_ATTR RANK_SDK_API rpc::rpc_result<rank_ret_t> batch_upload_score(
+      rpc::context& ctx, const logic_rank_handle_key& key, gsl::span<const logic_rank_batch_upload_data> scores,
+      std::vector<int32_t>* results = nullptr);
+
   EXPLICIT_NODISCARD_ATTR RANK_SDK_API rpc::rpc_result<rank_ret_t> clear_all(
       rpc::context& ctx, const logic_rank_handle_key& key, PROJECT_NAMESPACE_ID::DRankImageData* image = nullptr);
 
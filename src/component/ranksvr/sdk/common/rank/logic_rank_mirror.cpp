@@ -0,0 +1,84 @@
+#include "rank/logic_rank_mirror.h"
+
+RANK_SDK_API bool logic_rank_select_delta_base_mirror(
+    const PROJECT_NAMESPACE_ID::table_rank_mirror_meta_data& meta_data, bool has_running_full_mirror,
+    PROJECT_NAMESPACE_ID::rank_mirror_meta_info& base_mirror) {
+  const PROJECT_NAMESPACE_ID::rank_mirror_meta_info& last_mirror = meta_data.last_save_mirror();
+  if (last_mirror.mirror_id() <= 0) {
+    return false;
+  }
+
+  // 变化的玩家是从最后创建的全量镜像开始记录的，这个镜像保存完成之前不能生成增量
+  if (has_running_full_mirror) {
+    return false;
+  }
+
+  if (last_mirror.base_mirror_id() > 0) {
+    base_mirror.set_mirror_id(last_mirror.base_mirror_id());
+    base_mirror.set_max_slice_count(last_mirror.base_max_slice_count());
+  } else {
+    // 非定时保存的全量镜像之后会放到success_mirror中
+    if (!last_mirror.is_normal_save()) {
+      return false;
+    }
+    base_mirror.set_mirror_id(last_mirror.mirror_id());
+    base_mirror.set_max_slice_count(last_mirror.max_slice_count());
+  }
+  base_mirror.set_is_normal_save(true);
+
+  for (auto& success_mirror : meta_data.success_mirror()) {
+    if (success_mirror.mirror_id() == base_mirror.mirror_id()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+RANK_SDK_API bool logic_rank_commit_mirror_meta(PROJECT_NAMESPACE_ID::table_rank_mirror_meta_data& meta_data,
+                                                int64_t& last_data_version,
+                                                const PROJECT_NAMESPACE_ID::rank_mirror_meta_info& new_mirror,
+                                                int64_t data_version) {
+  if (data_version < last_data_version) {
+    // 更新的镜像已经先保存完成了，这个镜像不再作为最新的镜像
+    if (new_mirror.is_normal_save()) {
+      protobuf_copy_message(*meta_data.add_removing_mirror(), new_mirror);
+    } else {
+      protobuf_copy_message(*meta_data.add_success_mirror(), new_mirror);
+    }
+    return false;
+  }
+
+  const PROJECT_NAMESPACE_ID::rank_mirror_meta_info& last_mirror = meta_data.last_save_mirror();
+  if (last_mirror.mirror_id() > 0) {
+    if (last_mirror.is_normal_save()) {
+      // 直接remove，新的增量镜像依赖的全量镜像除外
+      if (last_mirror.mirror_id() != new_mirror.base_mirror_id()) {
+        protobuf_copy_message(*meta_data.add_removing_mirror(), last_mirror);
+      }
+    } else {
+      // 放到success_mirror里面
+      protobuf_copy_message(*meta_data.add_success_mirror(), last_mirror);
+    }
+
+    // 上一个增量镜像依赖的全量镜像已经没有用了
+    if (last_mirror.base_mirror_id() > 0 && last_mirror.base_mirror_id() != new_mirror.base_mirror_id()) {
+      bool is_success_mirror = false;
+      for (auto& success_mirror : meta_data.success_mirror()) {
+        if (success_mirror.mirror_id() == last_mirror.base_mirror_id()) {
+          is_success_mirror = true;
+          break;
+        }
+      }
+      if (!is_success_mirror) {
+        auto base_mirror = meta_data.add_removing_mirror();
+        base_mirror->set_mirror_id(last_mirror.base_mirror_id());
+        base_mirror->set_max_slice_count(last_mirror.base_max_slice_count());
+        base_mirror->set_is_normal_save(true);
+      }
+    }
+  }
+
+  protobuf_copy_message(*meta_data.mutable_last_save_mirror(), new_mirror);
+  last_data_version = data_version;
+  return true;
+}
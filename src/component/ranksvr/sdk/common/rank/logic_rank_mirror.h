@@ -0,0 +1,110 @@
+#pragma once
+
+#include <config/compile_optimize.h>
+
+// clang-format off
+#include <config/compiler/protobuf_prefix.h>
+// clang-format on
+
+#include <protocol/pbdesc/com.struct.rank.pb.h>
+#include <protocol/pbdesc/svr.struct.rank.pb.h>
+
+// clang-format off
+#include <config/compiler/protobuf_suffix.h>
+// clang-format on
+
+#include <utility/protobuf_mini_dumper.h>
+
+#include <stdint.h>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "config/server_frame_build_feature.h"
+
+#include "rank/logic_rank_tree.h"
+
+/**
+ * @brief 选择增量镜像依赖的全量镜像
+ * @note 变化的玩家是从最后创建的全量镜像开始记录的，
+ *       只有最后保存的镜像是这个全量镜像或者依赖它的增量镜像时才能生成增量。
+ *       success_mirror中的镜像给其他服务使用，可能会被淘汰，不能作为增量镜像的基准
+ * @param meta_data 镜像元数据
+ * @param has_running_full_mirror 是否有正在保存的全量镜像
+ * @param base_mirror 输出依赖的全量镜像
+ * @return 可以生成增量镜像时返回true
+ */
+RANK_SDK_API bool logic_rank_select_delta_base_mirror(
+    const PROJECT_NAMESPACE_ID::table_rank_mirror_meta_data& meta_data, bool has_running_full_mirror,
+    PROJECT_NAMESPACE_ID::rank_mirror_meta_info& base_mirror);
+
+/**
+ * @brief 镜像保存完成后更新镜像元数据，不再使用的镜像放入removing_mirror，非定时保存的镜像放入success_mirror
+ * @param meta_data 镜像元数据
+ * @param last_data_version 最后一次成功保存的镜像数据版本号，新镜像成为最新的镜像时更新
+ * @param new_mirror 保存完成的镜像
+ * @param data_version 保存完成的镜像的数据版本号
+ * @return 新镜像成为最新的镜像时返回true，更新的镜像已经先保存完成时返回false
+ */
+RANK_SDK_API bool logic_rank_commit_mirror_meta(PROJECT_NAMESPACE_ID::table_rank_mirror_meta_data& meta_data,
+                                                int64_t& last_data_version,
+                                                const PROJECT_NAMESPACE_ID::rank_mirror_meta_info& new_mirror,
+                                                int64_t data_version);
+
+/**
+ * @brief 把增量镜像中变化过的玩家导出到镜像数据
+ * @param delta_data 变化过的玩家，空指针表示玩家已经下榜
+ * @param offset 起始下标
+ * @param max_count 最多导出的数量
+ * @param output 输出
+ * @return 实际导出的数量
+ */
+template <class TValuePtr>
+size_t logic_rank_dump_mirror_delta(
+    const std::vector<std::pair<PROJECT_NAMESPACE_ID::DRankUserKey, TValuePtr>>& delta_data, size_t offset,
+    size_t max_count, PROJECT_NAMESPACE_ID::table_rank_blob_data& output) {
+  size_t count = 0;
+  for (; count < max_count && offset + count < delta_data.size(); ++count) {
+    auto& delta = delta_data[offset + count];
+    if (delta.second) {
+      protobuf_copy_message(*output.add_data()->mutable_data(), *delta.second);
+    } else {
+      protobuf_copy_message(*output.add_removed_users(), delta.first);
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief 把增量镜像应用到已经恢复的全量镜像上
+ * @note 增量镜像的多个分片之间没有顺序，应用过程中不按容量移除数据，否则下榜的玩家还没删除时可能会挤掉其他玩家。
+ *       所有分片应用完成后的数据不会超过容量
+ * @param tree 排行榜B树
+ * @param index 玩家key到榜单数据的索引
+ * @param delta 增量镜像数据
+ * @param on_change 每个变化的玩家的回调，参数为玩家key
+ * @return 应用的玩家数量
+ */
+template <class TTree, class TIndex, class TFn>
+size_t logic_rank_apply_mirror_delta(TTree& tree, TIndex& index,
+                                     const PROJECT_NAMESPACE_ID::table_rank_blob_data& delta, TFn&& on_change) {
+  size_t ret = 0;
+  for (const auto& key : delta.removed_users()) {
+    auto iter = index.find(key);
+    if (iter != index.end()) {
+      tree.erase(*iter->second);
+      index.erase(iter);
+    }
+    // 不在榜单上也要记录，下一个增量镜像才是完整的
+    on_change(key);
+    ++ret;
+  }
+
+  for (const auto& unit : delta.data()) {
+    if (logic_rank_upsert_data(tree, index, std::numeric_limits<size_t>::max(), unit.data(), on_change)) {
+      ++ret;
+    }
+  }
+  return ret;
+}
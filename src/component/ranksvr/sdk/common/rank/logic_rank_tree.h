@@ -0,0 +1,131 @@
+#pragma once
+
+// clang-format off
+#include <config/compiler/protobuf_prefix.h>
+// clang-format on
+
+#include <protocol/pbdesc/com.struct.rank.pb.h>
+#include <protocol/pbdesc/svr.struct.rank.pb.h>
+
+// clang-format off
+#include <config/compiler/protobuf_suffix.h>
+// clang-format on
+
+#include <utility/protobuf_mini_dumper.h>
+#include <utility/rank_util.h>
+
+#include <stdint.h>
+#include <cstddef>
+
+#include "config/server_frame_build_feature.h"
+
+// 榜单B树的操作，由ranksvr的rank类和排行榜的性能测试共用，TTree为persistent_btree<rank_storage_data, ...>
+
+/**
+ * @brief 移除排名最后的数据直到榜单不超过容量
+ * @param tree 排行榜B树
+ * @param index 玩家key到榜单数据的索引
+ * @param capacity 榜单容量
+ * @param on_remove 每移除一个数据后的回调，参数为被移除的数据
+ */
+template <class TTree, class TIndex, class TFn>
+void logic_rank_remove_over_capacity(TTree& tree, TIndex& index, size_t capacity, TFn&& on_remove) {
+  while (tree.size() > capacity) {
+    auto min_key = tree.get_min_key();
+    tree.erase(*min_key);
+    index.erase(min_key->sort_data().key());
+    on_remove(*min_key);
+  }
+}
+
+/**
+ * @brief 更新玩家数据，超过容量时移除排名最后的数据
+ * @param tree 排行榜B树
+ * @param index 玩家key到榜单数据的索引
+ * @param capacity 榜单容量
+ * @param data 玩家的最新数据
+ * @param on_change 每个变化的玩家的回调，参数为玩家key，包括被移出榜单的玩家
+ * @return 分数非法时返回false
+ */
+template <class TTree, class TIndex, class TFn>
+bool logic_rank_upsert_data(TTree& tree, TIndex& index, size_t capacity,
+                            const PROJECT_NAMESPACE_ID::rank_storage_data& data, TFn&& on_change) {
+  if (data.sort_data().value().score() < 0) {
+    return false;
+  }
+
+  auto iter = index.find(data.sort_data().key());
+  if (iter != index.end()) {
+    // 先删除原来的分数
+    tree.erase(*iter->second);
+  }
+  // 树中的数据在多个版本间共享，不能原地修改，每次更新都创建新的对象
+  typename TTree::value_pointer value = tree.make_value(data);
+  index[data.sort_data().key()] = value;
+  on_change(data.sort_data().key());
+
+  // 先插入再移除，新数据排在最后时自己会被移出榜单，榜单不会超过容量
+  tree.insert(value);
+  logic_rank_remove_over_capacity(tree, index, capacity,
+                                  [&on_change](const PROJECT_NAMESPACE_ID::rank_storage_data& removed) {
+                                    on_change(removed.sort_data().key());
+                                  });
+  return true;
+}
+
+/**
+ * @brief 导出从from开始的count个排名数据
+ * @param tree 排行榜B树
+ * @param from 起始排名，从1开始
+ * @param count 导出数量，超过max_count时截断
+ * @param max_count 单次查询的最大区间
+ * @param output 输出
+ * @return 实际导出的数量
+ */
+template <class TTree>
+size_t logic_rank_dump_top(TTree& tree, uint32_t from, uint32_t count, uint32_t max_count,
+                           PROJECT_NAMESPACE_ID::DRankQueryRspData& output) {
+  if (from == 0 || count == 0) {
+    return 0;
+  }
+
+  if (count > max_count) {
+    count = max_count;
+  }
+
+  // 树中已经保存了完整的榜单数据，一次查找定位到from后按顺序遍历，不需要再回查玩家索引
+  size_t result_count = tree.visit_range(static_cast<size_t>(from), static_cast<size_t>(count),
+                                         [&output](size_t rank_no, const typename TTree::value_pointer& unit) {
+                                           auto data = output.mutable_rank_records()->Add();
+                                           if (data) {
+                                             rank_util::dump_rank_basic_board_from_rank_data(*unit, *data);
+                                             data->set_rank_no(static_cast<uint32_t>(rank_no));
+                                           }
+                                           return true;
+                                         });
+
+  output.set_rank_total_count(static_cast<uint32_t>(tree.size()));
+  return result_count;
+}
+
+/**
+ * @brief 导出指定排名的数据
+ * @return 排名存在时返回true
+ */
+template <class TTree>
+bool logic_rank_dump_data_by_rank_no(TTree& tree, int32_t rank_no, PROJECT_NAMESPACE_ID::rank_data& output) {
+  if (rank_no <= 0) {
+    return false;
+  }
+
+  size_t visited = tree.visit_range(static_cast<size_t>(rank_no), 1,
+                                    [&output](size_t, const typename TTree::value_pointer& unit) {
+                                      protobuf_copy_message(*output.mutable_data(), *unit);
+                                      return false;
+                                    });
+  if (0 == visited) {
+    return false;
+  }
+  output.set_rank_no(static_cast<uint32_t>(rank_no));
+  return true;
+}
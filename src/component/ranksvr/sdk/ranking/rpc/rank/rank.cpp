@@ -32,23 +32,66 @@ namespace rpc {
 
 namespace rank {
 
+namespace {
+// 查询默认随机选一个从节点，max_staleness_version小于0时只从主节点读取
+rpc::result_code_type select_query_server(rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank,
+                                          int64_t max_staleness_version, uint64_t& destination_server_id) {
+  if (max_staleness_version < 0) {
+    RPC_RETURN_CODE(RPC_AWAIT_CODE_RESULT(
+        PROJECT_NAMESPACE_ID::rank_api::get_rank_router_main_server_id(ctx, rank, destination_server_id)));
+  }
+
+  RPC_RETURN_CODE(RPC_AWAIT_CODE_RESULT(
+      PROJECT_NAMESPACE_ID::rank_api::get_rank_slave_server_random(ctx, rank, destination_server_id)));
+}
+
+// 从节点数据落后太多时换成主节点重试，主节点总是可读的
+rpc::result_code_type select_fallback_server(rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank,
+                                             uint64_t& destination_server_id) {
+  uint64_t main_server_id = 0;
+  auto ret = RPC_AWAIT_CODE_RESULT(
+      PROJECT_NAMESPACE_ID::rank_api::get_rank_router_main_server_id(ctx, rank, main_server_id));
+  if (ret != 0) {
+    RPC_RETURN_CODE(ret);
+  }
+  if (main_server_id == destination_server_id) {
+    RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_DATA_TOO_STALE);
+  }
+
+  FWLOGDEBUG("rank({}:{}:{}:{}) server {} is too stale, fallback to main server {}", rank.rank_type(),
+             rank.rank_instance_id(), rank.sub_rank_type(), rank.sub_rank_instance_id(), destination_server_id,
+             main_server_id);
+  destination_server_id = main_server_id;
+  RPC_RETURN_CODE(0);
+}
+}  // namespace
+
 EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_special_one(
     rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankUserKey& user, const PROJECT_NAMESPACE_ID::DRankKey& rank,
-    PROJECT_NAMESPACE_ID::DRankUserBoardData& output) {
+    PROJECT_NAMESPACE_ID::DRankUserBoardData& output, int64_t max_staleness_version) {
   rpc::context::message_holder<PROJECT_NAMESPACE_ID::SSRankGetSpecifyRankReq> request_body{ctx};
   rpc::context::message_holder<PROJECT_NAMESPACE_ID::SSRankGetSpecifyRankRsp> response_body{ctx};
 
   protobuf_copy_message(*request_body->mutable_user_key(), user);
   protobuf_copy_message(*request_body->mutable_rank_key(), rank);
+  request_body->set_max_staleness_version(max_staleness_version);
 
   uint64_t destination_server_id = 0;
-  auto ret = RPC_AWAIT_CODE_RESULT(
-      PROJECT_NAMESPACE_ID::rank_api::get_rank_slave_server_random(ctx, rank, destination_server_id));
+  auto ret = RPC_AWAIT_CODE_RESULT(select_query_server(ctx, rank, max_staleness_version, destination_server_id));
   if (ret != 0) {
     RPC_RETURN_CODE(ret);
   }
 
   ret = RPC_AWAIT_CODE_RESULT(rpc::rank::rank_get_special(ctx, destination_server_id, *request_body, *response_body));
+  if (ret == 0 && response_body->result() == PROJECT_NAMESPACE_ID::EN_ERR_RANK_DATA_TOO_STALE) {
+    ret = RPC_AWAIT_CODE_RESULT(select_fallback_server(ctx, rank, destination_server_id));
+    if (ret != 0) {
+      RPC_RETURN_CODE(ret);
+    }
+    response_body->Clear();
+    ret =
+        RPC_AWAIT_CODE_RESULT(rpc::rank::rank_get_special(ctx, destination_server_id, *request_body, *response_body));
+  }
   if (ret != 0) {
     RPC_RETURN_CODE(ret);
   }
@@ -59,22 +102,31 @@ EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_special_one(
 EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_top(rpc::context& ctx,
                                                                    const PROJECT_NAMESPACE_ID::DRankKey& rank,
                                                                    uint32_t start_no, uint32_t count,
-                                                                   PROJECT_NAMESPACE_ID::DRankQueryRspData& output) {
+                                                                   PROJECT_NAMESPACE_ID::DRankQueryRspData& output,
+                                                                   int64_t max_staleness_version) {
   rpc::context::message_holder<PROJECT_NAMESPACE_ID::SSRankGetTopReq> request_body{ctx};
   rpc::context::message_holder<PROJECT_NAMESPACE_ID::SSRankGetTopRsp> response_body{ctx};
 
   protobuf_copy_message(*request_body->mutable_rank_key(), rank);
   request_body->set_start_no(start_no);
   request_body->set_count(count);
+  request_body->set_max_staleness_version(max_staleness_version);
 
   uint64_t destination_server_id = 0;
-  auto ret = RPC_AWAIT_CODE_RESULT(
-      PROJECT_NAMESPACE_ID::rank_api::get_rank_slave_server_random(ctx, rank, destination_server_id));
+  auto ret = RPC_AWAIT_CODE_RESULT(select_query_server(ctx, rank, max_staleness_version, destination_server_id));
   if (ret != 0) {
     RPC_RETURN_CODE(ret);
   }
 
   ret = RPC_AWAIT_CODE_RESULT(rpc::rank::rank_get_top(ctx, destination_server_id, *request_body, *response_body));
+  if (ret == 0 && response_body->result() == PROJECT_NAMESPACE_ID::EN_ERR_RANK_DATA_TOO_STALE) {
+    ret = RPC_AWAIT_CODE_RESULT(select_fallback_server(ctx, rank, destination_server_id));
+    if (ret != 0) {
+      RPC_RETURN_CODE(ret);
+    }
+    response_body->Clear();
+    ret = RPC_AWAIT_CODE_RESULT(rpc::rank::rank_get_top(ctx, destination_server_id, *request_body, *response_body));
+  }
   if (ret != 0) {
     RPC_RETURN_CODE(ret);
   }
@@ -84,23 +136,33 @@ EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_top(rpc::context&
 
 EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_special_one_front_back(
     rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank, const PROJECT_NAMESPACE_ID::DRankUserKey& user,
-    uint32_t count, google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::DRankUserBoardData>& output) {
+    uint32_t count, google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::DRankUserBoardData>& output,
+    int64_t max_staleness_version) {
   rpc::context::message_holder<PROJECT_NAMESPACE_ID::SSRankGetUserFrontBackReq> request_body{ctx};
   rpc::context::message_holder<PROJECT_NAMESPACE_ID::SSRankGetUserFrontBackRsp> response_body{ctx};
 
   protobuf_copy_message(*request_body->mutable_rank_key(), rank);
   protobuf_copy_message(*request_body->mutable_user_key(), user);
   request_body->set_count(count);
+  request_body->set_max_staleness_version(max_staleness_version);
 
   uint64_t destination_server_id = 0;
-  auto ret = RPC_AWAIT_CODE_RESULT(
-      PROJECT_NAMESPACE_ID::rank_api::get_rank_slave_server_random(ctx, rank, destination_server_id));
+  auto ret = RPC_AWAIT_CODE_RESULT(select_query_server(ctx, rank, max_staleness_version, destination_server_id));
   if (ret != 0) {
     RPC_RETURN_CODE(ret);
   }
 
   ret = RPC_AWAIT_CODE_RESULT(
       rpc::rank::rank_get_special_one_front_back(ctx, destination_server_id, *request_body, *response_body));
+  if (ret == 0 && response_body->result() == PROJECT_NAMESPACE_ID::EN_ERR_RANK_DATA_TOO_STALE) {
+    ret = RPC_AWAIT_CODE_RESULT(select_fallback_server(ctx, rank, destination_server_id));
+    if (ret != 0) {
+      RPC_RETURN_CODE(ret);
+    }
+    response_body->Clear();
+    ret = RPC_AWAIT_CODE_RESULT(
+        rpc::rank::rank_get_special_one_front_back(ctx, destination_server_id, *request_body, *response_body));
+  }
   if (ret != 0) {
     RPC_RETURN_CODE(ret);
   }
@@ -130,6 +192,47 @@ EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type update_score(
   RPC_RETURN_CODE(response_body->result());
 }
 
+EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type batch_update_score(
+    rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank,
+    const google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore>& updates,
+    uint32_t* update_count, std::vector<int32_t>* results) {
+  if (nullptr != update_count) {
+    *update_count = 0;
+  }
+  if (nullptr != results) {
+    results->clear();
+  }
+  if (updates.empty()) {
+    RPC_RETURN_CODE(0);
+  }
+
+  rpc::context::message_holder<PROJECT_NAMESPACE_ID::SSRankBatchSetScoreReq> request_body{ctx};
+  rpc::context::message_holder<PROJECT_NAMESPACE_ID::SSRankBatchSetScoreRsp> response_body{ctx};
+
+  protobuf_copy_message(*request_body->mutable_rank_key(), rank);
+  protobuf_copy_message(*request_body->mutable_data(), updates);
+
+  uint64_t destination_server_id = PROJECT_NAMESPACE_ID::rank_api::get_rank_main_server_id(ctx, rank);
+
+  int32_t ret = RPC_AWAIT_CODE_RESULT(
+      rpc::rank::rank_batch_set_score(ctx, destination_server_id, *request_body, *response_body));
+  if (ret != 0) {
+    RPC_RETURN_CODE(ret);
+  }
+  if (nullptr != update_count) {
+    *update_count = response_body->update_count();
+  }
+  if (nullptr != results) {
+    if (response_body->results_size() == updates.size()) {
+      results->assign(response_body->results().begin(), response_body->results().end());
+    } else {
+      // 旧版本的ranksvr没有逐个返回结果，所有玩家都使用整批的结果
+      results->assign(static_cast<size_t>(updates.size()), response_body->result());
+    }
+  }
+  RPC_RETURN_CODE(response_body->result());
+}
+
 EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type modify_score(
     rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankUserKey& user, const PROJECT_NAMESPACE_ID::DRankKey& rank,
     int64_t score, const PROJECT_NAMESPACE_ID::DRankCustomData& custom_data) {
@@ -41,6 +41,7 @@ class DRankUserKey;
 class DRankKey;
 class DRankUserBoardData;
 class DRankCustomData;
+class DRankEventUpdateUserScore;
 
 PROJECT_NAMESPACE_END
 
@@ -54,11 +55,13 @@ namespace rank {
  * @param user 玩家key
  * @param rank 排行榜key
  * @param output 结果
+ * @param max_staleness_version 从节点允许落后主节点的最大数据版本数，超过时回退到主节点读取。
+ *                              0表示不限制，小于0表示只从主节点读取
  * @return future of 0 or error code
  */
 EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_special_one(
     rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankUserKey& user, const PROJECT_NAMESPACE_ID::DRankKey& rank,
-    PROJECT_NAMESPACE_ID::DRankUserBoardData& output);
+    PROJECT_NAMESPACE_ID::DRankUserBoardData& output, int64_t max_staleness_version = 0);
 
 /**
  * @brief 拉取榜单数据
@@ -67,12 +70,15 @@ EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_special_one(
  * @param count 个数
  * @param rank 排行榜key
  * @param output 结果
+ * @param max_staleness_version 从节点允许落后主节点的最大数据版本数，超过时回退到主节点读取。
+ *                              0表示不限制，小于0表示只从主节点读取
  * @return future of 0 or error code
  */
 EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_top(rpc::context& ctx,
                                                                    const PROJECT_NAMESPACE_ID::DRankKey& rank,
                                                                    uint32_t start_no, uint32_t count,
-                                                                   PROJECT_NAMESPACE_ID::DRankQueryRspData& output);
+                                                                   PROJECT_NAMESPACE_ID::DRankQueryRspData& output,
+                                                                   int64_t max_staleness_version = 0);
 
 /**
  * @brief 获取玩家前后排名count的排行榜数据
@@ -80,11 +86,14 @@ EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_top(rpc::context&
  * @param user 玩家key
  * @param count 前后的数量
  * @param output 结果
+ * @param max_staleness_version 从节点允许落后主节点的最大数据版本数，超过时回退到主节点读取。
+ *                              0表示不限制，小于0表示只从主节点读取
  * @return future of 0 or error code
  */
 EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_special_one_front_back(
     rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank, const PROJECT_NAMESPACE_ID::DRankUserKey& user,
-    uint32_t count, google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::DRankUserBoardData>& output);
+    uint32_t count, google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::DRankUserBoardData>& output,
+    int64_t max_staleness_version = 0);
 
 /**
  * @brief 设置玩家分数
@@ -98,6 +107,19 @@ EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type update_score(
     rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankUserKey& user, const PROJECT_NAMESPACE_ID::DRankKey& rank,
     int64_t score, const PROJECT_NAMESPACE_ID::DRankCustomData& custom_data);
 
+/**
+ * @brief 批量设置玩家分数，一次请求只产生一个数据版本
+ * @param rank 排行榜key
+ * @param updates 玩家分数列表，同一个玩家出现多次时以最后一次为准
+ * @param update_count 合并后实际更新的玩家数，不需要时传nullptr
+ * @param results 输出和updates一一对应的错误码，不需要时传nullptr。RPC失败时为空
+ * @return future of 0 or error code，部分玩家失败时返回第一个失败的错误码
+ */
+EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type batch_update_score(
+    rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank,
+    const google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore>& updates,
+    uint32_t* update_count = nullptr, std::vector<int32_t>* results = nullptr);
+
 /**
  * @brief 修改玩家分数(增量加减)
  * @param user 玩家key
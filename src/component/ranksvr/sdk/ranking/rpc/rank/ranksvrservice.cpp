@@ -127,7 +127,7 @@ inline static rpc::telemetry::tracer::span_ptr_type __setup_tracer(rpc::context
 }
 
 inline static int __setup_rpc_stream_header(atframework::SSMsgHead &head, atfw::util::nostd::string_view rpc_full_name,
-                                            atfw::util::nostd::string_view type_full_name) {
+                                            uint32_t rpc_method_id, atfw::util::nostd::string_view type_full_name) {
   atframework::RpcStreamMeta* stream_meta = head.mutable_rpc_stream();
   if (nullptr == stream_meta) {
     return prx::err::EN_SYS_MALLOC;
@@ -136,6 +136,7 @@ inline static int __setup_rpc_stream_header(atframework::SSMsgHead &head, atfw::
   stream_meta->set_caller(static_cast<std::string>(logic_config::me()->get_local_server_name()));
   stream_meta->set_callee("prx.RanksvrService");
   stream_meta->set_rpc_name(static_cast<std::string>(rpc_full_name));
+  stream_meta->set_rpc_method_id(rpc_method_id);
   stream_meta->set_type_url(type_full_name.data(), type_full_name.size());
   stream_meta->mutable_caller_timestamp()->set_seconds(util::time::time_utility::get_sys_now());
   stream_meta->mutable_caller_timestamp()->set_nanos(util::time::time_utility::get_now_nanos());
@@ -143,7 +144,7 @@ inline static int __setup_rpc_stream_header(atframework::SSMsgHead &head, atfw::
   return prx::err::EN_SUCCESS;
 }
 inline static int __setup_rpc_request_header(atframework::SSMsgHead &head, task_type_trait::id_type task_id,
-                                             atfw::util::nostd::string_view rpc_full_name,
+                                             atfw::util::nostd::string_view rpc_full_name, uint32_t rpc_method_id,
                                              atfw::util::nostd::string_view type_full_name) {
   head.set_source_task_id(task_id);
   atframework::RpcRequestMeta* request_meta = head.mutable_rpc_request();
@@ -154,6 +155,7 @@ inline static int __setup_rpc_request_header(atframework::SSMsgHead &head, task_
   request_meta->set_caller(static_cast<std::string>(logic_config::me()->get_local_server_name()));
   request_meta->set_callee("prx.RanksvrService");
   request_meta->set_rpc_name(static_cast<std::string>(rpc_full_name));
+  request_meta->set_rpc_method_id(rpc_method_id);
   request_meta->set_type_url(type_full_name.data(), type_full_name.size());
   request_meta->mutable_caller_timestamp()->set_seconds(util::time::time_utility::get_sys_now());
   request_meta->mutable_caller_timestamp()->set_nanos(util::time::time_utility::get_now_nanos());
@@ -250,13 +252,13 @@ static rpc::result_code_type __rank_get_special(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_get_special",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_get_special", 0xc0e896aeU,
     __to_string_view(  prx::SSRankGetSpecifyRankReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_get_special",
+    "prx.RanksvrService.rank_get_special", 0xc0e896aeU,
     __to_string_view(  prx::SSRankGetSpecifyRankReq::descriptor()->full_name())
     );
   }
@@ -394,13 +396,13 @@ static rpc::result_code_type __rank_set_score(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_set_score",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_set_score", 0x710584e7U,
     __to_string_view(  prx::SSRankSetScoreReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_set_score",
+    "prx.RanksvrService.rank_set_score", 0x710584e7U,
     __to_string_view(  prx::SSRankSetScoreReq::descriptor()->full_name())
     );
   }
@@ -538,13 +540,13 @@ static rpc::result_code_type __rank_modify_score(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_modify_score",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_modify_score", 0x44f8f499U,
     __to_string_view(  prx::SSRankModifyScoreReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_modify_score",
+    "prx.RanksvrService.rank_modify_score", 0x44f8f499U,
     __to_string_view(  prx::SSRankModifyScoreReq::descriptor()->full_name())
     );
   }
@@ -682,13 +684,13 @@ static rpc::result_code_type __rank_del_one_user(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_del_one_user",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_del_one_user", 0xe94e5756U,
     __to_string_view(  prx::SSRankDelUserReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_del_one_user",
+    "prx.RanksvrService.rank_del_one_user", 0xe94e5756U,
     __to_string_view(  prx::SSRankDelUserReq::descriptor()->full_name())
     );
   }
@@ -826,13 +828,13 @@ static rpc::result_code_type __rank_get_top(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_get_top",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_get_top", 0x7a4ff15eU,
     __to_string_view(  prx::SSRankGetTopReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_get_top",
+    "prx.RanksvrService.rank_get_top", 0x7a4ff15eU,
     __to_string_view(  prx::SSRankGetTopReq::descriptor()->full_name())
     );
   }
@@ -970,13 +972,13 @@ static rpc::result_code_type __rank_clear(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_clear",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_clear", 0xeb3945ffU,
     __to_string_view(  prx::SSRankClearReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_clear",
+    "prx.RanksvrService.rank_clear", 0xeb3945ffU,
     __to_string_view(  prx::SSRankClearReq::descriptor()->full_name())
     );
   }
@@ -1114,13 +1116,13 @@ static rpc::result_code_type __rank_load_main(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_load_main",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_load_main", 0x3db2b232U,
     __to_string_view(  prx::SSRankLoadMainReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_load_main",
+    "prx.RanksvrService.rank_load_main", 0x3db2b232U,
     __to_string_view(  prx::SSRankLoadMainReq::descriptor()->full_name())
     );
   }
@@ -1258,13 +1260,13 @@ static rpc::result_code_type __rank_check_slave(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_check_slave",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_check_slave", 0x0a5de84aU,
     __to_string_view(  prx::SSRankCheckSlaveReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_check_slave",
+    "prx.RanksvrService.rank_check_slave", 0x0a5de84aU,
     __to_string_view(  prx::SSRankCheckSlaveReq::descriptor()->full_name())
     );
   }
@@ -1385,7 +1387,7 @@ static rpc::always_ready_code_type __rank_event_sync(
   task_action_ss_req_base::init_msg(req_msg, logic_config::me()->get_local_server_id(),
     logic_config::me()->get_local_server_name());
   res = __setup_rpc_stream_header(
-    *req_msg.mutable_head(), "prx.RanksvrService.rank_event_sync",
+    *req_msg.mutable_head(), "prx.RanksvrService.rank_event_sync", 0xe20363b8U,
     __to_string_view(prx::SSRankEventSync::descriptor()->full_name())
   );
   if (res < 0) {
@@ -1487,13 +1489,13 @@ static rpc::result_code_type __rank_heartbeat(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_heartbeat",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_heartbeat", 0xcd0b9802U,
     __to_string_view(  prx::SSRankHeartbeatReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_heartbeat",
+    "prx.RanksvrService.rank_heartbeat", 0xcd0b9802U,
     __to_string_view(  prx::SSRankHeartbeatReq::descriptor()->full_name())
     );
   }
@@ -1631,13 +1633,13 @@ static rpc::result_code_type __rank_switch_to_slave(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_switch_to_slave",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_switch_to_slave", 0x94be13f2U,
     __to_string_view(  prx::SSRankSwitchToSlaveReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_switch_to_slave",
+    "prx.RanksvrService.rank_switch_to_slave", 0x94be13f2U,
     __to_string_view(  prx::SSRankSwitchToSlaveReq::descriptor()->full_name())
     );
   }
@@ -1775,13 +1777,13 @@ static rpc::result_code_type __rank_get_special_one_front_back(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_get_special_one_front_back",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_get_special_one_front_back", 0x14a30fa5U,
     __to_string_view(  prx::SSRankGetUserFrontBackReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_get_special_one_front_back",
+    "prx.RanksvrService.rank_get_special_one_front_back", 0x14a30fa5U,
     __to_string_view(  prx::SSRankGetUserFrontBackReq::descriptor()->full_name())
     );
   }
@@ -1919,13 +1921,13 @@ static rpc::result_code_type __rank_make_new_mirror(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_make_new_mirror",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_make_new_mirror", 0x7ce79dc9U,
     __to_string_view(  prx::SSRankMakeNewMirrorReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_make_new_mirror",
+    "prx.RanksvrService.rank_make_new_mirror", 0x7ce79dc9U,
     __to_string_view(  prx::SSRankMakeNewMirrorReq::descriptor()->full_name())
     );
   }
@@ -2063,13 +2065,13 @@ static rpc::result_code_type __rank_check_mirror_dump_finish(
     logic_config::me()->get_local_server_name());
   if (__no_wait) {
     res = __setup_rpc_stream_header(
-      *req_msg.mutable_head(), "prx.RanksvrService.rank_check_mirror_dump_finish",
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_check_mirror_dump_finish", 0xaf3e7b8fU,
     __to_string_view(  prx::SSRankCheckMirrorDumpFinishReq::descriptor()->full_name())
     );
   } else {
     res = __setup_rpc_request_header(
       *req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "prx.RanksvrService.rank_check_mirror_dump_finish",
+    "prx.RanksvrService.rank_check_mirror_dump_finish", 0xaf3e7b8fU,
     __to_string_view(  prx::SSRankCheckMirrorDumpFinishReq::descriptor()->full_name())
     );
   }
@@ -2151,5 +2153,149 @@ RANK_SDK_API rpc::result_code_type rank_check_mirror_dump_finish(
   RPC_RETURN_CODE(RPC_AWAIT_CODE_RESULT(unicast::__rank_check_mirror_dump_finish(__ctx, destination_server, request_body, response_body, __no_wait, __wait_later)));
 }
 
+
+// ============ prx.RanksvrService.rank_batch_set_score ============
+namespace packer {
+RANK_SDK_API bool pack_rank_batch_set_score(std::string& output, const prx::SSRankBatchSetScoreReq& input) {
+  return prx::err::EN_SUCCESS ==
+         __pack_rpc_body(
+             input, &output, "prx.RanksvrService.rank_batch_set_score",
+             __to_string_view(prx::SSRankBatchSetScoreReq::descriptor()->full_name()));
+}
+
+RANK_SDK_API bool unpack_rank_batch_set_score(const std::string& input, prx::SSRankBatchSetScoreReq& output) {
+  return prx::err::EN_SUCCESS ==
+         __unpack_rpc_body(
+             output, input, "prx.RanksvrService.rank_batch_set_score",
+             __to_string_view(prx::SSRankBatchSetScoreReq::descriptor()->full_name()));
+}
+
+RANK_SDK_API bool pack_rank_batch_set_score(std::string& output, const prx::SSRankBatchSetScoreRsp& input) {
+  return prx::err::EN_SUCCESS ==
+         __pack_rpc_body(
+             input, &output, "prx.RanksvrService.rank_batch_set_score",
+             __to_string_view(prx::SSRankBatchSetScoreRsp::descriptor()->full_name()));
+}
+
+RANK_SDK_API bool unpack_rank_batch_set_score(const std::string& input, prx::SSRankBatchSetScoreRsp& output) {
+  return prx::err::EN_SUCCESS ==
+         __unpack_rpc_body(
+             output, input, "prx.RanksvrService.rank_batch_set_score",
+             __to_string_view(prx::SSRankBatchSetScoreRsp::descriptor()->full_name()));
+}
+
+}  // namespace packer
+namespace unicast {
+template<class TargetServerNode>
+static rpc::result_code_type __rank_batch_set_score(
+  context& __ctx, TargetServerNode&& destination_server, prx::SSRankBatchSetScoreReq &request_body, prx::SSRankBatchSetScoreRsp &response_body, bool __no_wait, dispatcher_await_options* __wait_later) {
+  if (__is_invalid_server_node(destination_server)) {
+    RPC_RETURN_CODE(prx::err::EN_SYS_PARAM);
+  }
+
+  TASK_COMPAT_CHECK_TASK_ACTION_RETURN("rpc {} must be called in a task",
+    "prx.RanksvrService.rank_batch_set_score")
+
+  atframework::SSMsg* req_msg_ptr = __ctx.create<atframework::SSMsg>();
+  if (nullptr == req_msg_ptr) {
+    FWLOGERROR("rpc {} create request message failed",
+               "prx.RanksvrService.rank_batch_set_score");
+    RPC_RETURN_CODE(prx::err::EN_SYS_MALLOC);
+  }
+
+  rpc::result_code_type::value_type res;
+  atframework::SSMsg& req_msg = *req_msg_ptr;
+  task_action_ss_req_base::init_msg(req_msg, logic_config::me()->get_local_server_id(),
+    logic_config::me()->get_local_server_name());
+  if (__no_wait) {
+    res = __setup_rpc_stream_header(
+      *req_msg.mutable_head(), "prx.RanksvrService.rank_batch_set_score", 0x4386549cU,
+    __to_string_view(  prx::SSRankBatchSetScoreReq::descriptor()->full_name())
+    );
+  } else {
+    res = __setup_rpc_request_header(
+      *req_msg.mutable_head(), __ctx.get_task_context().task_id,
+    "prx.RanksvrService.rank_batch_set_score", 0x4386549cU,
+    __to_string_view(  prx::SSRankBatchSetScoreReq::descriptor()->full_name())
+    );
+  }
+  if (res < 0) {
+    RPC_RETURN_CODE(res);
+  }
+
+  res = __pack_rpc_body(
+    request_body, req_msg.mutable_body_bin(), "prx.RanksvrService.rank_batch_set_score",
+    __to_string_view(prx::SSRankBatchSetScoreReq::descriptor()->full_name()));
+  if (res < 0) {
+    RPC_RETURN_CODE(res);
+  }
+
+  rpc::context __child_ctx(__ctx);
+  rpc::telemetry::tracer __tracer;
+  rpc::telemetry::trace_attribute_pair_type __trace_attributes[] = {
+    {opentelemetry::semconv::rpc::kRpcSystem, "atrpc.ss"},
+    {opentelemetry::semconv::rpc::kRpcService, "prx.RanksvrService"},
+    {opentelemetry::semconv::rpc::kRpcMethod, "prx.RanksvrService.rank_batch_set_score"}
+  };
+  __setup_tracer(__child_ctx, __tracer, *req_msg.mutable_head(),
+                          "prx.RanksvrService.rank_batch_set_score",
+                          __trace_attributes);
+
+  res = ss_msg_dispatcher::me()->send_to_proc(destination_server, req_msg);
+  do {
+    dispatcher_await_options await_options = dispatcher_make_default<dispatcher_await_options>();
+    await_options.sequence = req_msg.head().sequence();
+    {
+      const google::protobuf::MethodDescriptor *method = prx::RanksvrService::descriptor()
+        ->FindMethodByName("rank_batch_set_score");
+
+      if (nullptr != method && method->options().HasExtension(atframework::rpc_options)) {
+        await_options.timeout = rpc::make_duration_or_default(
+            method->options().GetExtension(atframework::rpc_options).timeout(),
+            rpc::make_duration_or_default(logic_config::me()->get_server_cfg().task().csmsg().timeout(),
+                                          std::chrono::seconds{6}));
+      } else {
+        await_options.timeout = rpc::make_duration_or_default(logic_config::me()->get_server_cfg().task().csmsg().timeout(),
+                                                              std::chrono::seconds{6});
+      }
+    }
+    if (__no_wait) {
+      break;
+    } else if (nullptr != __wait_later) {
+      *__wait_later = await_options;
+      // need to call RPC_AWAIT_CODE_RESULT(rpc::wait(...)) to wait this rpc sequence later
+      break;
+    }
+    if (res < 0) {
+      break;
+    }
+
+    res = RPC_AWAIT_CODE_RESULT(__rpc_wait_and_unpack_response(__ctx, response_body,
+        "prx.RanksvrService.rank_batch_set_score",
+        __to_string_view(prx::SSRankBatchSetScoreRsp::descriptor()->full_name()),
+        await_options));
+  } while (false);
+
+  if (res < 0) {
+      FWLOGERROR("rpc {} call failed, res: {}({})",
+                 "prx.RanksvrService.rank_batch_set_score",
+                 res, protobuf_mini_dumper_get_error_msg(res)
+      );
+  }
+
+  RPC_RETURN_CODE(__tracer.finish({res , __trace_attributes}));
+}
+
+RANK_SDK_API rpc::result_code_type rank_batch_set_score(
+  context& __ctx, const atfw::atapp::etcd_discovery_node& destination_server, prx::SSRankBatchSetScoreReq &request_body, prx::SSRankBatchSetScoreRsp &response_body, bool __no_wait, dispatcher_await_options* __wait_later) {
+  RPC_RETURN_CODE(RPC_AWAIT_CODE_RESULT(__rank_batch_set_score(__ctx, destination_server, request_body, response_body, __no_wait, __wait_later)));
+}
+}  // namespace unicast
+
+RANK_SDK_API rpc::result_code_type rank_batch_set_score(
+  context& __ctx, uint64_t destination_server, prx::SSRankBatchSetScoreReq &request_body, prx::SSRankBatchSetScoreRsp &response_body, bool __no_wait, dispatcher_await_options* __wait_later) {
+  RPC_RETURN_CODE(RPC_AWAIT_CODE_RESULT(unicast::__rank_batch_set_score(__ctx, destination_server, request_body, response_body, __no_wait, __wait_later)));
+}
+
 }  // namespace rank
 }
@@ -572,6 +572,44 @@ EXPLICIT_NODISCARD_ATTR RANK_SDK_API rpc::result_code_type
 EXPLICIT_NODISCARD_ATTR RANK_SDK_API rpc::result_code_type
   rank_check_mirror_dump_finish(
     context& __ctx, uint64_t destination_server_id, prx::SSRankCheckMirrorDumpFinishReq &request_body, prx::SSRankCheckMirrorDumpFinishRsp &response_body, bool __no_wait = false, dispatcher_await_options* __wait_later = nullptr);
+
+// ============ prx.RanksvrService.rank_batch_set_score ============
+namespace packer {
+RANK_SDK_API bool pack_rank_batch_set_score(std::string& output, const prx::SSRankBatchSetScoreReq& input);
+RANK_SDK_API bool unpack_rank_batch_set_score(const std::string& input, prx::SSRankBatchSetScoreReq& output);
+RANK_SDK_API bool pack_rank_batch_set_score(std::string& output, const prx::SSRankBatchSetScoreRsp& input);
+RANK_SDK_API bool unpack_rank_batch_set_score(const std::string& input, prx::SSRankBatchSetScoreRsp& output);
+}  // namespace packer
+
+namespace unicast {
+/**
+ * @brief 批量更新玩家排行榜数据
+ * @param __ctx               RPC context, you can get it from get_shared_context() of task_action or just create one on stack
+ * @param destination_server  target server
+ * @param request_body       request body
+ * @param response_body       response body
+ * @param __no_wait           set true if not need to wait response
+ * @param __wait_later        set not nullptr if caller want to wait this RPC later, and receive rpc sequence to wait here
+ * @return 0 or error code
+ */
+EXPLICIT_NODISCARD_ATTR RANK_SDK_API rpc::result_code_type
+  rank_batch_set_score(
+    context& __ctx, const atfw::atapp::etcd_discovery_node& destination_server, prx::SSRankBatchSetScoreReq &request_body, prx::SSRankBatchSetScoreRsp &response_body, bool __no_wait = false, dispatcher_await_options* __wait_later = nullptr);
+}  // namespace unicast
+
+/**
+ * @brief 批量更新玩家排行榜数据
+ * @param __ctx               RPC context, you can get it from get_shared_context() of task_action or just create one on stack
+ * @param destination_server  target server
+ * @param request_body       request body
+ * @param response_body       response body
+ * @param __no_wait           set true if not need to wait response
+ * @param __wait_later        set not nullptr if caller want to wait this RPC later, and receive rpc sequence to wait here
+ * @return 0 or error code
+ */
+EXPLICIT_NODISCARD_ATTR RANK_SDK_API rpc::result_code_type
+  rank_batch_set_score(
+    context& __ctx, uint64_t destination_server_id, prx::SSRankBatchSetScoreReq &request_body, prx::SSRankBatchSetScoreRsp &response_body, bool __no_wait = false, dispatcher_await_options* __wait_later = nullptr);
 }  // namespace rank
 }
 
@@ -86,6 +86,22 @@ class router_rank_manager : public util::design_pattern::singleton<router_rank_m
     RPC_RETURN_CODE(0);
   }
 
+  EXPLICIT_NODISCARD_ATTR rpc::result_code_type get_rank_router_main_server_id(
+      rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank_key, uint64_t& main_server_id) {
+    const router_rank_info* router_info = nullptr;
+    auto ret = RPC_AWAIT_CODE_RESULT(get_rank_server_router_info(ctx, rank_key, &router_info));
+    if (ret != 0) {
+      RPC_RETURN_CODE(ret);
+    }
+    if (router_info == nullptr || router_info->main_node_server_id == 0) {
+      FWLOGERROR("not found router main node rank_id ({}:{}:{}:{})", rank_key.rank_type(), rank_key.rank_instance_id(),
+                 rank_key.sub_rank_type(), rank_key.sub_rank_instance_id());
+      RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_SERVICE_NOT_AVAILABLE);
+    }
+    main_server_id = router_info->main_node_server_id;
+    RPC_RETURN_CODE(0);
+  }
+
  private:
   uint64_t get_ranksvr_server_id_by_consistent_hash(uint32_t rank_id) {
     if (auto common_mod = logic_server_last_common_module()) {
@@ -192,6 +208,12 @@ EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_rank_slave_server
       inner::router_rank_manager::me()->get_rank_slave_server_random(ctx, rank_key, slave_server_id)));
 }
 
+EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_rank_router_main_server_id(
+    rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank_key, uint64_t& main_server_id) {
+  RPC_RETURN_CODE(RPC_AWAIT_CODE_RESULT(
+      inner::router_rank_manager::me()->get_rank_router_main_server_id(ctx, rank_key, main_server_id)));
+}
+
 }  // namespace rank_api
 
 PROJECT_NAMESPACE_END
\ No newline at end of file
@@ -46,6 +46,14 @@ EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_rank_slave_server
  */
 EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_rank_slave_server_random(
     rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank_key, uint64_t& slave_server_id);
+
+/**
+ * @brief 获取路由表中的主节点(从节点数据落后太多时回退到主节点读取)
+ * @param rank_key 排行榜key
+ * @param main_server_id 主节点id
+ */
+EXPLICIT_NODISCARD_ATTR RANK_RPC_API rpc::result_code_type get_rank_router_main_server_id(
+    rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank_key, uint64_t& main_server_id);
 }  // namespace rank_api
 
 PROJECT_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "task_action_rank_batch_set_score.h"
+
+#include <log/log_wrapper.h>
+#include <std/explicit_declare.h>
+#include <time/time_utility.h>
+
+// clang-format off
+#include <config/compiler/protobuf_prefix.h>
+// clang-format on
+
+#include <protocol/pbdesc/rank_service.pb.h>
+#include <protocol/pbdesc/svr.const.err.pb.h>
+#include "protocol/pbdesc/com.const.pb.h"
+
+// clang-format off
+#include <config/compiler/protobuf_suffix.h>
+// clang-format on
+
+#include <config/logic_config.h>
+#include <utility/protobuf_mini_dumper.h>
+
+#include <config/extern_service_types.h>
+
+#include <logic/rank_manager.h>
+#include "config/server_frame_build_feature.h"
+
+RANK_SERVICE_API task_action_rank_batch_set_score::task_action_rank_batch_set_score(
+    dispatcher_start_data_type&& param)
+    : base_type(COPP_MACRO_STD_MOVE(param)) {}
+
+RANK_SERVICE_API task_action_rank_batch_set_score::~task_action_rank_batch_set_score() {}
+
+RANK_SERVICE_API const char* task_action_rank_batch_set_score::name() const {
+  return "task_action_rank_batch_set_score";
+}
+
+RANK_SERVICE_API task_action_rank_batch_set_score::result_type task_action_rank_batch_set_score::operator()() {
+  EXPLICIT_UNUSED_ATTR const rpc_request_type& req_body = get_request_body();
+  EXPLICIT_UNUSED_ATTR rpc_response_type& rsp_body = get_response_body();
+  if (is_stream_rpc()) {
+    disable_response_message();
+  }
+  if (req_body.data_size() <= 0) {
+    rsp_body.set_result(0);
+    TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SUCCESS);
+  }
+
+  rank_ptr_type rank_ptr = nullptr;
+  auto ret =
+      RPC_AWAIT_TYPE_RESULT(rank_manager::me()->mutable_main_rank(get_shared_context(), req_body.rank_key(), rank_ptr));
+  if (ret != 0) {
+    TASK_ACTION_RETURN_CODE(ret);
+  }
+  if (!rank_ptr) {
+    TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_NOT_EXIST);
+  }
+  if (!rank_ptr->is_main_node()) {
+    bool ok = false;
+    ret = RPC_AWAIT_CODE_RESULT(forward_rpc(rank_ptr->get_router_data().main_server_id(), false, ok));
+    if (ret != 0 || !ok) {
+      FWLOGERROR("forward rank({}:{}:{}:{}) message to dest server {} failed! ret:{} ok:{}",
+                 req_body.rank_key().rank_type(), req_body.rank_key().rank_instance_id(),
+                 req_body.rank_key().sub_rank_type(), req_body.rank_key().sub_rank_instance_id(),
+                 rank_ptr->get_router_data().main_server_id(), ret, ok ? 1 : 0);
+      TASK_ACTION_RETURN_CODE(ret != 0 ? ret : PROJECT_NAMESPACE_ID::EN_ERR_UNKNOWN);
+    }
+    FWLOGDEBUG("forward rank({}:{}:{}:{}) message to dest server {} success", req_body.rank_key().rank_type(),
+               req_body.rank_key().rank_instance_id(), req_body.rank_key().sub_rank_type(),
+               req_body.rank_key().sub_rank_instance_id(), rank_ptr->get_router_data().main_server_id());
+    TASK_ACTION_RETURN_CODE(0);
+  }
+
+  auto old_version = rank_ptr->get_data_version();
+
+  PROJECT_NAMESPACE_ID::DRankEventLog log;
+  ret = rank_ptr->batch_update_score(req_body.data(), log.mutable_batch_update_score(), rsp_body.mutable_results());
+
+  // 整批更新只产生一个版本，也只广播一条事件
+  rsp_body.set_update_count(static_cast<uint32_t>(log.batch_update_score().updates_size()));
+  if (rank_ptr->get_data_version() > old_version) {
+    rank_ptr->broadcast_events(get_shared_context(), std::move(log));
+  }
+  FWLOGDEBUG(" rank({}:{}) batch set score request count:{} update count:{} err:{}", req_body.rank_key().rank_type(),
+             req_body.rank_key().rank_instance_id(), req_body.data_size(), rsp_body.update_count(), ret);
+
+  rsp_body.set_result(ret);
+  TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SUCCESS);
+}
+
+RANK_SERVICE_API int task_action_rank_batch_set_score::on_success() { return get_result(); }
+
+RANK_SERVICE_API int task_action_rank_batch_set_score::on_failed() { return get_result(); }
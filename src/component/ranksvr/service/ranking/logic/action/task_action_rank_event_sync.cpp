@@ -45,6 +45,9 @@ RANK_SERVICE_API task_action_rank_event_sync::result_type task_action_rank_event
     TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_IS_NOT_SLAVE);
   }
   // TODO 比较数据版本号
+  if (req_body.event_logs_size() > 0) {
+    rank->update_main_data_version(req_body.event_logs(req_body.event_logs_size() - 1).event_id());
+  }
 
   for (auto& event : req_body.event_logs()) {
     if (event.event_id() <= rank->get_data_version()) {
@@ -53,6 +56,8 @@ RANK_SERVICE_API task_action_rank_event_sync::result_type task_action_rank_event
     if (event.event_id() != rank->get_data_version() + 1) {
       FWLOGDEBUG("event logs is break!!!! rank({}:{}) log_event_id:{} cur_event_id:{}", req_body.rank_key().rank_type(),
                  req_body.rank_key().rank_instance_id(), event.event_id(), rank->get_data_version());
+      // 中间有事件丢失（比如被主节点流控跳过），立即上报已确认版本让主节点补发
+      rank->request_event_resync(get_shared_context());
       break;
     }
     int ret = 0;
@@ -66,6 +71,9 @@ RANK_SERVICE_API task_action_rank_event_sync::result_type task_action_rank_event
       case PROJECT_NAMESPACE_ID::DRankEventLog::kRankClear:
         rank->clear_rank();
         break;
+      case PROJECT_NAMESPACE_ID::DRankEventLog::kBatchUpdateScore:
+        rank->batch_update_score(event.batch_update_score().updates(), nullptr);
+        break;
       default:
         FWLOGERROR("unsupport event type:{}", static_cast<int>(event.event_case()));
         break;
@@ -36,7 +36,8 @@ RANK_SERVICE_API task_action_rank_get_special::result_type task_action_rank_get_
   }
 
   int32_t ret = RPC_AWAIT_CODE_RESULT(rank_manager::me()->query_one_user(
-      get_shared_context(), req_body.rank_key(), req_body.user_key(), *rsp_body.mutable_rank_records()));
+      get_shared_context(), req_body.rank_key(), req_body.user_key(), *rsp_body.mutable_rank_records(),
+      req_body.max_staleness_version()));
   rsp_body.set_result(ret);
   TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SUCCESS);
 }
@@ -42,6 +42,13 @@ RANK_SERVICE_API task_action_rank_get_special_one_front_back::result_type task_a
                req_body.rank_key().rank_instance_id(), req_body.rank_key().sub_rank_type(), req_body.rank_key().sub_rank_instance_id(), logic_config::me()->get_local_server_id());
     TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_IS_NOT_SLAVE);
   }
+  if (!rank->is_readable(req_body.max_staleness_version())) {
+    FWLOGDEBUG("rank:({}:{}:{}:{}) data is too stale, staleness:{} max_staleness:{}", req_body.rank_key().rank_type(),
+               req_body.rank_key().rank_instance_id(), req_body.rank_key().sub_rank_type(),
+               req_body.rank_key().sub_rank_instance_id(), rank->get_data_staleness(), req_body.max_staleness_version());
+    rsp_body.set_result(PROJECT_NAMESPACE_ID::EN_ERR_RANK_DATA_TOO_STALE);
+    TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SUCCESS);
+  }
 
   auto ret = rank->query_rank_user_front_back(req_body.user_key(), req_body.count(), *rsp_body.mutable_data());
   rsp_body.set_result(ret);
@@ -36,7 +36,8 @@ RANK_SERVICE_API task_action_rank_get_top::result_type task_action_rank_get_top:
   }
 
   int32_t ret = RPC_AWAIT_CODE_RESULT(rank_manager::me()->query_top(
-      get_shared_context(), req_body.rank_key(), req_body.start_no(), req_body.count(), *rsp_body.mutable_data()));
+      get_shared_context(), req_body.rank_key(), req_body.start_no(), req_body.count(), *rsp_body.mutable_data(),
+      req_body.max_staleness_version()));
   rsp_body.set_result(ret);
   TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SUCCESS);
 }
@@ -45,6 +45,8 @@ RANK_SERVICE_API task_action_rank_heartbeat::result_type task_action_rank_heartb
                   rank_ptr->get_router_data().router_version(), req_body.router_version());
   }
   rank_ptr->slave_confirm_info(get_shared_context(), get_request_node_id(), req_body.data_version());
+  protobuf_copy_message(*rsp_body.mutable_rank_key(), req_body.rank_key());
+  rsp_body.set_data_version(rank_ptr->get_data_version());
 
   TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SUCCESS);
 }
@@ -75,7 +75,7 @@ RANK_SERVICE_API task_action_rank_switch_to_slave::result_type task_action_rank_
                  req_body.rank_key().rank_instance_id(), req_body.rank_key().sub_rank_type(),
                  req_body.rank_key().sub_rank_instance_id(), rank_ptr->get_data_version(), req_body.data_version());
   }
-  rank_ptr->switch_to_slave(get_shared_context(), req_body.router_data());
+  rank_ptr->switch_to_slave(get_shared_context(), req_body.router_data(), req_body.data_version());
   FWLOGDEBUG("req_node:{} cur_node:{} rank:({}:{}:{}:{}) switch to slave success", get_request_node_id(),
              logic_config::me()->get_local_server_id(), req_body.rank_key().rank_type(),
              req_body.rank_key().rank_instance_id(), req_body.rank_key().sub_rank_type(),
@@ -28,8 +28,12 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <map>
+#include <set>
 #include <utility>
+#include <vector>
 
+#include "logic/rank_manager.h"
 #include "logic/rank_mirror_manager.h"
 #include "logic/rank_wal_handle.h"
 #include "memory/rc_ptr.h"
@@ -37,15 +41,19 @@
 #include "rpc/db/local_db_interface.h"
 #include "rpc/rank/ranksvrservice.h"
 #include "rpc/rpc_async_invoke.h"
+#include "rpc/rpc_utils.h"
 
 #include <rank/logic_rank_algorithm.h>
 #include <rank/logic_rank_handle.h>
+#include <rank/logic_rank_mirror.h>
+#include <rank/logic_rank_tree.h>
 
 #include "rpc/rpc_common_types.h"
 
 rank::rank(const PROJECT_NAMESPACE_ID::DRankKey& rank_key, uint32_t capacity, compare_fn_t compare_fn,
            int64_t data_version)
     : capacity_(capacity),
+      compare_fn_(compare_fn),
       data_version_(data_version),
 
       next_daily_settlement_id_(0),
@@ -54,12 +62,18 @@ rank::rank(const PROJECT_NAMESPACE_ID::DRankKey& rank_key, uint32_t capacity, co
       is_saving_mirror_(false) {
   btree_ = atfw::memory::stl::make_strong_rc<rank_tree>(
       static_cast<size_t>(logic_config::me()->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>().rank_btree_degree()),
-      logic_config::me()->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>().rank_history_version_max_count(), compare_fn);
+      logic_config::me()->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>().rank_history_version_max_count(),
+      [compare_fn](const PROJECT_NAMESPACE_ID::rank_storage_data& l, const PROJECT_NAMESPACE_ID::rank_storage_data& r) {
+        return compare_fn(l.sort_data(), r.sort_data());
+      });
   key_.set_rank_type(rank_key.rank_type());
   key_.set_rank_instance_id(rank_key.rank_instance_id());
   key_.set_sub_rank_type(rank_key.sub_rank_type());
   key_.set_sub_rank_instance_id(rank_key.sub_rank_instance_id());
   mirror_manager_ = atfw::memory::stl::make_strong_rc<rank_mirror_manager>(this);
+  mirror_delta_max_percent_ = logic_config::me()
+                                  ->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>()
+                                  .rank_mirror_delta_max_percent();
   last_save_time_ = util::time::time_utility::get_now();
 }
 
@@ -70,29 +84,38 @@ int rank::tick() {
   return ret;
 }
 
-void rank::del_data_from_btree(const PROJECT_NAMESPACE_ID::rank_sort_data& score) { btree_->erase(score); }
+void rank::del_data_from_btree(const PROJECT_NAMESPACE_ID::rank_storage_data& data) { btree_->erase(data); }
 
-void rank::insert_data_from_btree(const PROJECT_NAMESPACE_ID::rank_sort_data& score) {
-  while (btree_->size() > capacity_) {
-    auto min_key = btree_->get_min_key();
-    del_data_from_btree(*min_key);
-    mp_.erase(min_key->key());
-    FWRLOGDEBUG(*this, "btree test del usr:{}.{}", min_key->key().user_id(), min_key->key().zone_id());
-  }
+void rank::insert_data_from_btree(const rank_tree::value_pointer& data) {
+  const PROJECT_NAMESPACE_ID::rank_sort_data& score = data->sort_data();
   FWRLOGDEBUG(*this, "btree test insert start usr:{}.{} score:{}", score.key().user_id(), score.key().zone_id(),
               score.value().score());
-  btree_->insert(score);
+  btree_->insert(data);
   FWRLOGDEBUG(*this, "btree test insert finish usr:{}.{} score:{}", score.key().user_id(), score.key().zone_id(),
               score.value().score());
+  // 先插入再移除，新数据排在最后时自己会被移出榜单，榜单不会超过容量
+  logic_rank_remove_over_capacity(*btree_, mp_, capacity_,
+                                  [this](const PROJECT_NAMESPACE_ID::rank_storage_data& removed) {
+                                    mark_mirror_dirty(removed.sort_data().key());
+                                    FWRLOGDEBUG(*this, "btree test del usr:{}.{}", removed.sort_data().key().user_id(),
+                                                removed.sort_data().key().zone_id());
+                                  });
 }
 
 void rank::refresh_limit_second(rpc::context& ctx, time_t now_tm) {
-  if (is_slave_node() &&
-      now_tm - last_heartbeat_time_ > logic_config::me()
-                                          ->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>()
-                                          .rank_refresh_limit_second_interval()
-                                          .seconds()) {
-    async_heartbeat(ctx);
+  // 每次更新分数都要判定增量比例，配置在这里定期刷新
+  mirror_delta_max_percent_ = logic_config::me()
+                                  ->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>()
+                                  .rank_mirror_delta_max_percent();
+
+  if (is_slave_node()) {
+    const auto& ranking_cfg = logic_config::me()->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>();
+    // 主节点按确认的版本号做流控时，从节点每秒上报一次版本号
+    bool need_confirm = ranking_cfg.pushlisher_congihure().max_unconfirmed_log_count() > 0 &&
+                        last_heartbeat_data_version_ != get_data_version();
+    if (need_confirm || now_tm - last_heartbeat_time_ > ranking_cfg.rank_refresh_limit_second_interval().seconds()) {
+      async_heartbeat(ctx);
+    }
   }
 
   auto router_lock_timeout = logic_config::me()
@@ -132,11 +155,16 @@ void rank::slave_confirm_info(rpc::context& ctx, uint64_t slave_node, int64_t da
     rank_wal_subscriber_private_data private_data_ptr =
         util::memory::make_strong_rc<PROJECT_NAMESPACE_ID::DRankSubscriberData>();
     private_data_ptr->set_server_id(slave_node);
+    private_data_ptr->set_confirmed_data_version(data_version);
     protobuf_copy_message(*private_data_ptr->mutable_rank_key(), get_key());
 
     subscriber = wal_publisher_->create_subscriber(slave_node, now, data_version, wal_ctx, private_data_ptr);
     FWRLOGDEBUG(*this, "add slave subscriber success slave_node:{} data_version:{}", slave_node, data_version);
   } else {
+    if (subscriber->get_private_data()) {
+      subscriber->get_private_data()->set_confirmed_data_version(data_version);
+    }
+    // 从节点落后时从日志中补发确认版本之后的事件
     wal_publisher_->receive_subscribe_request(slave_node, data_version, now, wal_ctx);
     FWRLOGDEBUG(*this, "slave subscriber confirm slave_node:{} data_version:{}", slave_node, data_version);
   }
@@ -144,8 +172,8 @@ void rank::slave_confirm_info(rpc::context& ctx, uint64_t slave_node, int64_t da
 
 void rank::increase_data_version() { data_version_++; }
 
-int32_t rank::update_score(const PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore& data) {
-  PROJECT_NAMESPACE_ID::rank_storage_data storage_data;
+static void rank_make_storage_data(const PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore& data,
+                                   PROJECT_NAMESPACE_ID::rank_storage_data& storage_data) {
   protobuf_copy_message(*storage_data.mutable_custom_data(), data.custom_data());
   protobuf_copy_message(*storage_data.mutable_sort_data()->mutable_key(), data.user_key());
   storage_data.mutable_sort_data()->mutable_value()->set_score(data.score());
@@ -154,26 +182,187 @@ int32_t rank::update_score(const PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore
   if (storage_data.sort_data().value().submit_timepoint() == 0) {
     storage_data.mutable_sort_data()->mutable_value()->set_submit_timepoint(util::time::time_utility::get_now());
   }
+}
+
+int32_t rank::update_score(const PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore& data) {
+  PROJECT_NAMESPACE_ID::rank_storage_data storage_data;
+  rank_make_storage_data(data, storage_data);
   return update_score(storage_data);
 }
 
 int32_t rank::update_score(const PROJECT_NAMESPACE_ID::rank_storage_data& data) {
-  if (data.sort_data().value().score() < 0) {
-    return PROJECT_NAMESPACE_ID::EN_ERR_RANK_SCORE_INVALID;
+  int32_t ret = apply_update_score(data);
+  if (ret != 0) {
+    return ret;
   }
+  increase_data_version();
+  return 0;
+}
 
-  auto iter = mp_.find(data.sort_data().key());
-  if (iter != mp_.end()) {
-    // 先删除原来的分数
-    del_data_from_btree(mp_[data.sort_data().key()].sort_data());
+int32_t rank::batch_update_score(
+    const google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore>& data,
+    PROJECT_NAMESPACE_ID::DRankEventBatchUpdateUserScore* applied,
+    google::protobuf::RepeatedField<int32_t>* results) {
+  // 从后往前找出每个玩家的最后一次更新，然后按原来的顺序执行，保证和逐条执行的结果一致
+  // 被覆盖的更新记录生效的那次更新的下标，返回相同的结果
+  std::map<PROJECT_NAMESPACE_ID::DRankUserKey, int> visited_users;
+  std::vector<int> apply_indexes;
+  std::vector<int> result_indexes;
+  apply_indexes.reserve(static_cast<size_t>(data.size()));
+  result_indexes.resize(static_cast<size_t>(data.size()));
+  for (int i = data.size() - 1; i >= 0; --i) {
+    auto res = visited_users.emplace(data.Get(i).user_key(), i);
+    if (res.second) {
+      apply_indexes.push_back(i);
+    }
+    result_indexes[static_cast<size_t>(i)] = res.first->second;
+  }
+  if (nullptr != results) {
+    results->Clear();
+    results->Resize(data.size(), 0);
+  }
+
+  int32_t ret = 0;
+  size_t applied_count = 0;
+  PROJECT_NAMESPACE_ID::rank_storage_data storage_data;
+  for (auto iter = apply_indexes.rbegin(); iter != apply_indexes.rend(); ++iter) {
+    const PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore& unit = data.Get(*iter);
+    storage_data.Clear();
+    rank_make_storage_data(unit, storage_data);
+    int32_t res = apply_update_score(storage_data);
+    if (nullptr != results) {
+      results->Set(*iter, res);
+    }
+    if (res != 0) {
+      FWRLOGWARNING(*this, "batch update score for user:{}.{} score:{} failed, res: {}", unit.user_key().user_id(),
+                    unit.user_key().zone_id(), unit.score(), res);
+      if (0 == ret) {
+        ret = res;
+      }
+      continue;
+    }
+
+    ++applied_count;
+    if (nullptr != applied) {
+      protobuf_copy_message(*applied->add_updates(), unit);
+    }
+  }
+
+  if (nullptr != results) {
+    for (int i = 0; i < data.size(); ++i) {
+      results->Set(i, results->Get(result_indexes[static_cast<size_t>(i)]));
+    }
+  }
+
+  // 整批只占用一个数据版本，同步给从节点时也只有一条事件
+  if (applied_count > 0) {
+    increase_data_version();
+  }
+  return ret;
+}
+
+int32_t rank::apply_update_score(const PROJECT_NAMESPACE_ID::rank_storage_data& data) {
+  if (!logic_rank_upsert_data(*btree_, mp_, capacity_, data,
+                              [this](const PROJECT_NAMESPACE_ID::DRankUserKey& key) { mark_mirror_dirty(key); })) {
+    return PROJECT_NAMESPACE_ID::EN_ERR_RANK_SCORE_INVALID;
   }
-  mp_[data.sort_data().key()] = data;
-  // 之前的删除操作时一个内部临时处理，不应该保存版本
-  insert_data_from_btree(mp_[data.sort_data().key()].sort_data());
-  increase_data_version();
   return 0;
 }
 
+void rank::restore_from_mirror(
+    const std::vector<atfw::util::memory::strong_rc_ptr<rpc::shared_message<PROJECT_NAMESPACE_ID::table_rank_mirror>>>&
+        db_data) {
+  // 镜像是按树的顺序分片保存的，分片按顺序合并后就是有序的，可以直接批量建树，不需要逐个插入
+  // 数据版本号由调用方按镜像中记录的版本设置，这里不修改
+  size_t total_count = 0;
+  for (const auto& table : db_data) {
+    total_count += static_cast<size_t>(table->get()->blob_data().data_size());
+  }
+
+  std::vector<rank_tree::value_pointer> values;
+  values.reserve(total_count < capacity_ ? total_count : static_cast<size_t>(capacity_));
+  bool bulk_load = true;
+  for (const auto& table : db_data) {
+    for (const auto& unit : table->get()->blob_data().data()) {
+      if (values.size() >= capacity_) {
+        break;
+      }
+      if (unit.data().sort_data().value().score() < 0) {
+        continue;
+      }
+
+      rank_tree::value_pointer value = btree_->make_value(unit.data());
+      if (!mp_.emplace(unit.data().sort_data().key(), value).second) {
+        // 重复的玩家按逐条更新的规则处理
+        bulk_load = false;
+        break;
+      }
+      values.push_back(value);
+    }
+
+    if (!bulk_load || values.size() >= capacity_) {
+      break;
+    }
+  }
+
+  if (bulk_load && !btree_->is_sorted(values)) {
+    bulk_load = false;
+  }
+
+  if (bulk_load) {
+    btree_->assign_sorted(values);
+    reset_mirror_dirty(false);
+    FWRLOGDEBUG(*this, "restore {} users from mirror by bulk load", values.size());
+    return;
+  }
+
+  // 旧版本保存的数据或者数据异常时退化为逐条插入
+  FWRLOGWARNING(*this, "mirror data can not be bulk loaded, restore {} users one by one", total_count);
+  mp_.clear();
+  btree_->clear();
+  for (const auto& table : db_data) {
+    for (const auto& unit : table->get()->blob_data().data()) {
+      apply_update_score(unit.data());
+    }
+  }
+  reset_mirror_dirty(false);
+}
+
+void rank::apply_mirror_delta(
+    const std::vector<atfw::util::memory::strong_rc_ptr<rpc::shared_message<PROJECT_NAMESPACE_ID::table_rank_mirror>>>&
+        db_data) {
+  // 增量镜像里是相对全量镜像变化过的玩家的最新数据，应用后这些玩家仍然要记录为变化，下一个增量镜像才是完整的
+  size_t apply_count = 0;
+  for (const auto& table : db_data) {
+    apply_count += logic_rank_apply_mirror_delta(
+        *btree_, mp_, table->get()->blob_data(),
+        [this](const PROJECT_NAMESPACE_ID::DRankUserKey& key) { mark_mirror_dirty(key); });
+  }
+  // 分片都应用完成后才能按容量移除，正常情况下不会有数据被移除
+  logic_rank_remove_over_capacity(
+      *btree_, mp_, capacity_,
+      [this](const PROJECT_NAMESPACE_ID::rank_storage_data& removed) { mark_mirror_dirty(removed.sort_data().key()); });
+  FWRLOGDEBUG(*this, "apply mirror delta, {} users", apply_count);
+}
+
+void rank::mark_mirror_dirty(const PROJECT_NAMESPACE_ID::DRankUserKey& key) {
+  if (mirror_dirty_all_) {
+    return;
+  }
+
+  mirror_dirty_users_.insert(key);
+  if (mirror_delta_max_percent_ <= 0 ||
+      mirror_dirty_users_.size() * 100 > btree_->size() * static_cast<size_t>(mirror_delta_max_percent_)) {
+    // 增量比例太大时下次直接保存全量镜像，不再记录变化的玩家
+    reset_mirror_dirty(true);
+  }
+}
+
+void rank::reset_mirror_dirty(bool dirty_all) {
+  mirror_dirty_users_.clear();
+  mirror_dirty_all_ = dirty_all;
+}
+
 int32_t rank::modify_score(const PROJECT_NAMESPACE_ID::rank_storage_data& data) {
   auto iter = mp_.find(data.sort_data().key());
   int64_t origin_score = 0;
@@ -181,9 +370,10 @@ int32_t rank::modify_score(const PROJECT_NAMESPACE_ID::rank_storage_data& data)
 
   if (iter != mp_.end()) {
     // 先删除原来的分数
-    del_data_from_btree(mp_[data.sort_data().key()].sort_data());
-    origin_score = mp_[data.sort_data().key()].sort_data().value().score();
+    del_data_from_btree(*iter->second);
+    origin_score = iter->second->sort_data().value().score();
   }
+  mark_mirror_dirty(data.sort_data().key());
   int64_t now_score = origin_score + data.sort_data().value().score();
   if (now_score < 0) {
     now_score = 0;
@@ -191,12 +381,16 @@ int32_t rank::modify_score(const PROJECT_NAMESPACE_ID::rank_storage_data& data)
 
   if (now_score == 0) {
     // 0分自动下榜
+    if (iter != mp_.end()) {
+      mp_.erase(iter);
+    }
     return 0;
   }
 
-  mp_[data.sort_data().key()] = data;
-  mp_[data.sort_data().key()].mutable_sort_data()->mutable_value()->set_score(now_score);
-  insert_data_from_btree(mp_[data.sort_data().key()].sort_data());
+  rank_tree::value_pointer value = btree_->make_value(data);
+  value->mutable_sort_data()->mutable_value()->set_score(now_score);
+  mp_[data.sort_data().key()] = value;
+  insert_data_from_btree(value);
   return 0;
 }
 
@@ -207,14 +401,16 @@ int32_t rank::del_one_user(const PROJECT_NAMESPACE_ID::DRankUserKey& key) {
     return 0;
   }
   increase_data_version();
-  del_data_from_btree(mp_[key].sort_data());
-  mp_.erase(key);
+  del_data_from_btree(*iter->second);
+  mp_.erase(iter);
+  mark_mirror_dirty(key);
   return 0;
 }
 
 int32_t rank::clear_rank() {
   increase_data_version();
   btree_->clear();
+  reset_mirror_dirty(true);
   return 0;
 }
 
@@ -224,91 +420,75 @@ int32_t rank::query_one_user_by_key(const PROJECT_NAMESPACE_ID::DRankUserKey& ke
   if (iter == mp_.end()) {
     return PROJECT_NAMESPACE_ID::EN_ERR_RANK_USER_NOT_FOUND;
   }
-  size_t rank_no = btree_->index(iter->second.sort_data());
-  rank_util::dump_rank_basic_board_from_rank_data(iter->second, output);
+  size_t rank_no = btree_->index(*iter->second);
+  rank_util::dump_rank_basic_board_from_rank_data(*iter->second, output);
   output.set_rank_no(static_cast<uint32_t>(rank_no));
   return 0;
 }
 
-int32_t rank::query_one_user_by_score(ATFW_EXPLICIT_UNUSED_ATTR const PROJECT_NAMESPACE_ID::rank_sort_score& key,
-                                      ATFW_EXPLICIT_UNUSED_ATTR PROJECT_NAMESPACE_ID::rank_data& output) {
-  return 0;
-}
-
-int32_t rank::query_rank_top(uint32_t from, uint32_t count, PROJECT_NAMESPACE_ID::DRankQueryRspData& output) {
-  if (from == 0 || count == 0) {
-    return 0;
-  }
-
-  if (count > logic_config::me()->get_server_cfg().rank().query_max_count()) {
-    count = logic_config::me()->get_server_cfg().rank().query_max_count();
+int32_t rank::query_one_user_by_score(const PROJECT_NAMESPACE_ID::rank_sort_score& key,
+                                      PROJECT_NAMESPACE_ID::rank_data& output) {
+  if (nullptr == compare_fn_) {
+    return PROJECT_NAMESPACE_ID::EN_ERR_RANK_NO_NOT_FOUND;
   }
 
-  std::vector<util::memory::strong_rc_ptr<PROJECT_NAMESPACE_ID::rank_sort_data>> result;
-  btree_->batch_query(static_cast<size_t>(from), static_cast<size_t>(count), result);
-
-  FWRLOGDEBUG(*this, "query_rank_top count {}", result.size());
+  // 分数不同时比较函数不会比较玩家key，所以这里只需要填充分数
+  PROJECT_NAMESPACE_ID::rank_sort_data probe;
+  protobuf_copy_message(*probe.mutable_value(), key);
+  size_t before_count = btree_->count_prefix([this, &probe](const PROJECT_NAMESPACE_ID::rank_storage_data& value) {
+    return !(value.sort_data().value() == probe.value()) && compare_fn_(value.sort_data(), probe);
+  });
 
-  for (auto& unit : result) {
-    if (mp_.find(unit->key()) != mp_.end()) {
-      auto data = output.mutable_rank_records()->Add();
-      if (data) {
-        rank_util::dump_rank_basic_board_from_rank_data(mp_[unit->key()], *data);
-        data->set_rank_no(from);
-      }
-      from++;
+  size_t rank_no = before_count + 1;
+  btree_->visit_range(rank_no, 1, [&key, &output](size_t, const rank_tree::value_pointer& value) {
+    if (value->sort_data().value() == key) {
+      protobuf_copy_message(*output.mutable_data(), *value);
     }
-  }
-  output.set_rank_total_count(static_cast<uint32_t>(btree_->size()));
+    return false;
+  });
+  output.set_rank_no(static_cast<uint32_t>(rank_no));
+  return 0;
+}
+
+int32_t rank::query_rank_top(uint32_t from, uint32_t count, PROJECT_NAMESPACE_ID::DRankQueryRspData& output) {
+  size_t result_count = logic_rank_dump_top(*btree_, from, count, rank_util::get_rank_query_max_count(), output);
+  FWRLOGDEBUG(*this, "query_rank_top count {}", result_count);
   return 0;
 }
 
 int32_t rank::query_one_user_by_rank_no(int32_t rank_no, PROJECT_NAMESPACE_ID::rank_data& output) {
-  auto iter = btree_->at(static_cast<size_t>(rank_no));
-  if (iter == btree_->end()) {
+  if (!logic_rank_dump_data_by_rank_no(*btree_, rank_no, output)) {
     return PROJECT_NAMESPACE_ID::EN_ERR_RANK_NO_NOT_FOUND;
   }
-  auto mp_iter = mp_.find((*iter).key());
-  if (mp_iter == mp_.end()) {
-    return PROJECT_NAMESPACE_ID::EN_ERR_RANK_NO_HAS_BUT_NO_FOUND_DETAIL_DATA;
-  }
-  protobuf_copy_message(*output.mutable_data(), mp_iter->second);
-  output.set_rank_no(static_cast<uint32_t>(rank_no));
   return 0;
 }
 
 int32_t rank::query_rank_user_front_back(const PROJECT_NAMESPACE_ID::DRankUserKey& key, uint32_t count,
                                          PROJECT_NAMESPACE_ID::DRankQueryRspData& output) {
-  if (2 * count > logic_config::me()->get_server_cfg().rank().query_max_count()) {
-    count = logic_config::me()->get_server_cfg().rank().query_max_count() / 2;
-  }
   auto iter = mp_.find(key);
   if (iter == mp_.end()) {
     // 不在榜上
     return PROJECT_NAMESPACE_ID::EN_ERR_RANK_USER_NOT_FOUND;
   }
-  uint32_t rank_no = static_cast<uint32_t>(btree_->index(iter->second.sort_data()));
-  auto start_no = rank_no > count ? rank_no - count : 1;
-  auto real_count = start_no == 1 ? (count + rank_no) : (2 * count + 1);
+  uint32_t rank_no = static_cast<uint32_t>(btree_->index(*iter->second));
+  uint32_t start_no = 0;
+  uint32_t real_count = 0;
+  rank_util::get_rank_front_back_range(rank_no, count, rank_util::get_rank_query_max_count(), start_no, real_count);
   FWRLOGDEBUG(*this, "query_rank_user_front_back user:{} rank_no:{} start_no:{} count {} real_count:{}", key.user_id(),
               rank_no, start_no, count, real_count);
   return query_rank_top(start_no, real_count, output);
 }
 
 void rank::fetch_rank_data(google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::rank_data>& output) {
-  std::vector<util::memory::strong_rc_ptr<PROJECT_NAMESPACE_ID::rank_sort_data>> result;
-  btree_->get_preorder_traversal(result);
-  uint32_t rank_no = 0;
-  for (const auto& unit : result) {
-    rank_no++;
-    if (mp_.find(unit->key()) != mp_.end()) {
-      auto ptr = output.Add();
-      if (ptr) {
-        ptr->set_rank_no(rank_no);
-        protobuf_copy_message(*ptr->mutable_data(), mp_[unit->key()]);
-      }
+  output.Reserve(static_cast<int>(btree_->size()));
+  btree_->visit_range(1, btree_->size(), [&output](size_t rank_no, const rank_tree::value_pointer& unit) {
+    auto ptr = output.Add();
+    if (ptr) {
+      ptr->set_rank_no(static_cast<uint32_t>(rank_no));
+      protobuf_copy_message(*ptr->mutable_data(), *unit);
     }
-  }
+    return true;
+  });
   return;
 }
 
@@ -352,24 +532,42 @@ rpc::result_code_type rank::init_rank_from_db(rpc::context& ctx) {
         }
         auto& mirror_meta_data = rank_ptr->mirror_manager_->get_rank_mirror_meta_data();
         if (mirror_meta_data.last_save_mirror().mirror_id() > 0) {
+          // 增量镜像需要先加载它依赖的全量镜像
+          PROJECT_NAMESPACE_ID::rank_mirror_meta_info full_mirror;
+          if (mirror_meta_data.last_save_mirror().base_mirror_id() > 0) {
+            full_mirror.set_mirror_id(mirror_meta_data.last_save_mirror().base_mirror_id());
+            full_mirror.set_max_slice_count(mirror_meta_data.last_save_mirror().base_max_slice_count());
+          } else {
+            protobuf_copy_message(full_mirror, mirror_meta_data.last_save_mirror());
+          }
+
           std::vector<atfw::util::memory::strong_rc_ptr<rpc::shared_message<PROJECT_NAMESPACE_ID::table_rank_mirror>>>
               db_data;
-          ret = RPC_AWAIT_CODE_RESULT(rank_ptr->mirror_manager_->get_mirror_data_from_db(
-              child_ctx, mirror_meta_data.last_save_mirror(), db_data));
+          ret = RPC_AWAIT_CODE_RESULT(rank_ptr->mirror_manager_->get_mirror_data_from_db(child_ctx, full_mirror, db_data));
           if (ret != 0) {
-            FWRLOGDEBUG(*rank_ptr.get(), "get_mirror_data_from_db failed mirror:{} ret:{}",
-                        mirror_meta_data.last_save_mirror().mirror_id(), ret);
+            FWRLOGDEBUG(*rank_ptr.get(), "get_mirror_data_from_db failed mirror:{} ret:{}", full_mirror.mirror_id(),
+                        ret);
             RPC_RETURN_CODE(ret);
           }
           // 恢复榜单数据
-          for (const auto& table : db_data) {
-            for (const auto& unit : table->get()->blob_data().data()) {
-              rank_ptr->update_score(unit.data());
-            }
-          }
+          rank_ptr->restore_from_mirror(db_data);
           if (!db_data.empty()) {
             rank_ptr->data_version_ = db_data[0]->get()->data_version();
           }
+
+          if (mirror_meta_data.last_save_mirror().base_mirror_id() > 0) {
+            db_data.clear();
+            ret = RPC_AWAIT_CODE_RESULT(rank_ptr->mirror_manager_->get_mirror_data_from_db(
+                child_ctx, mirror_meta_data.last_save_mirror(), db_data));
+            if (ret != 0) {
+              FWRLOGDEBUG(*rank_ptr.get(), "get_mirror_data_from_db failed mirror:{} ret:{}",
+                          mirror_meta_data.last_save_mirror().mirror_id(), ret);
+              RPC_RETURN_CODE(ret);
+            }
+            rank_ptr->apply_mirror_delta(db_data);
+            // 增量镜像可能没有任何分片，版本号以元数据为准
+            rank_ptr->data_version_ = rank_ptr->mirror_manager_->get_last_data_version();
+          }
         }
 
         rank_ptr->is_init_ = true;
@@ -408,6 +606,37 @@ bool rank::is_slave_node() const {
 
 bool rank::is_readable() const { return is_main_node() || is_slave_node(); }
 
+bool rank::is_readable(int64_t max_staleness_version) const {
+  if (is_main_node()) {
+    return true;
+  }
+  if (!is_slave_node()) {
+    return false;
+  }
+  return rank_util::is_slave_data_readable(
+      data_version_, main_data_version_, max_staleness_version, main_data_version_refresh_time_,
+      util::time::time_utility::get_now(),
+      logic_config::me()
+          ->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>()
+          .rank_slave_max_stale_duration()
+          .seconds());
+}
+
+int64_t rank::get_data_staleness() const {
+  if (main_data_version_ <= data_version_) {
+    return 0;
+  }
+  return main_data_version_ - data_version_;
+}
+
+void rank::update_main_data_version(int64_t main_data_version) {
+  // 版本号没有变化也说明和主节点的同步是正常的
+  main_data_version_refresh_time_ = util::time::time_utility::get_now();
+  if (main_data_version > main_data_version_) {
+    main_data_version_ = main_data_version;
+  }
+}
+
 const PROJECT_NAMESPACE_ID::DRankRouterData& rank::get_router_data() const { return router_data_; }
 
 rpc::result_code_type rank::switch_to_main(rpc::context& ctx, const PROJECT_NAMESPACE_ID::table_rank_router& db_router,
@@ -429,8 +658,12 @@ void rank::set_router_data(const PROJECT_NAMESPACE_ID::table_rank_router& db_rou
   router_data_.set_router_version(db_router_version);
 }
 
-void rank::switch_to_slave(rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankRouterData& router_data) {
+void rank::switch_to_slave(rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankRouterData& router_data,
+                           int64_t main_data_version) {
   protobuf_copy_message(router_data_, router_data);
+  // 主节点可能切换到版本号更低的节点，这里直接覆盖
+  main_data_version_ = main_data_version;
+  main_data_version_refresh_time_ = util::time::time_utility::get_now();
   async_heartbeat(ctx);
 }
 
@@ -491,6 +724,7 @@ void rank::async_heartbeat(rpc::context& ctx) {
     return;
   }
   is_heartbeat_running_ = true;
+  last_heartbeat_data_version_ = get_data_version();
   auto rank_ptr = this->shared_from_this();
   auto invoke_task = rpc::async_invoke(
       ctx, "rank.heartbeat", [main_server_id, rank_ptr](rpc::context& child_ctx) -> rpc::result_code_type {
@@ -502,6 +736,8 @@ void rank::async_heartbeat(rpc::context& ctx) {
         if (ret != 0) {
           FWRLOGERROR(*rank_ptr.get(), "heartbeat failed main:{} slave:{} ret {}", main_server_id,
                       logic_config::me()->get_local_server_id(), ret);
+        } else {
+          rank_ptr->update_main_data_version(rsp.data_version());
         }
         rank_ptr->last_heartbeat_time_ = util::time::time_utility::get_now();
         RPC_RETURN_CODE(0);
@@ -587,11 +823,50 @@ void rank::broadcast_events(rpc::context& ctx, PROJECT_NAMESPACE_ID::DRankEventL
     FWRLOGERROR(*this, "emplace_back_log failed version:{} ret {}", get_data_version(), static_cast<int>(res))
     return;
   }
+  FWRLOGDEBUG(*this, "emplace_back_log finish version:{}", get_data_version())
+
+  // 热门榜单的更新很密集，短时间内的事件合并成一次广播，每个从节点只收到一个消息
+  ++pending_event_count_;
+  const auto& publisher_cfg = logic_config::me()
+                                  ->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>()
+                                  .pushlisher_congihure();
+  auto broadcast_interval = rpc::make_duration(publisher_cfg.broadcast_interval());
+  if (broadcast_interval <= std::chrono::system_clock::duration::zero() ||
+      pending_event_count_ >= static_cast<size_t>(publisher_cfg.broadcast_max_log_count())) {
+    flush_events(ctx);
+    return;
+  }
+
+  if (!is_events_flush_scheduled_) {
+    // 第一个事件决定本批次的广播时间
+    is_events_flush_scheduled_ = true;
+    events_flush_timepoint_ = util::time::time_utility::now() + broadcast_interval;
+    rank_manager::me()->add_events_flush_rank(shared_from_this());
+  }
+}
+
+void rank::flush_events(rpc::context& ctx) {
+  if (!wal_publisher_ || 0 == pending_event_count_) {
+    return;
+  }
+
+  int32_t ret = 0;
+  rank_wal_publisher_context wal_ctx{ctx, ret};
   wal_publisher_->broadcast(wal_ctx);
 
   // Recycle expired logs
   wal_publisher_->tick(util::time::time_utility::now(), wal_ctx);
-  FWRLOGDEBUG(*this, "emplace_back_log finish version:{}", get_data_version())
+  FWRLOGDEBUG(*this, "broadcast {} events finish version:{}", pending_event_count_, get_data_version())
+  pending_event_count_ = 0;
+}
+
+void rank::request_event_resync(rpc::context& ctx) {
+  auto now_tm = util::time::time_utility::get_now();
+  if (!is_slave_node() || last_resync_time_ == now_tm) {
+    return;
+  }
+  last_resync_time_ = now_tm;
+  async_heartbeat(ctx);
 }
 
 bool rank::is_task_running(task_type_trait::task_type& task) {
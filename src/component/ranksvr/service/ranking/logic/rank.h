@@ -22,10 +22,12 @@
 #include <rpc/rpc_common_types.h>
 #include <stdint.h>
 #include <utility/persistent_btree.h>
+#include <chrono>
 #include <cstddef>
 #include <ctime>
 #include <deque>
 #include <map>
+#include <set>
 #include <unordered_map>
 
 #include "config/logic_config.h"
@@ -64,6 +66,13 @@ class rank : public util::memory::enable_shared_rc_from_this<rank> {
   int32_t query_one_user_by_key(const PROJECT_NAMESPACE_ID::DRankUserKey& key,
                                 PROJECT_NAMESPACE_ID::DRankUserBoardData& output);
 
+  /**
+   * @brief 查询分数对应的排名，排名为分数严格高于key的玩家数+1
+   *
+   * @param key 分数
+   * @param output 返回的数据，如果该排名上的玩家分数和key相同，会同时返回该玩家的数据
+   * @return int32_t
+   */
   int32_t query_one_user_by_score(const PROJECT_NAMESPACE_ID::rank_sort_score& key,
                                   PROJECT_NAMESPACE_ID::rank_data& output);
 
@@ -77,6 +86,19 @@ class rank : public util::memory::enable_shared_rc_from_this<rank> {
   int32_t update_score(const PROJECT_NAMESPACE_ID::rank_storage_data& data);
   int32_t update_score(const PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore& data);
 
+  /**
+   * @brief 批量设置玩家分数，同一个玩家的多次更新只保留最后一次，整批只增加一次数据版本
+   *
+   * @param data 更新列表
+   * @param applied 实际生效的更新，用于生成同步给从节点的事件，不需要时传nullptr
+   * @param results 输出和data一一对应的错误码，不需要时传nullptr
+   * @return int32_t 第一个失败的错误码，其他玩家的更新不受影响
+   */
+  int32_t batch_update_score(
+      const google::protobuf::RepeatedPtrField<PROJECT_NAMESPACE_ID::DRankEventUpdateUserScore>& data,
+      PROJECT_NAMESPACE_ID::DRankEventBatchUpdateUserScore* applied,
+      google::protobuf::RepeatedField<int32_t>* results = nullptr);
+
   int32_t modify_score(const PROJECT_NAMESPACE_ID::rank_storage_data& data);
 
   //   int32_t add_user_score(const PROJECT_NAMESPACE_ID::DRankUserKey& key,
@@ -97,11 +119,18 @@ class rank : public util::memory::enable_shared_rc_from_this<rank> {
   bool is_main_node() const;
   bool is_slave_node() const;
   bool is_readable() const;
+  /* 从节点落后主节点不超过max_staleness_version个数据版本时才可读，max_staleness_version<=0表示不限制
+   * 限制时如果超过rank_slave_max_stale_duration没有收到主节点的数据版本号，也认为不可读
+   */
+  bool is_readable(int64_t max_staleness_version) const;
+  int64_t get_data_staleness() const;
+  void update_main_data_version(int64_t main_data_version);
 
   EXPLICIT_NODISCARD_ATTR rpc::result_code_type switch_to_main(rpc::context& ctx,
                                                                const PROJECT_NAMESPACE_ID::table_rank_router& db_router,
                                                                int32_t db_router_version);
-  void switch_to_slave(rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankRouterData& router_data);
+  void switch_to_slave(rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankRouterData& router_data,
+                       int64_t main_data_version);
   const PROJECT_NAMESPACE_ID::DRankRouterData& get_router_data() const;
   void set_router_data(const PROJECT_NAMESPACE_ID::table_rank_router& db_router, int32_t db_router_version);
 
@@ -114,13 +143,32 @@ class rank : public util::memory::enable_shared_rc_from_this<rank> {
 
   void broadcast_events(rpc::context& ctx, PROJECT_NAMESPACE_ID::DRankEventLog&& log);
 
+  /* 把合并窗口内积累的事件一次广播给所有从节点
+   */
+  void flush_events(rpc::context& ctx);
+  std::chrono::system_clock::time_point get_events_flush_timepoint() const { return events_flush_timepoint_; }
+  void clear_events_flush_scheduled() { is_events_flush_scheduled_ = false; }
+
+  /* 从节点收到的事件不连续时，立刻上报当前版本号让主节点补发
+   */
+  void request_event_resync(rpc::context& ctx);
+
   time_t get_last_save_router_data_time() const { return last_save_router_data_time_; }
 
   util::memory::strong_rc_ptr<rank_mirror_manager> get_mirror_manager() { return mirror_manager_; }
 
  private:
-  void del_data_from_btree(const PROJECT_NAMESPACE_ID::rank_sort_data& score);
-  void insert_data_from_btree(const PROJECT_NAMESPACE_ID::rank_sort_data& score);
+  int32_t apply_update_score(const PROJECT_NAMESPACE_ID::rank_storage_data& data);
+  void restore_from_mirror(
+      const std::vector<atfw::util::memory::strong_rc_ptr<rpc::shared_message<PROJECT_NAMESPACE_ID::table_rank_mirror>>>&
+          db_data);
+  void apply_mirror_delta(
+      const std::vector<atfw::util::memory::strong_rc_ptr<rpc::shared_message<PROJECT_NAMESPACE_ID::table_rank_mirror>>>&
+          db_data);
+  void mark_mirror_dirty(const PROJECT_NAMESPACE_ID::DRankUserKey& key);
+  void reset_mirror_dirty(bool dirty_all);
+  void del_data_from_btree(const PROJECT_NAMESPACE_ID::rank_storage_data& data);
+  void insert_data_from_btree(const rank_tree::value_pointer& data);
   inline int64_t get_next_data_version() { return data_version_; }
 
   EXPLICIT_NODISCARD_ATTR rpc::result_code_type notify_switch_to_slave(rpc::context& ctx);
@@ -136,15 +184,29 @@ class rank : public util::memory::enable_shared_rc_from_this<rank> {
  private:
   PROJECT_NAMESPACE_ID::DRankKey key_;
   uint32_t capacity_;
-  std::map<PROJECT_NAMESPACE_ID::DRankUserKey, PROJECT_NAMESPACE_ID::rank_storage_data> mp_;
+  compare_fn_t compare_fn_;
+  std::map<PROJECT_NAMESPACE_ID::DRankUserKey, rank_tree::value_pointer> mp_;
   util::memory::strong_rc_ptr<rank_tree> btree_;
-  std::deque<util::memory::strong_rc_ptr<btree_node<PROJECT_NAMESPACE_ID::rank_sort_data>>> history_version_;
+  std::deque<rank_tree::btree_node_pointer> history_version_;
   int64_t data_version_;
+  int64_t main_data_version_ = 0;  // 从节点已知的主节点数据版本号，用于计算读取的数据落后程度
+  time_t main_data_version_refresh_time_ = 0;  // 从节点最后一次收到主节点数据版本号的时间
+
+  // 最后一次全量镜像之后变化过的玩家，用于生成增量镜像。变化太多时只记录mirror_dirty_all_，下次保存全量镜像
+  std::set<PROJECT_NAMESPACE_ID::DRankUserKey> mirror_dirty_users_;
+  bool mirror_dirty_all_ = true;
+  int32_t mirror_delta_max_percent_ = 0;  // 缓存的rank_mirror_delta_max_percent配置
 
   PROJECT_NAMESPACE_ID::DRankRouterData router_data_;
   time_t last_save_router_data_time_ = 0;  // 路由表更新时间
   time_t last_heartbeat_time_ = 0;
   bool is_heartbeat_running_ = false;
+  int64_t last_heartbeat_data_version_ = 0;  // 从节点最后一次上报的数据版本号
+  time_t last_resync_time_ = 0;
+
+  size_t pending_event_count_ = 0;  // 还没有广播的事件数量
+  bool is_events_flush_scheduled_ = false;
+  std::chrono::system_clock::time_point events_flush_timepoint_;
 
   task_type_trait::task_type io_task_;
   bool is_init_ = false;
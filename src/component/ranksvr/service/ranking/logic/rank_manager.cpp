@@ -72,6 +72,8 @@ void rank_manager::tick() {
     refresh_limit_second(ctx, now_tm);
     last_refresh_second_ = now_tm;
   }
+
+  flush_rank_events(ctx);
 }
 
 int rank_manager::init() { return 0; }
@@ -103,6 +105,36 @@ void rank_manager::refresh_limit_second(rpc::context& ctx, time_t now_tm) {
   }
 }
 
+void rank_manager::add_events_flush_rank(const rank_ptr_type& rank_ptr) {
+  if (!rank_ptr) {
+    return;
+  }
+  events_flush_ranks_.push_back(rank_ptr);
+}
+
+void rank_manager::flush_rank_events(rpc::context& ctx) {
+  if (events_flush_ranks_.empty()) {
+    return;
+  }
+
+  auto now = util::time::time_utility::now();
+  for (auto iter = events_flush_ranks_.begin(); iter != events_flush_ranks_.end();) {
+    if (!*iter) {
+      iter = events_flush_ranks_.erase(iter);
+      continue;
+    }
+
+    if (now < (*iter)->get_events_flush_timepoint()) {
+      ++iter;
+      continue;
+    }
+
+    (*iter)->clear_events_flush_scheduled();
+    (*iter)->flush_events(ctx);
+    iter = events_flush_ranks_.erase(iter);
+  }
+}
+
 rank_ptr_type rank_manager::get_rank(const PROJECT_NAMESPACE_ID::DRankKey& rank_key) const {
   auto it = rank_map_.find(rank_key);
   if (it != rank_map_.end() && it->second) {
@@ -302,11 +334,18 @@ EXPLICIT_NODISCARD_ATTR rpc::result_code_type rank_manager::modify_score(
 // 查询排行榜接口
 EXPLICIT_NODISCARD_ATTR rpc::result_code_type rank_manager::query_one_user(
     rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank_key,
-    const PROJECT_NAMESPACE_ID::DRankUserKey& sort_key, PROJECT_NAMESPACE_ID::DRankUserBoardData& output) {
+    const PROJECT_NAMESPACE_ID::DRankUserKey& sort_key, PROJECT_NAMESPACE_ID::DRankUserBoardData& output,
+    int64_t max_staleness_version) {
   auto rank_iter = rank_map_.find(rank_key);
   if (rank_iter == rank_map_.end()) {
     RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_NOT_EXIST);
   }
+  if (max_staleness_version > 0 && !rank_iter->second->is_readable(max_staleness_version)) {
+    FWLOGDEBUG("rank({}:{}:{}:{}) data is too stale, staleness:{} max_staleness:{}", rank_key.rank_type(),
+               rank_key.rank_instance_id(), rank_key.sub_rank_type(), rank_key.sub_rank_instance_id(),
+               rank_iter->second->get_data_staleness(), max_staleness_version);
+    RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_DATA_TOO_STALE);
+  }
   int32_t ret = 0;
 
   rank_iter->second->query_one_user_by_key(sort_key, output);
@@ -315,11 +354,18 @@ EXPLICIT_NODISCARD_ATTR rpc::result_code_type rank_manager::query_one_user(
 EXPLICIT_NODISCARD_ATTR rpc::result_code_type rank_manager::query_top(rpc::context& ctx,
                                                                       const PROJECT_NAMESPACE_ID::DRankKey& rank_key,
                                                                       uint32_t from, uint32_t count,
-                                                                      PROJECT_NAMESPACE_ID::DRankQueryRspData& output) {
+                                                                      PROJECT_NAMESPACE_ID::DRankQueryRspData& output,
+                                                                      int64_t max_staleness_version) {
   auto rank_iter = rank_map_.find(rank_key);
   if (rank_iter == rank_map_.end()) {
     RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_NOT_EXIST);
   }
+  if (max_staleness_version > 0 && !rank_iter->second->is_readable(max_staleness_version)) {
+    FWLOGDEBUG("rank({}:{}:{}:{}) data is too stale, staleness:{} max_staleness:{}", rank_key.rank_type(),
+               rank_key.rank_instance_id(), rank_key.sub_rank_type(), rank_key.sub_rank_instance_id(),
+               rank_iter->second->get_data_staleness(), max_staleness_version);
+    RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_DATA_TOO_STALE);
+  }
   int32_t ret = rank_iter->second->query_rank_top(from, count, output);
   RPC_RETURN_CODE(ret);
 }
@@ -3,6 +3,7 @@
 #include <design_pattern/singleton.h>
 #include <cstdint>
 #include <ctime>
+#include <list>
 #include <memory>
 #include <unordered_map>
 
@@ -48,6 +49,12 @@ class rank_manager : public util::design_pattern::singleton<rank_manager> {
 
   void refresh_limit_second(rpc::context& ctx, time_t now_tm);
 
+  /**
+   * @brief 登记有待广播事件的排行榜，合并窗口结束后在tick中统一广播
+   * @param rank_ptr 排行榜对象
+   */
+  void add_events_flush_rank(const rank_ptr_type& rank_ptr);
+
   /**
    * @brief 获取可变排行榜对象
    * @param ctx rpc上下文
@@ -90,13 +97,15 @@ class rank_manager : public util::design_pattern::singleton<rank_manager> {
    * @param key 排行榜key
    * @param sort_key 玩家排序键
    * @param output 返回的玩家排行数据
+   * @param max_staleness_version 从节点允许落后主节点的最大数据版本数，0表示不限制
    * @return rpc::result_code_type
    */
   EXPLICIT_NODISCARD_ATTR rpc::result_code_type query_one_user(rpc::context& ctx,
                                                                const 
                                                                PROJECT_NAMESPACE_ID::DRankKey& rank_key,
                                                                const PROJECT_NAMESPACE_ID::DRankUserKey& sort_key,
-                                                               PROJECT_NAMESPACE_ID::DRankUserBoardData& output);
+                                                               PROJECT_NAMESPACE_ID::DRankUserBoardData& output,
+                                                               int64_t max_staleness_version = 0);
   /**
    * @brief 查询排行数据
    * @param ctx rpc上下文
@@ -104,11 +113,13 @@ class rank_manager : public util::design_pattern::singleton<rank_manager> {
    * @param from 查询的起始位置
    * @param count 查询的数量
    * @param output 返回的排行榜对象
+   * @param max_staleness_version 从节点允许落后主节点的最大数据版本数，0表示不限制
    * @return rpc::result_code_type
    */
   EXPLICIT_NODISCARD_ATTR rpc::result_code_type query_top(rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank_key,
                                                           uint32_t from, uint32_t count,
-                                                          PROJECT_NAMESPACE_ID::DRankQueryRspData& output);
+                                                          PROJECT_NAMESPACE_ID::DRankQueryRspData& output,
+                                                          int64_t max_staleness_version = 0);
 
   inline bool is_running() { return init_ && !closing_; }
   inline bool is_init() { return init_; }
@@ -118,6 +129,7 @@ class rank_manager : public util::design_pattern::singleton<rank_manager> {
 
  private:
   rank::compare_fn_t get_compare_fn(PROJECT_NAMESPACE_ID::EnRankSortType);
+  void flush_rank_events(rpc::context& ctx);
 
   std::vector<uint64_t> get_slave_nodes(rpc::context& ctx, const PROJECT_NAMESPACE_ID::DRankKey& rank,
                                         uint64_t main_node);
@@ -147,4 +159,6 @@ class rank_manager : public util::design_pattern::singleton<rank_manager> {
       PROJECT_NAMESPACE_ID::rank_api::rank_key_hash_type, PROJECT_NAMESPACE_ID::rank_api::rank_key_equal_type>
       load_main_task_mp_;
   time_t last_refresh_second_;
+
+  std::list<rank_ptr_type> events_flush_ranks_;
 };
\ No newline at end of file
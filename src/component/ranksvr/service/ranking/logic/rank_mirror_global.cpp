@@ -10,6 +10,7 @@
 
 #include <config/logic_config.h>
 #include <rpc/db/local_db_interface.h>
+#include <rank/logic_rank_mirror.h>
 #include "log/log_wrapper.h"
 #include "rpc/rpc_async_invoke.h"
 #include "rpc/rpc_common_types.h"
@@ -24,13 +25,12 @@ void rank_mirror_global::tick() {
 
 void rank_mirror_global::add_failed_task(const dump_mirror_task_ptr& task) {
   // 失败的任务重新放到尾部重新执行
-  if (!task || !task->mirror_ptr_) {
+  if (!task || (!task->mirror_ptr_ && !task->is_delta())) {
     return;
   }
   // 重置部分数据
   task->cur_rank_no_ = 0;
   task->cur_slice_index_ = 1;
-  task->iter_ = task->mirror_ptr_->begin();
 
   task_list_.push_back(task);
 }
@@ -92,7 +92,7 @@ rpc::result_code_type rank_mirror_global::tick_dump(rpc::context& ctx) {
   std::list<dump_mirror_task_ptr> failed_task_list;
   while (!task_list_.empty()) {
     auto task = task_list_.front();
-    if (!task || !task->mirror_ptr_) {
+    if (!task || (!task->mirror_ptr_ && !task->is_delta())) {
       task_list_.pop_front();
       continue;
     }
@@ -116,15 +116,28 @@ rpc::result_code_type rank_mirror_global::tick_dump(rpc::context& ctx) {
       db_data->set_per_slice_count(rank_per_slice_max_count);
       db_data->set_rank_total_size(task->total_rank_size_);
       db_data->set_data_version(task->data_version_);
+      db_data->set_base_mirror_id(task->base_mirror_id_);
 
-      while ((task->cur_rank_no_ - begin_rank_no < rank_per_slice_max_count) &&
-             task->iter_ != task->mirror_ptr_->end()) {
-        auto rank_info = db_data->mutable_blob_data()->mutable_data()->Add();
-        if (rank_info) {
-          rank_info->set_rank_no(static_cast<uint32_t>(++task->cur_rank_no_));
-          protobuf_copy_message(*rank_info->mutable_data()->mutable_sort_data(), *task->iter_);
-        }
-        task->iter_++;
+      if (task->is_delta()) {
+        // 增量镜像按玩家分片，只保存玩家的最新数据，不保存排名
+        task->cur_rank_no_ += static_cast<int32_t>(
+            logic_rank_dump_mirror_delta(task->delta_data_, static_cast<size_t>(task->cur_rank_no_),
+                                         static_cast<size_t>(rank_per_slice_max_count), *db_data->mutable_blob_data()));
+      } else {
+        // 按排名分页，镜像中的数据不会变化，失败重试时从头导出即可
+        auto* slice_data = db_data->mutable_blob_data()->mutable_data();
+        slice_data->Reserve(rank_per_slice_max_count);
+        task->mirror_ptr_->visit_range(
+            static_cast<size_t>(begin_rank_no) + 1, static_cast<size_t>(rank_per_slice_max_count),
+            [slice_data](size_t rank_no, const rank_tree::value_pointer& unit) {
+              auto rank_info = slice_data->Add();
+              if (rank_info) {
+                rank_info->set_rank_no(static_cast<uint32_t>(rank_no));
+                protobuf_copy_message(*rank_info->mutable_data(), *unit);
+              }
+              return true;
+            });
+        task->cur_rank_no_ = begin_rank_no + slice_data->size();
       }
 
       cur_io_num++;
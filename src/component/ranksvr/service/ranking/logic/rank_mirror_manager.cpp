@@ -28,6 +28,12 @@
 #include "rpc/rpc_async_invoke.h"
 #include "rpc/rpc_shared_message.h"
 #include "utility/protobuf_mini_dumper.h"
+#include "rank/logic_rank_mirror.h"
+
+namespace {
+// 释放镜像后保留的完全空闲的大块内存数量，留给接下来的更新使用
+static constexpr const size_t kRankTreeKeepFreeChunks = 4;
+}  // namespace
 
 rank_mirror_manager::rank_mirror_manager(rank* owner) : owner_(owner) {}
 
@@ -60,53 +66,136 @@ rpc::result_code_type rank_mirror_manager::get_mirror_data_from_db(
     rpc::context& ctx, const PROJECT_NAMESPACE_ID::rank_mirror_meta_info& mirror_info,
     std::vector<atfw::util::memory::strong_rc_ptr<rpc::shared_message<PROJECT_NAMESPACE_ID::table_rank_mirror>>>&
         db_data) {
-  const static int32_t rank_max_batch_get_num =
-      logic_config::me()
-          ->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>()
-          .rank_max_batch_get_num();
-  // TODO 先分批拉取，后续看看是否需要移到tick中处理
-  int32_t cur_batch_index = 0;
-  std::vector<rpc::db::rank_mirror::table_key_t> keys;
-  std::vector<rpc::db::rank_mirror::batch_get_result_t> out;
-  while (++cur_batch_index <= mirror_info.max_slice_count()) {
-    keys.push_back(rpc::db::rank_mirror::table_key_t(
-        owner_->get_key().rank_type(), owner_->get_key().rank_instance_id(), owner_->get_key().sub_rank_type(),
-        owner_->get_key().sub_rank_instance_id(), logic_config::me()->get_local_zone_id(), mirror_info.mirror_id(),
-        cur_batch_index));
-    if (cur_batch_index % rank_max_batch_get_num == 0) {
-      auto ret = RPC_AWAIT_CODE_RESULT(rpc::db::rank_mirror::batch_get_all(ctx, keys, out));
-      if (ret != 0) {
-        RPC_RETURN_CODE(ret);
-      }
-      for (auto& item : out) {
-        if (item.result != 0) {
-          continue;
-        }
-        db_data.push_back(item.message);
+  const auto& ranking_cfg = logic_config::me()->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>();
+  int32_t rank_max_batch_get_num = ranking_cfg.rank_max_batch_get_num();
+  if (rank_max_batch_get_num <= 0) {
+    rank_max_batch_get_num = 1;
+  }
+  size_t pipeline_num = ranking_cfg.rank_mirror_load_pipeline_num() > 0
+                            ? static_cast<size_t>(ranking_cfg.rank_mirror_load_pipeline_num())
+                            : 1;
+
+  int32_t max_slice_count = mirror_info.max_slice_count();
+  if (max_slice_count <= 0) {
+    RPC_RETURN_CODE(0);
+  }
+
+  // 最多pipeline_num个任务并发拉取，每个任务完成一批后立刻领取下一批，不需要等其他批次
+  // 每批的结果按批次下标保存，最后按分片顺序合并，保证恢复时仍是榜单顺序
+  using batch_output_type = std::vector<rpc::db::rank_mirror::batch_get_result_t>;
+  int32_t batch_count = (max_slice_count + rank_max_batch_get_num - 1) / rank_max_batch_get_num;
+  auto batch_outputs = atfw::util::memory::make_strong_rc<std::vector<batch_output_type>>();
+  batch_outputs->resize(static_cast<size_t>(batch_count));
+  auto next_batch_index = atfw::util::memory::make_strong_rc<int32_t>(0);
+  auto batch_result = atfw::util::memory::make_strong_rc<int32_t>(0);
+  if (pipeline_num > static_cast<size_t>(batch_count)) {
+    pipeline_num = static_cast<size_t>(batch_count);
+  }
+
+  PROJECT_NAMESPACE_ID::DRankKey rank_key = owner_->get_key();
+  uint32_t zone_id = logic_config::me()->get_local_zone_id();
+  int64_t mirror_id = mirror_info.mirror_id();
+  std::vector<task_type_trait::task_type> pending_tasks;
+  pending_tasks.reserve(pipeline_num);
+  int32_t ret = 0;
+  for (size_t i = 0; i < pipeline_num; ++i) {
+    auto invoke_task = rpc::async_invoke(
+        ctx, "rank_mirror_manager.get_mirror_data_from_db",
+        [rank_key, zone_id, mirror_id, max_slice_count, rank_max_batch_get_num, batch_count, batch_outputs,
+         next_batch_index, batch_result](rpc::context& child_ctx) -> rpc::result_code_type {
+          while (*next_batch_index < batch_count && 0 == *batch_result) {
+            int32_t batch_index = (*next_batch_index)++;
+            // 最后一批可能不满rank_max_batch_get_num
+            int32_t begin_slice = batch_index * rank_max_batch_get_num + 1;
+            int32_t end_slice = begin_slice + rank_max_batch_get_num;
+            if (end_slice > max_slice_count + 1) {
+              end_slice = max_slice_count + 1;
+            }
+
+            std::vector<rpc::db::rank_mirror::table_key_t> keys;
+            keys.reserve(static_cast<size_t>(end_slice - begin_slice));
+            for (int32_t slice_index = begin_slice; slice_index < end_slice; ++slice_index) {
+              keys.push_back(rpc::db::rank_mirror::table_key_t(
+                  rank_key.rank_type(), rank_key.rank_instance_id(), rank_key.sub_rank_type(),
+                  rank_key.sub_rank_instance_id(), zone_id, mirror_id, slice_index));
+            }
+
+            auto res = RPC_AWAIT_CODE_RESULT(rpc::db::rank_mirror::batch_get_all(
+                child_ctx, keys, (*batch_outputs)[static_cast<size_t>(batch_index)]));
+            if (res != 0) {
+              if (0 == *batch_result) {
+                *batch_result = res;
+              }
+              RPC_RETURN_CODE(res);
+            }
+          }
+          RPC_RETURN_CODE(0);
+        });
+    if (invoke_task.is_error()) {
+      ret = *invoke_task.get_error();
+      FWRLOGERROR(*owner_, "get mirror data invoke task failed mirror:{} ret:{}", mirror_info.mirror_id(), ret);
+      // 已经启动的任务发现出错后不再领取新的批次
+      *batch_result = ret;
+      break;
+    }
+    if (!task_type_trait::is_exiting(*invoke_task.get_success())) {
+      pending_tasks.emplace_back(std::move(*invoke_task.get_success()));
+    }
+  }
+
+  if (!pending_tasks.empty()) {
+    RPC_AWAIT_IGNORE_RESULT(rpc::wait_tasks(ctx, pending_tasks));
+    pending_tasks.clear();
+  }
+  if (0 == ret) {
+    ret = *batch_result;
+  }
+  if (ret != 0) {
+    RPC_RETURN_CODE(ret);
+  }
+
+  // 镜像的每个分片都必须存在，缺少分片时恢复出来的榜单不完整，不能使用
+  int32_t slice_index = 0;
+  for (auto& output : *batch_outputs) {
+    for (auto& item : output) {
+      ++slice_index;
+      if (item.result != 0 || !item.message) {
+        FWRLOGERROR(*owner_, "get mirror data failed mirror:{} slice:{}/{} ret:{}", mirror_info.mirror_id(),
+                    slice_index, max_slice_count, item.result);
+        RPC_RETURN_CODE(item.result != 0 ? item.result : PROJECT_NAMESPACE_ID::err::EN_DB_RECORD_NOT_FOUND);
       }
-      keys.clear();
-      out.clear();
+      db_data.push_back(item.message);
     }
   }
+  if (slice_index != max_slice_count) {
+    FWRLOGERROR(*owner_, "get mirror data failed mirror:{} expect {} slices but got {}", mirror_info.mirror_id(),
+                max_slice_count, slice_index);
+    RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_DB_RECORD_NOT_FOUND);
+  }
 
   RPC_RETURN_CODE(0);
 }
 
 std::pair<bool, int64_t> rank_mirror_manager::check_need_create_mirror(bool is_normal_save) {
   auto cur_data_version = owner_->get_data_version();
-  if (cur_data_version == last_data_version_ && meta_data_.last_save_mirror().mirror_id() > 0) {
+  // 其他服务读取的镜像必须是全量镜像，增量镜像只能给定时保存复用
+  if (cur_data_version == last_data_version_ && meta_data_.last_save_mirror().mirror_id() > 0 &&
+      (is_normal_save || meta_data_.last_save_mirror().base_mirror_id() <= 0)) {
     if (!is_normal_save) {
       meta_data_.mutable_last_save_mirror()->set_is_normal_save(is_normal_save);
     }
     return std::make_pair(false, meta_data_.last_save_mirror().mirror_id());
   }
-  auto it = running_mirror_map_.find(cur_data_version);
-  if (it != running_mirror_map_.end() && it->second) {
+  for (auto& running_mirror : running_mirror_map_) {
+    const dump_mirror_task_ptr& task = running_mirror.second;
+    if (!task || task->data_version_ != cur_data_version || (!is_normal_save && task->is_delta())) {
+      continue;
+    }
     if (!is_normal_save) {
       // 如果是非正常保存，需要重新设置is_normal_save_，这样可以保存到success_mirror_中
-      it->second->is_normal_save_ = is_normal_save;
+      task->is_normal_save_ = is_normal_save;
     }
-    return std::make_pair(false, it->second->mirror_id_);
+    return std::make_pair(false, task->mirror_id_);
   }
   return std::make_pair(true, 0);
 }
@@ -127,35 +216,55 @@ rpc::result_code_type rank_mirror_manager::create_mirror(rpc::context& ctx, int6
 
   auto total_rank_size = owner_->get_tree()->size();
   auto cur_data_version = owner_->get_data_version();
-  auto cur_rank_mirror = owner_->get_tree()->create_mirror();
-
-  if (!cur_rank_mirror) {
-    FWRLOGERROR(*owner_, "create mirror failed, total_rank_size: {}, data_version: {}", total_rank_size,
-                cur_data_version);
-    RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_UNKNOWN);
+  auto mirror_task = util::memory::make_strong_rc<dump_mirror_task>();
+  PROJECT_NAMESPACE_ID::rank_mirror_meta_info base_mirror;
+  if (is_normal_save && check_can_create_delta_mirror(base_mirror)) {
+    // 定时保存只用于本服务恢复数据，变化的玩家不多时只保存相对上一个全量镜像的增量
+    mirror_task->base_mirror_id_ = base_mirror.mirror_id();
+    mirror_task->base_max_slice_count_ = base_mirror.max_slice_count();
+    mirror_task->delta_data_.reserve(owner_->mirror_dirty_users_.size());
+    for (auto& key : owner_->mirror_dirty_users_) {
+      auto iter = owner_->mp_.find(key);
+      mirror_task->delta_data_.emplace_back(key, iter == owner_->mp_.end() ? nullptr : iter->second);
+    }
+  } else {
+    mirror_task->mirror_ptr_ = owner_->get_tree()->create_mirror();
+    if (!mirror_task->mirror_ptr_) {
+      FWRLOGERROR(*owner_, "create mirror failed, total_rank_size: {}, data_version: {}", total_rank_size,
+                  cur_data_version);
+      RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_UNKNOWN);
+    }
+    // 之后的增量镜像以这个全量镜像为基准
+    owner_->reset_mirror_dirty(false);
   }
+
   mirror_id = RPC_AWAIT_TYPE_RESULT(
       rpc::db::uuid::generate_global_unique_id(ctx, PROJECT_NAMESPACE_ID::EN_GLOBAL_UUID_MAT_RANK_MIRROR_ID));
   if (mirror_id <= 0) {
     FWRLOGERROR(*owner_, "generate global unique id failed, total_rank_size : {}, data_version: {}, mirror_id: {}",
                 total_rank_size, cur_data_version, mirror_id);
+    if (!mirror_task->is_delta()) {
+      // 全量镜像没有保存，变化的玩家已经丢失，下次只能保存全量镜像
+      owner_->reset_mirror_dirty(true);
+    }
     RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_MIRROR_ALLOC_FAILED);
   }
-  auto mirror_task = util::memory::make_strong_rc<dump_mirror_task>();
-  mirror_task->mirror_ptr_ = cur_rank_mirror;
   mirror_task->mirror_id_ = mirror_id;
   mirror_task->data_version_ = cur_data_version;
   mirror_task->cur_slice_index_ = 1;
-  mirror_task->iter_ = cur_rank_mirror->begin();
   protobuf_copy_message(mirror_task->rank_key_, owner_->get_key());
-  mirror_task->total_rank_size_ = static_cast<int32_t>(total_rank_size);
+  if (mirror_task->is_delta()) {
+    mirror_task->total_rank_size_ = static_cast<int32_t>(mirror_task->delta_data_.size());
+  } else {
+    mirror_task->total_rank_size_ = static_cast<int32_t>(total_rank_size);
+  }
   mirror_task->is_normal_save_ = is_normal_save;
 
-  running_mirror_map_[cur_data_version] = mirror_task;
+  running_mirror_map_[mirror_id] = mirror_task;
 
   rank_mirror_global::me()->add_dump_task(mirror_task);
-  FWRLOGDEBUG(*owner_, "create rank mirror task success mirror_id:{} data_version:{} is_normal_save:{}", mirror_id,
-              cur_data_version, is_normal_save ? "true" : "false");
+  FWRLOGDEBUG(*owner_, "create rank mirror task success mirror_id:{} data_version:{} is_normal_save:{} base_mirror_id:{}",
+              mirror_id, cur_data_version, is_normal_save ? "true" : "false", mirror_task->base_mirror_id_);
   RPC_RETURN_CODE(0);
 }
 
@@ -164,7 +273,7 @@ rpc::result_code_type rank_mirror_manager::dump_mirror_success(rpc::context& ctx
     RPC_RETURN_CODE(0);
   }
   {
-    auto it = running_mirror_map_.find(task->data_version_);
+    auto it = running_mirror_map_.find(task->mirror_id_);
     if (it == running_mirror_map_.end() || it->second == nullptr) {
       FWRLOGERROR(*owner_, "dump mirror finish failed, mirror_id:{} not found", task->mirror_id_);
       RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::EN_ERR_RANK_MIRROR_NOT_FOUND);
@@ -172,24 +281,25 @@ rpc::result_code_type rank_mirror_manager::dump_mirror_success(rpc::context& ctx
     // 删除镜像
     running_mirror_map_.erase(it);
   }
-  if (meta_data_.last_save_mirror().mirror_id() > 0) {
-    if (meta_data_.last_save_mirror().is_normal_save()) {
-      // 直接remove
-      auto mirror_meta = meta_data_.add_removing_mirror();
-      protobuf_copy_message(*mirror_meta, meta_data_.last_save_mirror());
-      FWRLOGDEBUG(*owner_, "add mirror to removing list mirror_id:{}", meta_data_.last_save_mirror().mirror_id());
-    } else {
-      // 放到success_mirror里面
-      auto mirror_meta = meta_data_.add_success_mirror();
-      protobuf_copy_message(*mirror_meta, meta_data_.last_save_mirror());
-      FWRLOGDEBUG(*owner_, "add mirror to success list mirror_id:{}", meta_data_.last_save_mirror().mirror_id());
+  // 镜像释放后只被它引用的旧节点回到空闲链表，完全空闲的大块内存还给系统
+  task->mirror_ptr_.reset();
+  if (owner_->get_tree()) {
+    size_t trim_chunks = owner_->get_tree()->get_allocator().get_slab()->trim(kRankTreeKeepFreeChunks);
+    if (trim_chunks > 0) {
+      FWRLOGDEBUG(*owner_, "mirror_id:{} released, trim {} free chunks", task->mirror_id_, trim_chunks);
     }
   }
+  PROJECT_NAMESPACE_ID::rank_mirror_meta_info new_mirror;
+  new_mirror.set_mirror_id(task->mirror_id_);
+  new_mirror.set_max_slice_count(task->cur_slice_index_);
+  new_mirror.set_is_normal_save(task->is_normal_save_);
+  new_mirror.set_base_mirror_id(task->base_mirror_id_);
+  new_mirror.set_base_max_slice_count(task->base_max_slice_count_);
 
-  meta_data_.mutable_last_save_mirror()->set_mirror_id(task->mirror_id_);
-  meta_data_.mutable_last_save_mirror()->set_max_slice_count(task->cur_slice_index_);
-  meta_data_.mutable_last_save_mirror()->set_is_normal_save(task->is_normal_save_);
-  last_data_version_ = task->data_version_;
+  if (!logic_rank_commit_mirror_meta(meta_data_, last_data_version_, new_mirror, task->data_version_)) {
+    FWRLOGDEBUG(*owner_, "mirror_id:{} data_version:{} finished after a newer mirror, last_data_version:{}",
+                task->mirror_id_, task->data_version_, last_data_version_);
+  }
 
   rpc::shared_message<PROJECT_NAMESPACE_ID::table_rank_mirror_meta> db_data;
   db_data->set_rank_type(owner_->get_key().rank_type());
@@ -212,6 +322,22 @@ rpc::result_code_type rank_mirror_manager::dump_mirror_success(rpc::context& ctx
   RPC_RETURN_CODE(0);
 }
 
+bool rank_mirror_manager::check_can_create_delta_mirror(
+    PROJECT_NAMESPACE_ID::rank_mirror_meta_info& base_mirror) const {
+  if (owner_->mirror_dirty_all_) {
+    return false;
+  }
+
+  bool has_running_full_mirror = false;
+  for (auto& running_mirror : running_mirror_map_) {
+    if (running_mirror.second && !running_mirror.second->is_delta()) {
+      has_running_full_mirror = true;
+      break;
+    }
+  }
+  return logic_rank_select_delta_base_mirror(meta_data_, has_running_full_mirror, base_mirror);
+}
+
 bool rank_mirror_manager::check_mirror_dump_finish(int64_t mirror_id) const {
   if (meta_data_.last_save_mirror().mirror_id() == mirror_id) {
     return true;
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "logic/rank_type.h"
 #include "memory/rc_ptr.h"
@@ -30,12 +31,18 @@ struct dump_mirror_task {
   rank_tree::mirror_pointer mirror_ptr_ = nullptr;
   int64_t mirror_id_ = 0;
   int32_t cur_slice_index_ = 1;  // slice index从1开始
-  rank_mirror::iterator iter_;
   int64_t data_version_ = 0;
   PROJECT_NAMESPACE_ID::DRankKey rank_key_;
   int32_t total_rank_size_ = 0;
-  int32_t cur_rank_no_ = 0;
+  int32_t cur_rank_no_ = 0;  // 已经导出的排名，也是分页导出的游标
   bool is_normal_save_ = false;
+
+  // 增量镜像只保存相对base_mirror_id_变化过的玩家，空指针表示玩家已经下榜
+  int64_t base_mirror_id_ = 0;
+  int32_t base_max_slice_count_ = 0;
+  std::vector<std::pair<PROJECT_NAMESPACE_ID::DRankUserKey, rank_tree::value_pointer>> delta_data_;
+
+  bool is_delta() const { return base_mirror_id_ > 0; }
 };
 using dump_mirror_task_ptr = util::memory::strong_rc_ptr<dump_mirror_task>;
 
@@ -59,9 +66,12 @@ class rank_mirror_manager {
 
   const PROJECT_NAMESPACE_ID::table_rank_mirror_meta_data& get_rank_mirror_meta_data() const { return meta_data_; }
 
+  int64_t get_last_data_version() const { return last_data_version_; }
+
   
  private:
   std::pair<bool, int64_t> check_need_create_mirror(bool is_normal_save);
+  bool check_can_create_delta_mirror(PROJECT_NAMESPACE_ID::rank_mirror_meta_info& base_mirror) const;
 
   void check_and_remove_mirror();
   EXPLICIT_NODISCARD_ATTR rpc::result_code_type do_remove_mirror(rpc::context& ctx);
@@ -73,5 +83,5 @@ class rank_mirror_manager {
   int64_t last_data_version_ = 0;  // 最后一次成功保存的镜像数据版本号
   PROJECT_NAMESPACE_ID::table_rank_mirror_meta_data meta_data_;
 
-  std::unordered_map<int64_t, dump_mirror_task_ptr> running_mirror_map_;
+  std::unordered_map<int64_t, dump_mirror_task_ptr> running_mirror_map_;  // mirror_id => 正在保存的镜像
 };
\ No newline at end of file
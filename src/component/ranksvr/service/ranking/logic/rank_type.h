@@ -10,6 +10,9 @@
 
 #include <config/server_frame_build_feature.h>
 #include <utility/persistent_btree.h>
+#include <utility/persistent_btree_allocator.h>
 
-using rank_tree = persistent_btree<PROJECT_NAMESPACE_ID::rank_sort_data>;
+// 树中直接保存完整的榜单数据，和rank::mp_共享同一份对象，查询时不需要再回查玩家索引
+using rank_tree = persistent_btree<PROJECT_NAMESPACE_ID::rank_storage_data,
+                                   persistent_btree_slab_allocator<PROJECT_NAMESPACE_ID::rank_storage_data>>;
 using rank_mirror = rank_tree::mirror_type;
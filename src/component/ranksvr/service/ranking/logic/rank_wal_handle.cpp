@@ -149,6 +149,13 @@ static rank_wal_publisher_type::vtable_pointer create_rank_publisher_vtable() {
 
       protobuf_copy_message(*log, **log_begin);
     }
+
+    // 流控: 从节点确认的版本落后太多时不再推送，等从节点心跳追上后再由发布者补发
+    int32_t max_unconfirmed_log_count = logic_config::me()
+                                            ->get_custom_config<PROJECT_NAMESPACE_ID::config::ranksvr_ranking_cfg>()
+                                            .pushlisher_congihure()
+                                            .max_unconfirmed_log_count();
+    int64_t first_event_id = sync_body->event_logs_size() > 0 ? sync_body->event_logs(0).event_id() : 0;
     for (; subscriber_begin != subscriber_end; ++subscriber_begin) {
       if (!subscriber_begin->second || !subscriber_begin->second->get_private_data()) {
         continue;
@@ -158,6 +165,17 @@ static rank_wal_publisher_type::vtable_pointer create_rank_publisher_vtable() {
         continue;
       }
 
+      if (max_unconfirmed_log_count > 0 && first_event_id > 0 && private_data->confirmed_data_version() > 0 &&
+          first_event_id - private_data->confirmed_data_version() - 1 > max_unconfirmed_log_count) {
+        FWLOGDEBUG(
+            "skip rank event sync to slow server rank_id({}:{}:{}:{}) subcribe_server_id:{} confirmed_version:{} "
+            "first_event_id:{}",
+            private_data->rank_key().rank_type(), private_data->rank_key().rank_instance_id(),
+            private_data->rank_key().sub_rank_type(), private_data->rank_key().sub_rank_instance_id(),
+            private_data->server_id(), private_data->confirmed_data_version(), first_event_id);
+        continue;
+      }
+
       int32_t res = rpc::rank::rank_event_sync(param.context, private_data->server_id(), *sync_body);
       if (res != 0) {
         FWLOGERROR(
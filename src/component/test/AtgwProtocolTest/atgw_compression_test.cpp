@@ -0,0 +1,304 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "atgw_test_peer.h"
+
+namespace {
+using atgw_test::atgw_error_code;
+using atgw_test::atgw_protocol_api;
+using atgw_test::atgw_protocol_sdk;
+using atgw_test::compression_type_t;
+using atgw_test::handshake;
+using atgw_test::make_conf;
+using atgw_test::test_peer_t;
+using atgw_test::transfer;
+
+static const compression_type_t kCompressionNone =
+    ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_NONE);
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+static const compression_type_t kCompressionZstd =
+    ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_ZSTD);
+#endif
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+static const compression_type_t kCompressionLz4 =
+    ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(compression_type_t, EN_CPT_LZ4);
+#endif
+
+// 简单的线性同余，保证每次运行的数据一样
+static std::string make_random_text(size_t size, uint32_t seed) {
+  static const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-";
+  std::string ret;
+  ret.reserve(size);
+  for (size_t i = 0; i < size; ++i) {
+    seed = seed * 1103515245 + 12345;
+    ret.push_back(kAlphabet[(seed >> 16) % (sizeof(kAlphabet) - 1)]);
+  }
+  return ret;
+}
+
+static std::string make_repeated_text(size_t size, uint32_t seed) {
+  std::string ret;
+  ret.reserve(size + 64);
+  uint32_t index = 0;
+  while (ret.size() < size) {
+    ret += "{\"item_id\":" + std::to_string(seed + index % 8) + ",\"count\":" + std::to_string(index % 3) + "},";
+    ++index;
+  }
+  ret.resize(size);
+  return ret;
+}
+
+// 返回发送端写出的字节数，并检查接收端收到的数据完全一致
+static size_t round_trip(test_peer_t &from, test_peer_t &to, const std::string &payload) {
+  from.outbox.clear();
+  to.received.clear();
+  CASE_EXPECT_EQ(0, from.proto->send_post(payload.data(), payload.size()));
+  size_t wire_size = from.outbox.size();
+
+  transfer(from, to);
+  CASE_EXPECT_EQ(1, to.received.size());
+  if (!to.received.empty()) {
+    CASE_EXPECT_TRUE(payload == to.received.back());
+  }
+  CASE_EXPECT_FALSE(to.closed);
+  return wire_size;
+}
+}  // namespace
+
+CASE_TEST(atgw_compression, both_without_support) {
+  test_peer_t client;
+  test_peer_t server;
+  handshake(client, make_conf({}, std::string(), true), server, make_conf({}, std::string(), false));
+
+  CASE_EXPECT_EQ(0, client.handshake_status);
+  CASE_EXPECT_EQ(0, server.handshake_status);
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionNone), static_cast<int>(client.proto->get_compression_type()));
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionNone), static_cast<int>(server.proto->get_compression_type()));
+
+  std::string payload = make_repeated_text(4096, 1);
+  CASE_EXPECT_GT(round_trip(client, server, payload), payload.size());
+  CASE_EXPECT_GT(round_trip(server, client, payload), payload.size());
+}
+
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD
+CASE_TEST(atgw_compression, client_without_support) {
+  test_peer_t client;
+  test_peer_t server;
+  handshake(client, make_conf({}, std::string(), true), server, make_conf({kCompressionZstd}, std::string(), false));
+
+  // 老的客户端不带压缩字段，服务器不能选择任何压缩算法
+  CASE_EXPECT_EQ(0, client.handshake_status);
+  CASE_EXPECT_EQ(0, server.handshake_status);
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionNone), static_cast<int>(client.proto->get_compression_type()));
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionNone), static_cast<int>(server.proto->get_compression_type()));
+
+  std::string payload = make_repeated_text(4096, 2);
+  CASE_EXPECT_GT(round_trip(client, server, payload), payload.size());
+  CASE_EXPECT_GT(round_trip(server, client, payload), payload.size());
+}
+
+CASE_TEST(atgw_compression, server_without_support) {
+  test_peer_t client;
+  test_peer_t server;
+  handshake(client, make_conf({kCompressionZstd}, std::string(), true), server, make_conf({}, std::string(), false));
+
+  CASE_EXPECT_EQ(0, client.handshake_status);
+  CASE_EXPECT_EQ(0, server.handshake_status);
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionNone), static_cast<int>(client.proto->get_compression_type()));
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionNone), static_cast<int>(server.proto->get_compression_type()));
+
+  std::string payload = make_repeated_text(4096, 3);
+  CASE_EXPECT_GT(round_trip(client, server, payload), payload.size());
+  CASE_EXPECT_GT(round_trip(server, client, payload), payload.size());
+}
+
+CASE_TEST(atgw_compression, selected_type_not_supported_by_client) {
+  test_peer_t client;
+  test_peer_t server;
+
+  // 客户端发出请求后重载了配置，不再支持服务器选择的算法，握手必须失败而不是收到无法解压的数据
+  atgw_protocol_sdk::crypt_conf_t client_conf = make_conf({kCompressionZstd}, std::string(), true);
+  atgw_protocol_sdk::crypt_conf_t server_conf = make_conf({kCompressionZstd}, std::string(), false);
+  atgw_protocol_sdk::crypt_conf_t reloaded_client_conf = make_conf({}, std::string(), true);
+  CASE_EXPECT_EQ(0, atgw_protocol_sdk::global_reload(client_conf));
+  CASE_EXPECT_EQ(0, client.proto->start_session(std::string()));
+  CASE_EXPECT_EQ(0, atgw_protocol_sdk::global_reload(server_conf));
+  transfer(client, server);
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(server.proto->get_compression_type()));
+
+  CASE_EXPECT_EQ(0, atgw_protocol_sdk::global_reload(reloaded_client_conf));
+  transfer(server, client);
+  CASE_EXPECT_EQ(static_cast<int>(atgw_error_code::EN_ECT_COMPRESSION_NOT_SUPPORTED), client.handshake_status);
+  CASE_EXPECT_TRUE(client.closed);
+}
+
+CASE_TEST(atgw_compression, zstd_round_trip) {
+  test_peer_t client;
+  test_peer_t server;
+  handshake(client, make_conf({kCompressionZstd}, std::string(), true), server,
+            make_conf({kCompressionZstd}, std::string(), false));
+
+  CASE_EXPECT_EQ(0, client.handshake_status);
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(client.proto->get_compression_type()));
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(server.proto->get_compression_type()));
+
+  std::string payload = make_repeated_text(4096, 4);
+  CASE_EXPECT_LT(round_trip(client, server, payload), payload.size());
+  CASE_EXPECT_LT(round_trip(server, client, payload), payload.size());
+
+  // 小于阈值的消息不压缩
+  std::string small_payload = make_repeated_text(32, 4);
+  CASE_EXPECT_GT(round_trip(client, server, small_payload), small_payload.size());
+
+  // 比压缩缓冲区大的消息走单独分配的缓冲区
+  std::string large_payload = make_repeated_text(
+      atgw_protocol_api::get_tls_length(atgw_protocol_api::tls_buffer_t::EN_TBT_ZIP) * 2 + 17, 4);
+  CASE_EXPECT_LT(round_trip(client, server, large_payload), large_payload.size());
+  CASE_EXPECT_LT(round_trip(server, client, large_payload), large_payload.size());
+}
+
+CASE_TEST(atgw_compression, zstd_dictionary) {
+  std::string dictionary = make_random_text(16 * 1024, 5);
+  // 字典里的内容本身是随机的，只有用了字典才能压缩得很小
+  std::string payload = dictionary.substr(1024, 2048);
+
+  size_t without_dictionary_size;
+  {
+    test_peer_t client;
+    test_peer_t server;
+    handshake(client, make_conf({kCompressionZstd}, std::string(), true), server,
+              make_conf({kCompressionZstd}, std::string(), false));
+    CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(client.proto->get_compression_type()));
+    without_dictionary_size = round_trip(client, server, payload);
+  }
+
+  test_peer_t client;
+  test_peer_t server;
+  handshake(client, make_conf({kCompressionZstd}, dictionary, true), server,
+            make_conf({kCompressionZstd}, dictionary, false));
+  CASE_EXPECT_EQ(0, client.handshake_status);
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(client.proto->get_compression_type()));
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(server.proto->get_compression_type()));
+
+  size_t with_dictionary_size = round_trip(client, server, payload);
+  CASE_EXPECT_LT(with_dictionary_size, without_dictionary_size);
+  CASE_EXPECT_LT(round_trip(server, client, payload), without_dictionary_size);
+  CASE_MSG_INFO() << "zstd: " << payload.size() << " bytes, " << without_dictionary_size << " bytes without dictionary, "
+                  << with_dictionary_size << " bytes with dictionary" << std::endl;
+}
+
+CASE_TEST(atgw_compression, dictionary_mismatch) {
+  std::string client_dictionary = make_random_text(16 * 1024, 6);
+  std::string server_dictionary = make_random_text(16 * 1024, 7);
+  std::string payload = client_dictionary.substr(1024, 2048) + make_repeated_text(2048, 6);
+
+  test_peer_t client;
+  test_peer_t server;
+  handshake(client, make_conf({kCompressionZstd}, client_dictionary, true), server,
+            make_conf({kCompressionZstd}, server_dictionary, false));
+
+  // 字典不一致时仍然使用协商的算法，只是不使用字典
+  CASE_EXPECT_EQ(0, client.handshake_status);
+  CASE_EXPECT_EQ(0, server.handshake_status);
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(client.proto->get_compression_type()));
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(server.proto->get_compression_type()));
+  CASE_EXPECT_TRUE(std::string::npos != client.proto->get_info().find("dictionary=none"));
+  CASE_EXPECT_TRUE(std::string::npos != server.proto->get_info().find("dictionary=none"));
+
+  round_trip(client, server, payload);
+  round_trip(server, client, payload);
+}
+#endif
+
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+CASE_TEST(atgw_compression, lz4_round_trip) {
+  test_peer_t client;
+  test_peer_t server;
+  handshake(client, make_conf({kCompressionLz4}, std::string(), true), server,
+            make_conf({kCompressionLz4}, std::string(), false));
+
+  CASE_EXPECT_EQ(0, client.handshake_status);
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionLz4), static_cast<int>(client.proto->get_compression_type()));
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionLz4), static_cast<int>(server.proto->get_compression_type()));
+
+  std::string payload = make_repeated_text(4096, 8);
+  CASE_EXPECT_LT(round_trip(client, server, payload), payload.size());
+  CASE_EXPECT_LT(round_trip(server, client, payload), payload.size());
+
+  // 无法压缩的数据原样发送
+  std::string random_payload = make_random_text(4096, 8);
+  CASE_EXPECT_GT(round_trip(client, server, random_payload), random_payload.size());
+
+  std::string large_payload = make_repeated_text(
+      atgw_protocol_api::get_tls_length(atgw_protocol_api::tls_buffer_t::EN_TBT_ZIP) * 2 + 17, 8);
+  CASE_EXPECT_LT(round_trip(client, server, large_payload), large_payload.size());
+  CASE_EXPECT_LT(round_trip(server, client, large_payload), large_payload.size());
+}
+
+CASE_TEST(atgw_compression, lz4_dictionary_stream_reuse) {
+  std::string dictionary = make_random_text(16 * 1024, 9);
+  std::string payload = dictionary.substr(dictionary.size() - 4096, 2048);
+  // 不在字典里的数据，如果线程内的 LZ4_stream_t 没有被字典状态覆盖，第二次发送会引用上一条消息而无法解压
+  std::string unique_payload = make_random_text(1024, 10) + dictionary.substr(dictionary.size() - 2048, 1024);
+
+  test_peer_t client;
+  test_peer_t server;
+  handshake(client, make_conf({kCompressionLz4}, dictionary, true), server,
+            make_conf({kCompressionLz4}, dictionary, false));
+  CASE_EXPECT_EQ(0, client.handshake_status);
+  CASE_EXPECT_EQ(static_cast<int>(kCompressionLz4), static_cast<int>(client.proto->get_compression_type()));
+  CASE_EXPECT_TRUE(std::string::npos != client.proto->get_info().find("dictionary=shared"));
+
+  size_t first_size = round_trip(client, server, payload);
+  CASE_EXPECT_LT(first_size, payload.size() / 4);
+  size_t unique_size = round_trip(client, server, unique_payload);
+  CASE_EXPECT_EQ(unique_size, round_trip(client, server, unique_payload));
+  CASE_EXPECT_EQ(first_size, round_trip(client, server, payload));
+
+  // 同一个线程里不使用字典的连接也共用 LZ4_stream_t ，之后使用字典的连接不能受影响
+  {
+    test_peer_t plain_client;
+    test_peer_t plain_server;
+    handshake(plain_client, make_conf({kCompressionLz4}, std::string(), true), plain_server,
+              make_conf({kCompressionLz4}, std::string(), false));
+    CASE_EXPECT_EQ(static_cast<int>(kCompressionLz4), static_cast<int>(plain_client.proto->get_compression_type()));
+    CASE_EXPECT_TRUE(std::string::npos != plain_client.proto->get_info().find("dictionary=none"));
+    round_trip(plain_client, plain_server, make_repeated_text(4096, 10));
+    round_trip(plain_client, plain_server, unique_payload);
+  }
+
+  CASE_EXPECT_EQ(first_size, round_trip(client, server, payload));
+  CASE_EXPECT_EQ(unique_size, round_trip(server, client, unique_payload));
+}
+#endif
+
+#if defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_ZSTD && \
+    defined(ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4) && ATFRAMEWORK_GATEWAY_MACRO_ENABLE_LZ4
+CASE_TEST(atgw_compression, select_by_client_priority) {
+  {
+    test_peer_t client;
+    test_peer_t server;
+    handshake(client, make_conf({kCompressionLz4, kCompressionZstd}, std::string(), true), server,
+              make_conf({kCompressionZstd, kCompressionLz4}, std::string(), false));
+    CASE_EXPECT_EQ(static_cast<int>(kCompressionLz4), static_cast<int>(client.proto->get_compression_type()));
+    CASE_EXPECT_EQ(static_cast<int>(kCompressionLz4), static_cast<int>(server.proto->get_compression_type()));
+  }
+
+  {
+    test_peer_t client;
+    test_peer_t server;
+    handshake(client, make_conf({kCompressionLz4, kCompressionZstd}, std::string(), true), server,
+              make_conf({kCompressionZstd}, std::string(), false));
+    CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(client.proto->get_compression_type()));
+    CASE_EXPECT_EQ(static_cast<int>(kCompressionZstd), static_cast<int>(server.proto->get_compression_type()));
+
+    std::string payload = make_repeated_text(4096, 11);
+    CASE_EXPECT_LT(round_trip(client, server, payload), payload.size());
+  }
+}
+#endif
@@ -0,0 +1,169 @@
+// Copyright 2026 atframework
+
+#pragma once
+
+#include "frame/test_macros.h"
+
+#include <atgateway/protocols/v1/libatgw_protocol_sdk.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace atgw_test {
+using atgw_protocol_api = ::atframework::gateway::libatgw_protocol_api;
+using atgw_protocol_sdk = ::atframework::gateway::libatgw_protocol_sdk;
+using atgw_error_code = ::atframework::gateway::error_code_t;
+using compression_type_t = atgw_protocol_sdk::compression_type_t;
+
+// 一端的协议对象，写出的数据都放在outbox里，由 transfer 交给另一端
+struct test_peer_t {
+  struct write_record_t {
+    bool is_vector;
+    size_t buffer_count;
+    size_t bytes;
+  };
+
+  atgw_protocol_api::proto_callbacks_t callbacks;
+  std::string outbox;
+  std::vector<std::string> received;
+  // 异步写模式下写回调不会立即完成，需要调用 proto->write_done(status) 模拟 uv_write 的完成回调
+  bool async_write = false;
+  std::vector<write_record_t> write_records;
+  int handshake_status = 1;
+  bool closed = false;
+  // 析构时会回调close_fn，必须放在最后先析构
+  std::unique_ptr<atgw_protocol_sdk> proto;
+
+  test_peer_t() {
+    callbacks.write_fn = [](atgw_protocol_api *proto, void *buffer, size_t sz, bool *is_done) -> int {
+      test_peer_t *self = reinterpret_cast<test_peer_t *>(proto->get_private_data());
+      size_t offset = proto->get_write_header_offset();
+      if (nullptr == self) {
+        return 0;
+      }
+      if (sz > offset) {
+        self->outbox.append(reinterpret_cast<const char *>(buffer) + offset, sz - offset);
+      }
+      self->write_records.push_back(write_record_t{false, 1, sz > offset ? sz - offset : 0});
+      if (nullptr != is_done) {
+        *is_done = !self->async_write;
+      }
+      return 0;
+    };
+    callbacks.message_fn = [](atgw_protocol_api *proto, const void *buffer, size_t sz) -> int {
+      test_peer_t *self = reinterpret_cast<test_peer_t *>(proto->get_private_data());
+      if (nullptr != self) {
+        self->received.emplace_back(reinterpret_cast<const char *>(buffer), sz);
+      }
+      return 0;
+    };
+    callbacks.new_session_fn = [](atgw_protocol_api *, uint64_t &session_id) -> int {
+      static uint64_t session_id_seq = 0;
+      session_id = ++session_id_seq;
+      return 0;
+    };
+    callbacks.close_fn = [](atgw_protocol_api *proto, int) -> int {
+      test_peer_t *self = reinterpret_cast<test_peer_t *>(proto->get_private_data());
+      if (nullptr != self) {
+        self->closed = true;
+      }
+      return 0;
+    };
+    callbacks.on_handshake_done_fn = [](atgw_protocol_api *proto, int status) -> int {
+      test_peer_t *self = reinterpret_cast<test_peer_t *>(proto->get_private_data());
+      if (nullptr != self) {
+        self->handshake_status = status;
+      }
+      return 0;
+    };
+
+    proto.reset(new atgw_protocol_sdk());
+    proto->set_callbacks(&callbacks);
+    proto->set_private_data(this);
+  }
+
+  test_peer_t(const test_peer_t &) = delete;
+  test_peer_t &operator=(const test_peer_t &) = delete;
+
+  // 和 atgateway 一样把所有块交给一次写操作
+  void enable_write_vector(bool enable) {
+    if (!enable) {
+      callbacks.write_vector_fn = nullptr;
+      return;
+    }
+
+    callbacks.write_vector_fn = [](atgw_protocol_api *proto, void *, const atgw_protocol_api::write_buffer_t *buffers,
+                                   size_t count, bool *is_done) -> int {
+      test_peer_t *self = reinterpret_cast<test_peer_t *>(proto->get_private_data());
+      if (nullptr == self) {
+        return 0;
+      }
+      size_t bytes = 0;
+      for (size_t i = 0; i < count; ++i) {
+        self->outbox.append(reinterpret_cast<const char *>(buffers[i].data), buffers[i].size);
+        bytes += buffers[i].size;
+      }
+      self->write_records.push_back(write_record_t{true, count, bytes});
+      if (nullptr != is_done) {
+        *is_done = !self->async_write;
+      }
+      return 0;
+    };
+  }
+};
+
+inline void transfer(test_peer_t &from, test_peer_t &to) {
+  std::string data;
+  data.swap(from.outbox);
+
+  size_t offset = 0;
+  while (offset < data.size() && !to.proto->check_flag(atgw_protocol_api::flag_t::EN_PFT_CLOSING)) {
+    char *buffer = nullptr;
+    size_t len = 0;
+    to.proto->alloc_recv_buffer(data.size() - offset, buffer, len);
+    CASE_EXPECT_TRUE(nullptr != buffer);
+    if (nullptr == buffer || 0 == len) {
+      break;
+    }
+    if (len > data.size() - offset) {
+      len = data.size() - offset;
+    }
+    memcpy(buffer, data.data() + offset, len);
+    offset += len;
+
+    int errcode = 0;
+    to.proto->read(static_cast<int>(len), buffer, len, errcode);
+    CASE_EXPECT_EQ(0, errcode);
+  }
+}
+
+inline atgw_protocol_sdk::crypt_conf_t make_conf(const std::vector<compression_type_t> &types,
+                                                 const std::string &dictionary, bool client_mode) {
+  atgw_protocol_sdk::crypt_conf_t conf;
+  conf.default_key = "atgw-key";
+  conf.update_interval = 1200;
+  conf.switch_secret_type = ::atframework::gw::v1::ATFRAMEWORK_GATEWAY_MACRO_ENUM_VALUE(switch_secret_t, EN_SST_DIRECT);
+  conf.client_mode = client_mode;
+  conf.compression.types = types;
+  conf.compression.threshold = 64;
+  conf.compression.level = 0;
+  conf.compression.dictionary = dictionary;
+  return conf;
+}
+
+// 配置是进程级的，两端在同一个线程里轮流切换成各自的配置来模拟两个进程
+inline void handshake(test_peer_t &client, atgw_protocol_sdk::crypt_conf_t client_conf, test_peer_t &server,
+                      atgw_protocol_sdk::crypt_conf_t server_conf) {
+  CASE_EXPECT_EQ(0, atgw_protocol_sdk::global_reload(client_conf));
+  CASE_EXPECT_EQ(0, client.proto->start_session(std::string()));
+
+  CASE_EXPECT_EQ(0, atgw_protocol_sdk::global_reload(server_conf));
+  transfer(client, server);
+
+  CASE_EXPECT_EQ(0, atgw_protocol_sdk::global_reload(client_conf));
+  transfer(server, client);
+}
+}  // namespace atgw_test
@@ -0,0 +1,167 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+#include <string>
+#include <vector>
+
+#include "atgw_test_peer.h"
+
+namespace {
+using atgw_test::atgw_error_code;
+using atgw_test::atgw_protocol_api;
+using atgw_test::handshake;
+using atgw_test::make_conf;
+using atgw_test::test_peer_t;
+using atgw_test::transfer;
+
+static void setup_async_session(test_peer_t &client, test_peer_t &server) {
+  handshake(client, make_conf({}, std::string(), true), server, make_conf({}, std::string(), false));
+  CASE_EXPECT_EQ(0, client.handshake_status);
+  CASE_EXPECT_EQ(0, server.handshake_status);
+
+  client.async_write = true;
+  client.write_records.clear();
+  server.received.clear();
+}
+
+static std::string make_message(size_t index) { return "message-" + std::to_string(index); }
+
+static void send_messages(test_peer_t &peer, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    std::string message = make_message(i);
+    CASE_EXPECT_EQ(0, peer.proto->send_post(message.data(), message.size()));
+  }
+}
+
+static void expect_received(const test_peer_t &peer, size_t count) {
+  CASE_EXPECT_EQ(count, peer.received.size());
+  for (size_t i = 0; i < count && i < peer.received.size(); ++i) {
+    CASE_EXPECT_EQ(make_message(i), peer.received[i]);
+  }
+}
+}  // namespace
+
+CASE_TEST(atgw_write_queue, vector_partial_completion) {
+  test_peer_t client;
+  test_peer_t server;
+  setup_async_session(client, server);
+  client.enable_write_vector(true);
+
+  // 第一条消息直接开始写，写完成之前的消息都排队
+  send_messages(client, 0, 1);
+  CASE_EXPECT_EQ(1, client.write_records.size());
+  CASE_EXPECT_TRUE(client.proto->check_flag(atgw_protocol_api::flag_t::EN_PFT_WRITING));
+  send_messages(client, 1, 4);
+  CASE_EXPECT_EQ(1, client.write_records.size());
+
+  // 每次完成只释放已经写出的块，剩下的块合成一次写
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(2, client.write_records.size());
+  CASE_EXPECT_TRUE(client.write_records.back().is_vector);
+  CASE_EXPECT_EQ(3, client.write_records.back().buffer_count);
+
+  client.proto->set_write_vector_limit(2, 0);
+  send_messages(client, 4, 7);
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(3, client.write_records.size());
+  CASE_EXPECT_EQ(2, client.write_records.back().buffer_count);
+
+  // 写失败也要释放这一次写出的块
+  client.proto->write_done(-1);
+  CASE_EXPECT_EQ(4, client.write_records.size());
+  CASE_EXPECT_EQ(1, client.write_records.back().buffer_count);
+
+  // 超过字节上限的单个块也要单独写出去
+  client.proto->set_write_vector_limit(0, 1);
+  send_messages(client, 7, 10);
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(5, client.write_records.size());
+  CASE_EXPECT_EQ(1, client.write_records.back().buffer_count);
+  client.proto->write_done(0);
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(7, client.write_records.size());
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(7, client.write_records.size());
+  CASE_EXPECT_FALSE(client.proto->check_flag(atgw_protocol_api::flag_t::EN_PFT_WRITING));
+
+  transfer(client, server);
+  expect_received(server, 10);
+}
+
+CASE_TEST(atgw_write_queue, close_while_writing) {
+  test_peer_t client;
+  test_peer_t server;
+  setup_async_session(client, server);
+  client.enable_write_vector(true);
+
+  send_messages(client, 0, 3);
+  CASE_EXPECT_EQ(1, client.write_records.size());
+
+  // 正在写的时候关闭，要等写完成才能回调close_fn
+  client.proto->close(::atframework::gateway::close_reason_t::EN_CRT_LOGOUT);
+  CASE_EXPECT_TRUE(client.proto->check_flag(atgw_protocol_api::flag_t::EN_PFT_CLOSING));
+  CASE_EXPECT_FALSE(client.proto->check_flag(atgw_protocol_api::flag_t::EN_PFT_CLOSED));
+  CASE_EXPECT_FALSE(client.closed);
+
+  std::string message = make_message(3);
+  CASE_EXPECT_EQ(static_cast<int>(atgw_error_code::EN_ECT_CLOSING),
+                 client.proto->send_post(message.data(), message.size()));
+
+  // 排队的块直接丢弃，不会再发起写
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(1, client.write_records.size());
+  CASE_EXPECT_TRUE(client.proto->check_flag(atgw_protocol_api::flag_t::EN_PFT_CLOSED));
+  CASE_EXPECT_FALSE(client.proto->check_flag(atgw_protocol_api::flag_t::EN_PFT_WRITING));
+  CASE_EXPECT_TRUE(client.closed);
+
+  transfer(client, server);
+  expect_received(server, 1);
+}
+
+CASE_TEST(atgw_write_queue, mixed_merge_and_vector) {
+  test_peer_t client;
+  test_peer_t server;
+  setup_async_session(client, server);
+  client.enable_write_vector(false);
+
+  send_messages(client, 0, 1);
+  send_messages(client, 1, 4);
+  CASE_EXPECT_EQ(1, client.write_records.size());
+  CASE_EXPECT_FALSE(client.write_records.back().is_vector);
+
+  // 没有 write_vector_fn 时拷贝合并成一个块，合并出来的块也要放进索引里
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(2, client.write_records.size());
+  CASE_EXPECT_FALSE(client.write_records.back().is_vector);
+  CASE_EXPECT_GT(client.write_records.back().bytes, client.write_records.front().bytes * 2);
+
+  // 合并块写出的过程中切换成向量写
+  client.enable_write_vector(true);
+  send_messages(client, 4, 6);
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(3, client.write_records.size());
+  CASE_EXPECT_TRUE(client.write_records.back().is_vector);
+  CASE_EXPECT_EQ(2, client.write_records.back().buffer_count);
+
+  // 向量写的过程中再切换回合并
+  client.enable_write_vector(false);
+  send_messages(client, 6, 9);
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(4, client.write_records.size());
+  CASE_EXPECT_FALSE(client.write_records.back().is_vector);
+
+  client.enable_write_vector(true);
+  client.proto->write_done(0);
+  CASE_EXPECT_EQ(4, client.write_records.size());
+
+  send_messages(client, 9, 10);
+  CASE_EXPECT_EQ(5, client.write_records.size());
+  CASE_EXPECT_TRUE(client.write_records.back().is_vector);
+  CASE_EXPECT_EQ(1, client.write_records.back().buffer_count);
+  client.proto->write_done(0);
+  CASE_EXPECT_FALSE(client.proto->check_flag(atgw_protocol_api::flag_t::EN_PFT_WRITING));
+
+  transfer(client, server);
+  expect_received(server, 10);
+}
@@ -0,0 +1,110 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+#include <core/mpsc_queue.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+using queue_type = atframework::component::mpsc_queue<uint64_t>;
+
+static uint64_t make_value(uint32_t producer, uint32_t sequence) {
+  return (static_cast<uint64_t>(producer) << 32) | sequence;
+}
+}  // namespace
+
+CASE_TEST(mpsc_queue, single_thread) {
+  atframework::component::mpsc_queue<std::unique_ptr<int>> queue;
+  std::unique_ptr<int> out;
+  CASE_EXPECT_TRUE(queue.empty());
+  CASE_EXPECT_FALSE(queue.pop(out));
+
+  for (int i = 0; i < 8; ++i) {
+    queue.push(std::unique_ptr<int>(new int(i)));
+  }
+  CASE_EXPECT_FALSE(queue.empty());
+
+  for (int i = 0; i < 8; ++i) {
+    CASE_EXPECT_TRUE(queue.pop(out));
+    CASE_EXPECT_TRUE(nullptr != out);
+    if (out) {
+      CASE_EXPECT_EQ(i, *out);
+    }
+  }
+  CASE_EXPECT_TRUE(queue.empty());
+  CASE_EXPECT_FALSE(queue.pop(out));
+}
+
+CASE_TEST(mpsc_queue, destroy_with_pending_tasks) {
+  std::shared_ptr<int> counter = std::make_shared<int>(0);
+  {
+    atframework::component::mpsc_queue<std::function<void()>> queue;
+    for (int i = 0; i < 4; ++i) {
+      queue.push([counter]() { ++*counter; });
+    }
+    CASE_EXPECT_EQ(5, counter.use_count());
+  }
+
+  // 析构时未处理的任务也要释放
+  CASE_EXPECT_EQ(1, counter.use_count());
+  CASE_EXPECT_EQ(0, *counter);
+}
+
+CASE_TEST(mpsc_queue, multiple_producers) {
+  const uint32_t producer_count = 4;
+  const uint32_t push_count = 20000;
+
+  queue_type queue;
+  std::atomic<uint32_t> ready{0};
+  std::vector<std::thread> producers;
+  for (uint32_t i = 0; i < producer_count; ++i) {
+    producers.emplace_back([&queue, &ready, i, producer_count, push_count]() {
+      // 所有生产者同时开始，尽量让push交错
+      ready.fetch_add(1);
+      while (ready.load() < producer_count) {
+        std::this_thread::yield();
+      }
+      for (uint32_t j = 0; j < push_count; ++j) {
+        queue.push(make_value(i, j));
+      }
+    });
+  }
+
+  // 消费者和生产者同时运行，每个生产者的数据要按push顺序出队
+  std::vector<uint32_t> next_sequence(producer_count, 0);
+  uint64_t total = 0;
+  bool ordered = true;
+  while (total < static_cast<uint64_t>(producer_count) * push_count) {
+    uint64_t value = 0;
+    if (!queue.pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    uint32_t producer = static_cast<uint32_t>(value >> 32);
+    uint32_t sequence = static_cast<uint32_t>(value & 0xFFFFFFFFU);
+    if (producer >= producer_count || sequence != next_sequence[producer]) {
+      ordered = false;
+      break;
+    }
+    ++next_sequence[producer];
+    ++total;
+  }
+
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  CASE_EXPECT_TRUE(ordered);
+  CASE_EXPECT_EQ(static_cast<uint64_t>(producer_count) * push_count, total);
+  for (uint32_t i = 0; i < producer_count; ++i) {
+    CASE_EXPECT_EQ(push_count, next_sequence[i]);
+  }
+  CASE_EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,139 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+#include <core/sharded_id_allocator.h>
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#include "session_shard_dispatch.h"  // NOLINT: build/include_subdir
+
+namespace {
+using dispatch_type = atframework::gateway::session_shard_dispatch_t;
+using id_allocator = atframework::component::sharded_id_allocator<uint64_t>;
+
+// 和 session_manager 一样，每个分片用自己的分配器生成会话ID
+static std::vector<uint64_t> allocate_session_ids(uint32_t shard_index, uint32_t shard_count, size_t count) {
+  id_allocator allocator(shard_index, id_allocator::get_shard_bits_by_count(shard_count));
+  std::vector<uint64_t> ret;
+  time_t now = 1700000000;
+  for (size_t i = 0; i < count; ++i) {
+    ret.push_back(allocator.allocate(now));
+  }
+  return ret;
+}
+}  // namespace
+
+CASE_TEST(session_shard_dispatch, shard_index_by_count) {
+  CASE_EXPECT_EQ(0, id_allocator::get_shard_bits_by_count(1));
+  CASE_EXPECT_EQ(1, id_allocator::get_shard_bits_by_count(2));
+  CASE_EXPECT_EQ(2, id_allocator::get_shard_bits_by_count(3));
+  CASE_EXPECT_EQ(2, id_allocator::get_shard_bits_by_count(4));
+  CASE_EXPECT_EQ(3, id_allocator::get_shard_bits_by_count(5));
+
+  for (uint32_t shard_count = 1; shard_count <= 6; ++shard_count) {
+    for (uint32_t i = 0; i < shard_count; ++i) {
+      for (auto &sess_id : allocate_session_ids(i, shard_count, 16)) {
+        CASE_EXPECT_EQ(i, id_allocator::get_shard_index_by_count(sess_id, shard_count));
+      }
+    }
+  }
+}
+
+CASE_TEST(session_shard_dispatch, multicast) {
+  const uint32_t shard_count = 3;
+  std::vector<uint64_t> shard0 = allocate_session_ids(0, shard_count, 3);
+  std::vector<uint64_t> shard2 = allocate_session_ids(2, shard_count, 2);
+
+  // 不同分片的会话交错排列，拆分后每个分片内保持原来的顺序
+  ::atframework::gw::ss_msg msg;
+  msg.mutable_head()->set_session_id(shard0[0]);
+  ::atframework::gw::ss_body_post *post = msg.mutable_body()->mutable_post();
+  post->add_session_ids(shard0[0]);
+  post->add_session_ids(shard2[0]);
+  post->add_session_ids(shard0[1]);
+  post->add_session_ids(shard2[1]);
+  post->add_session_ids(shard0[2]);
+  post->set_content("multicast");
+
+  dispatch_type dispatch;
+  dispatch.build(msg, shard_count);
+  CASE_EXPECT_EQ(static_cast<int>(dispatch_type::mode_t::kMulticast), static_cast<int>(dispatch.mode));
+  CASE_EXPECT_EQ(shard_count, dispatch.shard_sessions.size());
+  if (dispatch.shard_sessions.size() != shard_count) {
+    return;
+  }
+
+  // 没有会话的分片不投递
+  CASE_EXPECT_TRUE(nullptr != dispatch.shard_sessions[0]);
+  CASE_EXPECT_TRUE(nullptr == dispatch.shard_sessions[1]);
+  CASE_EXPECT_TRUE(nullptr != dispatch.shard_sessions[2]);
+  if (dispatch.shard_sessions[0]) {
+    CASE_EXPECT_TRUE(shard0 == *dispatch.shard_sessions[0]);
+  }
+  if (dispatch.shard_sessions[2]) {
+    CASE_EXPECT_TRUE(shard2 == *dispatch.shard_sessions[2]);
+  }
+
+  // 复用同一个对象时要清掉上一次的结果
+  post->clear_session_ids();
+  post->add_session_ids(shard2[0]);
+  dispatch.build(msg, shard_count);
+  CASE_EXPECT_EQ(static_cast<int>(dispatch_type::mode_t::kMulticast), static_cast<int>(dispatch.mode));
+  CASE_EXPECT_TRUE(nullptr == dispatch.shard_sessions[0]);
+  CASE_EXPECT_TRUE(nullptr == dispatch.shard_sessions[1]);
+  CASE_EXPECT_TRUE(nullptr != dispatch.shard_sessions[2]);
+  if (dispatch.shard_sessions[2]) {
+    CASE_EXPECT_EQ(1, dispatch.shard_sessions[2]->size());
+  }
+}
+
+CASE_TEST(session_shard_dispatch, broadcast) {
+  ::atframework::gw::ss_msg msg;
+  msg.mutable_head()->set_session_id(0);
+  msg.mutable_body()->mutable_post()->set_content("broadcast");
+
+  dispatch_type dispatch;
+  dispatch.build(msg, 4);
+  CASE_EXPECT_EQ(static_cast<int>(dispatch_type::mode_t::kBroadcast), static_cast<int>(dispatch.mode));
+  CASE_EXPECT_TRUE(dispatch.shard_sessions.empty());
+}
+
+CASE_TEST(session_shard_dispatch, single_session_post) {
+  const uint32_t shard_count = 4;
+  dispatch_type dispatch;
+  for (uint32_t i = 0; i < shard_count; ++i) {
+    uint64_t sess_id = allocate_session_ids(i, shard_count, 1)[0];
+
+    ::atframework::gw::ss_msg msg;
+    msg.mutable_head()->set_session_id(sess_id);
+    msg.mutable_body()->mutable_post()->set_content("single");
+
+    dispatch.build(msg, shard_count);
+    CASE_EXPECT_EQ(static_cast<int>(dispatch_type::mode_t::kSingle), static_cast<int>(dispatch.mode));
+    CASE_EXPECT_EQ(i, dispatch.shard_index);
+    CASE_EXPECT_TRUE(dispatch.shard_sessions.empty());
+  }
+}
+
+CASE_TEST(session_shard_dispatch, session_command) {
+  const uint32_t shard_count = 3;
+  uint64_t sess_id = allocate_session_ids(2, shard_count, 1)[0];
+
+  // 非post的指令按头部的会话ID投递给所属分片
+  ::atframework::gw::ss_msg msg;
+  msg.mutable_head()->set_session_id(sess_id);
+  msg.mutable_body()->mutable_kickoff_session();
+
+  dispatch_type dispatch;
+  dispatch.build(msg, shard_count);
+  CASE_EXPECT_EQ(static_cast<int>(dispatch_type::mode_t::kSingle), static_cast<int>(dispatch.mode));
+  CASE_EXPECT_EQ(2, dispatch.shard_index);
+
+  // 只有一个分片时全部投递给第一个分片
+  dispatch.build(msg, 1);
+  CASE_EXPECT_EQ(static_cast<int>(dispatch_type::mode_t::kSingle), static_cast<int>(dispatch.mode));
+  CASE_EXPECT_EQ(0, dispatch.shard_index);
+}
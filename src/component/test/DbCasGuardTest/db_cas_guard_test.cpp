@@ -0,0 +1,96 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+#include <config/compiler/protobuf_prefix.h>
+
+#include <protocol/pbdesc/svr.const.err.pb.h>
+
+#include <config/compiler/protobuf_suffix.h>
+
+#include <rpc/db/db_utils.h>
+#include <rpc/db/hash_table.h>
+
+#include <cstdint>
+
+namespace {
+using cas_guard_t = rpc::db::hash_table::key_value::cas_guard_t;
+using cas_guard_status = rpc::db::hash_table::key_value::cas_guard_status;
+
+static cas_guard_t make_guard(uint64_t version) {
+  cas_guard_t ret;
+  ret.version = version;
+  ret.pack_fn = nullptr;
+  ret.cas_failed = false;
+  ret.saved = false;
+  return ret;
+}
+}  // namespace
+
+CASE_TEST(db_cas_guard, cluster_hash_slot) {
+  // Redis Cluster 文档里的例子
+  CASE_EXPECT_EQ(12739, rpc::db::get_cluster_hash_slot("123456789"));
+  CASE_EXPECT_EQ(12182, rpc::db::get_cluster_hash_slot("foo"));
+  CASE_EXPECT_EQ(0, rpc::db::get_cluster_hash_slot(""));
+}
+
+CASE_TEST(db_cas_guard, cluster_hash_tag) {
+  CASE_EXPECT_EQ(rpc::db::get_cluster_hash_slot("{user1000}.following"),
+                 rpc::db::get_cluster_hash_slot("{user1000}.followers"));
+  CASE_EXPECT_EQ(rpc::db::get_cluster_hash_slot("bar"), rpc::db::get_cluster_hash_slot("foo{bar}{zap}"));
+  CASE_EXPECT_EQ(rpc::db::get_cluster_hash_slot("{bar"), rpc::db::get_cluster_hash_slot("foo{{bar}}zap"));
+  // 空的 hash tag 按整个key计算
+  CASE_EXPECT_NE(rpc::db::get_cluster_hash_slot("bar"), rpc::db::get_cluster_hash_slot("foo{}{bar}"));
+
+  // hash tag 相同的key在同一个slot，可以在一个脚本里一起操作
+  CASE_EXPECT_EQ(rpc::db::get_cluster_hash_slot("prefix-login_lock.{123456}"),
+                 rpc::db::get_cluster_hash_slot("prefix-user.1.{123456}"));
+  CASE_EXPECT_EQ(rpc::db::get_cluster_hash_slot("123456"), rpc::db::get_cluster_hash_slot("prefix-user.1.{123456}"));
+}
+
+CASE_TEST(db_cas_guard, status_success) {
+  cas_guard_t guard = make_guard(3);
+  uint64_t version = 7;
+  CASE_EXPECT_EQ(PROJECT_NAMESPACE_ID::err::EN_SUCCESS,
+                 rpc::db::hash_table::key_value::apply_cas_guard_result(
+                     static_cast<int64_t>(cas_guard_status::kSuccess), 4, 8, guard, version));
+  CASE_EXPECT_EQ(4, guard.version);
+  CASE_EXPECT_EQ(8, version);
+  CASE_EXPECT_TRUE(guard.saved);
+  CASE_EXPECT_FALSE(guard.cas_failed);
+}
+
+CASE_TEST(db_cas_guard, status_guard_version_mismatch) {
+  cas_guard_t guard = make_guard(3);
+  uint64_t version = 7;
+  CASE_EXPECT_EQ(PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION,
+                 rpc::db::hash_table::key_value::apply_cas_guard_result(
+                     static_cast<int64_t>(cas_guard_status::kGuardVersionMismatch), 5, 7, guard, version));
+  // 守护表没有写入，需要重新拉取守护表
+  CASE_EXPECT_EQ(5, guard.version);
+  CASE_EXPECT_EQ(7, version);
+  CASE_EXPECT_FALSE(guard.saved);
+  CASE_EXPECT_TRUE(guard.cas_failed);
+}
+
+CASE_TEST(db_cas_guard, status_data_version_mismatch) {
+  cas_guard_t guard = make_guard(3);
+  uint64_t version = 7;
+  CASE_EXPECT_EQ(PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION,
+                 rpc::db::hash_table::key_value::apply_cas_guard_result(
+                     static_cast<int64_t>(cas_guard_status::kDataVersionMismatch), 4, 9, guard, version));
+  // 守护表已经续期，只需要使用返回的版本号重试数据表
+  CASE_EXPECT_EQ(4, guard.version);
+  CASE_EXPECT_EQ(9, version);
+  CASE_EXPECT_TRUE(guard.saved);
+  CASE_EXPECT_FALSE(guard.cas_failed);
+}
+
+CASE_TEST(db_cas_guard, status_unknown) {
+  cas_guard_t guard = make_guard(3);
+  uint64_t version = 7;
+  CASE_EXPECT_EQ(PROJECT_NAMESPACE_ID::err::EN_DB_REPLY_ERROR,
+                 rpc::db::hash_table::key_value::apply_cas_guard_result(3, 0, 0, guard, version));
+  CASE_EXPECT_FALSE(guard.saved);
+  CASE_EXPECT_FALSE(guard.cas_failed);
+}
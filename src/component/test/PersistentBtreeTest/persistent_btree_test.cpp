@@ -0,0 +1,550 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+#include <utility/persistent_btree.h>
+#include <utility/persistent_btree_allocator.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+struct test_sort_data {
+  int64_t score;
+  uint64_t user_id;
+
+  friend bool operator<(const test_sort_data& l, const test_sort_data& r) {
+    if (l.score != r.score) {
+      return l.score > r.score;
+    }
+    return l.user_id < r.user_id;
+  }
+};
+
+// 统计std::allocator的分配次数和内存占用，用来和slab分配器对比
+struct counting_allocator_stats {
+  static size_t allocate_count;
+  static size_t allocate_bytes;
+  static size_t peak_bytes;
+};
+
+size_t counting_allocator_stats::allocate_count = 0;
+size_t counting_allocator_stats::allocate_bytes = 0;
+size_t counting_allocator_stats::peak_bytes = 0;
+
+template <class T>
+struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator() noexcept = default;
+  template <class U>
+  counting_allocator(const counting_allocator<U>&) noexcept {}  // NOLINT: implicit
+
+  T* allocate(size_t n) {
+    ++counting_allocator_stats::allocate_count;
+    counting_allocator_stats::allocate_bytes += n * sizeof(T);
+    if (counting_allocator_stats::allocate_bytes > counting_allocator_stats::peak_bytes) {
+      counting_allocator_stats::peak_bytes = counting_allocator_stats::allocate_bytes;
+    }
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    counting_allocator_stats::allocate_bytes -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <class U>
+  bool operator==(const counting_allocator<U>&) const noexcept {
+    return true;
+  }
+
+  template <class U>
+  bool operator!=(const counting_allocator<U>&) const noexcept {
+    return false;
+  }
+};
+
+template <class TTree>
+static util::memory::strong_rc_ptr<TTree> create_tree(
+    size_t degree, const typename TTree::allocator_type& alloc = typename TTree::allocator_type()) {
+  return util::memory::make_strong_rc<TTree>(
+      degree, 10, [](const test_sort_data& l, const test_sort_data& r) { return l < r; }, alloc);
+}
+
+template <class TTree>
+static void check_tree_with_set(TTree& tree, const std::set<test_sort_data>& expect) {
+  CASE_EXPECT_EQ(expect.size(), tree.size());
+
+  size_t rank_no = 0;
+  bool all_matched = true;
+  for (auto& value : expect) {
+    ++rank_no;
+    auto iter = tree.at(rank_no);
+    if (iter == tree.end() || iter->user_id != value.user_id || tree.index(value) != rank_no) {
+      all_matched = false;
+      break;
+    }
+  }
+  CASE_EXPECT_TRUE(all_matched);
+}
+
+template <class TTree>
+static void run_random_update(size_t degree) {
+  auto tree = create_tree<TTree>(degree);
+  std::set<test_sort_data> expect;
+  std::vector<int64_t> scores;
+  scores.resize(2000, 0);
+
+  std::mt19937_64 rnd(static_cast<uint64_t>(degree));
+  for (size_t i = 0; i < 20000; ++i) {
+    uint64_t user_id = rnd() % scores.size();
+    if (0 != scores[user_id]) {
+      tree->erase(test_sort_data{scores[user_id], user_id});
+      expect.erase(test_sort_data{scores[user_id], user_id});
+    }
+
+    // 大约1/4的操作是删除
+    if (rnd() % 4 == 0) {
+      scores[user_id] = 0;
+      continue;
+    }
+    scores[user_id] = static_cast<int64_t>(rnd() % 100000) + 1;
+    tree->insert(test_sort_data{scores[user_id], user_id});
+    expect.insert(test_sort_data{scores[user_id], user_id});
+  }
+
+  check_tree_with_set(*tree, expect);
+}
+
+// 检查B树的结构: 非根节点的key数量在[T-1, 2T-1]之间，叶子节点在同一层，子树大小正确
+template <class TNode>
+static bool check_btree_node(const TNode& node, size_t degree, bool is_root, size_t depth, size_t& leaf_depth) {
+  if (node.keys.size() > 2 * degree - 1 || (!is_root && node.keys.size() < degree - 1)) {
+    return false;
+  }
+
+  size_t tree_sz = node.keys.size();
+  if (node.leaf_) {
+    if (0 == leaf_depth) {
+      leaf_depth = depth;
+    }
+    return leaf_depth == depth && tree_sz == node.tree_sz_;
+  }
+
+  if (node.children.size() != node.keys.size() + 1) {
+    return false;
+  }
+  for (auto& child : node.children) {
+    if (!check_btree_node(*child, degree, false, depth + 1, leaf_depth)) {
+      return false;
+    }
+    tree_sz += child->tree_sz_;
+  }
+  return tree_sz == node.tree_sz_;
+}
+
+// 性能测试的数据量可以通过环境变量调整，默认值比较小，避免拖慢单元测试:
+//   PERSISTENT_BTREE_BENCHMARK_ENTRIES 排行榜条目数和更新次数，默认 20000
+static size_t get_benchmark_entry_count() {
+  const char* env_value = getenv("PERSISTENT_BTREE_BENCHMARK_ENTRIES");
+  if (nullptr == env_value || 0 == *env_value) {
+    return 20000;
+  }
+
+  size_t ret = static_cast<size_t>(strtoull(env_value, nullptr, 10));
+  return ret > 0 ? ret : 20000;
+}
+
+// 逐个比较两棵树(或镜像)的数据，必须完全一致
+template <class TLeft, class TRight>
+static bool is_tree_equal(TLeft& l, TRight& r) {
+  if (l.size() != r.size()) {
+    return false;
+  }
+
+  auto riter = r.begin();
+  for (auto liter = l.begin(); liter != l.end(); ++liter, ++riter) {
+    if (riter == r.end() || liter->score != riter->score || liter->user_id != riter->user_id) {
+      return false;
+    }
+  }
+  return riter == r.end();
+}
+
+static int64_t get_elapsed_ms(std::chrono::steady_clock::time_point begin) {
+  return static_cast<int64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count());
+}
+
+struct benchmark_result {
+  int64_t build_ms;
+  int64_t update_ms;
+};
+
+// 模拟排行榜: 先插入全部数据，然后持续更新分数，并且和rank_mirror_manager一样保留最近若干个版本的镜像
+template <class TTree>
+static benchmark_result run_benchmark(const typename TTree::allocator_type& alloc, size_t entry_count,
+                                      size_t update_count, size_t keep_versions, size_t update_per_version) {
+  benchmark_result ret;
+  auto tree = create_tree<TTree>(20, alloc);
+  std::vector<int64_t> scores;
+  scores.resize(entry_count, 0);
+
+  std::mt19937_64 rnd(entry_count);
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < entry_count; ++i) {
+    scores[i] = static_cast<int64_t>(rnd() % 100000000) + 1;
+    tree->insert(test_sort_data{scores[i], i});
+  }
+  ret.build_ms = get_elapsed_ms(begin);
+
+  std::deque<typename TTree::mirror_pointer> mirrors;
+  // 最近一个镜像创建时的分数，用来检查镜像不受后续更新的影响
+  std::vector<int64_t> mirror_scores;
+  begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < update_count; ++i) {
+    uint64_t user_id = rnd() % entry_count;
+    tree->erase(test_sort_data{scores[user_id], user_id});
+    scores[user_id] = static_cast<int64_t>(rnd() % 100000000) + 1;
+    tree->insert(test_sort_data{scores[user_id], user_id});
+
+    if (i % update_per_version == 0) {
+      mirrors.push_back(tree->create_mirror());
+      while (mirrors.size() > keep_versions) {
+        mirrors.pop_front();
+      }
+      mirror_scores = scores;
+    }
+  }
+  ret.update_ms = get_elapsed_ms(begin);
+
+  CASE_EXPECT_EQ(entry_count, tree->size());
+  if (!mirrors.empty()) {
+    auto expect = create_tree<TTree>(20, alloc);
+    for (size_t i = 0; i < mirror_scores.size(); ++i) {
+      expect->insert(test_sort_data{mirror_scores[i], i});
+    }
+    CASE_EXPECT_TRUE(is_tree_equal(*expect, *mirrors.back()));
+  }
+  return ret;
+}
+
+}  // namespace
+
+CASE_TEST(persistent_btree, random_update_std_allocator) {
+  run_random_update<persistent_btree<test_sort_data>>(2);
+  run_random_update<persistent_btree<test_sort_data>>(20);
+}
+
+CASE_TEST(persistent_btree, random_update_slab_allocator) {
+  run_random_update<persistent_btree<test_sort_data, persistent_btree_slab_allocator<test_sort_data>>>(2);
+  run_random_update<persistent_btree<test_sort_data, persistent_btree_slab_allocator<test_sort_data>>>(20);
+}
+
+CASE_TEST(persistent_btree, order_statistic) {
+  using tree_type = persistent_btree<test_sort_data, persistent_btree_slab_allocator<test_sort_data>>;
+  for (size_t degree : {2, 3, 20}) {
+    auto tree = create_tree<tree_type>(degree);
+    std::vector<test_sort_data> expect;
+    // 分数从高到低排序，每个分数有两个玩家
+    for (uint64_t i = 1; i <= 1000; ++i) {
+      tree->insert(test_sort_data{static_cast<int64_t>((i + 1) / 2), i});
+    }
+    for (auto iter = tree->begin(); iter != tree->end(); ++iter) {
+      expect.push_back(*iter);
+    }
+    CASE_EXPECT_EQ(static_cast<size_t>(1000), expect.size());
+
+    bool all_matched = true;
+    for (size_t from = 1; from <= expect.size() + 1; from += 7) {
+      size_t visited = tree->visit_range(from, 13, [&](size_t rank_no, const tree_type::value_pointer& value) {
+        if (rank_no > expect.size() || expect[rank_no - 1].user_id != value->user_id) {
+          all_matched = false;
+        }
+        return true;
+      });
+      size_t expect_count = from > expect.size() ? 0 : std::min<size_t>(13, expect.size() - from + 1);
+      if (visited != expect_count) {
+        all_matched = false;
+      }
+    }
+    CASE_EXPECT_TRUE(all_matched);
+
+    // 回调返回false时提前结束
+    size_t stop_count = tree->visit_range(100, 50, [](size_t rank_no, const tree_type::value_pointer&) {
+      return rank_no < 109;
+    });
+    CASE_EXPECT_EQ(static_cast<size_t>(10), stop_count);
+
+    // 分数高于score的玩家数
+    for (int64_t score : {0, 1, 250, 499, 500, 501}) {
+      size_t count = tree->count_prefix([score](const test_sort_data& value) { return value.score > score; });
+      size_t expect_count = score >= 500 ? 0 : static_cast<size_t>(500 - score) * 2;
+      CASE_EXPECT_EQ(expect_count, count);
+    }
+
+    CASE_EXPECT_EQ(static_cast<size_t>(1), tree->index(expect.front()));
+    CASE_EXPECT_EQ(expect.size(), tree->index(expect.back()));
+    CASE_EXPECT_EQ(static_cast<size_t>(500), tree->index(expect[499]));
+  }
+}
+
+CASE_TEST(persistent_btree, assign_sorted) {
+  using tree_type = persistent_btree<test_sort_data, persistent_btree_slab_allocator<test_sort_data>>;
+  for (size_t degree : {2, 3, 20}) {
+    for (size_t count : {0, 1, 2, 3, 4, 5, 39, 40, 41, 1000, 12345}) {
+      std::set<test_sort_data> expect;
+      std::vector<tree_type::value_pointer> values;
+      for (uint64_t i = 1; i <= count; ++i) {
+        expect.insert(test_sort_data{static_cast<int64_t>((i + 1) / 2), i});
+      }
+      for (auto& value : expect) {
+        values.push_back(util::memory::make_strong_rc<test_sort_data>(value));
+      }
+
+      auto tree = util::memory::make_strong_rc<tree_type>(
+          degree, 10, [](const test_sort_data& l, const test_sort_data& r) { return l < r; }, values);
+      CASE_EXPECT_TRUE(tree->is_sorted(values));
+      size_t leaf_depth = 0;
+      CASE_EXPECT_TRUE(check_btree_node(*tree->get_root(), degree, true, 1, leaf_depth));
+      check_tree_with_set(*tree, expect);
+
+      // 批量建树后可以继续正常增删
+      for (uint64_t i = 1; i <= count; i += 3) {
+        test_sort_data value{static_cast<int64_t>((i + 1) / 2), i};
+        tree->erase(value);
+        expect.erase(value);
+        value.score += 1000000;
+        tree->insert(value);
+        expect.insert(value);
+      }
+      leaf_depth = 0;
+      CASE_EXPECT_TRUE(check_btree_node(*tree->get_root(), degree, true, 1, leaf_depth));
+      check_tree_with_set(*tree, expect);
+    }
+  }
+
+  // 乱序数据不能直接建树
+  auto tree = create_tree<tree_type>(3);
+  std::vector<tree_type::value_pointer> values;
+  values.push_back(tree->make_value(test_sort_data{1, 1}));
+  values.push_back(tree->make_value(test_sort_data{2, 2}));
+  CASE_EXPECT_FALSE(tree->is_sorted(values));
+}
+
+CASE_TEST(persistent_btree, mirror_keep_old_version) {
+  using tree_type = persistent_btree<test_sort_data, persistent_btree_slab_allocator<test_sort_data>>;
+  auto tree = create_tree<tree_type>(3);
+  for (uint64_t i = 1; i <= 100; ++i) {
+    tree->insert(test_sort_data{static_cast<int64_t>(i), i});
+  }
+
+  auto mirror = tree->create_mirror();
+  for (uint64_t i = 1; i <= 50; ++i) {
+    tree->erase(test_sort_data{static_cast<int64_t>(i), i});
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(50), tree->size());
+  CASE_EXPECT_EQ(static_cast<size_t>(100), mirror->size());
+
+  // 镜像按旧版本的顺序遍历，分数从高到低
+  int64_t expect_score = 100;
+  for (auto iter = mirror->begin(); iter != mirror->end(); ++iter) {
+    CASE_EXPECT_EQ(expect_score, iter->score);
+    --expect_score;
+  }
+  CASE_EXPECT_EQ(static_cast<int64_t>(0), expect_score);
+
+  // 用排名做游标分页导出，中途修改树不影响镜像
+  expect_score = 100;
+  size_t cursor = 1;
+  size_t page_count = 0;
+  while (true) {
+    size_t visited = mirror->visit_range(cursor, 7, [&](size_t rank_no, const tree_type::value_pointer& value) {
+      CASE_EXPECT_EQ(static_cast<size_t>(101 - expect_score), rank_no);
+      CASE_EXPECT_EQ(expect_score, value->score);
+      --expect_score;
+      return true;
+    });
+    if (0 == visited) {
+      break;
+    }
+    cursor += visited;
+    ++page_count;
+    tree->insert(test_sort_data{static_cast<int64_t>(1000 + page_count), 1000 + page_count});
+  }
+  CASE_EXPECT_EQ(static_cast<int64_t>(0), expect_score);
+  CASE_EXPECT_EQ(static_cast<size_t>(15), page_count);
+
+  // 树释放后镜像还持有slab，释放镜像后所有内存块一起回收
+  persistent_btree_slab* slab = tree->get_allocator().get_slab();
+  size_t used_bytes = slab->get_used_bytes();
+  tree.reset();
+  CASE_EXPECT_TRUE(slab->get_used_bytes() <= used_bytes);
+  CASE_EXPECT_EQ(static_cast<size_t>(100), mirror->size());
+}
+
+CASE_TEST(persistent_btree, slab_trim) {
+  persistent_btree_slab_allocator<test_sort_data> alloc(4096);
+  persistent_btree_slab* slab = alloc.get_slab();
+
+  // 每个块48字节，4096字节的大块内存切分85个块后剩下16字节的尾部
+  std::vector<test_sort_data*> blocks;
+  for (size_t i = 0; i < 1000; ++i) {
+    blocks.push_back(alloc.allocate(3));
+  }
+  size_t chunk_count = slab->get_chunk_count();
+  CASE_EXPECT_EQ(static_cast<size_t>(12), chunk_count);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), slab->trim());
+
+  // 每个大块内存里留一个块时都不能归还
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (0 != i % 85) {
+      alloc.deallocate(blocks[i], 3);
+      blocks[i] = nullptr;
+    }
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(0), slab->trim());
+  CASE_EXPECT_EQ(chunk_count, slab->get_chunk_count());
+
+  // 前一半的大块内存完全空闲，保留2个给接下来的分配
+  for (size_t i = 0; i < 85 * 6; i += 85) {
+    alloc.deallocate(blocks[i], 3);
+    blocks[i] = nullptr;
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(4), slab->trim(2));
+  CASE_EXPECT_EQ(static_cast<size_t>(8), slab->get_chunk_count());
+  CASE_EXPECT_EQ(static_cast<size_t>(2), slab->trim());
+  CASE_EXPECT_EQ(static_cast<size_t>(6), slab->get_chunk_count());
+  CASE_EXPECT_EQ(static_cast<size_t>(6) * 4096, slab->get_reserved_bytes());
+
+  // 剩下的空闲块还可以继续分配，不会申请新的大块内存
+  for (size_t i = 0; i < 100; ++i) {
+    blocks.push_back(alloc.allocate(3));
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(6), slab->get_chunk_count());
+
+  for (auto& block : blocks) {
+    if (nullptr != block) {
+      alloc.deallocate(block, 3);
+    }
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(0), slab->get_used_bytes());
+  CASE_EXPECT_EQ(static_cast<size_t>(6), slab->trim());
+  CASE_EXPECT_EQ(static_cast<size_t>(0), slab->get_reserved_bytes());
+
+  // 全部归还后还可以重新分配
+  test_sort_data* block = alloc.allocate(1);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), slab->get_chunk_count());
+  alloc.deallocate(block, 1);
+}
+
+CASE_TEST(persistent_btree, slab_trim_after_mirror_release) {
+  using tree_type = persistent_btree<test_sort_data, persistent_btree_slab_allocator<test_sort_data>>;
+  auto tree = create_tree<tree_type>(3, tree_type::allocator_type(4096));
+  persistent_btree_slab* slab = tree->get_allocator().get_slab();
+  for (uint64_t i = 1; i <= 2000; ++i) {
+    tree->insert(test_sort_data{static_cast<int64_t>(i), i});
+  }
+
+  // 镜像持有旧版本的节点，树上删除的数据要等镜像释放后才会回到空闲链表
+  auto mirror = tree->create_mirror();
+  for (uint64_t i = 1; i <= 1900; ++i) {
+    tree->erase(test_sort_data{static_cast<int64_t>(i), i});
+  }
+  size_t chunk_count = slab->get_chunk_count();
+  size_t trim_with_mirror = slab->trim();
+  CASE_EXPECT_EQ(chunk_count - trim_with_mirror, slab->get_chunk_count());
+
+  mirror.reset();
+  size_t used_bytes = slab->get_used_bytes();
+  CASE_EXPECT_GT(slab->trim(), static_cast<size_t>(0));
+  CASE_EXPECT_LT(slab->get_chunk_count(), chunk_count - trim_with_mirror);
+  CASE_EXPECT_EQ(used_bytes, slab->get_used_bytes());
+
+  // 归还内存后树还可以继续修改
+  for (uint64_t i = 1; i <= 1900; ++i) {
+    tree->insert(test_sort_data{static_cast<int64_t>(i), i});
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(2000), tree->size());
+  int64_t expect_score = 2000;
+  for (auto iter = tree->begin(); iter != tree->end(); ++iter) {
+    CASE_EXPECT_EQ(expect_score, iter->score);
+    --expect_score;
+  }
+  CASE_EXPECT_EQ(static_cast<int64_t>(0), expect_score);
+}
+
+CASE_TEST(persistent_btree, benchmark) {
+  const size_t entry_count = get_benchmark_entry_count();
+  const size_t update_count = entry_count;
+  const size_t keep_versions = 10;
+  const size_t update_per_version = entry_count / 100 + 1;
+
+  {
+    using tree_type = persistent_btree<test_sort_data, counting_allocator<test_sort_data>>;
+    counting_allocator_stats::allocate_count = 0;
+    counting_allocator_stats::peak_bytes = 0;
+    benchmark_result result = run_benchmark<tree_type>(tree_type::allocator_type(), entry_count, update_count,
+                                                       keep_versions, update_per_version);
+    CASE_MSG_INFO() << "std::allocator: build " << entry_count << " entries cost " << result.build_ms << "ms, update "
+                    << update_count << " times with " << keep_versions << " versions cost " << result.update_ms
+                    << "ms, allocate " << counting_allocator_stats::allocate_count << " times, peak "
+                    << counting_allocator_stats::peak_bytes / 1024 / 1024 << "MB(without malloc overhead)"
+                    << std::endl;
+  }
+
+  {
+    // 从有序的镜像数据恢复时，批量建树和逐个插入的对比
+    using tree_type = persistent_btree<test_sort_data, persistent_btree_slab_allocator<test_sort_data>>;
+    auto source = create_tree<tree_type>(20);
+    std::mt19937_64 rnd(entry_count);
+    for (size_t i = 0; i < entry_count; ++i) {
+      source->insert(test_sort_data{static_cast<int64_t>(rnd() % 100000000) + 1, i});
+    }
+    std::vector<tree_type::value_pointer> values;
+    values.reserve(entry_count);
+    for (auto iter = source->begin(); iter != source->end(); ++iter) {
+      values.push_back(source->make_value(*iter));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    auto insert_tree = create_tree<tree_type>(20);
+    for (auto& value : values) {
+      insert_tree->insert(value);
+    }
+    int64_t insert_ms = get_elapsed_ms(begin);
+
+    begin = std::chrono::steady_clock::now();
+    auto bulk_tree = create_tree<tree_type>(20);
+    bulk_tree->assign_sorted(values);
+    int64_t bulk_ms = get_elapsed_ms(begin);
+
+    CASE_EXPECT_EQ(entry_count, insert_tree->size());
+    CASE_EXPECT_EQ(entry_count, bulk_tree->size());
+    CASE_EXPECT_TRUE(is_tree_equal(*source, *insert_tree));
+    CASE_EXPECT_TRUE(is_tree_equal(*source, *bulk_tree));
+    CASE_MSG_INFO() << "restore " << entry_count << " sorted entries: insert one by one cost " << insert_ms
+                    << "ms, assign_sorted cost " << bulk_ms << "ms" << std::endl;
+  }
+
+  {
+    using tree_type = persistent_btree<test_sort_data, persistent_btree_slab_allocator<test_sort_data>>;
+    // 分配器持有slab，benchmark结束后还可以读取统计数据。slab的内存只会复用不会归还，所以占用就是峰值
+    tree_type::allocator_type alloc;
+    benchmark_result result =
+        run_benchmark<tree_type>(alloc, entry_count, update_count, keep_versions, update_per_version);
+    CASE_MSG_INFO() << "persistent_btree_slab_allocator: build " << entry_count << " entries cost " << result.build_ms
+                    << "ms, update " << update_count << " times with " << keep_versions << " versions cost "
+                    << result.update_ms << "ms, allocate " << alloc.get_slab()->get_chunk_count()
+                    << " chunks, peak " << alloc.get_slab()->get_reserved_bytes() / 1024 / 1024 << "MB" << std::endl;
+  }
+}
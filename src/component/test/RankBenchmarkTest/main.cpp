@@ -0,0 +1,5 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+int main(int argc, char* argv[]) { return run_tests(argc, argv); }
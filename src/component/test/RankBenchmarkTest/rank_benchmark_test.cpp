@@ -0,0 +1,367 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+// clang-format off
+#include <config/compiler/protobuf_prefix.h>
+// clang-format on
+
+#include <protocol/pbdesc/com.struct.rank.pb.h>
+#include <protocol/pbdesc/svr.struct.pb.h>
+
+// clang-format off
+#include <config/compiler/protobuf_suffix.h>
+// clang-format on
+
+#include <utility/persistent_btree.h>
+#include <utility/persistent_btree_allocator.h>
+#include <utility/protobuf_mini_dumper.h>
+#include <utility/rank_util.h>
+
+#include <rank/logic_rank_tree.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 排行榜的性能测试，参数可以通过环境变量调整:
+//   RANK_BENCHMARK_ENTRIES    榜单大小，逗号分隔，默认 10000,1000000 (10000000需要数GB内存，按需开启)
+//   RANK_BENCHMARK_DEGREES    B树的最小度数T，逗号分隔，默认 8,20,64
+//   RANK_BENCHMARK_OPERATIONS 每项测试的操作次数，默认 100000
+// 所有随机数都使用固定的种子，相同参数下每次执行的操作序列完全一致
+
+namespace {
+
+// 和ranksvr中的rank_tree保持一致
+using benchmark_rank_tree = persistent_btree<PROJECT_NAMESPACE_ID::rank_storage_data,
+                                             persistent_btree_slab_allocator<PROJECT_NAMESPACE_ID::rank_storage_data>>;
+
+// 和ranksvr中rank_manager::get_compare_fn()返回的降序比较函数一致
+static bool descending_order(const PROJECT_NAMESPACE_ID::rank_storage_data& l,
+                             const PROJECT_NAMESPACE_ID::rank_storage_data& r) {
+  return l.sort_data().value() == r.sort_data().value() ? r.sort_data().key() < l.sort_data().key()
+                                                        : r.sort_data().value() < l.sort_data().value();
+}
+
+struct benchmark_options {
+  std::vector<size_t> entry_counts;
+  std::vector<size_t> degrees;
+  size_t operation_count;
+};
+
+static std::vector<size_t> parse_size_list(const char* env_name, std::vector<size_t> default_value) {
+  const char* env_value = getenv(env_name);
+  if (nullptr == env_value || 0 == *env_value) {
+    return default_value;
+  }
+
+  std::vector<size_t> ret;
+  std::stringstream ss(env_value);
+  std::string segment;
+  while (std::getline(ss, segment, ',')) {
+    size_t value = static_cast<size_t>(strtoull(segment.c_str(), nullptr, 10));
+    if (value > 0) {
+      ret.push_back(value);
+    }
+  }
+  return ret.empty() ? default_value : ret;
+}
+
+static const benchmark_options& get_options() {
+  static benchmark_options ret = []() {
+    benchmark_options opts;
+    opts.entry_counts = parse_size_list("RANK_BENCHMARK_ENTRIES", {10000, 1000000});
+    opts.degrees = parse_size_list("RANK_BENCHMARK_DEGREES", {8, 20, 64});
+    opts.operation_count = parse_size_list("RANK_BENCHMARK_OPERATIONS", {100000}).front();
+    return opts;
+  }();
+  return ret;
+}
+
+class benchmark_timer {
+ public:
+  benchmark_timer() : begin_(std::chrono::steady_clock::now()) {}
+
+  int64_t get_elapsed_ns() const {
+    return static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin_).count());
+  }
+
+  int64_t get_ns_per_op(size_t count) const {
+    return count > 0 ? get_elapsed_ns() / static_cast<int64_t>(count) : 0;
+  }
+
+ private:
+  std::chrono::steady_clock::time_point begin_;
+};
+
+static void make_sort_data(PROJECT_NAMESPACE_ID::rank_sort_data& out, uint64_t user_id, int64_t score) {
+  out.mutable_key()->set_user_id(user_id);
+  out.mutable_key()->set_zone_id(1);
+  out.mutable_value()->set_score(score);
+  out.mutable_value()->set_submit_timepoint(1700000000);
+}
+
+static int64_t random_score(std::mt19937_64& rnd) { return static_cast<int64_t>(rnd() % 100000000) + 1; }
+
+// 和ranksvr的rank类使用相同的内存结构，更新和查询都调用rank_util中和rank类共用的实现，去掉了日志、配置和版本同步部分
+class benchmark_board {
+ public:
+  benchmark_board(size_t degree, uint32_t capacity) : capacity_(capacity) {
+    btree_ = util::memory::make_strong_rc<benchmark_rank_tree>(degree, 10, descending_order);
+  }
+
+  int32_t update_score(const PROJECT_NAMESPACE_ID::rank_storage_data& data) {
+    logic_rank_upsert_data(*btree_, mp_, capacity_, data, [](const PROJECT_NAMESPACE_ID::DRankUserKey&) {});
+    return 0;
+  }
+
+  int32_t query_rank_top(uint32_t from, uint32_t count, PROJECT_NAMESPACE_ID::DRankQueryRspData& output) {
+    logic_rank_dump_top(*btree_, from, count, rank_util::get_rank_query_max_count(), output);
+    return 0;
+  }
+
+  int32_t query_one_user_by_rank_no(int32_t rank_no, PROJECT_NAMESPACE_ID::rank_data& output) {
+    return logic_rank_dump_data_by_rank_no(*btree_, rank_no, output) ? 0 : -1;
+  }
+
+  int32_t query_rank_user_front_back(const PROJECT_NAMESPACE_ID::DRankUserKey& key, uint32_t count,
+                                     PROJECT_NAMESPACE_ID::DRankQueryRspData& output) {
+    auto iter = mp_.find(key);
+    if (iter == mp_.end()) {
+      return -1;
+    }
+    uint32_t rank_no = static_cast<uint32_t>(btree_->index(*iter->second));
+    uint32_t start_no = 0;
+    uint32_t real_count = 0;
+    rank_util::get_rank_front_back_range(rank_no, count, rank_util::get_rank_query_max_count(), start_no, real_count);
+    return query_rank_top(start_no, real_count, output);
+  }
+
+  benchmark_rank_tree& get_tree() { return *btree_; }
+
+ private:
+  uint32_t capacity_;
+  std::map<PROJECT_NAMESPACE_ID::DRankUserKey, benchmark_rank_tree::value_pointer> mp_;
+  util::memory::strong_rc_ptr<benchmark_rank_tree> btree_;
+};
+
+static void benchmark_tree_operations(size_t entry_count, size_t degree, size_t operation_count) {
+  auto tree = util::memory::make_strong_rc<benchmark_rank_tree>(degree, 10, descending_order);
+  std::vector<int64_t> scores;
+  scores.resize(entry_count, 0);
+  std::mt19937_64 rnd(entry_count * 131 + degree);
+  PROJECT_NAMESPACE_ID::rank_storage_data storage_data;
+
+  benchmark_timer timer;
+  for (size_t i = 0; i < entry_count; ++i) {
+    scores[i] = random_score(rnd);
+    make_sort_data(*storage_data.mutable_sort_data(), i + 1, scores[i]);
+    tree->insert(storage_data);
+  }
+  int64_t build_ns = timer.get_ns_per_op(entry_count);
+
+  // 按榜单大小取模后，同一个玩家可能被选中多次，所以删除后立即重新插入保证下一次删除的key存在
+  std::vector<uint64_t> users;
+  users.reserve(operation_count);
+  for (size_t i = 0; i < operation_count; ++i) {
+    users.push_back(rnd() % entry_count);
+  }
+
+  int64_t erase_total_ns = 0;
+  int64_t insert_total_ns = 0;
+  for (auto user_index : users) {
+    make_sort_data(*storage_data.mutable_sort_data(), user_index + 1, scores[user_index]);
+    benchmark_timer erase_timer;
+    tree->erase(storage_data);
+    erase_total_ns += erase_timer.get_elapsed_ns();
+
+    scores[user_index] = random_score(rnd);
+    make_sort_data(*storage_data.mutable_sort_data(), user_index + 1, scores[user_index]);
+    benchmark_timer insert_timer;
+    tree->insert(storage_data);
+    insert_total_ns += insert_timer.get_elapsed_ns();
+  }
+
+  size_t found_count = 0;
+  timer = benchmark_timer();
+  for (size_t i = 0; i < operation_count; ++i) {
+    if (tree->at(rnd() % entry_count + 1) != tree->end()) {
+      ++found_count;
+    }
+  }
+  int64_t at_ns = timer.get_ns_per_op(operation_count);
+  CASE_EXPECT_EQ(operation_count, found_count);
+
+  size_t index_sum = 0;
+  timer = benchmark_timer();
+  for (size_t i = 0; i < operation_count; ++i) {
+    uint64_t user_index = rnd() % entry_count;
+    make_sort_data(*storage_data.mutable_sort_data(), user_index + 1, scores[user_index]);
+    index_sum += tree->index(storage_data);
+  }
+  int64_t index_ns = timer.get_ns_per_op(operation_count);
+  CASE_EXPECT_TRUE(index_sum > 0);
+
+  size_t top_count = 0;
+  timer = benchmark_timer();
+  for (size_t i = 0; i < operation_count; ++i) {
+    top_count += tree->visit_range(1, rank_util::get_rank_query_max_count(),
+                                   [](size_t, const benchmark_rank_tree::value_pointer&) { return true; });
+  }
+  int64_t top_ns = timer.get_ns_per_op(operation_count);
+  CASE_EXPECT_TRUE(top_count > 0);
+
+  CASE_MSG_INFO() << "persistent_btree entries=" << entry_count << " T=" << degree << ": build " << build_ns
+                  << "ns/op, erase " << erase_total_ns / static_cast<int64_t>(operation_count) << "ns/op, insert "
+                  << insert_total_ns / static_cast<int64_t>(operation_count) << "ns/op, at " << at_ns
+                  << "ns/op, index " << index_ns << "ns/op, top" << rank_util::get_rank_query_max_count() << " "
+                  << top_ns << "ns/op" << std::endl;
+}
+
+// 镜像本身只持有根节点，主要开销在于镜像存在时的写时复制和导出时的全量遍历
+static void benchmark_mirror_operations(size_t entry_count, size_t degree, size_t operation_count) {
+  auto tree = util::memory::make_strong_rc<benchmark_rank_tree>(degree, 10, descending_order);
+  std::vector<int64_t> scores;
+  scores.resize(entry_count, 0);
+  std::mt19937_64 rnd(entry_count * 137 + degree);
+  PROJECT_NAMESPACE_ID::rank_storage_data storage_data;
+  for (size_t i = 0; i < entry_count; ++i) {
+    scores[i] = random_score(rnd);
+    make_sort_data(*storage_data.mutable_sort_data(), i + 1, scores[i]);
+    tree->insert(storage_data);
+  }
+
+  auto run_updates = [&](size_t keep_versions) {
+    std::deque<benchmark_rank_tree::mirror_pointer> mirrors;
+    size_t update_per_version = operation_count / 100 + 1;
+    benchmark_timer timer;
+    for (size_t i = 0; i < operation_count; ++i) {
+      uint64_t user_index = rnd() % entry_count;
+      make_sort_data(*storage_data.mutable_sort_data(), user_index + 1, scores[user_index]);
+      tree->erase(storage_data);
+      scores[user_index] = random_score(rnd);
+      make_sort_data(*storage_data.mutable_sort_data(), user_index + 1, scores[user_index]);
+      tree->insert(storage_data);
+
+      if (keep_versions > 0 && i % update_per_version == 0) {
+        mirrors.push_back(tree->create_mirror());
+        while (mirrors.size() > keep_versions) {
+          mirrors.pop_front();
+        }
+      }
+    }
+    return timer.get_ns_per_op(operation_count);
+  };
+
+  int64_t update_without_mirror_ns = run_updates(0);
+  int64_t update_with_mirror_ns = run_updates(10);
+
+  size_t create_count = operation_count < 10000 ? operation_count : 10000;
+  benchmark_timer timer;
+  for (size_t i = 0; i < create_count; ++i) {
+    auto mirror = tree->create_mirror();
+    CASE_EXPECT_TRUE(!!mirror);
+  }
+  int64_t create_ns = timer.get_ns_per_op(create_count);
+
+  auto mirror = tree->create_mirror();
+  size_t visited = 0;
+  timer = benchmark_timer();
+  for (auto iter = mirror->begin(); iter != mirror->end(); ++iter) {
+    ++visited;
+  }
+  int64_t traverse_ms = timer.get_elapsed_ns() / 1000000;
+  CASE_EXPECT_EQ(entry_count, visited);
+
+  CASE_MSG_INFO() << "persistent_btree mirror entries=" << entry_count << " T=" << degree << ": create "
+                  << create_ns << "ns/op, update without mirror " << update_without_mirror_ns
+                  << "ns/op, update with 10 mirrors " << update_with_mirror_ns << "ns/op, traverse mirror "
+                  << traverse_ms << "ms" << std::endl;
+}
+
+static void benchmark_rank_operations(size_t entry_count, size_t degree, size_t operation_count) {
+  benchmark_board board(degree, static_cast<uint32_t>(entry_count));
+  std::mt19937_64 rnd(entry_count * 139 + degree);
+  PROJECT_NAMESPACE_ID::rank_storage_data storage_data;
+
+  for (size_t i = 0; i < entry_count; ++i) {
+    make_sort_data(*storage_data.mutable_sort_data(), i + 1, random_score(rnd));
+    board.update_score(storage_data);
+  }
+
+  benchmark_timer timer;
+  for (size_t i = 0; i < operation_count; ++i) {
+    make_sort_data(*storage_data.mutable_sort_data(), rnd() % entry_count + 1, random_score(rnd));
+    board.update_score(storage_data);
+  }
+  int64_t update_ns = timer.get_ns_per_op(operation_count);
+
+  timer = benchmark_timer();
+  for (size_t i = 0; i < operation_count; ++i) {
+    PROJECT_NAMESPACE_ID::DRankQueryRspData output;
+    board.query_rank_top(1, rank_util::get_rank_query_max_count(), output);
+  }
+  int64_t top_ns = timer.get_ns_per_op(operation_count);
+
+  size_t found_count = 0;
+  timer = benchmark_timer();
+  for (size_t i = 0; i < operation_count; ++i) {
+    PROJECT_NAMESPACE_ID::rank_data output;
+    if (0 == board.query_one_user_by_rank_no(static_cast<int32_t>(rnd() % entry_count + 1), output)) {
+      ++found_count;
+    }
+  }
+  int64_t rank_no_ns = timer.get_ns_per_op(operation_count);
+  CASE_EXPECT_EQ(operation_count, found_count);
+
+  PROJECT_NAMESPACE_ID::DRankUserKey user_key;
+  user_key.set_zone_id(1);
+  timer = benchmark_timer();
+  for (size_t i = 0; i < operation_count; ++i) {
+    PROJECT_NAMESPACE_ID::DRankQueryRspData output;
+    user_key.set_user_id(rnd() % entry_count + 1);
+    board.query_rank_user_front_back(user_key, 10, output);
+  }
+  int64_t front_back_ns = timer.get_ns_per_op(operation_count);
+
+  CASE_MSG_INFO() << "rank entries=" << entry_count << " T=" << degree << ": update_score " << update_ns
+                  << "ns/op, query_rank_top(1," << rank_util::get_rank_query_max_count() << ") " << top_ns
+                  << "ns/op, query_one_user_by_rank_no " << rank_no_ns << "ns/op, query_rank_user_front_back(10) "
+                  << front_back_ns << "ns/op" << std::endl;
+}
+
+}  // namespace
+
+CASE_TEST(rank_benchmark, persistent_btree_operations) {
+  const benchmark_options& opts = get_options();
+  for (auto entry_count : opts.entry_counts) {
+    for (auto degree : opts.degrees) {
+      benchmark_tree_operations(entry_count, degree, opts.operation_count);
+    }
+  }
+}
+
+CASE_TEST(rank_benchmark, persistent_btree_mirror) {
+  const benchmark_options& opts = get_options();
+  for (auto entry_count : opts.entry_counts) {
+    for (auto degree : opts.degrees) {
+      benchmark_mirror_operations(entry_count, degree, opts.operation_count);
+    }
+  }
+}
+
+CASE_TEST(rank_benchmark, rank_operations) {
+  const benchmark_options& opts = get_options();
+  for (auto entry_count : opts.entry_counts) {
+    for (auto degree : opts.degrees) {
+      benchmark_rank_operations(entry_count, degree, opts.operation_count);
+    }
+  }
+}
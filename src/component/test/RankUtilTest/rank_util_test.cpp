@@ -0,0 +1,289 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+// clang-format off
+#include <config/compiler/protobuf_prefix.h>
+
+#include <protocol/pbdesc/svr.struct.rank.pb.h>
+
+#include <config/compiler/protobuf_suffix.h>
+// clang-format on
+
+#include <memory/rc_ptr.h>
+#include <utility/persistent_btree.h>
+#include <utility/persistent_btree_allocator.h>
+#include <utility/rank_util.h>
+
+#include <rank/logic_rank_mirror.h>
+#include <rank/logic_rank_tree.h>
+
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// 和ranksvr中的rank_tree保持一致
+using test_rank_tree = persistent_btree<PROJECT_NAMESPACE_ID::rank_storage_data,
+                                        persistent_btree_slab_allocator<PROJECT_NAMESPACE_ID::rank_storage_data>>;
+using test_rank_index = std::map<PROJECT_NAMESPACE_ID::DRankUserKey, test_rank_tree::value_pointer>;
+
+static bool descending_order(const PROJECT_NAMESPACE_ID::rank_storage_data& l,
+                             const PROJECT_NAMESPACE_ID::rank_storage_data& r) {
+  return l.sort_data().value() == r.sort_data().value() ? r.sort_data().key() < l.sort_data().key()
+                                                        : r.sort_data().value() < l.sort_data().value();
+}
+
+static PROJECT_NAMESPACE_ID::DRankUserKey make_user_key(uint64_t user_id) {
+  PROJECT_NAMESPACE_ID::DRankUserKey ret;
+  ret.set_user_id(user_id);
+  ret.set_zone_id(1);
+  return ret;
+}
+
+static PROJECT_NAMESPACE_ID::rank_storage_data make_storage_data(uint64_t user_id, int64_t score) {
+  PROJECT_NAMESPACE_ID::rank_storage_data ret;
+  *ret.mutable_sort_data()->mutable_key() = make_user_key(user_id);
+  ret.mutable_sort_data()->mutable_value()->set_score(score);
+  ret.mutable_sort_data()->mutable_value()->set_submit_timepoint(1700000000);
+  return ret;
+}
+
+static PROJECT_NAMESPACE_ID::rank_mirror_meta_info make_mirror(int64_t mirror_id, bool is_normal_save,
+                                                              int64_t base_mirror_id = 0) {
+  PROJECT_NAMESPACE_ID::rank_mirror_meta_info ret;
+  ret.set_mirror_id(mirror_id);
+  ret.set_max_slice_count(static_cast<int32_t>(mirror_id % 7 + 1));
+  ret.set_is_normal_save(is_normal_save);
+  ret.set_base_mirror_id(base_mirror_id);
+  if (base_mirror_id > 0) {
+    ret.set_base_max_slice_count(static_cast<int32_t>(base_mirror_id % 7 + 1));
+  }
+  return ret;
+}
+
+template <class TList>
+static std::set<int64_t> get_mirror_ids(const TList& list) {
+  std::set<int64_t> ret;
+  for (auto& mirror : list) {
+    ret.insert(mirror.mirror_id());
+  }
+  return ret;
+}
+
+}  // namespace
+
+CASE_TEST(rank_util, slave_readable_unbounded) {
+  time_t now = 1700000000;
+  // 不限制落后程度时，不管落后多少版本、多久没有收到主节点的版本号都可读
+  CASE_EXPECT_TRUE(rank_util::is_slave_data_readable(10, 1000, 0, 0, now, 180));
+  CASE_EXPECT_TRUE(rank_util::is_slave_data_readable(10, 1000, -1, now - 3600, now, 180));
+}
+
+CASE_TEST(rank_util, slave_readable_version_bound) {
+  time_t now = 1700000000;
+  CASE_EXPECT_TRUE(rank_util::is_slave_data_readable(100, 100, 5, now, now, 180));
+  CASE_EXPECT_TRUE(rank_util::is_slave_data_readable(100, 105, 5, now, now, 180));
+  CASE_EXPECT_FALSE(rank_util::is_slave_data_readable(100, 106, 5, now, now, 180));
+
+  // 从节点刚切换主节点时版本号可能比已知的主节点版本号更高
+  CASE_EXPECT_TRUE(rank_util::is_slave_data_readable(200, 100, 5, now, now, 180));
+}
+
+CASE_TEST(rank_util, slave_readable_time_bound) {
+  time_t now = 1700000000;
+  // 版本号一致，但很久没有收到主节点的版本号，可能是网络分区或者被流控跳过
+  CASE_EXPECT_TRUE(rank_util::is_slave_data_readable(100, 100, 5, now - 180, now, 180));
+  CASE_EXPECT_FALSE(rank_util::is_slave_data_readable(100, 100, 5, now - 181, now, 180));
+  CASE_EXPECT_FALSE(rank_util::is_slave_data_readable(100, 100, 5, 0, now, 180));
+
+  // 不限制时间
+  CASE_EXPECT_TRUE(rank_util::is_slave_data_readable(100, 100, 5, 0, now, 0));
+  CASE_EXPECT_FALSE(rank_util::is_slave_data_readable(100, 106, 5, 0, now, 0));
+}
+
+CASE_TEST(rank_util, front_back_range) {
+  uint32_t start_no = 0;
+  uint32_t real_count = 0;
+
+  rank_util::get_rank_front_back_range(50, 10, 100, start_no, real_count);
+  CASE_EXPECT_EQ(40, start_no);
+  CASE_EXPECT_EQ(21, real_count);
+
+  rank_util::get_rank_front_back_range(3, 10, 100, start_no, real_count);
+  CASE_EXPECT_EQ(1, start_no);
+  CASE_EXPECT_EQ(13, real_count);
+
+  // 超过最大区间时两侧各取一半
+  rank_util::get_rank_front_back_range(500, 80, 100, start_no, real_count);
+  CASE_EXPECT_EQ(450, start_no);
+  CASE_EXPECT_EQ(101, real_count);
+}
+
+CASE_TEST(rank_util, mirror_meta_base_retention) {
+  PROJECT_NAMESPACE_ID::table_rank_mirror_meta_data meta_data;
+  PROJECT_NAMESPACE_ID::rank_mirror_meta_info base_mirror;
+  int64_t last_data_version = 0;
+
+  CASE_EXPECT_FALSE(logic_rank_select_delta_base_mirror(meta_data, false, base_mirror));
+
+  CASE_EXPECT_TRUE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(101, true), 10));
+  CASE_EXPECT_EQ(10, last_data_version);
+  CASE_EXPECT_TRUE(logic_rank_select_delta_base_mirror(meta_data, false, base_mirror));
+  CASE_EXPECT_EQ(101, base_mirror.mirror_id());
+  CASE_EXPECT_EQ(make_mirror(101, true).max_slice_count(), base_mirror.max_slice_count());
+
+  // 增量镜像保存完成后，依赖的全量镜像要保留
+  CASE_EXPECT_TRUE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(102, true, 101), 20));
+  CASE_EXPECT_EQ(0, meta_data.removing_mirror_size());
+  CASE_EXPECT_TRUE(logic_rank_select_delta_base_mirror(meta_data, false, base_mirror));
+  CASE_EXPECT_EQ(101, base_mirror.mirror_id());
+  CASE_EXPECT_EQ(make_mirror(101, true).max_slice_count(), base_mirror.max_slice_count());
+
+  // 新的增量镜像替换旧的增量镜像，基准不变
+  CASE_EXPECT_TRUE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(103, true, 101), 30));
+  CASE_EXPECT_TRUE((std::set<int64_t>{102} == get_mirror_ids(meta_data.removing_mirror())));
+
+  // 新的全量镜像保存完成后，旧的增量镜像和它的基准都释放
+  CASE_EXPECT_TRUE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(104, true), 40));
+  CASE_EXPECT_TRUE((std::set<int64_t>{101, 102, 103} == get_mirror_ids(meta_data.removing_mirror())));
+  CASE_EXPECT_EQ(0, meta_data.success_mirror_size());
+  CASE_EXPECT_EQ(104, meta_data.last_save_mirror().mirror_id());
+  CASE_EXPECT_EQ(40, last_data_version);
+
+  // 有正在保存的全量镜像时变化的玩家是相对它记录的
+  CASE_EXPECT_FALSE(logic_rank_select_delta_base_mirror(meta_data, true, base_mirror));
+}
+
+CASE_TEST(rank_util, mirror_meta_finish_after_newer) {
+  PROJECT_NAMESPACE_ID::table_rank_mirror_meta_data meta_data;
+  int64_t last_data_version = 0;
+
+  CASE_EXPECT_TRUE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(202, true), 20));
+
+  // 更早创建的定时保存镜像后完成，直接释放
+  CASE_EXPECT_FALSE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(201, true), 10));
+  CASE_EXPECT_EQ(202, meta_data.last_save_mirror().mirror_id());
+  CASE_EXPECT_EQ(20, last_data_version);
+  CASE_EXPECT_TRUE((std::set<int64_t>{201} == get_mirror_ids(meta_data.removing_mirror())));
+
+  // 给其他服务使用的镜像后完成，要保留在success_mirror中
+  CASE_EXPECT_FALSE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(203, false), 15));
+  CASE_EXPECT_TRUE((std::set<int64_t>{203} == get_mirror_ids(meta_data.success_mirror())));
+  CASE_EXPECT_EQ(202, meta_data.last_save_mirror().mirror_id());
+
+  // 更早的增量镜像后完成，不能释放新镜像依赖的全量镜像
+  CASE_EXPECT_TRUE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(205, true, 202), 40));
+  CASE_EXPECT_FALSE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(204, true, 202), 30));
+  CASE_EXPECT_TRUE((std::set<int64_t>{201, 204} == get_mirror_ids(meta_data.removing_mirror())));
+  CASE_EXPECT_EQ(205, meta_data.last_save_mirror().mirror_id());
+  CASE_EXPECT_EQ(40, last_data_version);
+}
+
+CASE_TEST(rank_util, mirror_meta_exclude_success_base) {
+  PROJECT_NAMESPACE_ID::table_rank_mirror_meta_data meta_data;
+  PROJECT_NAMESPACE_ID::rank_mirror_meta_info base_mirror;
+  int64_t last_data_version = 0;
+
+  // 非定时保存的全量镜像会被放到success_mirror，不能作为增量镜像的基准
+  CASE_EXPECT_TRUE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(301, false), 10));
+  CASE_EXPECT_FALSE(logic_rank_select_delta_base_mirror(meta_data, false, base_mirror));
+
+  CASE_EXPECT_TRUE(logic_rank_commit_mirror_meta(meta_data, last_data_version, make_mirror(302, true), 20));
+  CASE_EXPECT_TRUE((std::set<int64_t>{301} == get_mirror_ids(meta_data.success_mirror())));
+  CASE_EXPECT_TRUE(logic_rank_select_delta_base_mirror(meta_data, false, base_mirror));
+  CASE_EXPECT_EQ(302, base_mirror.mirror_id());
+
+  // 基准已经在success_mirror中时也不能再生成增量
+  *meta_data.mutable_last_save_mirror() = make_mirror(303, true, 301);
+  CASE_EXPECT_FALSE(logic_rank_select_delta_base_mirror(meta_data, false, base_mirror));
+}
+
+CASE_TEST(rank_util, mirror_delta_restore) {
+  const size_t capacity = 40;
+  test_rank_index index;
+  auto tree = util::memory::make_strong_rc<test_rank_tree>(8, 10, descending_order);
+  auto ignore_change = [](const PROJECT_NAMESPACE_ID::DRankUserKey&) {};
+  for (uint64_t user_id = 1; user_id <= capacity; ++user_id) {
+    logic_rank_upsert_data(*tree, index, capacity, make_storage_data(user_id, static_cast<int64_t>(user_id * 10)),
+                           ignore_change);
+  }
+
+  // 全量镜像
+  auto base_mirror = tree->create_mirror();
+  CASE_EXPECT_TRUE(!!base_mirror);
+  PROJECT_NAMESPACE_ID::table_rank_blob_data base_blob;
+  base_mirror->visit_range(1, capacity, [&base_blob](size_t rank_no, const test_rank_tree::value_pointer& unit) {
+    auto rank_info = base_blob.add_data();
+    rank_info->set_rank_no(static_cast<uint32_t>(rank_no));
+    *rank_info->mutable_data() = *unit;
+    return true;
+  });
+  CASE_EXPECT_EQ(static_cast<int>(capacity), base_blob.data_size());
+
+  // 全量镜像之后的变化：更新分数、删除玩家、新玩家上榜挤掉最后一名
+  std::set<PROJECT_NAMESPACE_ID::DRankUserKey> dirty_users;
+  auto mark_dirty = [&dirty_users](const PROJECT_NAMESPACE_ID::DRankUserKey& key) { dirty_users.insert(key); };
+  logic_rank_upsert_data(*tree, index, capacity, make_storage_data(3, 1000), mark_dirty);
+  logic_rank_upsert_data(*tree, index, capacity, make_storage_data(30, 5), mark_dirty);
+  CASE_EXPECT_FALSE(logic_rank_upsert_data(*tree, index, capacity, make_storage_data(31, -1), mark_dirty));
+  {
+    auto iter = index.find(make_user_key(20));
+    tree->erase(*iter->second);
+    index.erase(iter);
+    mark_dirty(make_user_key(20));
+  }
+  logic_rank_upsert_data(*tree, index, capacity, make_storage_data(100, 255), mark_dirty);
+  logic_rank_upsert_data(*tree, index, capacity, make_storage_data(101, 256), mark_dirty);
+  CASE_EXPECT_EQ(capacity, tree->size());
+  CASE_EXPECT_TRUE(index.end() == index.find(make_user_key(30)));
+
+  // 增量镜像，分多个分片导出
+  std::vector<std::pair<PROJECT_NAMESPACE_ID::DRankUserKey, test_rank_tree::value_pointer>> delta_data;
+  for (auto& key : dirty_users) {
+    auto iter = index.find(key);
+    delta_data.emplace_back(key, iter == index.end() ? nullptr : iter->second);
+  }
+  std::vector<PROJECT_NAMESPACE_ID::table_rank_blob_data> delta_blobs;
+  for (size_t offset = 0; offset < delta_data.size();) {
+    delta_blobs.emplace_back();
+    offset += logic_rank_dump_mirror_delta(delta_data, offset, 2, delta_blobs.back());
+  }
+  CASE_EXPECT_EQ((delta_data.size() + 1) / 2, delta_blobs.size());
+
+  // 恢复全量镜像后应用增量，和原来的榜单一致
+  test_rank_index restore_index;
+  auto restore_tree = util::memory::make_strong_rc<test_rank_tree>(8, 10, descending_order);
+  for (auto& unit : base_blob.data()) {
+    logic_rank_upsert_data(*restore_tree, restore_index, capacity, unit.data(), ignore_change);
+  }
+  std::set<PROJECT_NAMESPACE_ID::DRankUserKey> restore_dirty_users;
+  size_t apply_count = 0;
+  for (auto& blob : delta_blobs) {
+    apply_count += logic_rank_apply_mirror_delta(
+        *restore_tree, restore_index, blob,
+        [&restore_dirty_users](const PROJECT_NAMESPACE_ID::DRankUserKey& key) { restore_dirty_users.insert(key); });
+  }
+  CASE_EXPECT_EQ(delta_data.size(), apply_count);
+  // 应用后仍然记录为变化，下一个增量镜像才是完整的
+  CASE_EXPECT_TRUE(dirty_users == restore_dirty_users);
+
+  CASE_EXPECT_EQ(tree->size(), restore_tree->size());
+  CASE_EXPECT_EQ(index.size(), restore_index.size());
+  std::vector<std::pair<uint64_t, int64_t>> expect_records;
+  std::vector<std::pair<uint64_t, int64_t>> real_records;
+  tree->visit_range(1, capacity, [&expect_records](size_t, const test_rank_tree::value_pointer& unit) {
+    expect_records.emplace_back(unit->sort_data().key().user_id(), unit->sort_data().value().score());
+    return true;
+  });
+  restore_tree->visit_range(1, capacity, [&real_records](size_t, const test_rank_tree::value_pointer& unit) {
+    real_records.emplace_back(unit->sort_data().key().user_id(), unit->sort_data().value().score());
+    return true;
+  });
+  CASE_EXPECT_TRUE(expect_records == real_records);
+  CASE_EXPECT_EQ(3, expect_records.front().first);
+}
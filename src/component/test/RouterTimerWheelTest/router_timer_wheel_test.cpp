@@ -0,0 +1,332 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+#include <router/router_timer_wheel.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace {
+
+static void init_nodes(std::vector<router_system_timer_t> &nodes) {
+  for (auto &node : nodes) {
+    router_timer_wheel::init_node(node, nullptr);
+  }
+}
+
+static size_t pop_all_expired(router_timer_wheel &wheel, time_t now) {
+  size_t ret = 0;
+  while (nullptr != wheel.pop_expired(now)) {
+    ++ret;
+  }
+  return ret;
+}
+
+// 性能测试的对象数量可以通过环境变量调整，默认值比较小，避免拖慢单元测试:
+//   ROUTER_TIMER_WHEEL_BENCHMARK_OBJECTS 对象数量，默认 20000
+static size_t get_benchmark_object_count() {
+  const char *env_value = getenv("ROUTER_TIMER_WHEEL_BENCHMARK_OBJECTS");
+  if (nullptr == env_value || 0 == *env_value) {
+    return 20000;
+  }
+
+  size_t ret = static_cast<size_t>(strtoull(env_value, nullptr, 10));
+  return ret > 0 ? ret : 20000;
+}
+
+// 时间轮的对象: 节点内嵌在对象中
+struct wheel_object_t {
+  router_system_timer_t timer;
+  uint32_t timer_sequence;
+};
+
+static void wheel_insert_timer(router_timer_wheel &wheel, wheel_object_t &obj, time_t now, time_t timeout) {
+  wheel.insert(obj.timer, now, timeout);
+  obj.timer.timer_sequence = ++obj.timer_sequence;
+}
+
+// 和 router_manager_set::tick_timer 一样，到期的定时器检查序列号后插入下一个定时器
+static size_t wheel_tick_timer(router_timer_wheel &wheel, time_t now, time_t interval) {
+  size_t ret = 0;
+  while (router_system_timer_t *timer = wheel.pop_expired(now)) {
+    wheel_object_t *obj = reinterpret_cast<wheel_object_t *>(timer);
+    if (obj->timer_sequence != timer->timer_sequence) {
+      continue;
+    }
+    wheel_insert_timer(wheel, *obj, now, now + interval);
+    ++ret;
+  }
+  return ret;
+}
+
+// 旧版定时器的实现: 每次插入都分配一个链表节点，对象持有链表和迭代器用于移除，定时器通过weak_ptr检查对象是否有效
+struct legacy_object_t;
+
+struct legacy_timer_t {
+  std::weak_ptr<legacy_object_t> obj_watcher;
+  uint32_t type_id;
+  time_t timeout;
+  uint32_t timer_sequence;
+};
+
+struct legacy_object_t : public std::enable_shared_from_this<legacy_object_t> {
+  uint32_t timer_sequence = 0;
+  std::list<legacy_timer_t> *timer_list = nullptr;
+  std::list<legacy_timer_t>::iterator timer_iter;
+
+  void reset_timer_ref(std::list<legacy_timer_t> *list, const std::list<legacy_timer_t>::iterator &it) {
+    if (timer_list == list && timer_iter == it) {
+      return;
+    }
+    unset_timer_ref();
+    timer_list = list;
+    timer_iter = it;
+  }
+
+  void check_and_remove_timer_ref(std::list<legacy_timer_t> *list, const std::list<legacy_timer_t>::iterator &it) {
+    if (timer_list != list || timer_iter != it) {
+      return;
+    }
+    timer_iter = timer_list->end();
+    timer_list = nullptr;
+  }
+
+  void unset_timer_ref() {
+    if (nullptr != timer_list && timer_iter != timer_list->end()) {
+      timer_list->erase(timer_iter);
+      timer_iter = timer_list->end();
+    }
+    timer_list = nullptr;
+  }
+};
+
+static void legacy_insert_timer(std::list<legacy_timer_t> &timer_list, const std::shared_ptr<legacy_object_t> &obj,
+                                time_t timeout) {
+  std::list<legacy_timer_t>::iterator iter = timer_list.insert(timer_list.end(), legacy_timer_t());
+  iter->obj_watcher = obj;
+  iter->type_id = 1;
+  iter->timeout = timeout;
+  iter->timer_sequence = ++obj->timer_sequence;
+  obj->reset_timer_ref(&timer_list, iter);
+}
+
+// 旧版 router_manager_set::tick_timer 的流程，链表按插入顺序排列，插入时的超时时间必须是递增的
+static size_t legacy_tick_timer(std::list<legacy_timer_t> &timer_list, time_t now, time_t interval) {
+  size_t ret = 0;
+  while (!timer_list.empty()) {
+    std::list<legacy_timer_t>::iterator iter = timer_list.begin();
+    if (now <= iter->timeout) {
+      break;
+    }
+
+    std::shared_ptr<legacy_object_t> obj = iter->obj_watcher.lock();
+    if (!obj) {
+      timer_list.erase(iter);
+      continue;
+    }
+
+    if (obj->timer_sequence != iter->timer_sequence) {
+      obj->check_and_remove_timer_ref(&timer_list, iter);
+      timer_list.erase(iter);
+      continue;
+    }
+
+    obj->check_and_remove_timer_ref(&timer_list, iter);
+    legacy_insert_timer(timer_list, obj, now + interval);
+    timer_list.erase(iter);
+    ++ret;
+  }
+  return ret;
+}
+
+static int64_t get_elapsed_ms(std::chrono::steady_clock::time_point begin) {
+  return static_cast<int64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count());
+}
+
+}  // namespace
+
+CASE_TEST(router_timer_wheel, expire_order) {
+  router_timer_wheel wheel(4);
+  std::vector<router_system_timer_t> nodes;
+  nodes.resize(3);
+  init_nodes(nodes);
+
+  wheel.insert(nodes[0], 100, 110);
+  wheel.insert(nodes[1], 100, 105);
+  wheel.insert(nodes[2], 100, 130);
+  CASE_EXPECT_EQ(static_cast<size_t>(3), wheel.size());
+  CASE_EXPECT_EQ(static_cast<time_t>(105), wheel.get_next_timeout());
+
+  // 超时时间等于当前时间时还不会触发
+  CASE_EXPECT_TRUE(nullptr == wheel.pop_expired(105));
+  CASE_EXPECT_EQ(&nodes[1], wheel.pop_expired(106));
+  CASE_EXPECT_TRUE(nullptr == wheel.pop_expired(106));
+
+  // 130超过一圈(16秒)，跨越它所在的槽位时不能被提前取出
+  CASE_EXPECT_EQ(&nodes[0], wheel.pop_expired(120));
+  CASE_EXPECT_TRUE(nullptr == wheel.pop_expired(120));
+  CASE_EXPECT_EQ(static_cast<size_t>(1), wheel.size());
+  CASE_EXPECT_EQ(&nodes[2], wheel.pop_expired(200));
+  CASE_EXPECT_TRUE(wheel.empty());
+  CASE_EXPECT_TRUE(nullptr == nodes[2].wheel);
+}
+
+CASE_TEST(router_timer_wheel, cancel_and_move) {
+  router_timer_wheel default_wheel(4);
+  router_timer_wheel fast_wheel(4);
+  std::vector<router_system_timer_t> nodes;
+  nodes.resize(2);
+  init_nodes(nodes);
+
+  default_wheel.insert(nodes[0], 100, 110);
+  default_wheel.insert(nodes[1], 100, 110);
+
+  // 再次插入会自动从原来的时间轮中移除
+  fast_wheel.insert(nodes[0], 100, 102);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), default_wheel.size());
+  CASE_EXPECT_EQ(static_cast<size_t>(1), fast_wheel.size());
+  CASE_EXPECT_EQ(&fast_wheel, nodes[0].wheel);
+
+  router_timer_wheel::cancel(nodes[1]);
+  router_timer_wheel::cancel(nodes[1]);
+  CASE_EXPECT_TRUE(default_wheel.empty());
+  CASE_EXPECT_TRUE(nullptr == default_wheel.pop_expired(200));
+
+  CASE_EXPECT_EQ(&nodes[0], fast_wheel.pop_expired(200));
+  CASE_EXPECT_TRUE(fast_wheel.empty());
+}
+
+CASE_TEST(router_timer_wheel, visit_and_cancel) {
+  router_timer_wheel wheel(4);
+  std::vector<router_system_timer_t> nodes;
+  nodes.resize(64);
+  init_nodes(nodes);
+
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    wheel.insert(nodes[i], 100, 100 + static_cast<time_t>(i));
+  }
+
+  size_t visited = 0;
+  wheel.visit([&visited](router_system_timer_t &node) {
+    ++visited;
+    if (node.timeout % 2 == 0) {
+      router_timer_wheel::cancel(node);
+    }
+    return true;
+  });
+  CASE_EXPECT_EQ(nodes.size(), visited);
+  CASE_EXPECT_EQ(nodes.size() / 2, wheel.size());
+  CASE_EXPECT_EQ(nodes.size() / 2, pop_all_expired(wheel, 1000));
+}
+
+CASE_TEST(router_timer_wheel, crowded_slot) {
+  router_timer_wheel wheel(4);
+  std::vector<router_system_timer_t> nodes;
+  nodes.resize(4096);
+  init_nodes(nodes);
+
+  // 所有定时器都在同一个槽位里，未到期的(后面几圈)和到期的交错排列
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    wheel.insert(nodes[i], 100, 100 + static_cast<time_t>(i % 2 == 0 ? 0 : 16 * (1 + i % 8)));
+  }
+
+  // 取出的过程中取消下一个要扫描的节点，并把到期的节点重新放回同一个槽位
+  router_system_timer_t *first = wheel.pop_expired(101);
+  CASE_EXPECT_EQ(&nodes[0], first);
+  router_timer_wheel::cancel(nodes[1]);
+  router_timer_wheel::cancel(nodes[2]);
+  wheel.insert(nodes[0], 101, 100);
+
+  size_t expired = 0;
+  router_system_timer_t *last = nullptr;
+  while (router_system_timer_t *node = wheel.pop_expired(101)) {
+    CASE_EXPECT_LE(node->timeout, 100);
+    last = node;
+    ++expired;
+  }
+  // nodes[0]被重新插入到了槽位末尾
+  CASE_EXPECT_EQ(nodes.size() / 2 - 1, expired);
+  CASE_EXPECT_EQ(&nodes[0], last);
+  CASE_EXPECT_EQ(nodes.size() / 2 - 1, wheel.size());
+  CASE_EXPECT_EQ(nodes.size() / 2 - 1, pop_all_expired(wheel, 1000));
+  CASE_EXPECT_TRUE(wheel.empty());
+}
+
+CASE_TEST(router_timer_wheel, benchmark) {
+  const size_t object_count = get_benchmark_object_count();
+  const time_t start_time = 1000000;
+  const time_t interval = 300;
+
+  // 时间轮: 节点内嵌在对象中，插入/移动/取出都不分配内存
+  {
+    std::unique_ptr<wheel_object_t[]> objects(new wheel_object_t[object_count]);
+    router_timer_wheel wheel;
+    for (size_t i = 0; i < object_count; ++i) {
+      router_timer_wheel::init_node(objects[i].timer, nullptr);
+      objects[i].timer_sequence = 0;
+    }
+
+    // 旧版链表要求超时时间递增，两边都按时间顺序插入
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < object_count; ++i) {
+      wheel_insert_timer(wheel, objects[i], start_time,
+                         start_time + static_cast<time_t>(i * static_cast<size_t>(interval) / object_count));
+    }
+    int64_t insert_ms = get_elapsed_ms(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < object_count; i += 2) {
+      wheel_insert_timer(wheel, objects[i], start_time, start_time + interval);
+    }
+    int64_t reschedule_ms = get_elapsed_ms(begin);
+
+    begin = std::chrono::steady_clock::now();
+    size_t expired = wheel_tick_timer(wheel, start_time + interval + 1, interval);
+    int64_t expire_ms = get_elapsed_ms(begin);
+
+    CASE_EXPECT_EQ(object_count, expired);
+    CASE_EXPECT_EQ(object_count, wheel.size());
+    CASE_MSG_INFO() << "router_timer_wheel: insert " << object_count << " timers cost " << insert_ms
+                    << "ms, reschedule " << (object_count + 1) / 2 << " timers cost " << reschedule_ms
+                    << "ms, tick " << expired << " timers cost " << expire_ms << "ms" << std::endl;
+  }
+
+  // 旧版std::list: 每次插入都要分配节点，移动定时器需要先移除旧节点，到期时通过weak_ptr检查对象
+  {
+    std::vector<std::shared_ptr<legacy_object_t>> objects;
+    objects.reserve(object_count);
+    for (size_t i = 0; i < object_count; ++i) {
+      objects.push_back(std::make_shared<legacy_object_t>());
+    }
+    std::list<legacy_timer_t> timer_list;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < object_count; ++i) {
+      legacy_insert_timer(timer_list, objects[i],
+                          start_time + static_cast<time_t>(i * static_cast<size_t>(interval) / object_count));
+    }
+    int64_t insert_ms = get_elapsed_ms(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < object_count; i += 2) {
+      legacy_insert_timer(timer_list, objects[i], start_time + interval);
+    }
+    int64_t reschedule_ms = get_elapsed_ms(begin);
+
+    begin = std::chrono::steady_clock::now();
+    size_t expired = legacy_tick_timer(timer_list, start_time + interval + 1, interval);
+    int64_t expire_ms = get_elapsed_ms(begin);
+
+    CASE_EXPECT_EQ(object_count, expired);
+    CASE_EXPECT_EQ(object_count, timer_list.size());
+    CASE_MSG_INFO() << "std::list: insert " << object_count << " timers cost " << insert_ms << "ms, reschedule "
+                    << (object_count + 1) / 2 << " timers cost " << reschedule_ms << "ms, tick " << expired
+                    << " timers cost " << expire_ms << "ms" << std::endl;
+  }
+}
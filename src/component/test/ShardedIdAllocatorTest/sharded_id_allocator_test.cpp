@@ -0,0 +1,76 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+#include <core/sharded_id_allocator.h>
+
+#include <cstdint>
+#include <ctime>
+#include <set>
+#include <vector>
+
+namespace {
+using id_allocator = atframework::component::sharded_id_allocator<uint64_t>;
+}  // namespace
+
+CASE_TEST(sharded_id_allocator, shard_index) {
+  const uint32_t shard_bits = 3;
+  std::vector<id_allocator> allocators;
+  for (uint32_t i = 0; i < 8; ++i) {
+    allocators.emplace_back(i, shard_bits);
+  }
+
+  std::set<uint64_t> ids;
+  time_t now = 1700000000;
+  for (int round = 0; round < 100; ++round) {
+    for (uint32_t i = 0; i < 8; ++i) {
+      uint64_t id = allocators[i].allocate(now);
+      CASE_EXPECT_NE(id_allocator::npos, id);
+      CASE_EXPECT_EQ(i, id_allocator::get_shard_index(id, shard_bits));
+      CASE_EXPECT_TRUE(ids.insert(id).second);
+    }
+  }
+
+  CASE_EXPECT_EQ(0, id_allocator::get_shard_index(12345, 0));
+}
+
+CASE_TEST(sharded_id_allocator, sequence_exhausted) {
+  // 31 bits are used by shard index, only 1 bit is left for sequence
+  id_allocator alloc(5, 31);
+  CASE_EXPECT_EQ(31, alloc.get_shard_bits());
+  CASE_EXPECT_EQ(1, alloc.get_max_sequence());
+
+  time_t now = 1700000000;
+  uint64_t last_id = 0;
+  std::set<uint64_t> ids;
+  for (int i = 0; i < 16; ++i) {
+    uint64_t id = alloc.allocate(now);
+    // ids must keep increasing when the sequence of current second is exhausted, instead of wrapping
+    CASE_EXPECT_GT(id, last_id);
+    CASE_EXPECT_EQ(5, id_allocator::get_shard_index(id, 31));
+    CASE_EXPECT_TRUE(ids.insert(id).second);
+    last_id = id;
+  }
+
+  // borrowed seconds are kept until the clock catch up
+  CASE_EXPECT_GT(last_id >> id_allocator::low_bits, static_cast<uint64_t>(now));
+  uint64_t id = alloc.allocate(now + 1);
+  CASE_EXPECT_GT(id, last_id);
+}
+
+CASE_TEST(sharded_id_allocator, clock_go_back) {
+  id_allocator alloc(1, 2);
+  time_t now = 1700000000;
+  uint64_t first_id = alloc.allocate(now);
+  uint64_t second_id = alloc.allocate(now - 10);
+  CASE_EXPECT_GT(second_id, first_id);
+  CASE_EXPECT_EQ(first_id >> id_allocator::low_bits, second_id >> id_allocator::low_bits);
+}
+
+CASE_TEST(sharded_id_allocator, invalid_shard_bits) {
+  // shard bits must leave at least one bit for sequence
+  id_allocator alloc(0, 64);
+  CASE_EXPECT_EQ(id_allocator::low_bits - 1, alloc.get_shard_bits());
+  CASE_EXPECT_NE(id_allocator::npos, alloc.allocate(0));
+  CASE_EXPECT_NE(id_allocator::npos, alloc.allocate(0));
+}
@@ -0,0 +1,88 @@
+// Copyright 2026 atframework
+
+#include "frame/test_macros.h"
+
+#include <dispatcher/ss_ingest_budget.h>
+
+#include <chrono>
+#include <cstddef>
+
+namespace {
+using admission = ss_ingest_budget::admission;
+using clock_type = ss_ingest_budget::clock_type;
+}  // namespace
+
+CASE_TEST(ss_ingest_budget, count_exhausted) {
+  ss_ingest_budget budget;
+  budget.set_limit(3, clock_type::duration::zero());
+  budget.reset();
+
+  clock_type::time_point now = clock_type::now();
+  for (size_t i = 0; i < 3; ++i) {
+    CASE_EXPECT_FALSE(budget.is_exhausted(now));
+    budget.consume(now);
+  }
+  CASE_EXPECT_TRUE(budget.is_exhausted(now));
+  CASE_EXPECT_EQ(3, budget.get_count());
+
+  // IO回调中处理的消息和check回调中处理的排队消息共用一份预算，只有新的一轮事件循环才重置
+  CASE_EXPECT_TRUE(budget.is_exhausted(now + std::chrono::seconds{1}));
+  budget.reset();
+  CASE_EXPECT_FALSE(budget.is_exhausted(now));
+}
+
+CASE_TEST(ss_ingest_budget, time_exhausted) {
+  ss_ingest_budget budget;
+  budget.set_limit(0, std::chrono::milliseconds{8});
+  budget.reset();
+
+  clock_type::time_point loop_start = clock_type::now();
+  // 阻塞等待IO的时间不计入预算，空闲很久之后的第一个消息仍然直接处理
+  clock_type::time_point first_message = loop_start + std::chrono::seconds{10};
+  CASE_EXPECT_FALSE(budget.is_exhausted(first_message));
+  budget.consume(first_message);
+  CASE_EXPECT_FALSE(budget.is_exhausted(first_message + std::chrono::milliseconds{7}));
+  budget.consume(first_message + std::chrono::milliseconds{7});
+  CASE_EXPECT_TRUE(budget.is_exhausted(first_message + std::chrono::milliseconds{8}));
+
+  // 新的一轮从下一个消息重新计时
+  budget.reset();
+  CASE_EXPECT_FALSE(budget.is_exhausted(first_message + std::chrono::seconds{1}));
+  budget.consume(first_message + std::chrono::seconds{1});
+  CASE_EXPECT_FALSE(budget.is_exhausted(first_message + std::chrono::seconds{1} + std::chrono::milliseconds{1}));
+}
+
+CASE_TEST(ss_ingest_budget, unlimited) {
+  ss_ingest_budget budget;
+  budget.reset();
+
+  clock_type::time_point now = clock_type::now();
+  for (size_t i = 0; i < 10000; ++i) {
+    budget.consume(now);
+  }
+  CASE_EXPECT_FALSE(budget.is_exhausted(now + std::chrono::hours{1}));
+}
+
+CASE_TEST(ss_ingest_budget, admission_rpc_request) {
+  CASE_EXPECT_TRUE(admission::kAccept == ss_ingest_budget::check_admission(true, false, 0, 10, false));
+  CASE_EXPECT_TRUE(admission::kAccept == ss_ingest_budget::check_admission(true, false, 9, 10, false));
+
+  // 请求队列满或者任务过多时直接回复繁忙
+  CASE_EXPECT_TRUE(admission::kRejectBusy == ss_ingest_budget::check_admission(true, false, 10, 10, false));
+  CASE_EXPECT_TRUE(admission::kRejectBusy == ss_ingest_budget::check_admission(true, false, 0, 10, true));
+  CASE_EXPECT_TRUE(admission::kRejectBusy == ss_ingest_budget::check_admission(true, false, 0, 0, true));
+
+  // 不限制队列长度
+  CASE_EXPECT_TRUE(admission::kAccept == ss_ingest_budget::check_admission(true, false, 100000, 0, false));
+}
+
+CASE_TEST(ss_ingest_budget, admission_other_message) {
+  // 回包总是接入
+  CASE_EXPECT_TRUE(admission::kAccept == ss_ingest_budget::check_admission(false, true, 100, 10, true));
+  CASE_EXPECT_TRUE(admission::kAccept == ss_ingest_budget::check_admission(true, true, 100, 10, true));
+
+  // 通知类消息没法回复繁忙，只在请求队列满时丢弃，不受任务数量影响
+  CASE_EXPECT_TRUE(admission::kAccept == ss_ingest_budget::check_admission(false, false, 9, 10, true));
+  CASE_EXPECT_TRUE(admission::kDrop == ss_ingest_budget::check_admission(false, false, 10, 10, false));
+  CASE_EXPECT_TRUE(admission::kAccept == ss_ingest_budget::check_admission(false, false, 100000, 0, false));
+}
@@ -35,6 +35,7 @@
 #include "app/handle_ss_rpc_gamesvrservice.h"
 
 #include "data/player.h"
+#include "logic/rank/rank_submit_aggregator.h"
 
 class main_service_module : public atfw::atapp::module_impl {
  private:
@@ -113,6 +114,13 @@ class main_service_module : public atfw::atapp::module_impl {
     return 0;
   }
 
+  int tick() override {
+    int ret = 0;
+    ret += rank_submit_aggregator::me()->tick();
+
+    return ret;
+  }
+
   const char *name() const override { return "main_service_module"; }
 };
 
@@ -0,0 +1,256 @@
+#include "logic/rank/rank_submit_aggregator.h"
+
+#include <config/compiler/protobuf_prefix.h>
+
+#include <protocol/config/svr.protocol.config.pb.h>
+#include <protocol/pbdesc/com.struct.rank.pb.h>
+#include <protocol/pbdesc/svr.const.err.pb.h>
+
+#include <config/compiler/protobuf_suffix.h>
+
+#include <log/log_wrapper.h>
+#include <time/time_utility.h>
+
+#include <config/logic_config.h>
+#include <utility/protobuf_mini_dumper.h>
+
+#include <rpc/rank/sharding.h>
+#include <rpc/rpc_async_invoke.h>
+#include <rpc/rpc_utils.h>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+rank_submit_aggregator::rank_submit_aggregator() : pending_count_(0) {}
+
+int rank_submit_aggregator::tick() {
+  if (0 == pending_count_) {
+    return 0;
+  }
+
+  int ret = 0;
+  std::chrono::system_clock::time_point now = util::time::time_utility::now();
+  size_t batch_max_count =
+      logic_config::me()->get_custom_config<PROJECT_NAMESPACE_ID::config::gamesvr_cfg>().rank_submit_batch_max_count();
+  for (auto iter = buckets_.begin(); iter != buckets_.end();) {
+    // 分组持有handle，空闲的分组直接移除，下次提交时再创建
+    if (iter->second->pending.empty()) {
+      iter = buckets_.erase(iter);
+      continue;
+    }
+
+    if (now >= iter->second->flush_timepoint || iter->second->pending.size() >= batch_max_count) {
+      if (flush(iter->first, *iter->second)) {
+        ++ret;
+      }
+    }
+    ++iter;
+  }
+
+  return ret;
+}
+
+bool rank_submit_aggregator::is_enabled() const {
+  return rpc::make_duration(logic_config::me()
+                                ->get_custom_config<PROJECT_NAMESPACE_ID::config::gamesvr_cfg>()
+                                .rank_submit_flush_interval()) > std::chrono::system_clock::duration::zero();
+}
+
+rpc::result_code_type rank_submit_aggregator::upload_score(rpc::context& ctx, logic_rank_handle_variant& handle,
+                                                           const logic_rank_handle_key& key, gsl::string_view openid,
+                                                           uint32_t score,
+                                                           const rank_callback_private_data& callback_data,
+                                                           logic_rank_user_extend_span user_extend_data) {
+  TASK_COMPAT_CHECK_TASK_ACTION_RETURN("{}", "this function should be called in task");
+
+  if (!is_enabled()) {
+    auto res =
+        RPC_AWAIT_TYPE_RESULT(handle.upload_score(ctx, key, openid, score, callback_data, user_extend_data));
+    RPC_RETURN_CODE(res.api_result);
+  }
+
+  task_type_trait::task_type self_task = task_manager::me()->get_task(ctx.get_task_context().task_id);
+  if (task_type_trait::empty(self_task)) {
+    RPC_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SYS_RPC_TASK_NOT_FOUND);
+  }
+
+  bucket_key bkey{key, handle.get_world_id(), handle.get_zone_id(), 0};
+  {
+    rpc::context::message_holder<PROJECT_NAMESPACE_ID::DRankKey> rank{ctx};
+    rank->set_rank_type(key.get_rank_type());
+    rank->set_rank_instance_id(key.get_instance_id());
+    rank->set_sub_rank_type(key.get_sub_rank_type());
+    rank->set_sub_rank_instance_id(key.get_sub_instance_id());
+    bkey.server_id = PROJECT_NAMESPACE_ID::rank_api::get_rank_main_server_id(ctx, *rank);
+  }
+
+  bucket_ptr bucket = buckets_[bkey];
+  if (!bucket) {
+    bucket = atfw::util::memory::make_strong_rc<bucket_type>(handle);
+    buckets_[bkey] = bucket;
+  }
+
+  pending_entry_ptr entry = atfw::util::memory::make_strong_rc<pending_entry>();
+  entry->openid = static_cast<std::string>(openid);
+  entry->score = score;
+  entry->callback_data = callback_data;
+  entry->sort_fields.assign(user_extend_data.sort_fields.begin(), user_extend_data.sort_fields.end());
+  entry->ext_fields.assign(user_extend_data.ext_fields.begin(), user_extend_data.ext_fields.end());
+  entry->waiter = self_task;
+  entry->finished = false;
+  entry->result = 0;
+
+  // 任务被强制销毁时来不及移除等待中的数据，重试时以最新的数据为准
+  for (auto iter = bucket->pending.begin(); iter != bucket->pending.end();) {
+    if ((*iter)->openid == entry->openid &&
+        (task_type_trait::empty((*iter)->waiter) || task_type_trait::is_exiting((*iter)->waiter))) {
+      iter = bucket->pending.erase(iter);
+      --pending_count_;
+    } else {
+      ++iter;
+    }
+  }
+
+  // 分组中第一个数据决定本批次的发送时间
+  if (bucket->pending.empty()) {
+    bucket->flush_timepoint =
+        util::time::time_utility::now() +
+        rpc::make_duration(logic_config::me()
+                               ->get_custom_config<PROJECT_NAMESPACE_ID::config::gamesvr_cfg>()
+                               .rank_submit_flush_interval());
+  }
+  bucket->pending.push_back(entry);
+  ++pending_count_;
+
+  dispatcher_await_options await_options = dispatcher_make_default<dispatcher_await_options>();
+  await_options.sequence = ctx.get_task_context().task_id;
+  await_options.timeout = rpc::make_duration_or_default(logic_config::me()->get_server_cfg().task().csmsg().timeout(),
+                                                        std::chrono::seconds{6});
+
+  int32_t ret = 0;
+  while (!entry->finished) {
+    TASK_COMPAT_ASSIGN_CURRENT_STATUS(current_task_status);
+    if (task_type_trait::is_exiting(current_task_status)) {
+      ret = task_manager::convert_task_status_to_error_code(current_task_status);
+      break;
+    }
+
+    int32_t res =
+        RPC_AWAIT_CODE_RESULT(rpc::custom_wait(ctx, reinterpret_cast<const void*>(entry.get()), await_options));
+    if (res < 0 && !entry->finished) {
+      ret = res;
+      break;
+    }
+  }
+
+  // 超时后还没有发出的数据直接丢弃，玩家任务重试时会带着最新的数据重新加入，避免同一个玩家在批次中堆积旧数据
+  // 已经发出的批次不再唤醒本任务，未提交数据由玩家任务保留后续重试
+  task_type_trait::reset_task(entry->waiter);
+  if (!entry->finished) {
+    auto iter = std::find(bucket->pending.begin(), bucket->pending.end(), entry);
+    if (iter != bucket->pending.end()) {
+      bucket->pending.erase(iter);
+      --pending_count_;
+    }
+  }
+  if (entry->finished) {
+    ret = entry->result;
+  }
+
+  RPC_RETURN_CODE(ret);
+}
+
+bool rank_submit_aggregator::flush(const bucket_key& key, bucket_type& bucket) {
+  if (bucket.pending.empty()) {
+    return false;
+  }
+
+  size_t batch_max_count =
+      logic_config::me()->get_custom_config<PROJECT_NAMESPACE_ID::config::gamesvr_cfg>().rank_submit_batch_max_count();
+  if (0 == batch_max_count) {
+    batch_max_count = 1;
+  }
+
+  auto entries = atfw::util::memory::make_strong_rc<std::vector<pending_entry_ptr>>();
+  if (bucket.pending.size() <= batch_max_count) {
+    entries->swap(bucket.pending);
+  } else {
+    // 超出单批上限的部分留到下一次tick发送
+    entries->assign(std::make_move_iterator(bucket.pending.begin()),
+                    std::make_move_iterator(bucket.pending.begin() + static_cast<std::ptrdiff_t>(batch_max_count)));
+    bucket.pending.erase(bucket.pending.begin(),
+                         bucket.pending.begin() + static_cast<std::ptrdiff_t>(batch_max_count));
+  }
+  pending_count_ -= entries->size();
+
+  logic_rank_handle_variant handle = bucket.handle;
+  logic_rank_handle_key rank_key = key.rank_key;
+  uint64_t server_id = key.server_id;
+  auto invoke_result = rpc::async_invoke(
+      "rank_submit_aggregator", "rank_submit_aggregator.flush",
+      [handle, rank_key, server_id, entries](rpc::context& child_ctx) mutable -> rpc::result_code_type {
+        std::vector<logic_rank_batch_upload_data> scores;
+        scores.resize(entries->size());
+        for (size_t i = 0; i < entries->size(); ++i) {
+          const pending_entry& entry = *(*entries)[i];
+          scores[i].openid = entry.openid;
+          scores[i].score = entry.score;
+          scores[i].callback_data = entry.callback_data;
+          scores[i].user_extend_data.sort_fields = gsl::span<const uint32_t>{entry.sort_fields};
+          scores[i].user_extend_data.ext_fields = gsl::span<const uint64_t>{entry.ext_fields};
+        }
+
+        std::vector<int32_t> results;
+        auto res = RPC_AWAIT_TYPE_RESULT(
+            handle.batch_upload_score(child_ctx, rank_key, gsl::make_span(scores), &results));
+        if (res.api_result != 0) {
+          FWLOGERROR("rank_submit_aggregator flush {} users to rank ({},{},{},{}) on server {} failed, res: {}({})",
+                     entries->size(), rank_key.get_rank_type(), rank_key.get_instance_id(),
+                     rank_key.get_sub_rank_type(), rank_key.get_sub_instance_id(), server_id, res.api_result,
+                     protobuf_mini_dumper_get_error_msg(res.api_result));
+        } else {
+          FWLOGDEBUG("rank_submit_aggregator flush {} users to rank ({},{},{},{}) on server {} success",
+                     entries->size(), rank_key.get_rank_type(), rank_key.get_instance_id(),
+                     rank_key.get_sub_rank_type(), rank_key.get_sub_instance_id(), server_id);
+        }
+
+        wakeup(*entries, res.api_result, &results);
+        RPC_RETURN_CODE(res.api_result);
+      });
+  if (invoke_result.is_error()) {
+    int32_t res = *invoke_result.get_error();
+    FWLOGERROR("rank_submit_aggregator start flush task for rank ({},{},{},{}) failed, res: {}({})",
+               rank_key.get_rank_type(), rank_key.get_instance_id(), rank_key.get_sub_rank_type(),
+               rank_key.get_sub_instance_id(), res, protobuf_mini_dumper_get_error_msg(res));
+    wakeup(*entries, res);
+    return false;
+  }
+
+  return true;
+}
+
+void rank_submit_aggregator::wakeup(const std::vector<pending_entry_ptr>& entries, int32_t result,
+                                    const std::vector<int32_t>* results) {
+  if (nullptr != results && results->size() != entries.size()) {
+    results = nullptr;
+  }
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const pending_entry_ptr& entry = entries[i];
+    if (!entry) {
+      continue;
+    }
+
+    entry->finished = true;
+    entry->result = nullptr == results ? result : (*results)[i];
+    if (task_type_trait::empty(entry->waiter) || task_type_trait::is_exiting(entry->waiter)) {
+      continue;
+    }
+
+    dispatcher_resume_data_type callback_data = dispatcher_make_default<dispatcher_resume_data_type>();
+    callback_data.message.message_type = reinterpret_cast<uintptr_t>(reinterpret_cast<const void*>(entry.get()));
+    callback_data.sequence = task_type_trait::get_task_id(entry->waiter);
+    rpc::custom_resume(entry->waiter, callback_data);
+  }
+}
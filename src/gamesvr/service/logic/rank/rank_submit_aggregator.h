@@ -0,0 +1,113 @@
+#pragma once
+
+#include <design_pattern/singleton.h>
+#include <gsl/select-gsl.h>
+#include <memory/rc_ptr.h>
+
+#include <dispatcher/task_manager.h>
+#include <dispatcher/task_type_traits.h>
+
+#include <rank/logic_rank_handle.h>
+#include <rpc/rpc_common_types.h>
+
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 本节点所有玩家的排行榜分数上报合并器
+ * @note 各个玩家的io任务提交的设置分数请求按(排行榜, ranksvr主节点)分组，
+ *       每个分组按固定间隔合并成一个rank_batch_set_score请求发出，发送完成后再逐个唤醒等待的玩家任务
+ * @note 增减分数的提交不满足覆盖语义，仍然按玩家单独提交
+ */
+class rank_submit_aggregator : public util::design_pattern::singleton<rank_submit_aggregator> {
+ private:
+  struct pending_entry {
+    std::string openid;
+    uint32_t score;
+    rank_callback_private_data callback_data;
+    std::vector<uint32_t> sort_fields;
+    std::vector<uint64_t> ext_fields;
+
+    task_type_trait::task_type waiter;
+    bool finished;
+    int32_t result;
+  };
+  using pending_entry_ptr = atfw::util::memory::strong_rc_ptr<pending_entry>;
+
+  struct bucket_key {
+    logic_rank_handle_key rank_key;
+    uint32_t world_id;
+    uint32_t zone_id;
+    uint64_t server_id;
+
+    friend inline bool operator<(const bucket_key& l, const bucket_key& r) noexcept {
+      if (l.server_id != r.server_id) {
+        return l.server_id < r.server_id;
+      }
+      if (l.world_id != r.world_id) {
+        return l.world_id < r.world_id;
+      }
+      if (l.zone_id != r.zone_id) {
+        return l.zone_id < r.zone_id;
+      }
+      return l.rank_key < r.rank_key;
+    }
+  };
+
+  struct bucket_type {
+    logic_rank_handle_variant handle;
+    std::chrono::system_clock::time_point flush_timepoint;
+    std::vector<pending_entry_ptr> pending;
+
+    inline explicit bucket_type(const logic_rank_handle_variant& h) : handle(h) {}
+  };
+  using bucket_ptr = atfw::util::memory::strong_rc_ptr<bucket_type>;
+
+ protected:
+  rank_submit_aggregator();
+
+ public:
+  /**
+   * @brief 检查到期的分组并发出合并后的请求
+   * @return 发出的请求数
+   */
+  int tick();
+
+  /**
+   * @brief 是否开启合并提交，gamesvr_cfg.rank_submit_flush_interval为0时关闭
+   */
+  bool is_enabled() const;
+
+  /**
+   * @brief 设置玩家分数，加入合并队列后等待本批次发送完成
+   * @note 未开启合并时直接调用upload_score
+   * @note 开启合并时每次提交最多要多等待一个gamesvr_cfg.rank_submit_flush_interval
+   * @note 超时或者任务退出时还没有发出的数据会被丢弃，由玩家任务带着最新的数据重试
+   * @return 0或错误码，每个玩家返回自己的结果，失败时由玩家任务保留未提交数据后续重试
+   */
+  EXPLICIT_NODISCARD_ATTR rpc::result_code_type upload_score(rpc::context& ctx, logic_rank_handle_variant& handle,
+                                                             const logic_rank_handle_key& key, gsl::string_view openid,
+                                                             uint32_t score,
+                                                             const rank_callback_private_data& callback_data,
+                                                             logic_rank_user_extend_span user_extend_data);
+
+  inline size_t get_pending_count() const noexcept { return pending_count_; }
+
+ private:
+  bool flush(const bucket_key& key, bucket_type& bucket);
+
+  /**
+   * @brief 唤醒等待的玩家任务
+   * @param result 整批的结果
+   * @param results 和entries一一对应的结果，数量不一致时所有玩家都使用result
+   */
+  static void wakeup(const std::vector<pending_entry_ptr>& entries, int32_t result,
+                     const std::vector<int32_t>* results = nullptr);
+
+ private:
+  std::map<bucket_key, bucket_ptr> buckets_;
+  size_t pending_count_;
+};
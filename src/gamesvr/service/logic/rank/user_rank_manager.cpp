@@ -34,6 +34,7 @@
 // #include <logic/item_util/item_algorithm.h>
 #include "data/player.h"
 #include "logic/async_jobs/user_async_jobs_manager.h"
+#include "logic/rank/rank_submit_aggregator.h"
 
 user_rank_manager::rank_data_index::rank_data_index(const PROJECT_NAMESPACE_ID::config::ExcelRankRule &rule) noexcept
     : logic_rank_handle_key(rule) {}
@@ -1469,21 +1470,22 @@ rpc::result_code_type user_rank_manager::submit(rpc::context &ctx, const rank_da
       } else {
         submit_value = static_cast<uint32_t>(unsubmit.value());
       }
-      auto res = RPC_AWAIT_TYPE_RESULT(
-          rank_handle.upload_score(ctx, rank_key,
-                                   rank_user_key_to_openid(unsubmit.user_key().zone_id(), unsubmit.user_key().user_id(),
-                                                           unsubmit.rank_instance_key()),
-                                   submit_value, callback_data, extend_data));
-      // send_report_rank_oss_log(ctx, unsubmit, rank_key, last_score_cache, res.api_result);
-
-      if (res.api_result != 0) {
+      // 覆盖式的提交在节点内合并，按排行榜批量发给ranksvr
+      auto res = RPC_AWAIT_CODE_RESULT(rank_submit_aggregator::me()->upload_score(
+          ctx, rank_handle, rank_key,
+          rank_user_key_to_openid(unsubmit.user_key().zone_id(), unsubmit.user_key().user_id(),
+                                  unsubmit.rank_instance_key()),
+          submit_value, callback_data, extend_data));
+      // send_report_rank_oss_log(ctx, unsubmit, rank_key, last_score_cache, res);
+
+      if (res != 0) {
         FWPLOGERROR(*owner_,
                     "upload_score to rank ({},{},{},{}) with user={},{}, score={} failed, res: "
                     "{}({})",
                     rank_key.get_rank_type(), rank_key.get_instance_id(), rank_key.get_sub_rank_type(),
                     rank_key.get_sub_instance_id(), unsubmit.user_key().zone_id(), unsubmit.user_key().user_id(),
-                    submit_value, res.api_result, protobuf_mini_dumper_get_error_msg(res.api_result));
-        ret = res.api_result;
+                    submit_value, res, protobuf_mini_dumper_get_error_msg(res));
+        ret = res;
         break;
       }
       FWPLOGDEBUG(*owner_, "upload_score to rank ({},{},{},{}) with user={},{}, score={} success",
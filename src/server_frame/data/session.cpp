@@ -18,7 +18,6 @@
 #include <config/compiler/protobuf_suffix.h>
 // clang-format on
 
-#include <atgateway/protocols/libatgw_protocol_api.h>
 #include <dispatcher/cs_msg_dispatcher.h>
 
 #include <utility/protobuf_mini_dumper.h>
@@ -213,18 +212,6 @@ SERVER_FRAME_API int32_t session::send_msg_to_client(rpc::context &ctx, atframew
   alloc_session_sequence(msg);
 
   size_t msg_buf_len = msg.ByteSizeLong();
-  size_t tls_buf_len = atfw::gateway::libatgw_protocol_api::get_tls_length(
-      atfw::gateway::libatgw_protocol_api::tls_buffer_t::EN_TBT_CUSTOM);
-  if (msg_buf_len > tls_buf_len) {
-    FWLOGERROR("send to gateway [{:#x}, {}] failed: require {}, only have {}", id_.node_id, id_.session_id, msg_buf_len,
-               tls_buf_len);
-    return PROJECT_NAMESPACE_ID::err::EN_SYS_BUFF_EXTEND;
-  }
-
-  ::google::protobuf::uint8 *buf_start =
-      reinterpret_cast< ::google::protobuf::uint8 *>(atfw::gateway::libatgw_protocol_api::get_tls_buffer(
-          atfw::gateway::libatgw_protocol_api::tls_buffer_t::EN_TBT_CUSTOM));
-  msg.SerializeWithCachedSizesToArray(buf_start);
   FWLOGDEBUG(
       "send msg to client:[{:#x}, {}] {} bytes.(session sequence: {}, client sequence: {}, server sequence: {})\n{}",
       id_.node_id, id_.session_id, msg_buf_len, msg.head().session_sequence(), msg.head().client_sequence(),
@@ -232,7 +219,8 @@ SERVER_FRAME_API int32_t session::send_msg_to_client(rpc::context &ctx, atframew
 
   write_actor_log_head(ctx, msg, msg_buf_len, false);
 
-  return send_msg_to_client(buf_start, msg_buf_len);
+  // serialize into the gateway envelope directly, without a temporary buffer
+  return cs_msg_dispatcher::me()->send_message(get_key().node_id, get_key().session_id, msg, msg_buf_len);
 }
 
 SERVER_FRAME_API int32_t session::send_msg_to_client(const void *msg_data, size_t msg_size) {
@@ -242,21 +230,10 @@ SERVER_FRAME_API int32_t session::send_msg_to_client(const void *msg_data, size_
 
 SERVER_FRAME_API int32_t session::broadcast_msg_to_client(uint64_t node_id, const atframework::CSMsg &msg) {
   size_t msg_buf_len = msg.ByteSizeLong();
-  size_t tls_buf_len = atfw::gateway::libatgw_protocol_api::get_tls_length(
-      atfw::gateway::libatgw_protocol_api::tls_buffer_t::EN_TBT_CUSTOM);
-  if (msg_buf_len > tls_buf_len) {
-    FWLOGERROR("broadcast to gateway [{:#x}] failed: require {}, only have {}", node_id, msg_buf_len, tls_buf_len);
-    return PROJECT_NAMESPACE_ID::err::EN_SYS_BUFF_EXTEND;
-  }
-
-  ::google::protobuf::uint8 *buf_start =
-      reinterpret_cast< ::google::protobuf::uint8 *>(atfw::gateway::libatgw_protocol_api::get_tls_buffer(
-          atfw::gateway::libatgw_protocol_api::tls_buffer_t::EN_TBT_CUSTOM));
-  msg.SerializeWithCachedSizesToArray(buf_start);
   FWLOGDEBUG("broadcast msg to gateway [{:#x}] {} bytes\n{}", node_id, msg_buf_len,
              protobuf_mini_dumper_get_readable(msg));
 
-  return broadcast_msg_to_client(node_id, buf_start, msg_buf_len);
+  return cs_msg_dispatcher::me()->send_message(node_id, 0, msg, msg_buf_len);
 }
 
 SERVER_FRAME_API int32_t session::broadcast_msg_to_client(uint64_t node_id, const void *msg_data, size_t msg_size) {
@@ -264,6 +241,19 @@ SERVER_FRAME_API int32_t session::broadcast_msg_to_client(uint64_t node_id, cons
   return cs_msg_dispatcher::me()->broadcast_data(node_id, msg_data, msg_size);
 }
 
+SERVER_FRAME_API int32_t session::multicast_msg_to_client(uint64_t node_id, const std::vector<uint64_t> &session_ids,
+                                                          const atframework::CSMsg &msg) {
+  if (session_ids.empty()) {
+    return 0;
+  }
+
+  size_t msg_buf_len = msg.ByteSizeLong();
+  FWLOGDEBUG("multicast msg to {} sessions of gateway [{:#x}] {} bytes\n{}", session_ids.size(), node_id, msg_buf_len,
+             protobuf_mini_dumper_get_readable(msg));
+
+  return cs_msg_dispatcher::me()->multicast_message(node_id, session_ids, msg, msg_buf_len);
+}
+
 SERVER_FRAME_API bool session::compare_callback::operator()(const key_t &l, const key_t &r) const noexcept {
   return l < r;
 }
@@ -293,7 +283,9 @@ SERVER_FRAME_API int32_t session::send_kickoff(int32_t reason) {
 
 SERVER_FRAME_API void session::write_actor_log_head(rpc::context &ctx, const atframework::CSMsg &msg, size_t byte_size,
                                                     bool is_input) {
-  if (!actor_log_writter_ && !actor_log_otel_) {
+  bool writter_enabled = is_actor_log_writter_enabled();
+  bool otel_enabled = is_actor_log_otel_enabled();
+  if (!writter_enabled && !otel_enabled) {
     return;
   }
 
@@ -332,10 +324,10 @@ SERVER_FRAME_API void session::write_actor_log_head(rpc::context &ctx, const atf
         ">>>>>>>>>>>> send {} bytes to player {}:{}, session: {:#x}:{}, rpc: {}, type: {}", byte_size, cached_zone_id_,
         cached_user_id_, get_key().node_id, get_key().session_id, rpc_name, type_url);
   }
-  if (actor_log_writter_) {
+  if (writter_enabled) {
     actor_log_writter_->write_log(caller, hint_text.c_str(), hint_text.size());
   }
-  if (actor_log_otel_) {
+  if (otel_enabled) {
     std::pair<opentelemetry::nostd::string_view, opentelemetry::common::AttributeValue> attributes[] = {
         {"tconnd.node_id", get_key().node_id},
         {"session.event", is_input ? "receive_hint" : "send_hint"},
@@ -359,7 +351,9 @@ SERVER_FRAME_API void session::write_actor_log_head(rpc::context &ctx, const atf
 
 SERVER_FRAME_API void session::write_actor_log_body(rpc::context &ctx, const google::protobuf::Message &msg,
                                                     const atframework::CSMsgHead &head, bool is_input) {
-  if (!actor_log_writter_ && !actor_log_otel_) {
+  bool writter_enabled = is_actor_log_writter_enabled();
+  bool otel_enabled = is_actor_log_otel_enabled();
+  if (!writter_enabled && !otel_enabled) {
     return;
   }
 
@@ -388,13 +382,13 @@ SERVER_FRAME_API void session::write_actor_log_body(rpc::context &ctx, const goo
 
   std::string head_text = protobuf_mini_dumper_get_readable(head);
   std::string body_text = protobuf_mini_dumper_get_readable(msg);
-  if (actor_log_writter_) {
+  if (writter_enabled) {
     actor_log_writter_->format_log(caller,
                                    "============ session: {:#x}:{}, rpc: {}, type: {} ============\n------------ "
                                    "Head ------------\n{}------------ Body ------------\n{}",
                                    get_key().node_id, get_key().session_id, rpc_name, type_url, head_text, body_text);
   }
-  if (actor_log_otel_) {
+  if (otel_enabled) {
     std::pair<opentelemetry::nostd::string_view, opentelemetry::common::AttributeValue> attributes[] = {
         {"tconnd.node_id", get_key().node_id},
 
@@ -438,6 +432,14 @@ SERVER_FRAME_API void session::write_actor_log_body(rpc::context &ctx, const goo
   }
 }
 
+bool session::is_actor_log_writter_enabled() const noexcept {
+  return actor_log_writter_ && actor_log_writter_->check_level(util::log::log_formatter::level_t::LOG_LW_INFO);
+}
+
+bool session::is_actor_log_otel_enabled() const noexcept {
+  return actor_log_otel_ && actor_log_otel_->Enabled(opentelemetry::logs::Severity::kInfo);
+}
+
 SERVER_FRAME_API void session::alloc_session_sequence(atframework::CSMsg &msg) {
   do {
     // has already alloc sequence, do nothing
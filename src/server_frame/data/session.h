@@ -18,6 +18,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #ifdef __cpp_impl_three_way_comparison
 #  include <compare>
@@ -147,6 +148,10 @@ class session {
 
   SERVER_FRAME_API static int32_t broadcast_msg_to_client(uint64_t node_id, const void *msg_data, size_t msg_size);
 
+  // 同一个gateway上的多个session共享一次下行post包
+  SERVER_FRAME_API static int32_t multicast_msg_to_client(uint64_t node_id, const std::vector<uint64_t> &session_ids,
+                                                          const atframework::CSMsg &msg);
+
   struct compare_callback {
     SERVER_FRAME_API bool operator()(const key_t &l, const key_t &r) const noexcept;
     SERVER_FRAME_API size_t operator()(const key_t &hash_obj) const noexcept;
@@ -170,6 +175,9 @@ class session {
  private:
   void create_actor_log_writter();
 
+  bool is_actor_log_writter_enabled() const noexcept;
+  bool is_actor_log_otel_enabled() const noexcept;
+
  private:
   key_t id_;
   uint32_t flags_;
@@ -20,6 +20,9 @@
 
 #include <config/compiler/protobuf_prefix.h>
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
 #include <protocol/pbdesc/com.const.pb.h>
 #include <protocol/pbdesc/com.protocol.pb.h>
 #include <protocol/pbdesc/svr.const.err.pb.h>
@@ -31,7 +34,9 @@
 #include <logic/session_manager.h>
 
 #include <rpc/rpc_context.h>
+#include <utility/tls_buffers.h>
 
+#include <cstring>
 #include <utility>
 
 #include "dispatcher/task_manager.h"
@@ -46,6 +51,99 @@ ATFW_UTIL_DESIGN_PATTERN_SINGLETON_IMPORT_DATA_DEFINITION(cs_msg_dispatcher);
 ATFW_UTIL_DESIGN_PATTERN_SINGLETON_VISIBLE_DATA_DEFINITION(cs_msg_dispatcher);
 #endif
 
+namespace {
+using cs_msg_wire_format = ::ATBUS_MACRO_PROTOBUF_NAMESPACE_ID::internal::WireFormatLite;
+using cs_msg_coded_stream = ::ATBUS_MACRO_PROTOBUF_NAMESPACE_ID::io::CodedOutputStream;
+
+// Layout of ss_msg{head{session_id}, body{post{session_ids, content}}}, all bytes before content are the envelope
+struct cs_msg_post_envelope_t {
+  size_t head_size;
+  size_t session_ids_size;
+  size_t post_size;
+  size_t body_size;
+  size_t envelope_size;
+};
+
+static size_t cs_msg_length_delimited_prefix_size(int field_number, size_t payload_size) {
+  return cs_msg_coded_stream::VarintSize32(
+             cs_msg_wire_format::MakeTag(field_number, cs_msg_wire_format::WIRETYPE_LENGTH_DELIMITED)) +
+         cs_msg_coded_stream::VarintSize64(static_cast<uint64_t>(payload_size));
+}
+
+static ::google::protobuf::uint8 *cs_msg_write_length_delimited_prefix(int field_number, size_t payload_size,
+                                                                       ::google::protobuf::uint8 *target) {
+  target = cs_msg_coded_stream::WriteTagToArray(
+      cs_msg_wire_format::MakeTag(field_number, cs_msg_wire_format::WIRETYPE_LENGTH_DELIMITED), target);
+  return cs_msg_coded_stream::WriteVarint64ToArray(static_cast<uint64_t>(payload_size), target);
+}
+
+static void cs_msg_make_post_envelope(cs_msg_post_envelope_t &out, uint64_t session_id,
+                                      const std::vector<uint64_t> *session_ids, size_t content_size) {
+  out.head_size = 0;
+  if (0 != session_id) {
+    out.head_size = cs_msg_coded_stream::VarintSize32(cs_msg_wire_format::MakeTag(
+                        ::atframework::gw::ss_msg_head::kSessionIdFieldNumber, cs_msg_wire_format::WIRETYPE_VARINT)) +
+                    cs_msg_coded_stream::VarintSize64(session_id);
+  }
+
+  // session_ids is a packed repeated field
+  out.session_ids_size = 0;
+  if (nullptr != session_ids) {
+    for (uint64_t target_session_id : *session_ids) {
+      out.session_ids_size += cs_msg_coded_stream::VarintSize64(target_session_id);
+    }
+  }
+
+  out.post_size =
+      cs_msg_length_delimited_prefix_size(::atframework::gw::ss_body_post::kContentFieldNumber, content_size) +
+      content_size;
+  if (out.session_ids_size > 0) {
+    out.post_size += cs_msg_length_delimited_prefix_size(::atframework::gw::ss_body_post::kSessionIdsFieldNumber,
+                                                         out.session_ids_size) +
+                     out.session_ids_size;
+  }
+  out.body_size =
+      cs_msg_length_delimited_prefix_size(::atframework::gw::ss_msg_body::kPostFieldNumber, out.post_size) +
+      out.post_size;
+
+  out.envelope_size =
+      cs_msg_length_delimited_prefix_size(::atframework::gw::ss_msg::kHeadFieldNumber, out.head_size) +
+      out.head_size +
+      cs_msg_length_delimited_prefix_size(::atframework::gw::ss_msg::kBodyFieldNumber, out.body_size) +
+      out.body_size - content_size;
+}
+
+// Write the envelope and return the address where content should be placed
+static ::google::protobuf::uint8 *cs_msg_write_post_envelope(const cs_msg_post_envelope_t &envelope,
+                                                             uint64_t session_id,
+                                                             const std::vector<uint64_t> *session_ids,
+                                                             size_t content_size, ::google::protobuf::uint8 *target) {
+  target = cs_msg_write_length_delimited_prefix(::atframework::gw::ss_msg::kHeadFieldNumber, envelope.head_size,
+                                                target);
+  if (0 != session_id) {
+    target = cs_msg_coded_stream::WriteTagToArray(
+        cs_msg_wire_format::MakeTag(::atframework::gw::ss_msg_head::kSessionIdFieldNumber,
+                                    cs_msg_wire_format::WIRETYPE_VARINT),
+        target);
+    target = cs_msg_coded_stream::WriteVarint64ToArray(session_id, target);
+  }
+
+  target = cs_msg_write_length_delimited_prefix(::atframework::gw::ss_msg::kBodyFieldNumber, envelope.body_size,
+                                                target);
+  target = cs_msg_write_length_delimited_prefix(::atframework::gw::ss_msg_body::kPostFieldNumber, envelope.post_size,
+                                                target);
+  if (envelope.session_ids_size > 0 && nullptr != session_ids) {
+    target = cs_msg_write_length_delimited_prefix(::atframework::gw::ss_body_post::kSessionIdsFieldNumber,
+                                                  envelope.session_ids_size, target);
+    for (uint64_t target_session_id : *session_ids) {
+      target = cs_msg_coded_stream::WriteVarint64ToArray(target_session_id, target);
+    }
+  }
+  return cs_msg_write_length_delimited_prefix(::atframework::gw::ss_body_post::kContentFieldNumber, content_size,
+                                              target);
+}
+}  // namespace
+
 SERVER_FRAME_API cs_msg_dispatcher::cs_msg_dispatcher() : is_closing_(false) {}
 
 SERVER_FRAME_API cs_msg_dispatcher::~cs_msg_dispatcher() {}
@@ -99,6 +197,30 @@ SERVER_FRAME_API const std::string &cs_msg_dispatcher::pick_rpc_name(msg_raw_t &
   return get_empty_string();
 }
 
+SERVER_FRAME_API uint32_t cs_msg_dispatcher::pick_rpc_method_id(msg_raw_t &raw_msg) {
+  atframework::CSMsg *real_msg = get_protobuf_msg<atframework::CSMsg>(raw_msg);
+  if (nullptr == real_msg || !real_msg->has_head()) {
+    return 0;
+  }
+
+  // 老版本客户端不会设置调度ID，这时返回0，按名字查找
+  switch (real_msg->head().rpc_type_case()) {
+    case atframework::CSMsgHead::kRpcRequest: {
+      return real_msg->head().rpc_request().rpc_method_id();
+    }
+    case atframework::CSMsgHead::kRpcStream: {
+      return real_msg->head().rpc_stream().rpc_method_id();
+    }
+    case atframework::CSMsgHead::kRpcResponse: {
+      return real_msg->head().rpc_response().rpc_method_id();
+    }
+    default:
+      break;
+  }
+
+  return 0;
+}
+
 SERVER_FRAME_API void cs_msg_dispatcher::on_create_task_failed(dispatcher_start_data_type &start_data,
                                                                int32_t error_code) {
   const std::string &rpc_name = pick_rpc_name(start_data.message);
@@ -169,6 +291,7 @@ SERVER_FRAME_API void cs_msg_dispatcher::on_create_task_failed(dispatcher_start_
 
   head->mutable_rpc_response()->set_version(logic_config::me()->get_atframework_settings().rpc_version());
   head->mutable_rpc_response()->set_rpc_name(rpc_name);
+  head->mutable_rpc_response()->set_rpc_method_id(real_msg->head().rpc_request().rpc_method_id());
   const ::ATBUS_MACRO_PROTOBUF_NAMESPACE_ID::MethodDescriptor *method = get_registered_method(rpc_name);
   if (nullptr != method) {
     head->mutable_rpc_response()->set_type_url(method->output_type()->full_name());
@@ -209,76 +332,18 @@ SERVER_FRAME_API int32_t cs_msg_dispatcher::dispatch(const atfw::atapp::app::mes
     case ::atframework::gw::ss_msg_body::kPost: {
       const ::atframework::gw::ss_body_post &post = req_msg.body().post();
 
-      rpc::context ctx{rpc::context::create_without_task()};
-      atframework::CSMsg *cs_msg = ctx.create<atframework::CSMsg>();
-      if (nullptr == cs_msg) {
-        FWLOGERROR("{} create message instance failed", name());
-        ret = PROJECT_NAMESPACE_ID::err::EN_SYS_MALLOC;
-        break;
-      }
-
-      session::key_t session_key;
-      session_key.node_id = from_server_id;
-      session_key.session_id = req_msg.head().session_id();
-
-      std::shared_ptr<session> sess = session_manager::me()->find(session_key);
-      if (!sess) {
-        FWLOGERROR("session [{:#x}: {}, {}] not found, try to kickoff", session_key.node_id,
-                   get_app()->convert_app_id_to_string(session_key.node_id), session_key.session_id);
-        ret = PROJECT_NAMESPACE_ID::err::EN_SYS_NOTFOUND;
-
-        send_kickoff(session_key.node_id, session_key.session_id, PROJECT_NAMESPACE_ID::EN_CRT_SESSION_NOT_FOUND);
-        break;
-      }
-
-      dispatcher_raw_message callback_msg = dispatcher_make_default<dispatcher_raw_message>();
-      ret = unpack_protobuf_msg(*cs_msg, callback_msg, reinterpret_cast<const void *>(post.content().data()),
-                                post.content().size());
-      if (ret != 0) {
-        FWLOGERROR("{} unpack received message from [{:#x}: {}], session id: {} failed, res: %d", name(),
-                   session_key.node_id, get_app()->convert_app_id_to_string(session_key.node_id),
-                   session_key.session_id, ret);
-        return ret;
-      }
-
-      cs_msg->mutable_head()->set_session_node_id(session_key.node_id);
-      cs_msg->mutable_head()->set_session_node_name(session_key.node_name);
-      cs_msg->mutable_head()->set_session_id(session_key.session_id);
-
-      sess->write_actor_log_head(ctx, *cs_msg, post.content().size(), true);
-
-      if (task_manager::me()->is_busy()) {
-        cs_msg->mutable_head()->set_error_code(PROJECT_NAMESPACE_ID::EN_ERR_SYSTEM_BUSY);
-        sess->send_msg_to_client(ctx, *cs_msg);
-        FWLOGINFO("server busy and send msg back to session [{:#x}: {}, {}]", session_key.node_id,
-                  get_app()->convert_app_id_to_string(session_key.node_id), session_key.session_id);
-        break;
-      }
+      // atgateway可能把同一个连接一次读到的多个消息合并在contents里
+      ret = dispatch_post(from_server_id, req_msg.head().session_id(), post.content());
+      for (int i = 0; i < post.contents_size(); ++i) {
+        if (PROJECT_NAMESPACE_ID::err::EN_SYS_NOTFOUND == ret) {
+          break;
+        }
 
-      rpc::telemetry::tracer tracer;
-      rpc::telemetry::trace_start_option trace_start_option;
-      trace_start_option.kind = ::atframework::RpcTraceSpan::SPAN_KIND_SERVER;
-      trace_start_option.is_remote = true;
-      trace_start_option.dispatcher = std::static_pointer_cast<dispatcher_implement>(cs_msg_dispatcher::me());
-      if (cs_msg->head().has_rpc_trace()) {
-        trace_start_option.parent_network_span = &cs_msg->head().rpc_trace();
-      } else {
-        trace_start_option.parent_network_span = nullptr;
-      }
-      rpc::telemetry::trace_attribute_pair_type internal_rpc_trace_attributes[] = {
-          {opentelemetry::semconv::rpc::kRpcSystem, "internal"},
-          {opentelemetry::semconv::rpc::kRpcService, "cs_msg_dispatcher"},
-          {opentelemetry::semconv::rpc::kRpcMethod, "cs_msg_dispatcher"}};
-      trace_start_option.attributes = internal_rpc_trace_attributes;
-      ctx.setup_tracer(tracer, "cs_msg_dispatcher", std::move(trace_start_option));
-
-      dispatcher_result_t res = on_receive_message(ctx, callback_msg, nullptr, cs_msg->head().client_sequence());
-      ret = res.result_code;
-      if (ret < 0) {
-        FWLOGERROR("{} on receive message callback from [{:#x}: {}, {}] failed, res: {}", name(), session_key.node_id,
-                   get_app()->convert_app_id_to_string(session_key.node_id), session_key.session_id, ret);
+        int32_t res = dispatch_post(from_server_id, req_msg.head().session_id(), post.contents(i));
+        if (0 != res) {
+          ret = res;
+        }
       }
-      tracer.finish({ret, {}});
       break;
     }
     case ::atframework::gw::ss_msg_body::kAddSession: {
@@ -377,6 +442,80 @@ SERVER_FRAME_API int32_t cs_msg_dispatcher::dispatch(const atfw::atapp::app::mes
   return ret;
 }
 
+int32_t cs_msg_dispatcher::dispatch_post(uint64_t from_server_id, uint64_t session_id, const std::string &content) {
+  int32_t ret = PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+  rpc::context ctx{rpc::context::create_without_task()};
+  atframework::CSMsg *cs_msg = ctx.create<atframework::CSMsg>();
+  if (nullptr == cs_msg) {
+    FWLOGERROR("{} create message instance failed", name());
+    ret = PROJECT_NAMESPACE_ID::err::EN_SYS_MALLOC;
+    return ret;
+  }
+
+  session::key_t session_key;
+  session_key.node_id = from_server_id;
+  session_key.session_id = session_id;
+
+  std::shared_ptr<session> sess = session_manager::me()->find(session_key);
+  if (!sess) {
+    FWLOGERROR("session [{:#x}: {}, {}] not found, try to kickoff", session_key.node_id,
+               get_app()->convert_app_id_to_string(session_key.node_id), session_key.session_id);
+    ret = PROJECT_NAMESPACE_ID::err::EN_SYS_NOTFOUND;
+
+    send_kickoff(session_key.node_id, session_key.session_id, PROJECT_NAMESPACE_ID::EN_CRT_SESSION_NOT_FOUND);
+    return ret;
+  }
+
+  dispatcher_raw_message callback_msg = dispatcher_make_default<dispatcher_raw_message>();
+  ret = unpack_protobuf_msg(*cs_msg, callback_msg, reinterpret_cast<const void *>(content.data()), content.size());
+  if (ret != 0) {
+    FWLOGERROR("{} unpack received message from [{:#x}: {}], session id: {} failed, res: %d", name(),
+               session_key.node_id, get_app()->convert_app_id_to_string(session_key.node_id), session_key.session_id,
+               ret);
+    return ret;
+  }
+
+  cs_msg->mutable_head()->set_session_node_id(session_key.node_id);
+  cs_msg->mutable_head()->set_session_node_name(session_key.node_name);
+  cs_msg->mutable_head()->set_session_id(session_key.session_id);
+
+  sess->write_actor_log_head(ctx, *cs_msg, content.size(), true);
+
+  if (task_manager::me()->is_busy()) {
+    cs_msg->mutable_head()->set_error_code(PROJECT_NAMESPACE_ID::EN_ERR_SYSTEM_BUSY);
+    sess->send_msg_to_client(ctx, *cs_msg);
+    FWLOGINFO("server busy and send msg back to session [{:#x}: {}, {}]", session_key.node_id,
+              get_app()->convert_app_id_to_string(session_key.node_id), session_key.session_id);
+    return ret;
+  }
+
+  rpc::telemetry::tracer tracer;
+  rpc::telemetry::trace_start_option trace_start_option;
+  trace_start_option.kind = ::atframework::RpcTraceSpan::SPAN_KIND_SERVER;
+  trace_start_option.is_remote = true;
+  trace_start_option.dispatcher = std::static_pointer_cast<dispatcher_implement>(cs_msg_dispatcher::me());
+  if (cs_msg->head().has_rpc_trace()) {
+    trace_start_option.parent_network_span = &cs_msg->head().rpc_trace();
+  } else {
+    trace_start_option.parent_network_span = nullptr;
+  }
+  rpc::telemetry::trace_attribute_pair_type internal_rpc_trace_attributes[] = {
+      {opentelemetry::semconv::rpc::kRpcSystem, "internal"},
+      {opentelemetry::semconv::rpc::kRpcService, "cs_msg_dispatcher"},
+      {opentelemetry::semconv::rpc::kRpcMethod, "cs_msg_dispatcher"}};
+  trace_start_option.attributes = internal_rpc_trace_attributes;
+  ctx.setup_tracer(tracer, "cs_msg_dispatcher", std::move(trace_start_option));
+
+  dispatcher_result_t res = on_receive_message(ctx, callback_msg, nullptr, cs_msg->head().client_sequence());
+  ret = res.result_code;
+  if (ret < 0) {
+    FWLOGERROR("{} on receive message callback from [{:#x}: {}, {}] failed, res: {}", name(), session_key.node_id,
+               get_app()->convert_app_id_to_string(session_key.node_id), session_key.session_id, ret);
+  }
+  tracer.finish({ret, {}});
+  return ret;
+}
+
 SERVER_FRAME_API int32_t cs_msg_dispatcher::send_kickoff(uint64_t node_id, uint64_t session_id, int32_t reason) {
   atfw::atapp::app *owner = get_app();
   if (nullptr == owner) {
@@ -401,43 +540,66 @@ SERVER_FRAME_API int32_t cs_msg_dispatcher::send_kickoff(uint64_t node_id, uint6
 
 SERVER_FRAME_API int32_t cs_msg_dispatcher::send_data(uint64_t node_id, uint64_t session_id, const void *buffer,
                                                       size_t len) {
+  if (nullptr == buffer) {
+    return 0;
+  }
+
+  return send_post(node_id, session_id, nullptr, nullptr, buffer, len);
+}
+
+SERVER_FRAME_API int32_t cs_msg_dispatcher::send_message(uint64_t node_id, uint64_t session_id,
+                                                         const ::google::protobuf::MessageLite &msg, size_t msg_size) {
+  return send_post(node_id, session_id, nullptr, &msg, nullptr, msg_size);
+}
+
+SERVER_FRAME_API int32_t cs_msg_dispatcher::multicast_message(uint64_t node_id,
+                                                              const std::vector<uint64_t> &session_ids,
+                                                              const ::google::protobuf::MessageLite &msg,
+                                                              size_t msg_size) {
+  // empty session_ids means broadcast to all sessions in atgateway
+  return send_post(node_id, 0, session_ids.empty() ? nullptr : &session_ids, &msg, nullptr, msg_size);
+}
+
+int32_t cs_msg_dispatcher::send_post(uint64_t node_id, uint64_t session_id, const std::vector<uint64_t> *session_ids,
+                                     const ::google::protobuf::MessageLite *msg, const void *buffer, size_t len) {
   atfw::atapp::app *owner = get_app();
   if (nullptr == owner) {
     FWLOGERROR("not in a atapp");
     return PROJECT_NAMESPACE_ID::err::EN_SYS_INIT;
   }
 
-  if (nullptr == buffer || 0 == len) {
+  if (0 == len) {
     return 0;
   }
 
-  ::atframework::gw::ss_msg msg;
-  msg.mutable_head()->set_session_id(session_id);
-
-  ::atframework::gw::ss_body_post *post = msg.mutable_body()->mutable_post();
+  // Pack ss_msg envelope and content into one buffer, so content is copied or serialized only once
+  cs_msg_post_envelope_t envelope;
+  cs_msg_make_post_envelope(envelope, session_id, session_ids, len);
 
-  if (nullptr == post) {
+  size_t packed_size = envelope.envelope_size + len;
+  size_t tls_buf_len = tls_buffers_get_length(tls_buffers_type_t::EN_TBT_MESSAGE);
+  if (packed_size > tls_buf_len) {
     if (0 == session_id) {
-      FWLOGERROR("broadcast {} bytes data to atgateway {:#x}: {} failed when malloc post", len, node_id,
-                 get_app()->convert_app_id_to_string(node_id));
+      FWLOGERROR("broadcast {} bytes data to atgateway [{:#x}: {}] failed: require {}, only have {}", len, node_id,
+                 get_app()->convert_app_id_to_string(node_id), packed_size, tls_buf_len);
     } else {
-      FWLOGERROR("send {} bytes data to session [{:#x}: {}, {}] failed when malloc post", len, node_id,
-                 get_app()->convert_app_id_to_string(node_id), session_id);
+      FWLOGERROR("send {} bytes data to session [{:#x}: {}, {}] failed: require {}, only have {}", len, node_id,
+                 get_app()->convert_app_id_to_string(node_id), session_id, packed_size, tls_buf_len);
     }
-    return PROJECT_NAMESPACE_ID::err::EN_SYS_MALLOC;
+    return PROJECT_NAMESPACE_ID::err::EN_SYS_BUFF_EXTEND;
   }
 
-  post->set_content(buffer, len);
-
-  std::string packed_buffer;
-  if (false == msg.SerializeToString(&packed_buffer)) {
-    FWLOGERROR("try to send {} bytes data to [{:#x}: {}] with serialize failed: {}", len, session_id,
-               get_app()->convert_app_id_to_string(session_id), msg.InitializationErrorString());
-    return 0;
+  ::google::protobuf::uint8 *buf_start = reinterpret_cast< ::google::protobuf::uint8 *>(
+      tls_buffers_get_buffer(tls_buffers_type_t::EN_TBT_MESSAGE));
+  ::google::protobuf::uint8 *content_start = cs_msg_write_post_envelope(envelope, session_id, session_ids, len, buf_start);
+  if (nullptr != msg) {
+    msg->SerializeWithCachedSizesToArray(content_start);
+  } else {
+    memcpy(content_start, buffer, len);
   }
 
   int ret = owner->get_bus_node()->send_data(node_id, ::atframework::component::service_type::EN_ATST_GATEWAY,
-                                             packed_buffer.data(), packed_buffer.size());
+                                             buf_start, packed_size);
   if (ret < 0) {
     if (0 == session_id) {
       FWLOGERROR("broadcast data to atgateway [{:#x}: {}] failed, res: {}", node_id,
@@ -456,43 +618,16 @@ SERVER_FRAME_API int32_t cs_msg_dispatcher::broadcast_data(uint64_t node_id, con
 }
 
 SERVER_FRAME_API int32_t cs_msg_dispatcher::broadcast_data(uint64_t node_id,
-                                                           const std::vector<uint64_t> & /*session_ids*/,
+                                                           const std::vector<uint64_t> &session_ids,
                                                            const void *buffer, size_t len) {
-  atfw::atapp::app *owner = get_app();
-  if (nullptr == owner) {
-    FWLOGERROR("not in a atapp");
-    return PROJECT_NAMESPACE_ID::err::EN_SYS_INIT;
+  // empty session_ids means broadcast to all sessions in atgateway
+  if (session_ids.empty()) {
+    return send_data(node_id, 0, buffer, len);
   }
 
-  if (nullptr == buffer || 0 == len) {
+  if (nullptr == buffer) {
     return 0;
   }
 
-  ::atframework::gw::ss_msg msg;
-  msg.mutable_head()->set_session_id(0);
-
-  ::atframework::gw::ss_body_post *post = msg.mutable_body()->mutable_post();
-
-  if (nullptr == post) {
-    FWLOGERROR("broadcast {} bytes data to atgateway [{:#x}: {}] failed when malloc post", len, node_id,
-               get_app()->convert_app_id_to_string(node_id));
-    return PROJECT_NAMESPACE_ID::err::EN_SYS_MALLOC;
-  }
-
-  post->set_content(buffer, len);
-
-  std::string packed_buffer;
-  if (false == msg.SerializeToString(&packed_buffer)) {
-    FWLOGERROR("try to broadcast {} bytes data with serialize failed: {}", len, msg.InitializationErrorString());
-    return 0;
-  }
-
-  int ret = owner->get_bus_node()->send_data(node_id, ::atframework::component::service_type::EN_ATST_GATEWAY,
-                                             packed_buffer.data(), packed_buffer.size());
-  if (ret < 0) {
-    FWLOGERROR("broadcast data to atgateway [{:#x}: {}] failed, res: {}", node_id,
-               get_app()->convert_app_id_to_string(node_id), ret);
-  }
-
-  return ret;
+  return send_post(node_id, 0, &session_ids, nullptr, buffer, len);
 }
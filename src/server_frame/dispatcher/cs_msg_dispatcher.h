@@ -10,6 +10,7 @@
 #include <config/compiler/protobuf_prefix.h>
 
 #include <google/protobuf/descriptor.h>
+#include <google/protobuf/message_lite.h>
 
 #include <config/compiler/protobuf_suffix.h>
 
@@ -19,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "dispatcher/dispatcher_implement.h"
 #include "dispatcher/dispatcher_type_defines.h"
@@ -69,6 +71,13 @@ class cs_msg_dispatcher : public dispatcher_implement {
    */
   SERVER_FRAME_API const std::string &pick_rpc_name(msg_raw_t &raw_msg) override;
 
+  /**
+   * @brief 获取消息的RPC调度ID
+   * @param raw_msg 消息抽象结构
+   * @return 消息的RPC调度ID,如果不是RPC消息或者客户端没有设置，返回0
+   */
+  SERVER_FRAME_API uint32_t pick_rpc_method_id(msg_raw_t &raw_msg) override;
+
   /**
    * @brief on create task failed
    * @param start_data start data
@@ -105,6 +114,18 @@ class cs_msg_dispatcher : public dispatcher_implement {
    */
   SERVER_FRAME_API int32_t send_data(uint64_t node_id, uint64_t session_id, const void *buffer, size_t len);
 
+  /**
+   * send message to client, the gateway envelope and the message are serialized into one buffer
+   * @note msg.ByteSizeLong() must be called before and msg must not be changed after that
+   * @param node_id bus id of atgateway
+   * @param session_id session id, 0 means broadcast
+   * @param msg message to send
+   * @param msg_size cached byte size of msg
+   * @return 0 or error code
+   */
+  SERVER_FRAME_API int32_t send_message(uint64_t node_id, uint64_t session_id,
+                                        const ::google::protobuf::MessageLite &msg, size_t msg_size);
+
   /**
    * broadcast data to atgateway
    * @param node_id bus id of atgateway
@@ -117,7 +138,7 @@ class cs_msg_dispatcher : public dispatcher_implement {
   /**
    * broadcast data to multiple clients
    * @param node_id bus id of atgateway
-   * @param session_ids session id
+   * @param session_ids session id list, broadcast to all sessions on the atgateway if it's empty
    * @param buffer data buffer
    * @param len data length
    * @return 0 or error code
@@ -125,6 +146,24 @@ class cs_msg_dispatcher : public dispatcher_implement {
   SERVER_FRAME_API int32_t broadcast_data(uint64_t node_id, const std::vector<uint64_t> &session_ids,
                                           const void *buffer, size_t len);
 
+  /**
+   * send message to multiple clients on the same atgateway with one bus message
+   * @note msg.ByteSizeLong() must be called before and msg must not be changed after that
+   * @param node_id bus id of atgateway
+   * @param session_ids session id list, broadcast to all sessions on the atgateway if it's empty
+   * @param msg message to send
+   * @param msg_size cached byte size of msg
+   * @return 0 or error code
+   */
+  SERVER_FRAME_API int32_t multicast_message(uint64_t node_id, const std::vector<uint64_t> &session_ids,
+                                             const ::google::protobuf::MessageLite &msg, size_t msg_size);
+
+ private:
+  int32_t dispatch_post(uint64_t from_server_id, uint64_t session_id, const std::string &content);
+
+  int32_t send_post(uint64_t node_id, uint64_t session_id, const std::vector<uint64_t> *session_ids,
+                    const ::google::protobuf::MessageLite *msg, const void *buffer, size_t len);
+
  private:
   bool is_closing_;
   std::unordered_map<msg_type_t, const atframework::DispatcherOptions *> dispatcher_options_map_;
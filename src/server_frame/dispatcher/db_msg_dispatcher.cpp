@@ -327,6 +327,38 @@ else
 end)";
       break;
     }
+    case script_type::kCompareAndSetHashTableWithGuard: {
+      // KEYS[1]: 守护表(比如登入锁)，KEYS[2]: 数据表
+      // ARGV: 守护表参数(版本号字段名, 期望版本号, 字段...), 数据表参数(同前), 守护表参数个数
+      // 守护表版本号校验通过就续期守护表，数据表版本号也校验通过才写入数据表(和分两次保存时的行为一致)
+      // 返回 { 状态, 守护表版本号, 数据表版本号 }
+      // 状态: 0 成功, 1 守护表版本号不匹配(都没有写入), 2 数据表版本号不匹配(只写入了守护表)
+      script = R"(local unpack_fn = table.unpack or unpack -- Lua 5.1 - 5.3
+local guard_argc = tonumber(ARGV[#ARGV])
+local function get_real_version(key, field)
+  local real_version_str = redis.call('HGET', key, field)
+  if real_version_str ~= false and real_version_str ~= nil then
+    return tonumber(real_version_str)
+  end
+  return 0
+end
+local guard_real_version = get_real_version(KEYS[1], ARGV[1])
+local data_real_version = get_real_version(KEYS[2], ARGV[guard_argc + 1])
+if guard_real_version ~= 0 and tonumber(ARGV[2]) ~= guard_real_version then
+  return { '1', tostring(guard_real_version), tostring(data_real_version) }
+end
+local guard_args = { unpack_fn(ARGV, 1, guard_argc) }
+guard_args[2] = guard_real_version + 1
+redis.call('HSET', KEYS[1], unpack_fn(guard_args))
+if data_real_version ~= 0 and tonumber(ARGV[guard_argc + 2]) ~= data_real_version then
+  return { '2', tostring(guard_args[2]), tostring(data_real_version) }
+end
+local data_args = { unpack_fn(ARGV, guard_argc + 1, #ARGV - 1) }
+data_args[2] = data_real_version + 1
+redis.call('HSET', KEYS[2], unpack_fn(data_args))
+return { '0', tostring(guard_args[2]), tostring(data_args[2]) })";
+      break;
+    }
     case script_type::kAddListIndexHashTable: {
       script = R"(local max_len = tonumber(ARGV[1])
 local index_field = "index_number"
@@ -517,6 +549,7 @@ void db_msg_dispatcher::cluster_on_connected(hiredis::happ::cluster *clu, hiredi
   // 注入redis的lua脚本
   me()->script_load(conn->get_context(), script_type::kCompareAndSetHashTable);
   me()->script_load(conn->get_context(), script_type::kAddListIndexHashTable);
+  me()->script_load(conn->get_context(), script_type::kCompareAndSetHashTableWithGuard);
 
   for (int i = 0; i < channel_t::SENTINEL_BOUND; ++i) {
     std::shared_ptr<hiredis::happ::cluster> &clu_ptr = me()->db_cluster_conns_[i];
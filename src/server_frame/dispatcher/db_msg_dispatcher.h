@@ -106,6 +106,7 @@ class db_msg_dispatcher : public dispatcher_implement {
     kInvalid = 0,
     kCompareAndSetHashTable = 1,
     kAddListIndexHashTable = 2,
+    kCompareAndSetHashTableWithGuard = 3,
     kMax  // Unused
   };
 
@@ -26,6 +26,11 @@
 
 #include <typeinfo>
 
+// 按调度ID索引的数组的最大长度，冲突的RPC超过这个长度以后回退到按名字查找
+#ifndef PROJECT_SERVER_FRAME_DISPATCHER_RPC_METHOD_SLOT_MAX_SIZE
+#  define PROJECT_SERVER_FRAME_DISPATCHER_RPC_METHOD_SLOT_MAX_SIZE 65536
+#endif
+
 SERVER_FRAME_API int dispatcher_implement::init() { return 0; }
 
 SERVER_FRAME_API const char *dispatcher_implement::name() const {
@@ -167,6 +172,16 @@ SERVER_FRAME_API int dispatcher_implement::create_task(dispatcher_start_data_typ
                                                        task_type_trait::task_type &task_inst) {
   task_type_trait::reset_task(task_inst);
 
+  // 优先按生成器填充的调度ID查找，不需要计算字符串hash和比较
+  uint32_t rpc_method_id = rpc_method_slots_.empty() ? 0 : pick_rpc_method_id(start_data.message);
+  if (0 != rpc_method_id) {
+    const rpc_method_slot_t &slot = rpc_method_slots_[rpc_method_id & rpc_method_slot_mask_];
+    if (slot.rpc_method_id == rpc_method_id && slot.action) {
+      start_data.options = &slot.action->options;
+      return (*slot.action)(task_inst, start_data);
+    }
+  }
+
   const std::string &rpc_name = pick_rpc_name(start_data.message);
   if (rpc_name.empty()) {
     return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
@@ -187,6 +202,23 @@ SERVER_FRAME_API int dispatcher_implement::create_task(dispatcher_start_data_typ
   return PROJECT_NAMESPACE_ID::err::EN_SYS_NOTFOUND;
 }
 
+SERVER_FRAME_API uint32_t dispatcher_implement::pick_rpc_method_id(msg_raw_t &) { return 0; }
+
+SERVER_FRAME_API uint32_t dispatcher_implement::make_rpc_method_id(gsl::string_view rpc_full_name) noexcept {
+  // FNV-1a 32
+  uint32_t ret = 0x811c9dc5U;
+  for (char c : rpc_full_name) {
+    ret ^= static_cast<uint32_t>(static_cast<unsigned char>(c));
+    ret *= 0x01000193U;
+  }
+
+  // 0 表示未设置
+  if (0 == ret) {
+    ret = 1;
+  }
+  return ret;
+}
+
 SERVER_FRAME_API void dispatcher_implement::push_filter_to_front(message_filter_handle_t fn) {
   msg_filter_list_.push_front(fn);
 }
@@ -233,6 +265,7 @@ SERVER_FRAME_API int32_t dispatcher_implement::convert_from_atapp_error_code(int
 }
 
 SERVER_FRAME_API int dispatcher_implement::_register_action(const std::string &rpc_full_name,
+                                                            uint32_t rpc_method_id,
                                                             task_manager::task_action_creator_t action) {
   rpc_task_action_set_t::iterator iter = task_action_map_by_name_.find(rpc_full_name);
   if (task_action_map_by_name_.end() != iter) {
@@ -241,5 +274,59 @@ SERVER_FRAME_API int dispatcher_implement::_register_action(const std::string &r
   }
 
   task_action_map_by_name_[rpc_full_name] = action;
+
+  if (0 != rpc_method_id && action) {
+    auto id_iter = task_action_map_by_id_.find(rpc_method_id);
+    if (task_action_map_by_id_.end() == id_iter) {
+      task_action_map_by_id_[rpc_method_id] = action;
+    } else if (id_iter->second) {
+      // 不同的RPC算出了相同的调度ID，这个ID的消息都按名字查找
+      FWLOGWARNING("{} rpc {} has the same method id {:#x} with another rpc, it will be dispatched by name", name(),
+                   rpc_full_name, rpc_method_id);
+      id_iter->second.reset();
+    }
+
+    rebuild_rpc_method_slots();
+  }
+
   return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
 }
+
+void dispatcher_implement::rebuild_rpc_method_slots() {
+  size_t slot_size = 1;
+  while (slot_size < task_action_map_by_id_.size() * 2) {
+    slot_size <<= 1;
+  }
+
+  // 扩大数组直到没有冲突，超过上限后冲突的RPC按名字查找
+  std::vector<rpc_method_slot_t> slots;
+  while (true) {
+    slots.clear();
+    slots.resize(slot_size, rpc_method_slot_t{0, nullptr});
+    uint32_t mask = static_cast<uint32_t>(slot_size - 1);
+    bool has_conflict = false;
+    for (auto &id_action : task_action_map_by_id_) {
+      if (!id_action.second) {
+        continue;
+      }
+
+      rpc_method_slot_t &slot = slots[id_action.first & mask];
+      if (slot.action) {
+        has_conflict = true;
+        continue;
+      }
+
+      slot.rpc_method_id = id_action.first;
+      slot.action = id_action.second;
+    }
+
+    if (!has_conflict || slot_size >= PROJECT_SERVER_FRAME_DISPATCHER_RPC_METHOD_SLOT_MAX_SIZE) {
+      rpc_method_slot_mask_ = mask;
+      break;
+    }
+
+    slot_size <<= 1;
+  }
+
+  rpc_method_slots_.swap(slots);
+}
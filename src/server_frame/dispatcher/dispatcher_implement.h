@@ -30,6 +30,7 @@
 #include <list>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "dispatcher/dispatcher_type_defines.h"
 
@@ -146,6 +147,20 @@ class ATFW_UTIL_SYMBOL_VISIBLE dispatcher_implement : public ::atfw::atapp::modu
    */
   virtual const std::string &pick_rpc_name(msg_raw_t &raw_msg) = 0;
 
+  /**
+   * @brief 获取消息的RPC调度ID
+   * @param raw_msg 消息抽象结构
+   * @return 消息的RPC调度ID,如果不是RPC消息或者发送方没有设置，返回0
+   */
+  SERVER_FRAME_API virtual uint32_t pick_rpc_method_id(msg_raw_t &raw_msg);
+
+  /**
+   * @brief 根据RPC完整名称计算调度ID(FNV-1a 32)，必须和代码生成器里的算法一致
+   * @param rpc_full_name RPC完整名称
+   * @return 调度ID，不会返回0
+   */
+  SERVER_FRAME_API static uint32_t make_rpc_method_id(gsl::string_view rpc_full_name) noexcept;
+
   /**
    * @brief 创建协程任务
    * @param raw_msg 消息抽象结构
@@ -162,7 +177,8 @@ class ATFW_UTIL_SYMBOL_VISIBLE dispatcher_implement : public ::atfw::atapp::modu
    */
   template <typename TAction>
   ATFW_UTIL_SYMBOL_VISIBLE int register_action(
-      const ::ATBUS_MACRO_PROTOBUF_NAMESPACE_ID::ServiceDescriptor *service_desc, const std::string &rpc_name) {
+      const ::ATBUS_MACRO_PROTOBUF_NAMESPACE_ID::ServiceDescriptor *service_desc, const std::string &rpc_name,
+      uint32_t generated_rpc_method_id = 0) {
     if (nullptr == service_desc) {
       return PROJECT_NAMESPACE_ID::err::EN_SYS_PARAM;
     }
@@ -197,7 +213,14 @@ class ATFW_UTIL_SYMBOL_VISIBLE dispatcher_implement : public ::atfw::atapp::modu
       options = &method->options().GetExtension(atframework::rpc_options);
     }
 
-    return _register_action(method_full_name, task_manager::me()->make_task_creator<TAction>(options));
+    uint32_t rpc_method_id = make_rpc_method_id(method_full_name);
+    if (0 != generated_rpc_method_id && generated_rpc_method_id != rpc_method_id) {
+      FWLOGERROR("{} rpc action {} has generated method id {:#x}, but expect {:#x}, the generator may be outdated",
+                 name(), rpc_name, generated_rpc_method_id, rpc_method_id);
+    }
+
+    return _register_action(method_full_name, rpc_method_id,
+                            task_manager::me()->make_task_creator<TAction>(options));
   }
 
   /**
@@ -242,10 +265,23 @@ class ATFW_UTIL_SYMBOL_VISIBLE dispatcher_implement : public ::atfw::atapp::modu
   SERVER_FRAME_API int32_t convert_from_atapp_error_code(int32_t code);
 
  private:
-  SERVER_FRAME_API int _register_action(const std::string &rpc_full_name, task_manager::task_action_creator_t action);
+  SERVER_FRAME_API int _register_action(const std::string &rpc_full_name, uint32_t rpc_method_id,
+                                        task_manager::task_action_creator_t action);
+
+  void rebuild_rpc_method_slots();
 
  private:
+  struct rpc_method_slot_t {
+    uint32_t rpc_method_id;
+    task_manager::task_action_creator_t action;
+  };
+
   rpc_task_action_set_t task_action_map_by_name_;
+  // 按调度ID索引的平坦数组，下标为 rpc_method_id & rpc_method_slot_mask_ ，只在注册时重建
+  // 调度ID冲突的RPC不放进来，还是按名字查找
+  std::unordered_map<uint32_t, task_manager::task_action_creator_t> task_action_map_by_id_;
+  std::vector<rpc_method_slot_t> rpc_method_slots_;
+  uint32_t rpc_method_slot_mask_ = 0;
   rpc_service_set_t registered_service_;
   rpc_method_set_t registered_method_;
 
@@ -312,3 +348,10 @@ ATFW_UTIL_SYMBOL_VISIBLE TMsg *dispatcher_implement::get_protobuf_msg(msg_raw_t
   } else {                                                                \
     ret = dispatcher::me()->register_action<act>(service_desc, rpc_name); \
   }
+
+#define REG_TASK_RPC_HANDLE_WITH_ID(dispatcher, ret, act, service_desc, rpc_name, rpc_method_id) \
+  if (ret < 0) {                                                                                 \
+    dispatcher::me()->register_action<act>(service_desc, rpc_name, rpc_method_id);               \
+  } else {                                                                                       \
+    ret = dispatcher::me()->register_action<act>(service_desc, rpc_name, rpc_method_id);         \
+  }
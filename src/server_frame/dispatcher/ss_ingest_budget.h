@@ -0,0 +1,99 @@
+// Copyright 2026 atframework
+
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @brief 服务器消息接入的单轮事件循环预算
+ * @note 每轮事件循环开始(uv_prepare)时调用reset()，IO回调中直接处理的消息和check回调中处理的排队消息共用一份预算。
+ *       计时从本轮处理第一个消息时开始，不包含阻塞等待IO的时间
+ */
+class ss_ingest_budget {
+ public:
+  using clock_type = std::chrono::steady_clock;
+
+  /**
+   * @brief 新消息的接入方式
+   */
+  enum class admission : int8_t {
+    kAccept = 0,  // 直接处理或者排队
+    kRejectBusy,  // RPC请求，直接回复繁忙
+    kDrop,        // 不能回复的消息，直接丢弃
+  };
+
+ public:
+  ss_ingest_budget() noexcept : max_count_(0), max_time_(clock_type::duration::zero()), count_(0) {}
+
+  /**
+   * @brief 设置预算
+   * @param max_count 每轮最多处理的消息数量，0表示不限制
+   * @param max_time 每轮处理消息的最长时间，0表示不限制
+   */
+  inline void set_limit(size_t max_count, clock_type::duration max_time) noexcept {
+    max_count_ = max_count;
+    max_time_ = max_time;
+  }
+
+  /**
+   * @brief 新的一轮事件循环，重置预算
+   */
+  inline void reset() noexcept { count_ = 0; }
+
+  /**
+   * @brief 处理一个消息前调用，本轮的第一个消息开始计时
+   */
+  inline void consume(clock_type::time_point now) noexcept {
+    if (0 == count_) {
+      start_ = now;
+    }
+    ++count_;
+  }
+
+  /**
+   * @brief 本轮预算是否已经用完
+   */
+  inline bool is_exhausted(clock_type::time_point now) const noexcept {
+    if (max_count_ > 0 && count_ >= max_count_) {
+      return true;
+    }
+
+    if (0 == count_ || max_time_ <= clock_type::duration::zero()) {
+      return false;
+    }
+    return now - start_ >= max_time_;
+  }
+
+  inline size_t get_count() const noexcept { return count_; }
+
+  /**
+   * @brief 判定新的消息是否可以进入请求队列
+   * @note 回包用于恢复等待中的任务，总是接入；新的RPC请求超出限制时回复繁忙；其他消息没法回复，超出队列上限时丢弃
+   * @param is_rpc_request 是否是新的RPC请求
+   * @param is_resume 是否是恢复任务的回包
+   * @param pending_request_count 请求队列中的消息数量
+   * @param max_pending_request_count 请求队列的最大长度，0表示不限制
+   * @param is_busy 是否需要按繁忙拒绝新的RPC请求
+   */
+  static inline admission check_admission(bool is_rpc_request, bool is_resume, size_t pending_request_count,
+                                          size_t max_pending_request_count, bool is_busy) noexcept {
+    if (is_resume) {
+      return admission::kAccept;
+    }
+
+    bool is_full = max_pending_request_count > 0 && pending_request_count >= max_pending_request_count;
+    if (!is_rpc_request) {
+      return is_full ? admission::kDrop : admission::kAccept;
+    }
+
+    return (is_full || is_busy) ? admission::kRejectBusy : admission::kAccept;
+  }
+
+ private:
+  size_t max_count_;
+  clock_type::duration max_time_;
+  size_t count_;
+  clock_type::time_point start_;
+};
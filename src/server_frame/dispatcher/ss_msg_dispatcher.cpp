@@ -38,6 +38,7 @@
 #include <config/logic_config.h>
 
 #include <chrono>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -61,6 +62,8 @@ struct ATFW_UTIL_SYMBOL_LOCAL ss_rpc_mertrics_item {
 
 struct ATFW_UTIL_SYMBOL_LOCAL ss_rpc_mertrics_group {
   std::unordered_map<std::string, ss_rpc_mertrics_item> rpc_metrics;
+  // 按调度ID索引，指向 rpc_metrics 里的节点，避免每次都计算字符串hash
+  std::unordered_map<uint32_t, ss_rpc_mertrics_item *> rpc_metrics_by_id;
 };
 
 struct ATFW_UTIL_SYMBOL_LOCAL ss_rpc_mertrics_manager
@@ -80,7 +83,8 @@ struct ATFW_UTIL_SYMBOL_LOCAL ss_rpc_mertrics_manager
   ss_rpc_mertrics_manager() {}
 };
 
-static void rpc_metrics_mutable_record_rpc(const std::string &rpc_name, std::chrono::microseconds delay, size_t size) {
+static void rpc_metrics_mutable_record_rpc(uint32_t rpc_method_id, const std::string &rpc_name,
+                                           std::chrono::microseconds delay, size_t size) {
   if (ss_rpc_mertrics_manager::is_instance_destroyed()) {
     return;
   }
@@ -99,9 +103,26 @@ static void rpc_metrics_mutable_record_rpc(const std::string &rpc_name, std::chr
     return;
   }
 
-  auto iter = mgr.current_group->rpc_metrics.find(rpc_name);
-  if (iter != mgr.current_group->rpc_metrics.end()) {
-    auto &record = iter->second;
+  ss_rpc_mertrics_item *found = nullptr;
+  if (0 != rpc_method_id) {
+    auto id_iter = mgr.current_group->rpc_metrics_by_id.find(rpc_method_id);
+    if (id_iter != mgr.current_group->rpc_metrics_by_id.end() && nullptr != id_iter->second &&
+        id_iter->second->rpc_name == rpc_name) {
+      found = id_iter->second;
+    }
+  }
+  if (nullptr == found) {
+    auto iter = mgr.current_group->rpc_metrics.find(rpc_name);
+    if (iter != mgr.current_group->rpc_metrics.end()) {
+      found = &iter->second;
+      if (0 != rpc_method_id) {
+        mgr.current_group->rpc_metrics_by_id[rpc_method_id] = found;
+      }
+    }
+  }
+
+  if (nullptr != found) {
+    auto &record = *found;
     if (delay < record.min_delay) {
       record.min_delay = delay;
     }
@@ -119,6 +140,9 @@ static void rpc_metrics_mutable_record_rpc(const std::string &rpc_name, std::chr
     record.total_delay = delay;
     record.total_bytes = size;
     record.total_count = 1;
+    if (0 != rpc_method_id) {
+      mgr.current_group->rpc_metrics_by_id[rpc_method_id] = &record;
+    }
   }
 }
 
@@ -159,7 +183,12 @@ ATFW_UTIL_DESIGN_PATTERN_SINGLETON_IMPORT_DATA_DEFINITION(ss_msg_dispatcher);
 ATFW_UTIL_DESIGN_PATTERN_SINGLETON_VISIBLE_DATA_DEFINITION(ss_msg_dispatcher);
 #endif
 
-SERVER_FRAME_API ss_msg_dispatcher::ss_msg_dispatcher() : sequence_allocator_(0) {}
+SERVER_FRAME_API ss_msg_dispatcher::ss_msg_dispatcher()
+    : sequence_allocator_(0), ingest_handles_inited_(false), ingest_idle_running_(false) {
+  memset(&ingest_prepare_handle_, 0, sizeof(ingest_prepare_handle_));
+  memset(&ingest_check_handle_, 0, sizeof(ingest_check_handle_));
+  memset(&ingest_idle_handle_, 0, sizeof(ingest_idle_handle_));
+}
 
 SERVER_FRAME_API ss_msg_dispatcher::~ss_msg_dispatcher() {}
 
@@ -176,6 +205,11 @@ SERVER_FRAME_API const char *ss_msg_dispatcher::name() const { return "ss_msg_di
 
 SERVER_FRAME_API int ss_msg_dispatcher::stop() {
   int ret = dispatcher_implement::stop();
+
+  // 停服时不再限制预算，排队的消息全部处理掉
+  drain_pending_messages(true);
+  close_ingest_handles();
+
   if (!running_dns_lookup_.empty()) {
     ret = 1;
 
@@ -192,6 +226,8 @@ SERVER_FRAME_API int ss_msg_dispatcher::stop() {
 SERVER_FRAME_API void ss_msg_dispatcher::ready() {
   // setup metrics
   setup_metrics();
+
+  setup_ingest_handles();
 }
 
 SERVER_FRAME_API int ss_msg_dispatcher::tick() {
@@ -262,6 +298,29 @@ SERVER_FRAME_API const std::string &ss_msg_dispatcher::pick_rpc_name(const atfra
   return get_empty_string();
 }
 
+SERVER_FRAME_API uint32_t ss_msg_dispatcher::pick_rpc_method_id(msg_raw_t &raw_msg) {
+  atframework::SSMsg *real_msg = get_protobuf_msg<atframework::SSMsg>(raw_msg);
+  if (nullptr == real_msg || !real_msg->has_head()) {
+    return 0;
+  }
+
+  switch (real_msg->head().rpc_type_case()) {
+    case atframework::SSMsgHead::kRpcRequest: {
+      return real_msg->head().rpc_request().rpc_method_id();
+    }
+    case atframework::SSMsgHead::kRpcStream: {
+      return real_msg->head().rpc_stream().rpc_method_id();
+    }
+    case atframework::SSMsgHead::kRpcResponse: {
+      return real_msg->head().rpc_response().rpc_method_id();
+    }
+    default:
+      break;
+  }
+
+  return 0;
+}
+
 SERVER_FRAME_API int32_t ss_msg_dispatcher::send_to_proc(uint64_t node_id, atframework::SSMsg &ss_msg,
                                                          bool ignore_discovery) {
   atfw::atapp::app *owner = get_app();
@@ -529,7 +588,8 @@ SERVER_FRAME_API int32_t ss_msg_dispatcher::dispatch(const atfw::atapp::app::mes
 
   uint64_t from_server_id = source.id;
 
-  rpc::context ctx{rpc::context::create_without_task()};
+  std::unique_ptr<rpc::context> ctx_holder{new rpc::context(rpc::context::create_without_task())};
+  rpc::context &ctx = *ctx_holder;
   atframework::SSMsg *ss_msg = ctx.create<atframework::SSMsg>();
   if (nullptr == ss_msg) {
     FWLOGERROR("{} create message instance failed", name());
@@ -574,16 +634,55 @@ SERVER_FRAME_API int32_t ss_msg_dispatcher::dispatch(const atfw::atapp::app::mes
       break;
     }
 
-    rpc_metrics_mutable_record_rpc(rpc_response.rpc_name(), delay, ss_msg->body_bin().size());
+    rpc_metrics_mutable_record_rpc(rpc_response.rpc_method_id(), rpc_response.rpc_name(), delay,
+                                   ss_msg->body_bin().size());
   } while (false);
 
+  // 新请求在过载时直接回复繁忙，避免排队到超时
+  switch (check_ingest_admission(*ss_msg, false)) {
+    case ss_ingest_budget::admission::kRejectBusy:
+      shed_request(ctx, *ss_msg, callback_msg);
+      return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+    case ss_ingest_budget::admission::kDrop:
+      FWLOGERROR("{} too many pending messages and drop message from [{:#x}: {}], pending requests: {}", name(),
+                 ss_msg->head().node_id(), ss_msg->head().node_name(), pending_request_messages_.size());
+      return PROJECT_NAMESPACE_ID::err::EN_SYS_BUSY;
+    default:
+      break;
+  }
+
+  // 没有排队的消息且本轮预算没用完时直接处理，否则进入接入队列等待下一轮事件循环
+  bool is_resume = 0 != ss_msg->head().destination_task_id();
+  if (!ingest_handles_inited_ ||
+      (pending_resume_messages_.empty() && (is_resume || pending_request_messages_.empty()) &&
+       !is_ingest_budget_exhausted())) {
+    ingest_budget_.consume(ss_ingest_budget::clock_type::now());
+    return dispatch_message(ctx, *ss_msg, callback_msg, from_server_id);
+  }
+
+  pending_message_t pending_message;
+  pending_message.context = std::move(ctx_holder);
+  pending_message.message = ss_msg;
+  pending_message.raw_message = callback_msg;
+  pending_message.from_server_id = from_server_id;
+  if (is_resume) {
+    pending_resume_messages_.emplace_back(std::move(pending_message));
+  } else {
+    pending_request_messages_.emplace_back(std::move(pending_message));
+  }
+
+  return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+}
+
+int32_t ss_msg_dispatcher::dispatch_message(rpc::context &ctx, atframework::SSMsg &ss_msg,
+                                            dispatcher_raw_message &callback_msg, uint64_t from_server_id) {
   rpc::telemetry::tracer tracer;
   rpc::telemetry::trace_start_option trace_start_option;
   trace_start_option.kind = ::atframework::RpcTraceSpan::SPAN_KIND_SERVER;
   trace_start_option.is_remote = true;
   trace_start_option.dispatcher = std::static_pointer_cast<dispatcher_implement>(ss_msg_dispatcher::me());
-  if (ss_msg->head().has_rpc_trace()) {
-    trace_start_option.parent_network_span = &ss_msg->head().rpc_trace();
+  if (ss_msg.head().has_rpc_trace()) {
+    trace_start_option.parent_network_span = &ss_msg.head().rpc_trace();
   } else {
     trace_start_option.parent_network_span = nullptr;
   }
@@ -594,8 +693,8 @@ SERVER_FRAME_API int32_t ss_msg_dispatcher::dispatch(const atfw::atapp::app::mes
   trace_start_option.attributes = internal_rpc_trace_attributes;
   ctx.setup_tracer(tracer, "ss_msg_dispatcher", std::move(trace_start_option));
 
-  dispatcher_result_t res = on_receive_message(ctx, callback_msg, nullptr, ss_msg->head().sequence());
-  ret = res.result_code;
+  dispatcher_result_t res = on_receive_message(ctx, callback_msg, nullptr, ss_msg.head().sequence());
+  int32_t ret = res.result_code;
   if (ret < 0) {
     FWLOGERROR("{} dispatch message from [{:#x}: {}] failed, res: {}", name(), from_server_id,
                get_app()->convert_app_id_to_string(from_server_id), ret);
@@ -604,6 +703,154 @@ SERVER_FRAME_API int32_t ss_msg_dispatcher::dispatch(const atfw::atapp::app::mes
   return tracer.finish({ret, {}});
 }
 
+ss_ingest_budget::admission ss_msg_dispatcher::check_ingest_admission(const atframework::SSMsg &ss_msg,
+                                                                       bool is_queued) const {
+  bool is_rpc_request = ss_msg.head().has_rpc_request();
+  bool is_resume = 0 != ss_msg.head().destination_task_id();
+  const auto &ingest_cfg = logic_config::me()->get_cfg_task().ss_ingest();
+  bool is_busy =
+      is_rpc_request && !is_resume && ingest_cfg.shed_request_when_busy() && task_manager::me()->is_busy();
+
+  // 已经排队的消息不再按队列长度判定
+  return ss_ingest_budget::check_admission(
+      is_rpc_request, is_resume, is_queued ? 0 : pending_request_messages_.size(),
+      is_queued ? 0 : static_cast<size_t>(ingest_cfg.max_pending_request_count()), is_busy);
+}
+
+void ss_msg_dispatcher::shed_request(rpc::context &ctx, atframework::SSMsg &ss_msg,
+                                     dispatcher_raw_message &callback_msg) {
+  FWLOGWARNING("{} server busy and reject rpc {} from [{:#x}: {}], pending requests: {}", name(),
+               ss_msg.head().rpc_request().rpc_name(), ss_msg.head().node_id(), ss_msg.head().node_name(),
+               pending_request_messages_.size());
+
+  dispatcher_start_data_type start_data = dispatcher_make_default<dispatcher_start_data_type>();
+  start_data.message = callback_msg;
+  start_data.context = &ctx;
+  on_create_task_failed(start_data, PROJECT_NAMESPACE_ID::EN_ERR_SYSTEM_BUSY);
+}
+
+void ss_msg_dispatcher::setup_ingest_handles() {
+  if (ingest_handles_inited_) {
+    return;
+  }
+
+  uv_loop_t *loop = nullptr;
+  if (nullptr != get_app() && get_app()->get_bus_node()) {
+    loop = get_app()->get_bus_node()->get_evloop();
+  }
+  if (nullptr == loop) {
+    FWLOGWARNING("{} can not find event loop, ss messages will be dispatched without budget", name());
+    return;
+  }
+
+  // prepare在每次事件循环等待IO前触发，用于重置预算。IO回调和check回调共用一份预算
+  uv_prepare_init(loop, &ingest_prepare_handle_);
+  ingest_prepare_handle_.data = this;
+  uv_prepare_start(&ingest_prepare_handle_, on_ingest_prepare);
+  uv_unref(reinterpret_cast<uv_handle_t *>(&ingest_prepare_handle_));
+
+  // check在每次事件循环处理完IO后触发，用剩余的预算处理排队的消息
+  uv_check_init(loop, &ingest_check_handle_);
+  ingest_check_handle_.data = this;
+  uv_check_start(&ingest_check_handle_, on_ingest_check);
+  uv_unref(reinterpret_cast<uv_handle_t *>(&ingest_check_handle_));
+
+  // 还有排队的消息时启动idle，让下一次事件循环不阻塞等待IO
+  uv_idle_init(loop, &ingest_idle_handle_);
+  ingest_idle_handle_.data = this;
+
+  ingest_handles_inited_ = true;
+  ingest_idle_running_ = false;
+  ingest_budget_.reset();
+}
+
+void ss_msg_dispatcher::close_ingest_handles() {
+  if (!ingest_handles_inited_) {
+    return;
+  }
+  ingest_handles_inited_ = false;
+
+  if (ingest_idle_running_) {
+    uv_idle_stop(&ingest_idle_handle_);
+    ingest_idle_running_ = false;
+  }
+  uv_prepare_stop(&ingest_prepare_handle_);
+  uv_check_stop(&ingest_check_handle_);
+  uv_close(reinterpret_cast<uv_handle_t *>(&ingest_idle_handle_), nullptr);
+  uv_close(reinterpret_cast<uv_handle_t *>(&ingest_check_handle_), nullptr);
+  uv_close(reinterpret_cast<uv_handle_t *>(&ingest_prepare_handle_), nullptr);
+}
+
+bool ss_msg_dispatcher::is_ingest_budget_exhausted() const {
+  return ingest_budget_.is_exhausted(ss_ingest_budget::clock_type::now());
+}
+
+size_t ss_msg_dispatcher::drain_pending_messages(bool ignore_budget) {
+  size_t ret = 0;
+  while (!pending_resume_messages_.empty() || !pending_request_messages_.empty()) {
+    if (!ignore_budget && is_ingest_budget_exhausted()) {
+      break;
+    }
+
+    std::deque<pending_message_t> &lane =
+        pending_resume_messages_.empty() ? pending_request_messages_ : pending_resume_messages_;
+    pending_message_t pending_message = std::move(lane.front());
+    lane.pop_front();
+
+    ++ret;
+    ingest_budget_.consume(ss_ingest_budget::clock_type::now());
+
+    // 排队期间可能已经过载了
+    if (!ignore_budget && &lane == &pending_request_messages_ &&
+        ss_ingest_budget::admission::kRejectBusy == check_ingest_admission(*pending_message.message, true)) {
+      shed_request(*pending_message.context, *pending_message.message, pending_message.raw_message);
+      continue;
+    }
+
+    dispatch_message(*pending_message.context, *pending_message.message, pending_message.raw_message,
+                     pending_message.from_server_id);
+  }
+
+  return ret;
+}
+
+void ss_msg_dispatcher::on_ingest_prepare(uv_prepare_t *handle) {
+  ss_msg_dispatcher *self = reinterpret_cast<ss_msg_dispatcher *>(handle->data);
+  if (nullptr == self) {
+    return;
+  }
+
+  // 新的一轮事件循环，重置预算。计时从本轮第一个消息开始，不包含等待IO的时间
+  const auto &ingest_cfg = logic_config::me()->get_cfg_task().ss_ingest();
+  self->ingest_budget_.set_limit(static_cast<size_t>(ingest_cfg.max_count_per_loop()),
+                                 std::chrono::duration_cast<ss_ingest_budget::clock_type::duration>(
+                                     rpc::make_duration(ingest_cfg.max_time_per_loop())));
+  self->ingest_budget_.reset();
+}
+
+void ss_msg_dispatcher::on_ingest_check(uv_check_t *handle) {
+  ss_msg_dispatcher *self = reinterpret_cast<ss_msg_dispatcher *>(handle->data);
+  if (nullptr == self) {
+    return;
+  }
+
+  // 不重置预算，IO回调中直接处理的消息已经占用了本轮的预算
+  self->drain_pending_messages(false);
+
+  bool has_pending = !self->pending_resume_messages_.empty() || !self->pending_request_messages_.empty();
+  if (has_pending && !self->ingest_idle_running_) {
+    uv_idle_start(&self->ingest_idle_handle_, on_ingest_idle);
+    self->ingest_idle_running_ = true;
+  } else if (!has_pending && self->ingest_idle_running_) {
+    uv_idle_stop(&self->ingest_idle_handle_);
+    self->ingest_idle_running_ = false;
+  }
+}
+
+void ss_msg_dispatcher::on_ingest_idle(uv_idle_t *) {
+  // 只用于让事件循环不阻塞，排队的消息在check回调里处理
+}
+
 SERVER_FRAME_API int32_t ss_msg_dispatcher::on_receive_send_data_response(
     const atfw::atapp::app::message_sender_t &source, const atfw::atapp::app::message_t &msg, int32_t error_code) {
   if (::atframework::component::message_type::EN_ATST_SS_MSG != msg.type) {
@@ -719,6 +966,7 @@ SERVER_FRAME_API void ss_msg_dispatcher::on_create_task_failed(dispatcher_start_
     }
     rpc_response->set_version(logic_config::me()->get_atframework_settings().rpc_version());
     rpc_response->set_rpc_name(rpc_name);
+    rpc_response->set_rpc_method_id(real_msg->head().rpc_request().rpc_method_id());
     const ::ATBUS_MACRO_PROTOBUF_NAMESPACE_ID::MethodDescriptor *method = get_registered_method(rpc_name);
     if (nullptr != method) {
       rpc_response->set_type_url(method->output_type()->full_name());
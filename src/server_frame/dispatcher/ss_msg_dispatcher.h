@@ -19,10 +19,14 @@
 #include <gsl/select-gsl.h>
 #include <mem_pool/lru_map.h>
 
+#include <chrono>
+#include <deque>
+#include <memory>
 #include <string>
 
 #include "dispatcher/dispatcher_implement.h"
 #include "dispatcher/dispatcher_type_defines.h"
+#include "dispatcher/ss_ingest_budget.h"
 
 namespace atframework {
 namespace atbus {
@@ -106,6 +110,13 @@ class ss_msg_dispatcher : public dispatcher_implement {
 
   SERVER_FRAME_API const std::string &pick_rpc_name(const atframework::SSMsg &ss_msg);
 
+  /**
+   * @brief 获取消息的RPC调度ID
+   * @param raw_msg 消息抽象结构
+   * @return 消息的RPC调度ID,如果不是RPC消息或者发送方没有设置，返回0
+   */
+  SERVER_FRAME_API uint32_t pick_rpc_method_id(msg_raw_t &raw_msg) override;
+
   /**
    * deal with cs message data
    * @param source data source wrapper
@@ -165,6 +176,45 @@ class ss_msg_dispatcher : public dispatcher_implement {
  private:
   void setup_metrics();
 
+  struct pending_message_t {
+    std::unique_ptr<rpc::context> context;
+    atframework::SSMsg *message;
+    dispatcher_raw_message raw_message;
+    uint64_t from_server_id;
+  };
+
+  int32_t dispatch_message(rpc::context &ctx, atframework::SSMsg &ss_msg, dispatcher_raw_message &callback_msg,
+                           uint64_t from_server_id);
+
+  /**
+   * @brief 判定消息是否可以接入，新请求过载时回复繁忙，没法回复的消息在请求队列满时丢弃
+   * @param ss_msg 消息
+   * @param is_queued 是否是已经在请求队列中的消息，这时只需要检查是否繁忙
+   * @return 接入方式
+   */
+  ss_ingest_budget::admission check_ingest_admission(const atframework::SSMsg &ss_msg, bool is_queued) const;
+
+  void shed_request(rpc::context &ctx, atframework::SSMsg &ss_msg, dispatcher_raw_message &callback_msg);
+
+  void setup_ingest_handles();
+  void close_ingest_handles();
+
+  /**
+   * @brief 当前事件循环的处理预算是否已经用完
+   */
+  bool is_ingest_budget_exhausted() const;
+
+  /**
+   * @brief 按预算处理排队的消息，恢复任务的回包优先
+   * @param ignore_budget 是否忽略预算(停服时使用)
+   * @return 处理的消息数量
+   */
+  size_t drain_pending_messages(bool ignore_budget);
+
+  static void on_ingest_prepare(uv_prepare_t *handle);
+  static void on_ingest_check(uv_check_t *handle);
+  static void on_ingest_idle(uv_idle_t *handle);
+
   static void dns_lookup_callback(uv_getaddrinfo_t *req, int status, struct addrinfo *res) noexcept;
 
  public:
@@ -185,6 +235,17 @@ class ss_msg_dispatcher : public dispatcher_implement {
   };
 
   atfw::util::mempool::lru_map<uint64_t, dns_lookup_async_data> running_dns_lookup_;
+
+  // 服务器消息接入队列，每次事件循环按预算分批处理
+  // 恢复协程任务的回包和新请求分开排队，回包优先处理
+  std::deque<pending_message_t> pending_resume_messages_;
+  std::deque<pending_message_t> pending_request_messages_;
+  uv_prepare_t ingest_prepare_handle_;
+  uv_check_t ingest_check_handle_;
+  uv_idle_t ingest_idle_handle_;
+  bool ingest_handles_inited_;
+  bool ingest_idle_running_;
+  ss_ingest_budget ingest_budget_;
 };
 
 #endif  // ATF4G_CO_SS_MSG_DISPATCHER_H
@@ -270,11 +270,13 @@ SERVER_FRAME_API task_action_cs_req_base::msg_ref_type task_action_cs_req_base::
   if (get_request().head().has_rpc_request()) {
     head->mutable_rpc_response()->set_version(logic_config::me()->get_atframework_settings().rpc_version());
     head->mutable_rpc_response()->set_rpc_name(get_request().head().rpc_request().rpc_name());
+    head->mutable_rpc_response()->set_rpc_method_id(get_request().head().rpc_request().rpc_method_id());
     head->mutable_rpc_response()->set_type_url(response_type_url.data(), response_type_url.size());
   } else {
     head->clear_rpc_stream();
     head->mutable_rpc_stream()->set_version(logic_config::me()->get_atframework_settings().rpc_version());
     head->mutable_rpc_stream()->set_rpc_name(get_request().head().rpc_stream().rpc_name());
+    head->mutable_rpc_stream()->set_rpc_method_id(get_request().head().rpc_stream().rpc_method_id());
     head->mutable_rpc_stream()->set_type_url(response_type_url.data(), response_type_url.size());
 
     head->mutable_rpc_stream()->set_caller(static_cast<std::string>(logic_config::me()->get_local_server_name()));
@@ -522,6 +522,7 @@ SERVER_FRAME_API atframework::SSMsg &task_action_ss_req_base::add_response_messa
       }
       rpc_response->set_version(logic_config::me()->get_atframework_settings().rpc_version());
       rpc_response->set_rpc_name(get_request().head().rpc_request().rpc_name());
+      rpc_response->set_rpc_method_id(get_request().head().rpc_request().rpc_method_id());
       rpc_response->set_type_url(response_type_url.data(), response_type_url.size());
       rpc_response->set_caller_node_id(get_request_node_id());
       rpc_response->set_caller_node_name(get_request_node_name());
@@ -537,6 +538,7 @@ SERVER_FRAME_API atframework::SSMsg &task_action_ss_req_base::add_response_messa
       }
       rpc_stream->set_version(logic_config::me()->get_atframework_settings().rpc_version());
       rpc_stream->set_rpc_name(get_request().head().rpc_stream().rpc_name());
+      rpc_stream->set_rpc_method_id(get_request().head().rpc_stream().rpc_method_id());
       rpc_stream->set_type_url(response_type_url.data(), response_type_url.size());
       rpc_stream->set_caller(static_cast<std::string>(logic_config::me()->get_local_server_name()));
       rpc_stream->set_callee(get_request().head().rpc_stream().caller());
@@ -251,3 +251,28 @@ SERVER_FRAME_API int32_t session_manager::broadcast_msg_to_client(const atframew
 
   return ret;
 }
+
+SERVER_FRAME_API int32_t session_manager::multicast_msg_to_client(const std::vector<sess_ptr_t> &sessions,
+                                                                  const atframework::CSMsg &msg) {
+  // group by gateway, each gateway receive only one post message
+  std::unordered_map<uint64_t, std::vector<uint64_t>> gateway_sessions;
+  for (auto &sess : sessions) {
+    if (!sess || !sess->is_valid()) {
+      continue;
+    }
+
+    gateway_sessions[sess->get_key().node_id].push_back(sess->get_key().session_id);
+  }
+
+  int32_t ret = 0;
+  for (auto &gateway : gateway_sessions) {
+    int32_t res = session::multicast_msg_to_client(gateway.first, gateway.second, msg);
+    if (res < 0) {
+      ret = res;
+      FWLOGERROR("multicast msg to {} sessions of gateway [{:#x}] failed, res: {}", gateway.second.size(),
+                 gateway.first, res);
+    }
+  }
+
+  return ret;
+}
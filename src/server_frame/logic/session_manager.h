@@ -56,6 +56,15 @@ class session_manager {
 
   SERVER_FRAME_API int32_t broadcast_msg_to_client(const atframework::CSMsg& msg);
 
+  /**
+   * @brief 发送消息给一组session，同一个gateway的session只会发送一次
+   * @param sessions 目标session列表
+   * @param msg 消息
+   * @return 0或错误码
+   */
+  SERVER_FRAME_API int32_t multicast_msg_to_client(const std::vector<sess_ptr_t>& sessions,
+                                                   const atframework::CSMsg& msg);
+
  private:
   session_counter_t session_counter_;
   session_index_t all_sessions_;
@@ -24,6 +24,7 @@
 #include <rpc/rpc_async_invoke.h>
 #include <utility/protobuf_mini_dumper.h>
 
+#include <list>
 #include <utility>
 #include <vector>
 
@@ -59,25 +60,15 @@ task_action_auto_save_objects::result_type task_action_auto_save_objects::operat
   status_data_->action_remove_cache_count = 0;
   status_data_->action_save_count = 0;
   uint64_t left_action_count = logic_config::me()->get_cfg_router().pending_action_max_count();
-  uint64_t pending_action_batch_count = logic_config::me()->get_cfg_router().pending_action_batch_count();
-  std::vector<task_type_trait::task_type> pending_action_batch_tasks;
-  pending_action_batch_tasks.reserve(pending_action_batch_count);
+  size_t pending_action_batch_count =
+      static_cast<size_t>(logic_config::me()->get_cfg_router().pending_action_batch_count());
+  size_t pending_save_window = static_cast<size_t>(logic_config::me()->get_cfg_router().pending_save_window());
 
-  while (left_action_count > 0) {
-    --left_action_count;
-    atfw::util::time::time_utility::update();
-    if (router_manager_set::me()->pending_action_list_.empty()) {
-      break;
-    }
-
-    std::shared_ptr<status_data_t> status_data = status_data_;
-    auto invoke_task = rpc::async_invoke(
+  std::shared_ptr<status_data_t> status_data = status_data_;
+  auto invoke_action = [this, &status_data](router_manager_set::pending_action_data &&action) {
+    return rpc::async_invoke(
         get_shared_context(), "task_action_auto_save_objects",
-        [status_data](rpc::context &ctx) -> rpc::result_code_type {
-          router_manager_set::pending_action_data auto_save =
-              std::move(router_manager_set::me()->pending_action_list_.front());
-          router_manager_set::me()->pending_action_list_.pop_front();
-
+        [status_data, auto_save = std::move(action)](rpc::context &ctx) -> rpc::result_code_type {
           // 如果已下线并且用户缓存失效则跳过
           if (!auto_save.object) {
             RPC_RETURN_CODE(0);
@@ -185,35 +176,54 @@ task_action_auto_save_objects::result_type task_action_auto_save_objects::operat
 
           RPC_RETURN_CODE(0);
         });
-    bool need_wait = false;
+  };
+
+  // 每个对象的保存仍然走自己的io_task_guard排队，这里只控制同时进行中的任务数量(保存和其他动作分别使用自己的窗口)。
+  // 前面的任务完成后立即补充新任务，避免整批等待导致延迟随队列长度线性增长。
+  std::list<task_type_trait::task_type> running_tasks;
+  auto start_action = [&running_tasks](rpc::async_invoke_result &&invoke_task) {
     if (invoke_task.is_success()) {
       if (!task_type_trait::is_exiting(*invoke_task.get_success())) {
-        pending_action_batch_tasks.emplace_back(std::move(*invoke_task.get_success()));
+        running_tasks.emplace_back(std::move(*invoke_task.get_success()));
       }
     } else {
-      need_wait = true;
+      FWLOGERROR("start auto save sub task failed, result: {}", *invoke_task.get_error());
     }
-    if (pending_action_batch_tasks.size() >= pending_action_batch_count) {
-      need_wait = true;
+  };
+
+  // 按入队顺序处理，动作真正发出时才从队列中移除。任务被杀死或者超时的时候，还没发出的动作会保留到下一轮。
+  // 保存请求在同一个连接上连续发出，不需要等待前一个请求的回包，所以窗口内的保存在连接上就是流水线执行的。
+  while (left_action_count > 0 && !router_manager_set::me()->pending_action_list_.empty()) {
+    --left_action_count;
+
+    size_t window = pending_action_batch_count;
+    if (router_manager_set::EN_ASA_SAVE == router_manager_set::me()->pending_action_list_.front().action) {
+      window = pending_save_window;
+    }
+    auto wait_result = RPC_AWAIT_CODE_RESULT(wait_running_tasks(running_tasks, window));
+    if (wait_result < 0) {
+      FWLOGERROR("Wait sub tasks failed, result: {}({})", wait_result, protobuf_mini_dumper_get_error_msg(wait_result));
     }
 
-    if (need_wait) {
-      auto wait_result = RPC_AWAIT_CODE_RESULT(rpc::wait_tasks(get_shared_context(), pending_action_batch_tasks));
-      pending_action_batch_tasks.clear();
-      if (wait_result < 0) {
-        FWLOGERROR("Wait sub tasks to failed, result: {}({})", wait_result,
-                   protobuf_mini_dumper_get_error_msg(wait_result));
-      }
+    TASK_COMPAT_ASSIGN_CURRENT_STATUS(current_status);
+    if (task_manager::convert_task_status_to_error_code(current_status) < 0) {
+      break;
     }
-  }
 
-  if (!pending_action_batch_tasks.empty()) {
-    auto wait_result = RPC_AWAIT_CODE_RESULT(rpc::wait_tasks(get_shared_context(), pending_action_batch_tasks));
-    pending_action_batch_tasks.clear();
-    if (wait_result < 0) {
-      FWLOGERROR("Wait sub tasks to remove_object failed, result: {}({})", wait_result,
-                 protobuf_mini_dumper_get_error_msg(wait_result));
+    atfw::util::time::time_utility::update();
+    if (router_manager_set::me()->pending_action_list_.empty()) {
+      break;
     }
+    router_manager_set::pending_action_data auto_save =
+        std::move(router_manager_set::me()->pending_action_list_.front());
+    router_manager_set::me()->pending_action_list_.pop_front();
+    start_action(invoke_action(std::move(auto_save)));
+  }
+
+  auto wait_result = RPC_AWAIT_CODE_RESULT(wait_running_tasks(running_tasks, 0));
+  if (wait_result < 0) {
+    FWLOGERROR("Wait sub tasks to finish failed, result: {}({})", wait_result,
+               protobuf_mini_dumper_get_error_msg(wait_result));
   }
 
   TASK_ACTION_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SUCCESS);
@@ -288,6 +298,28 @@ int task_action_auto_save_objects::on_complete() {
   return 0;
 }
 
+rpc::result_code_type task_action_auto_save_objects::wait_running_tasks(
+    std::list<task_type_trait::task_type> &running_tasks, size_t max_running_count) {
+  rpc::result_code_type::value_type ret = 0;
+  while (!running_tasks.empty()) {
+    task_type_trait::task_type &front_task = running_tasks.front();
+    if (!task_type_trait::is_exiting(front_task)) {
+      if (running_tasks.size() < max_running_count) {
+        break;
+      }
+
+      auto res = RPC_AWAIT_CODE_RESULT(rpc::wait_task(get_shared_context(), front_task));
+      if (res < 0 && 0 == ret) {
+        ret = res;
+      }
+    }
+
+    running_tasks.pop_front();
+  }
+
+  RPC_RETURN_CODE(ret);
+}
+
 const char *task_action_auto_save_objects::get_action_name(uint32_t act) {
   switch (act) {
     case router_manager_set::EN_ASA_SAVE: {
@@ -6,8 +6,11 @@
 
 #include <dispatcher/task_action_no_req_base.h>
 
+#include <list>
 #include <memory>
 
+#include "rpc/rpc_common_types.h"
+
 class task_action_auto_save_objects : public task_action_no_req_base {
  public:
   struct ctor_param_t : public task_action_no_req_base::ctor_param_t {};
@@ -32,6 +35,13 @@ class task_action_auto_save_objects : public task_action_no_req_base {
  private:
   static const char* get_action_name(uint32_t);
 
+  /**
+   * @brief 等待进行中的子任务，直到数量小于max_running_count
+   * @note 按启动顺序等待，前面的任务完成后就可以启动新的任务，而不需要等待整批任务完成
+   */
+  EXPLICIT_NODISCARD_ATTR rpc::result_code_type wait_running_tasks(std::list<task_type_trait::task_type>& running_tasks,
+                                                                   size_t max_running_count);
+
  private:
   struct status_data_t {
     size_t success_count_;
@@ -22,7 +22,6 @@
 #include <list>
 #include <memory>
 #include <sstream>
-#include <unordered_set>
 #include <utility>
 
 #include "router/action/task_action_auto_save_objects.h"
@@ -81,33 +80,29 @@ SERVER_FRAME_API int router_manager_set::tick() {
   // 每分钟打印一次统计数据
   if (last_proc_time_ / atfw::util::time::time_utility::MINITE_SECONDS !=
       atfw::util::time::time_utility::get_sys_now() / atfw::util::time::time_utility::MINITE_SECONDS) {
-    std::stringstream ss;
-    ss << "[STATISTICS] router manager set => now: " << atfw::util::time::time_utility::get_sys_now() << std::endl;
-    ss << "\tdefault timer count: " << timers_.default_timer_list.size() << ", next active timer: ";
-    if (timers_.default_timer_list.empty()) {
-      ss << 0 << std::endl;
-    } else {
-      ss << timers_.default_timer_list.front().timeout << std::endl;
-    }
-    ss << "\tfast timer count: " << timers_.fast_timer_list.size() << ", next active timer: ";
-    if (timers_.fast_timer_list.empty()) {
-      ss << 0 << std::endl;
-    } else {
-      ss << timers_.fast_timer_list.front().timeout << std::endl;
-    }
-
-    for (int i = 0; i < PROJECT_NAMESPACE_ID::EnRouterObjectType_ARRAYSIZE; ++i) {
-      if (mgrs_[i]) {
-        ss << "\t" << mgrs_[i]->name() << " has " << mgrs_[i]->size() << " cache(s)" << std::endl;
-      }
-    }
-
-    metrics_data_.default_timer_count.store(static_cast<int64_t>(timers_.default_timer_list.size()),
+    metrics_data_.default_timer_count.store(static_cast<int64_t>(timers_.default_timer_wheel.size()),
                                             std::memory_order_release);
-    metrics_data_.fast_timer_count.store(static_cast<int64_t>(timers_.fast_timer_list.size()),
+    metrics_data_.fast_timer_count.store(static_cast<int64_t>(timers_.fast_timer_wheel.size()),
                                          std::memory_order_release);
 
-    FWLOGWARNING("{}", ss.str());
+    // 日志等级没开启时不需要拼接统计文本
+    if (util::log::log_wrapper::check_level(WDTLOGGETCAT(util::log::log_wrapper::categorize_t::DEFAULT),
+                                            util::log::log_wrapper::level_t::LOG_LW_WARNING)) {
+      std::stringstream ss;
+      ss << "[STATISTICS] router manager set => now: " << atfw::util::time::time_utility::get_sys_now() << std::endl;
+      ss << "\tdefault timer count: " << timers_.default_timer_wheel.size()
+         << ", next active timer: " << timers_.default_timer_wheel.get_next_timeout() << std::endl;
+      ss << "\tfast timer count: " << timers_.fast_timer_wheel.size()
+         << ", next active timer: " << timers_.fast_timer_wheel.get_next_timeout() << std::endl;
+
+      for (int i = 0; i < PROJECT_NAMESPACE_ID::EnRouterObjectType_ARRAYSIZE; ++i) {
+        if (mgrs_[i]) {
+          ss << "\t" << mgrs_[i]->name() << " has " << mgrs_[i]->size() << " cache(s)" << std::endl;
+        }
+      }
+
+      FWLOGWARNING("{}", ss.str());
+    }
   }
   last_proc_time_ = atfw::util::time::time_utility::get_sys_now();
 
@@ -116,9 +111,10 @@ SERVER_FRAME_API int router_manager_set::tick() {
     time_t cache_expire = logic_config::me()->get_cfg_router().cache_free_timeout().seconds();
     time_t object_expire = logic_config::me()->get_cfg_router().object_free_timeout().seconds();
     time_t object_save = logic_config::me()->get_cfg_router().object_save_interval().seconds();
+    size_t max_count = static_cast<size_t>(logic_config::me()->get_cfg_router().timer_tick_max_count());
     // 缓存失效定时器
-    ret += tick_timer(cache_expire, object_expire, object_save, timers_.default_timer_list, false);
-    ret += tick_timer(cache_expire, object_expire, object_save, timers_.fast_timer_list, true);
+    ret += tick_timer(cache_expire, object_expire, object_save, timers_.default_timer_wheel, false, max_count);
+    ret += tick_timer(cache_expire, object_expire, object_save, timers_.fast_timer_wheel, true, max_count);
   }
 
   if (!pending_action_list_.empty() && !is_closed() && false == is_save_task_running() &&
@@ -157,37 +153,19 @@ SERVER_FRAME_API int router_manager_set::stop() {
 
   ctor_param.pending_list = atfw::memory::stl::make_shared<task_action_router_close_manager_set::pending_list_t>();
   if (ctor_param.pending_list) {
-    std::unordered_set<router_object_base::key_t> recheck_set;
-    ctor_param.pending_list->reserve(timers_.default_timer_list.size() + timers_.fast_timer_list.size());
+    ctor_param.pending_list->reserve(timers_.default_timer_wheel.size() + timers_.fast_timer_wheel.size());
 
-    std::list<timer_t> *timer_lists[2] = {&timers_.default_timer_list, &timers_.fast_timer_list};
+    router_timer_wheel *timer_wheels[2] = {&timers_.default_timer_wheel, &timers_.fast_timer_wheel};
     for (int i = 0; i < 2; ++i) {
-      std::list<timer_t> *cur_list = timer_lists[i];
-      for (std::list<timer_t>::iterator iter = cur_list->begin(); iter != cur_list->end(); ++iter) {
-        // 已过期，直接清理掉
-        if ((*iter).obj_watcher.expired()) {
-          continue;
-        }
-        std::shared_ptr<router_object_base> obj = (*iter).obj_watcher.lock();
-
-        // 已过期，直接清理掉
-        if (!obj) {
-          continue;
-        }
-
+      timer_wheels[i]->visit([&ctor_param](timer_t &timer) {
         // 不是实体，不需要保存
-        if (!obj->check_flag(router_object_base::flag_t::EN_ROFT_IS_OBJECT)) {
-          continue;
+        if (nullptr == timer.owner || !timer.owner->check_flag(router_object_base::flag_t::EN_ROFT_IS_OBJECT)) {
+          return true;
         }
 
-        // 已经在其他队列处理过了则跳过
-        if (recheck_set.end() != recheck_set.find(obj->get_key())) {
-          continue;
-        }
-        recheck_set.insert(obj->get_key());
-
-        ctor_param.pending_list->push_back(obj);
-      }
+        ctor_param.pending_list->push_back(timer.owner->shared_from_this());
+        return true;
+      });
     }
   }
 
@@ -267,27 +245,22 @@ SERVER_FRAME_API bool router_manager_set::insert_timer(router_manager_base *mgr,
     return false;
   }
 
-  std::list<timer_t> *tm_timer;
+  router_timer_wheel *tm_wheel;
+  time_t now = atfw::util::time::time_utility::get_sys_now();
+  time_t timeout;
   if (!is_fast) {
-    tm_timer = &timers_.default_timer_list;
+    tm_wheel = &timers_.default_timer_wheel;
+    timeout = now + logic_config::me()->get_cfg_router().default_timer_interval().seconds();
   } else {
-    tm_timer = &timers_.fast_timer_list;
+    tm_wheel = &timers_.fast_timer_wheel;
+    timeout = now + logic_config::me()->get_cfg_router().fast_timer_interval().seconds();
   }
 
-  std::list<timer_t>::iterator tm_iter = tm_timer->insert(tm_timer->end(), timer_t());
-  timer_t *tm_inst = &(*tm_iter);
-
-  tm_inst->obj_watcher = obj;
-  tm_inst->type_id = mgr->get_type_id();
-  if (!is_fast) {
-    tm_inst->timeout = atfw::util::time::time_utility::get_sys_now() +
-                       logic_config::me()->get_cfg_router().default_timer_interval().seconds();
-  } else {
-    tm_inst->timeout = atfw::util::time::time_utility::get_sys_now() +
-                       logic_config::me()->get_cfg_router().fast_timer_interval().seconds();
-  }
-  tm_inst->timer_sequence = obj->alloc_timer_sequence();
-  obj->reset_timer_ref(tm_timer, tm_iter);
+  // 每个对象只有一个定时器节点，插入时会自动从原来的时间轮中移除
+  timer_t &tm_inst = obj->timer_node_;
+  tm_inst.type_id = mgr->get_type_id();
+  tm_inst.timer_sequence = obj->alloc_timer_sequence();
+  tm_wheel->insert(tm_inst, now, timeout);
 
   return true;
 }
@@ -361,97 +334,60 @@ SERVER_FRAME_API int router_manager_set::recycle_caches(int max_count) {
 
   int ret = 0;
 
-  std::list<timer_t>::iterator default_timer_iter = timers_.default_timer_list.begin();
-  std::list<timer_t>::iterator fast_timer_iter = timers_.fast_timer_list.begin();
-
   using recheck_list_t = std::list<std::pair<std::shared_ptr<router_object_base>, router_manager_base *>>;
 
   recheck_list_t recheck_list;
-  std::unordered_set<router_object_base::key_t> recheck_set;
-
-  while (ret < max_count) {
-    if (default_timer_iter == timers_.default_timer_list.end() && fast_timer_iter == timers_.fast_timer_list.end()) {
-      break;
-    }
-
-    std::list<timer_t> *selected_list;
-    std::list<timer_t>::iterator selected_iter;
-    if (default_timer_iter == timers_.default_timer_list.end()) {
-      selected_list = &timers_.fast_timer_list;
-      selected_iter = fast_timer_iter;
-      ++fast_timer_iter;
-    } else if (fast_timer_iter == timers_.fast_timer_list.end()) {
-      selected_list = &timers_.default_timer_list;
-      selected_iter = default_timer_iter;
-      ++default_timer_iter;
-    } else if ((*default_timer_iter).timeout <= (*fast_timer_iter).timeout) {
-      selected_list = &timers_.default_timer_list;
-      selected_iter = default_timer_iter;
-      ++default_timer_iter;
-    } else {
-      selected_list = &timers_.fast_timer_list;
-      selected_iter = fast_timer_iter;
-      ++fast_timer_iter;
-    }
-
-    // 已过期，直接清理掉
-    if ((*selected_iter).obj_watcher.expired()) {
-      selected_list->erase(selected_iter);
-      continue;
-    }
-    std::shared_ptr<router_object_base> obj = (*selected_iter).obj_watcher.lock();
-
-    // 已过期，直接清理掉
-    if (!obj) {
-      selected_list->erase(selected_iter);
-      continue;
-    }
 
-    // 如果操作序列失效则跳过
-    if (false == obj->check_timer_sequence((*selected_iter).timer_sequence)) {
-      selected_list->erase(selected_iter);
-      continue;
-    }
+  // 定时器节点内嵌在对象中，每个对象最多只会出现在一个时间轮里，所以不需要再去重
+  router_timer_wheel *timer_wheels[2] = {&timers_.default_timer_wheel, &timers_.fast_timer_wheel};
+  for (int i = 0; i < 2 && ret < max_count; ++i) {
+    timer_wheels[i]->visit([this, &ret, max_count, &recheck_list](timer_t &timer) {
+      if (ret >= max_count) {
+        return false;
+      }
 
-    // 不是缓存，不能清理
-    if (obj->check_flag(router_object_base::flag_t::EN_ROFT_IS_OBJECT)) {
-      continue;
-    }
+      router_object_base *owner = timer.owner;
+      // 如果操作序列失效则跳过
+      if (nullptr == owner || false == owner->check_timer_sequence(timer.timer_sequence)) {
+        router_timer_wheel::cancel(timer);
+        return true;
+      }
 
-    // manager 错误
-    router_manager_base *mgr = get_manager((*selected_iter).type_id);
-    if (nullptr == mgr) {
-      FWLOGERROR("invalid manager {}", (*selected_iter).type_id);
-      selected_list->erase(selected_iter);
-      continue;
-    }
+      // 不是缓存，不能清理
+      if (owner->check_flag(router_object_base::flag_t::EN_ROFT_IS_OBJECT)) {
+        return true;
+      }
 
-    // 管理器中的对象已被替换或移除则跳过
-    if (mgr->get_base_cache(obj->get_key()) != obj) {
-      selected_list->erase(selected_iter);
-      continue;
-    }
+      // manager 错误
+      router_manager_base *mgr = get_manager(timer.type_id);
+      if (nullptr == mgr) {
+        FWLOGERROR("invalid manager {}", timer.type_id);
+        router_timer_wheel::cancel(timer);
+        return true;
+      }
 
-    // 已经在其他队列处理过了则跳过
-    if (recheck_set.end() != recheck_set.find(obj->get_key())) {
-      selected_list->erase(selected_iter);
-      continue;
-    }
-    recheck_set.insert(obj->get_key());
+      // 管理器中的对象已被替换或移除则跳过
+      std::shared_ptr<router_object_base> obj = owner->shared_from_this();
+      if (mgr->get_base_cache(obj->get_key()) != obj) {
+        router_timer_wheel::cancel(timer);
+        return true;
+      }
 
-    // 缓存过期,和上面定时回收缓存的逻辑保持一致
-    pending_action_list_.push_back(pending_action_data());
-    pending_action_data &auto_save = pending_action_list_.back();
-    auto_save.object = obj;
-    auto_save.type_id = (*selected_iter).type_id;
-    auto_save.action = EN_ASA_REMOVE_CACHE;
+      // 缓存过期,和上面定时回收缓存的逻辑保持一致
+      pending_action_list_.push_back(pending_action_data());
+      pending_action_data &auto_save = pending_action_list_.back();
+      auto_save.object = obj;
+      auto_save.type_id = timer.type_id;
+      auto_save.action = EN_ASA_REMOVE_CACHE;
 
-    obj->set_flag(router_object_base::flag_t::EN_ROFT_SCHED_REMOVE_CACHE);
+      obj->set_flag(router_object_base::flag_t::EN_ROFT_SCHED_REMOVE_CACHE);
 
-    // 无论什么事件，都需要插入下一个定时器做检查，以防异步流程异常结束
-    recheck_list.push_back(std::make_pair(obj, mgr));
-    selected_list->erase(selected_iter);
-    ++ret;
+      // 无论什么事件，都需要插入下一个定时器做检查，以防异步流程异常结束
+      router_timer_wheel::cancel(timer);
+      recheck_list.push_back(std::make_pair(std::move(obj), mgr));
+      ++ret;
+      return true;
+    });
   }
 
   // 重新加入到快队列，因为实际执行前可能被mutable而导致缓存对象被重新激活
@@ -529,7 +465,7 @@ SERVER_FRAME_API bool router_manager_set::mark_fast_save(router_manager_base *mg
 
   // Mark force save and move to fast timer
   obj->set_flag(router_object_base::flag_t::EN_ROFT_FORCE_SAVE_OBJECT);
-  if (obj->timer_list_ == &timers_.fast_timer_list) {
+  if (obj->timer_node_.wheel == &timers_.fast_timer_wheel) {
     return false;
   }
 
@@ -619,48 +555,36 @@ bool router_manager_set::is_closing_task_running() const {
 }
 
 int router_manager_set::tick_timer(time_t cache_expire, time_t object_expire, time_t object_save,
-                                   std::list<timer_t> &timer_list, bool is_fast) {
+                                   router_timer_wheel &timer_wheel, bool is_fast, size_t max_count) {
   int ret = 0;
-  // 缓存失效定时器
-  do {
-    if (timer_list.empty()) {
-      break;
-    }
-
-    std::list<timer_t>::iterator timer_iter = timer_list.begin();
-    timer_t &cache = *timer_iter;
-
-    // 如果没到时间，后面的全没到时间
-    if (last_proc_time_ <= cache.timeout) {
+  // 缓存失效定时器，每次最多处理max_count个，剩下的留到下次tick
+  for (size_t processed = 0; processed < max_count; ++processed) {
+    // 时间轮只会取出已到期的定时器
+    timer_t *cache = timer_wheel.pop_expired(last_proc_time_);
+    if (nullptr == cache) {
       break;
     }
 
-    // 如果已下线并且缓存失效则跳过
-    std::shared_ptr<router_object_base> obj = cache.obj_watcher.lock();
-    if (!obj) {
-      timer_list.erase(timer_iter);
+    // 对象析构时会自动移除定时器，所以这里owner一定有效
+    router_object_base *owner = cache->owner;
+    if (nullptr == owner) {
       continue;
     }
 
     // 如果操作序列失效则跳过
-    if (false == obj->check_timer_sequence(cache.timer_sequence)) {
-      obj->check_and_remove_timer_ref(&timer_list, timer_iter);
-      timer_list.erase(timer_iter);
+    if (false == owner->check_timer_sequence(cache->timer_sequence)) {
       continue;
     }
 
     // 已销毁则跳过
-    router_manager_base *mgr = get_manager(cache.type_id);
+    router_manager_base *mgr = get_manager(cache->type_id);
     if (nullptr == mgr) {
-      obj->check_and_remove_timer_ref(&timer_list, timer_iter);
-      timer_list.erase(timer_iter);
       continue;
     }
 
     // 管理器中的对象已被替换或移除则跳过
+    std::shared_ptr<router_object_base> obj = owner->shared_from_this();
     if (mgr->get_base_cache(obj->get_key()) != obj) {
-      obj->check_and_remove_timer_ref(&timer_list, timer_iter);
-      timer_list.erase(timer_iter);
       continue;
     }
 
@@ -674,7 +598,7 @@ int router_manager_set::tick_timer(time_t cache_expire, time_t object_expire, ti
           pending_action_list_.push_back(pending_action_data());
           pending_action_data &auto_save = pending_action_list_.back();
           auto_save.object = obj;
-          auto_save.type_id = cache.type_id;
+          auto_save.type_id = cache->type_id;
           auto_save.action = EN_ASA_REMOVE_OBJECT;
 
           obj->set_flag(router_object_base::flag_t::EN_ROFT_SCHED_REMOVE_OBJECT);
@@ -684,7 +608,7 @@ int router_manager_set::tick_timer(time_t cache_expire, time_t object_expire, ti
           pending_action_list_.push_back(pending_action_data());
           pending_action_data &auto_save = pending_action_list_.back();
           auto_save.object = obj;
-          auto_save.type_id = cache.type_id;
+          auto_save.type_id = cache->type_id;
           auto_save.action = EN_ASA_SAVE;
           obj->refresh_save_time();
 
@@ -697,7 +621,7 @@ int router_manager_set::tick_timer(time_t cache_expire, time_t object_expire, ti
           pending_action_list_.push_back(pending_action_data());
           pending_action_data &auto_save = pending_action_list_.back();
           auto_save.object = obj;
-          auto_save.type_id = cache.type_id;
+          auto_save.type_id = cache->type_id;
           auto_save.action = EN_ASA_REMOVE_CACHE;
 
           obj->set_flag(router_object_base::flag_t::EN_ROFT_SCHED_REMOVE_CACHE);
@@ -712,12 +636,9 @@ int router_manager_set::tick_timer(time_t cache_expire, time_t object_expire, ti
     }
 
     // 无论什么事件，都需要插入下一个定时器做检查，以防异步流程异常结束
-    // 先移除定时器引用，否则insert_timer里会移除一次
-    obj->check_and_remove_timer_ref(&timer_list, timer_iter);
     insert_timer(mgr, obj, is_next_timer_fast);
-    timer_list.erase(timer_iter);
     ++ret;
-  } while (true);
+  }
 
   return ret;
 }
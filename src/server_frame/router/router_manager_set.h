@@ -23,6 +23,7 @@
 #include <unordered_map>
 
 #include "router/router_system_defs.h"
+#include "router/router_timer_wheel.h"
 
 class task_action_auto_save_objects;
 class router_manager_set {
@@ -104,15 +105,15 @@ class router_manager_set {
 
   bool is_closing_task_running() const;
 
-  int tick_timer(time_t cache_expire, time_t object_expire, time_t object_save, std::list<timer_t> &timer_list,
-                 bool is_fast);
+  int tick_timer(time_t cache_expire, time_t object_expire, time_t object_save, router_timer_wheel &timer_wheel,
+                 bool is_fast, size_t max_count);
 
   void setup_metrics();
 
  private:
   struct timer_set_t {
-    std::list<timer_t> default_timer_list;
-    std::list<timer_t> fast_timer_list;
+    router_timer_wheel default_timer_wheel;
+    router_timer_wheel fast_timer_wheel;
   };
   timer_set_t timers_;
   time_t last_proc_time_;
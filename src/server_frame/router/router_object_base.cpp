@@ -27,6 +27,7 @@
 #include <rpc/rpc_utils.h>
 
 #include "router/router_manager_set.h"
+#include "router/router_timer_wheel.h"
 
 SERVER_FRAME_API bool router_object_base::key_t::operator==(const key_t &r) const noexcept {
   return object_id == r.object_id && zone_id == r.zone_id && type_id == r.type_id;
@@ -150,13 +151,14 @@ SERVER_FRAME_API router_object_base::router_object_base(const key_t &k)
       router_svr_id_(0),
       router_svr_ver_(0),
       timer_sequence_(0),
-      timer_list_(nullptr),
       io_task_id_(0),
       saving_sequence_(0),
       saved_sequence_(0),
       io_last_pull_cache_task_id_(0),
       io_last_pull_object_task_id_(0),
       flags_(0) {
+  router_timer_wheel::init_node(timer_node_, this);
+
   // 创建时初始化最后访问时间
   refresh_visit_time();
 }
@@ -168,13 +170,14 @@ SERVER_FRAME_API router_object_base::router_object_base(key_t &&k)
       router_svr_id_(0),
       router_svr_ver_(0),
       timer_sequence_(0),
-      timer_list_(nullptr),
       io_task_id_(0),
       saving_sequence_(0),
       saved_sequence_(0),
       io_last_pull_cache_task_id_(0),
       io_last_pull_object_task_id_(0),
       flags_(0) {
+  router_timer_wheel::init_node(timer_node_, this);
+
   // 创建时初始化最后访问时间
   refresh_visit_time();
 }
@@ -609,38 +612,9 @@ SERVER_FRAME_API rpc::result_code_type router_object_base::internal_save_object(
   RPC_RETURN_CODE(ret);
 }
 
-void router_object_base::reset_timer_ref(std::list<router_system_timer_t> *timer_list,
-                                         const std::list<router_system_timer_t>::iterator &it) {
-  if (timer_list_ == timer_list && timer_iter_ == it) {
-    return;
-  }
-
-  unset_timer_ref();
-
-  timer_list_ = timer_list;
-  timer_iter_ = it;
-}
-
-void router_object_base::check_and_remove_timer_ref(std::list<router_system_timer_t> *timer_list,
-                                                    const std::list<router_system_timer_t>::iterator &it) {
-  if (timer_list_ != timer_list || timer_iter_ != it) {
-    return;
-  }
-
-  if (timer_list_ != nullptr && timer_iter_ != timer_list_->end()) {
-    // 内部接口，会在外层执行timer_list_->erase(timer_iter_);所以这里不执行移除
-    timer_iter_ = timer_list_->end();
-  }
-  timer_list_ = nullptr;
-}
-
 void router_object_base::unset_timer_ref() {
   // 清理掉timer
-  if (timer_list_ != nullptr && timer_iter_ != timer_list_->end()) {
-    timer_list_->erase(timer_iter_);
-    timer_iter_ = timer_list_->end();
-  }
-  timer_list_ = nullptr;
+  router_timer_wheel::cancel(timer_node_);
 }
 
 rpc::result_code_type router_object_base::await_io_schedule_order_task(rpc::context &ctx) {
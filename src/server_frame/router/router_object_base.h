@@ -426,12 +426,6 @@ class ATFW_UTIL_SYMBOL_VISIBLE router_object_base : public std::enable_shared_fr
                                                                                       io_task_guard &guard);
 
  private:
-  // 重置定时器引用
-  void reset_timer_ref(std::list<router_system_timer_t> *timer_list,
-                       const std::list<router_system_timer_t>::iterator &it);
-  // 检查并移除定时器引用
-  void check_and_remove_timer_ref(std::list<router_system_timer_t> *timer_list,
-                                  const std::list<router_system_timer_t>::iterator &it);
   // 取消定时器引用
   void unset_timer_ref();
 
@@ -446,8 +440,7 @@ class ATFW_UTIL_SYMBOL_VISIBLE router_object_base : public std::enable_shared_fr
   std::string router_svr_name_;                            // 路由服务器名称
   uint64_t router_svr_ver_;                                // 路由服务器版本
   uint32_t timer_sequence_;                                // 定时器序列
-  std::list<router_system_timer_t> *timer_list_;           // 定时器列表
-  std::list<router_system_timer_t>::iterator timer_iter_;  // 定时器迭代器
+  router_system_timer_t timer_node_;                       // 定时器节点
 
   // 新版排队系统
   task_type_trait::id_type io_task_id_;  // IO任务ID
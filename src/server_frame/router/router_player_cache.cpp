@@ -225,8 +225,11 @@ SERVER_FRAME_API rpc::result_code_type router_player_cache::save_object(rpc::con
   // RPC read from DB(以后可以优化掉)
   int res = 0;
   int try_times = 2;  // 其实并不需要重试，这里只是处理table_login过期后走更新流程
+  bool reload_login_lock = false;
+  bool user_saved_with_login_lock = false;
   while (try_times-- > 0) {
-    if (PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION == res) {
+    if (reload_login_lock) {
+      reload_login_lock = false;
       auto save_login_blob_data =
           rpc::clone_shared_message<PROJECT_NAMESPACE_ID::table_login_lock>(ctx, obj->get_login_lock());
       res = RPC_AWAIT_CODE_RESULT(rpc::db::login_lock::get_all(ctx, get_key().object_id, save_login_blob_data,
@@ -285,15 +288,16 @@ SERVER_FRAME_API rpc::result_code_type router_player_cache::save_object(rpc::con
         obj->get_login_lock().set_router_server_id(old_router_server_id);
         obj->get_login_lock().set_router_version(old_router_ver);
         if (PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION == res) {
+          reload_login_lock = true;
           continue;
         }
         FWPLOGERROR(*obj, "try set login data failed, result: {}({}).", res, protobuf_mini_dumper_get_error_msg(res));
         RPC_RETURN_CODE(res);
       }
       set_router_server_id(obj->get_login_lock().router_server_id(), obj->get_login_lock().router_version());
-      // Logout
+      // Logout, 可能会修改用户数据，所以用户数据在后面单独保存
       obj->on_logout(ctx);
-    } else {  // 续期login code
+    } else {  // 续期login code，和用户数据在同一个脚本里保存
       uint64_t old_router_server_id = obj->get_login_lock().router_server_id();
       uint64_t old_router_ver = obj->get_login_lock().router_version();
 
@@ -302,44 +306,64 @@ SERVER_FRAME_API rpc::result_code_type router_player_cache::save_object(rpc::con
         obj->get_login_lock().set_router_version(old_router_ver + 1);
       }
 
-      auto save_login_blob_data =
-          rpc::clone_shared_message<PROJECT_NAMESPACE_ID::table_login_lock>(ctx, obj->get_login_lock());
-      res = RPC_AWAIT_CODE_RESULT(
-          rpc::db::login_lock::replace(ctx, std::move(save_login_blob_data), obj->get_login_lock_cas_version()));
-      if (res != 0) {
+      rpc::shared_message<PROJECT_NAMESPACE_ID::table_user> user_tb{ctx};
+      obj->dump(ctx, *user_tb, true);
+      FWPLOGDEBUG(*obj, "save curr cas version: {}, login cas version: {}", obj->get_user_cas_version(),
+                  obj->get_login_lock_cas_version());
+
+      // RPC save to DB
+      rpc::db::hash_table::key_value::cas_guard_t login_lock_guard = rpc::db::login_lock::make_cas_guard(
+          rpc::clone_shared_message<PROJECT_NAMESPACE_ID::table_login_lock>(ctx, obj->get_login_lock()),
+          obj->get_login_lock_cas_version());
+      res = RPC_AWAIT_CODE_RESULT(rpc::db::user::replace_with_cas_guard(
+          ctx, std::move(user_tb), obj->get_user_cas_version(), login_lock_guard));
+      obj->get_login_lock_cas_version() = login_lock_guard.version;
+
+      if (login_lock_guard.saved) {
+        set_router_server_id(obj->get_login_lock().router_server_id(), obj->get_login_lock().router_version());
+      } else {
         obj->get_login_lock().set_router_server_id(old_router_server_id);
         obj->get_login_lock().set_router_version(old_router_ver);
-        if (PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION == res) {
-          continue;
-        }
+      }
+
+      if (PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION == res && login_lock_guard.cas_failed) {
+        reload_login_lock = true;
+        continue;
+      }
+
+      if (res < 0 && !login_lock_guard.saved) {
         FWPLOGERROR(*obj, "try set login data failed, result: {}({}).", res, protobuf_mini_dumper_get_error_msg(res));
         RPC_RETURN_CODE(res);
       }
-      set_router_server_id(obj->get_login_lock().router_server_id(), obj->get_login_lock().router_version());
+
+      // 登入锁已经续期，只有用户数据的CAS冲突时(可能是先超时再返回成功)，后面使用返回的版本号单独重试用户数据
+      user_saved_with_login_lock = PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION != res;
     }
 
     break;
   }
 
-  // 尝试保存用户数据
-  {
-    rpc::shared_message<PROJECT_NAMESPACE_ID::table_user> user_tb{ctx};
-    obj->dump(ctx, *user_tb, true);
-    FWPLOGDEBUG(*obj, "save curr cas version: {}", obj->get_user_cas_version());
+  // 登出流程或者用户数据CAS冲突时，单独保存用户数据
+  if (!user_saved_with_login_lock) {
+    {
+      rpc::shared_message<PROJECT_NAMESPACE_ID::table_user> user_tb{ctx};
+      obj->dump(ctx, *user_tb, true);
+      FWPLOGDEBUG(*obj, "save curr cas version: {}", obj->get_user_cas_version());
 
-    // RPC save to DB
-    res = RPC_AWAIT_CODE_RESULT(rpc::db::user::replace(ctx, std::move(user_tb), obj->get_user_cas_version()));
-  }
+      // RPC save to DB
+      res = RPC_AWAIT_CODE_RESULT(rpc::db::user::replace(ctx, std::move(user_tb), obj->get_user_cas_version()));
+    }
 
-  // CAS 序号错误（可能是先超时再返回成功）,重试一次
-  // 前面已经确认了当前用户在此处登入并且已经更新了版本号到版本信息
-  // RPC save to DB again
-  if (PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION == res) {
-    rpc::shared_message<PROJECT_NAMESPACE_ID::table_user> user_tb{ctx};
-    obj->dump(ctx, *user_tb, true);
-    FWPLOGINFO(*obj, "force save curr cas version: {}", obj->get_user_cas_version());
+    // CAS 序号错误（可能是先超时再返回成功）,重试一次
+    // 前面已经确认了当前用户在此处登入并且已经更新了版本号到版本信息
+    // RPC save to DB again
+    if (PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION == res) {
+      rpc::shared_message<PROJECT_NAMESPACE_ID::table_user> user_tb{ctx};
+      obj->dump(ctx, *user_tb, true);
+      FWPLOGINFO(*obj, "force save curr cas version: {}", obj->get_user_cas_version());
 
-    res = RPC_AWAIT_CODE_RESULT(rpc::db::user::replace(ctx, std::move(user_tb), obj->get_user_cas_version()));
+      res = RPC_AWAIT_CODE_RESULT(rpc::db::user::replace(ctx, std::move(user_tb), obj->get_user_cas_version()));
+    }
   }
 
   if (res < 0) {
@@ -10,18 +10,25 @@
 
 #include <stdint.h>
 #include <cstddef>
+#include <ctime>
 #include <list>
 #include <memory>
 
 class router_object_base;
 class router_manager_base;
 class router_manager_set;
+class router_timer_wheel;
 
+// 侵入式定时器节点，内嵌在router_object_base中，由router_timer_wheel管理
 struct ATFW_UTIL_SYMBOL_VISIBLE router_system_timer_t {
   uint32_t timer_sequence;
   uint32_t type_id;
   time_t timeout;
-  std::weak_ptr<router_object_base> obj_watcher;
+  uint32_t slot_index;
+  router_object_base *owner;
+  router_timer_wheel *wheel;
+  router_system_timer_t *prev;
+  router_system_timer_t *next;
 };
 
 namespace rpc {
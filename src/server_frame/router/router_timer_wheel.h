@@ -0,0 +1,269 @@
+// Copyright 2026 atframework
+// Created by owent on 2026-10-17.
+//
+// 路由系统定时器时间轮，精度为1秒
+
+#pragma once
+
+#include <config/compiler_features.h>
+#include <design_pattern/nomovable.h>
+#include <design_pattern/noncopyable.h>
+
+#include <stdint.h>
+#include <cstddef>
+#include <ctime>
+#include <vector>
+
+#include "router/router_system_defs.h"
+
+/**
+ * @brief 散列时间轮
+ * @note 每个槽位是一个侵入式双向链表，节点内嵌在router_object_base中，插入和取消都是O(1)且不分配内存。
+ * @note 每次取到期定时器只访问当前游标所在的槽位，超过一圈的定时器会留在槽位中等待下一圈。
+ */
+class ATFW_UTIL_SYMBOL_VISIBLE router_timer_wheel {
+  UTIL_DESIGN_PATTERN_NOCOPYABLE(router_timer_wheel)
+  UTIL_DESIGN_PATTERN_NOMOVABLE(router_timer_wheel)
+
+ public:
+  using timer_t = router_system_timer_t;
+
+ private:
+  struct slot_t {
+    timer_t *head;
+    timer_t *tail;
+  };
+
+ public:
+  /**
+   * @brief 构造时间轮
+   * @param slot_bits 槽位数量的位数，默认4096个槽位(约68分钟一圈)
+   */
+  explicit router_timer_wheel(size_t slot_bits = 12)
+      : slot_mask_((static_cast<size_t>(1) << slot_bits) - 1),
+        current_(0),
+        size_(0),
+        scan_cursor_(nullptr),
+        scan_active_(false) {
+    slots_.resize(slot_mask_ + 1, slot_t{nullptr, nullptr});
+  }
+
+  ~router_timer_wheel() { clear(); }
+
+  /**
+   * @brief 初始化定时器节点
+   * @param node 定时器节点
+   * @param owner 节点所属的对象
+   */
+  static void init_node(timer_t &node, router_object_base *owner) noexcept {
+    node.timer_sequence = 0;
+    node.type_id = 0;
+    node.timeout = 0;
+    node.slot_index = 0;
+    node.owner = owner;
+    node.wheel = nullptr;
+    node.prev = nullptr;
+    node.next = nullptr;
+  }
+
+  /**
+   * @brief 取消定时器，如果节点不在任何时间轮中则什么都不做
+   * @param node 定时器节点
+   */
+  static void cancel(timer_t &node) noexcept {
+    if (nullptr != node.wheel) {
+      node.wheel->unlink(node);
+    }
+  }
+
+  /**
+   * @brief 插入定时器，如果节点已经在某个时间轮中，会先取消
+   * @param node 定时器节点
+   * @param now 当前时间
+   * @param timeout 超时时间
+   */
+  void insert(timer_t &node, time_t now, time_t timeout) noexcept {
+    cancel(node);
+
+    // 空的时间轮可以直接移动游标
+    if (0 == size_ && current_ < now) {
+      current_ = now;
+      reset_scan();
+    }
+
+    // 已经过期的定时器放到游标所在的槽位，下一次tick即可取出
+    node.timeout = timeout;
+    node.slot_index =
+        static_cast<uint32_t>(static_cast<size_t>(timeout < current_ ? current_ : timeout) & slot_mask_);
+    slot_t &slot = slots_[node.slot_index];
+    node.wheel = this;
+    node.next = nullptr;
+    node.prev = slot.tail;
+    if (nullptr != slot.tail) {
+      slot.tail->next = &node;
+    } else {
+      slot.head = &node;
+    }
+    slot.tail = &node;
+    ++size_;
+
+    // 正在扫描的槽位已经扫描到末尾时，新追加的节点要从这里继续扫描
+    if (scan_active_ && nullptr == scan_cursor_ && node.slot_index == (static_cast<size_t>(current_) & slot_mask_)) {
+      scan_cursor_ = &node;
+    }
+  }
+
+  /**
+   * @brief 取出一个已到期(timeout < now)的定时器
+   * @param now 当前时间
+   * @return 到期的定时器节点，已经从时间轮中移除。没有到期的定时器时返回nullptr
+   */
+  timer_t *pop_expired(time_t now) noexcept {
+    if (0 == size_) {
+      if (current_ < now) {
+        current_ = now;
+        reset_scan();
+      }
+      return nullptr;
+    }
+
+    // 跨度超过一圈时只需要扫描最后一圈，更早的定时器也满足timeout <= current_
+    time_t slot_count = static_cast<time_t>(slots_.size());
+    if (now - current_ > slot_count) {
+      current_ = now - slot_count;
+      reset_scan();
+    }
+
+    while (current_ < now) {
+      // 从上次取出的位置继续扫描，拥挤的槽位也只需要扫描一遍
+      timer_t *node = scan_active_ ? scan_cursor_ : slots_[static_cast<size_t>(current_) & slot_mask_].head;
+      scan_active_ = true;
+      for (; nullptr != node; node = node->next) {
+        if (node->timeout <= current_) {
+          scan_cursor_ = node->next;
+          unlink(*node);
+          return node;
+        }
+      }
+
+      reset_scan();
+      ++current_;
+    }
+
+    return nullptr;
+  }
+
+  /**
+   * @brief 获取下一个会到期的定时器的超时时间
+   * @note 只用于统计，最坏情况下需要遍历所有节点
+   * @return 下一个会到期的超时时间，没有定时器时返回0
+   */
+  time_t get_next_timeout() const noexcept {
+    if (0 == size_) {
+      return 0;
+    }
+
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      time_t slot_time = current_ + static_cast<time_t>(i);
+      for (const timer_t *node = slots_[static_cast<size_t>(slot_time) & slot_mask_].head; nullptr != node;
+           node = node->next) {
+        if (node->timeout <= slot_time) {
+          return node->timeout;
+        }
+      }
+    }
+
+    time_t ret = 0;
+    for (auto &slot : slots_) {
+      for (const timer_t *node = slot.head; nullptr != node; node = node->next) {
+        if (0 == ret || node->timeout < ret) {
+          ret = node->timeout;
+        }
+      }
+    }
+    return ret;
+  }
+
+  /**
+   * @brief 从游标位置开始按槽位顺序遍历所有定时器
+   * @param fn 回调，返回false时停止遍历。回调中允许取消当前节点
+   */
+  template <class TFn>
+  void visit(TFn &&fn) {
+    for (size_t i = 0; i < slots_.size() && size_ > 0; ++i) {
+      slot_t &slot = slots_[static_cast<size_t>(current_ + static_cast<time_t>(i)) & slot_mask_];
+      timer_t *node = slot.head;
+      while (nullptr != node) {
+        timer_t *next = node->next;
+        if (!fn(*node)) {
+          return;
+        }
+        node = next;
+      }
+    }
+  }
+
+  /**
+   * @brief 移除所有定时器
+   */
+  void clear() noexcept {
+    for (auto &slot : slots_) {
+      timer_t *node = slot.head;
+      while (nullptr != node) {
+        timer_t *next = node->next;
+        node->wheel = nullptr;
+        node->prev = nullptr;
+        node->next = nullptr;
+        node = next;
+      }
+      slot.head = nullptr;
+      slot.tail = nullptr;
+    }
+    size_ = 0;
+    reset_scan();
+  }
+
+  ATFW_UTIL_FORCEINLINE size_t size() const noexcept { return size_; }
+  ATFW_UTIL_FORCEINLINE bool empty() const noexcept { return 0 == size_; }
+  ATFW_UTIL_FORCEINLINE time_t get_current_tick() const noexcept { return current_; }
+
+ private:
+  ATFW_UTIL_FORCEINLINE void reset_scan() noexcept {
+    scan_cursor_ = nullptr;
+    scan_active_ = false;
+  }
+
+  void unlink(timer_t &node) noexcept {
+    // 移除的是下一个要扫描的节点时，扫描位置后移
+    if (scan_active_ && scan_cursor_ == &node) {
+      scan_cursor_ = node.next;
+    }
+
+    slot_t &slot = slots_[node.slot_index];
+    if (nullptr != node.prev) {
+      node.prev->next = node.next;
+    } else {
+      slot.head = node.next;
+    }
+    if (nullptr != node.next) {
+      node.next->prev = node.prev;
+    } else {
+      slot.tail = node.prev;
+    }
+
+    node.wheel = nullptr;
+    node.prev = nullptr;
+    node.next = nullptr;
+    --size_;
+  }
+
+ private:
+  std::vector<slot_t> slots_;
+  size_t slot_mask_;
+  time_t current_;
+  size_t size_;
+
+  // 当前槽位(current_)下一个要扫描的节点，scan_active_为false时从槽位头部开始
+  timer_t *scan_cursor_;
+  bool scan_active_;
+};
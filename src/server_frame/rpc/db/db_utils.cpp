@@ -378,71 +378,17 @@ bool redis_args::push(int64_t v) {
   return true;
 }
 
-int unpack_message(::google::protobuf::Message &msg, const redisReply *reply, uint64_t &version, bool &record_existed) {
-  if (nullptr == reply) {
-    FWLOGDEBUG("unpack message {} failed, data mot found.", msg.GetDescriptor()->full_name());
-    return PROJECT_NAMESPACE_ID::err::EN_SYS_PARAM;
-  }
-
-  bool has_failed = false;
+namespace {
+static bool unpack_field_by_reflection(::google::protobuf::Message &msg, std::string_view field_name,
+                                       const redisReply *value, bool &has_failed) {
   const ::google::protobuf::Reflection *reflect = msg.GetReflection();
-  const google::protobuf::Descriptor *desc = msg.GetDescriptor();
-
-  if (REDIS_REPLY_ARRAY != reply->type) {
-    FWLOGDEBUG("unpack message {} failed, reply type {} is not a array.", msg.GetDescriptor()->full_name(),
-               reply->type);
-    return PROJECT_NAMESPACE_ID::err::EN_SYS_UNPACK;
-  }
-
-  if (reply->elements <= 0) {
-    return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+  const ::google::protobuf::FieldDescriptor *fd = msg.GetDescriptor()->FindFieldByName(field_name);
+  if (nullptr == fd) {
+    return false;
   }
-  record_existed = true;
-  bool version_found = false;
-
-  for (size_t i = 0; i < reply->elements - 1; i += 2) {
-    const redisReply *key = reply->element[i];
-    const redisReply *value = reply->element[i + 1];
-
-    if (REDIS_REPLY_STRING != key->type || nullptr == key->str) {
-      if (nullptr != key->str) {
-        FWLOGDEBUG("unpack message {} failed, key(replay[{}], {}) type {} is not a string.",
-                   msg.GetDescriptor()->full_name(), i, key->str, key->type);
-      } else {
-        FWLOGDEBUG("unpack message {} failed, key(replay[{}]) type {} is not a string.",
-                   msg.GetDescriptor()->full_name(), i, key->type);
-      }
-      continue;
-    }
-
-    if (!version_found && 0 == UTIL_STRFUNC_STRNCMP(RPC_DB_VERSION_NAME, key->str, RPC_DB_VERSION_LENGTH)) {
-      if (REDIS_REPLY_INTEGER == value->type) {
-        char intval[24] = {0};
-        UTIL_STRFUNC_SNPRINTF(intval, sizeof(intval), "%lld", value->integer);
-        version = static_cast<uint64_t>(value->integer);
-      } else if (nullptr != value->str) {
-        version = atfw::util::string::to_int<uint64_t>(value->str);
-      } else {
-        version = 0;
-      }
-      version_found = true;
-      continue;
-    }
-
-    const ::google::protobuf::FieldDescriptor *fd = desc->FindFieldByName(key->str);
-    // 老版本的服务器用新的数据
-    if (nullptr == fd) {
-      // has_failed = true;
-      FWLOGERROR("unpack message {} failed, field name {} not found, maybe deleted", msg.GetDescriptor()->full_name(),
-                 key->str);
-      continue;
-    }
 
 #define CASE_REDIS_DATA_TO_PB_INT(pbtype, cpptype, func)                                                         \
   case pbtype: {                                                                                                 \
-    if (REDIS_REPLY_NIL == value->type) {                                                                        \
-      break;                                                                                                     \
-    }                                                                                                            \
     if (REDIS_REPLY_INTEGER == value->type) {                                                                    \
       reflect->func(&msg, fd, static_cast<cpptype>(value->integer));                                             \
     } else if (REDIS_REPLY_STRING == value->type && nullptr != value->str) {                                     \
@@ -457,87 +403,153 @@ int unpack_message(::google::protobuf::Message &msg, const redisReply *reply, ui
       FWLOGERROR(                                                                                                \
           "unpack message {} failed, type of {} in pb is a message, but the redis reply type is not string nor " \
           "integer(reply type={}).",                                                                             \
-          msg.GetDescriptor()->full_name(), key->str, value->type);                                              \
+          msg.GetDescriptor()->full_name(), field_name, value->type);                                            \
       has_failed = true;                                                                                         \
     }                                                                                                            \
     break;                                                                                                       \
   }
 
-    switch (fd->cpp_type()) {
-      case google::protobuf::FieldDescriptor::CPPTYPE_STRING: {
-        if (REDIS_REPLY_NIL == value->type) {
+  switch (fd->cpp_type()) {
+    case google::protobuf::FieldDescriptor::CPPTYPE_STRING: {
+      if (REDIS_REPLY_STRING != value->type || nullptr == value->str) {
+        FWLOGERROR(
+            "unpack message {} failed, type of {} in pb is a string, but the redis reply type is not(reply type={}).",
+            msg.GetDescriptor()->full_name(), field_name, value->type);
+        has_failed = true;
+      } else {
+        if (value->len <= 1) {
+          FWLOGERROR("unpack message {} failed, type of {} in pb is a string, but the redis reply len error(len{}).",
+                     msg.GetDescriptor()->full_name(), field_name, value->len);
+          has_failed = true;
           break;
         }
-
-        if (REDIS_REPLY_STRING != value->type || nullptr == value->str) {
-          FWLOGERROR(
-              "unpack message {} failed, type of {} in pb is a string, but the redis reply type is not(reply type={}).",
-              msg.GetDescriptor()->full_name(), key->str, value->type);
+        reflect->SetString(&msg, fd, value->str + 1);
+      }
+      break;
+    }
+    case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE: {
+      if (REDIS_REPLY_STRING != value->type || nullptr == value->str) {
+        FWLOGERROR(
+            "unpack message {} failed, type of {} in pb is a message, but the redis reply type is not string(reply "
+            "type={}).",
+            msg.GetDescriptor()->full_name(), field_name, value->type);
+        has_failed = true;
+      } else {
+        if (value->len <= 1) {
+          FWLOGERROR("unpack message {} failed, type of {} in pb is a string, but the redis reply len error(len{}).",
+                     msg.GetDescriptor()->full_name(), field_name, value->len);
           has_failed = true;
-        } else {
-          if (value->len <= 1) {
-            FWLOGERROR("unpack message {} failed, type of {} in pb is a string, but the redis reply len error(len{}).",
-                       msg.GetDescriptor()->full_name(), key->str, value->type);
-            has_failed = true;
-            break;
-          }
-          reflect->SetString(&msg, fd, value->str + 1);
+          break;
         }
-        break;
-      }
-      case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE: {
-        if (REDIS_REPLY_NIL == value->type) {
+        ::google::protobuf::Message *data_msg = reflect->MutableMessage(&msg, fd);
+        if (nullptr == data_msg) {
+          has_failed = true;
+          FWLOGERROR("mutable message {}.{} failed", msg.GetDescriptor()->full_name(), field_name);
           break;
         }
 
-        if (REDIS_REPLY_STRING != value->type || nullptr == value->str) {
-          FWLOGERROR(
-              "unpack message {} failed, type of {} in pb is a message, but the redis reply type is not string(reply "
-              "type={}).",
-              msg.GetDescriptor()->full_name(), key->str, value->type);
+        if (false == data_msg->ParseFromArray(value->str + 1, static_cast<int>(value->len) - 1)) {
           has_failed = true;
-        } else {
-          if (value->len <= 1) {
-            FWLOGERROR("unpack message {} failed, type of {} in pb is a string, but the redis reply len error(len{}).",
-                       msg.GetDescriptor()->full_name(), key->str, value->type);
-            has_failed = true;
-            break;
-          }
-          ::google::protobuf::Message *data_msg = reflect->MutableMessage(&msg, fd);
-          if (nullptr == data_msg) {
-            has_failed = true;
-            FWLOGERROR("mutable message {}.{} failed", msg.GetDescriptor()->full_name(), key->str);
-            continue;
-          }
-
-          if (false == data_msg->ParseFromArray(value->str + 1, static_cast<int>(value->len) - 1)) {
-            has_failed = true;
-            FWLOGERROR("message field [{}] unpack error failed", key->str);
-            FWLOGDEBUG("{}", data_msg->InitializationErrorString());
-          }
+          FWLOGERROR("message field [{}] unpack error failed", field_name);
+          FWLOGDEBUG("{}", data_msg->InitializationErrorString());
         }
-
-        break;
       }
 
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_INT32, google::protobuf::int32, SetInt32)
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_INT64, google::protobuf::int64, SetInt64)
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_UINT32, google::protobuf::uint32,
-                                  SetUInt32)
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_UINT64, google::protobuf::uint64,
-                                  SetUInt64)
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_ENUM, int, SetEnumValue)
+      break;
+    }
 
-      default: {
-        FWLOGERROR("message {} field {}(type={}) invalid", msg.GetDescriptor()->full_name(), fd->name(),
-                   fd->cpp_type_name());
-        break;
-      }
+      CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_INT32, google::protobuf::int32, SetInt32)
+      CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_INT64, google::protobuf::int64, SetInt64)
+      CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_UINT32, google::protobuf::uint32, SetUInt32)
+      CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_UINT64, google::protobuf::uint64, SetUInt64)
+      CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_ENUM, int, SetEnumValue)
+
+    default: {
+      FWLOGERROR("message {} field {}(type={}) invalid", msg.GetDescriptor()->full_name(), fd->name(),
+                 fd->cpp_type_name());
+      break;
     }
   }
 
 #undef CASE_REDIS_DATA_TO_PB_INT
 
+  return true;
+}
+
+static void unpack_version(const redisReply *value, uint64_t &version) {
+  if (REDIS_REPLY_INTEGER == value->type) {
+    version = static_cast<uint64_t>(value->integer);
+  } else if (nullptr != value->str) {
+    version = atfw::util::string::to_int<uint64_t>(value->str);
+  } else {
+    version = 0;
+  }
+}
+
+static void unpack_field_value(::google::protobuf::Message &msg, std::string_view field_name, const redisReply *value,
+                               unpack_field_fn_t unpack_field_fn, bool &has_failed) {
+  if (REDIS_REPLY_NIL == value->type) {
+    return;
+  }
+
+  // 生成代码没有处理的字段走反射流程
+  if (nullptr != unpack_field_fn && unpack_field_fn(msg, field_name, value, has_failed)) {
+    return;
+  }
+
+  // 老版本的服务器用新的数据
+  if (!unpack_field_by_reflection(msg, field_name, value, has_failed)) {
+    FWLOGERROR("unpack message {} failed, field name {} not found, maybe deleted", msg.GetDescriptor()->full_name(),
+               field_name);
+  }
+}
+}  // namespace
+
+int unpack_message(::google::protobuf::Message &msg, const redisReply *reply, uint64_t &version, bool &record_existed,
+                   unpack_field_fn_t unpack_field_fn) {
+  if (nullptr == reply) {
+    FWLOGDEBUG("unpack message {} failed, data mot found.", msg.GetDescriptor()->full_name());
+    return PROJECT_NAMESPACE_ID::err::EN_SYS_PARAM;
+  }
+
+  bool has_failed = false;
+
+  if (REDIS_REPLY_ARRAY != reply->type) {
+    FWLOGDEBUG("unpack message {} failed, reply type {} is not a array.", msg.GetDescriptor()->full_name(),
+               reply->type);
+    return PROJECT_NAMESPACE_ID::err::EN_SYS_UNPACK;
+  }
+
+  if (reply->elements <= 0) {
+    return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+  }
+  record_existed = true;
+  bool version_found = false;
+
+  for (size_t i = 0; i < reply->elements - 1; i += 2) {
+    const redisReply *key = reply->element[i];
+    const redisReply *value = reply->element[i + 1];
+
+    if (REDIS_REPLY_STRING != key->type || nullptr == key->str) {
+      if (nullptr != key->str) {
+        FWLOGDEBUG("unpack message {} failed, key(replay[{}], {}) type {} is not a string.",
+                   msg.GetDescriptor()->full_name(), i, key->str, key->type);
+      } else {
+        FWLOGDEBUG("unpack message {} failed, key(replay[{}]) type {} is not a string.",
+                   msg.GetDescriptor()->full_name(), i, key->type);
+      }
+      continue;
+    }
+
+    if (!version_found && 0 == UTIL_STRFUNC_STRNCMP(RPC_DB_VERSION_NAME, key->str, RPC_DB_VERSION_LENGTH)) {
+      unpack_version(value, version);
+      version_found = true;
+      continue;
+    }
+
+    unpack_field_value(msg, std::string_view{key->str, key->len}, value, unpack_field_fn, has_failed);
+  }
+
   if (has_failed) {
     FWLOGERROR("unpack message {} finished, but not all data fields success: {}", msg.GetDescriptor()->full_name(),
                msg.DebugString());
@@ -548,15 +560,14 @@ int unpack_message(::google::protobuf::Message &msg, const redisReply *reply, ui
 }
 
 int unpack_message_with_field(::google::protobuf::Message &msg, const redisReply *reply, std::string_view *fields,
-                              int32_t length, uint64_t &version, bool &record_existed) {
+                              int32_t length, uint64_t &version, bool &record_existed,
+                              unpack_field_fn_t unpack_field_fn) {
   if (nullptr == reply) {
     FWLOGDEBUG("unpack message {} failed, data mot found.", msg.GetDescriptor()->full_name());
     return PROJECT_NAMESPACE_ID::err::EN_SYS_PARAM;
   }
 
   bool has_failed = false;
-  const ::google::protobuf::Reflection *reflect = msg.GetReflection();
-  const google::protobuf::Descriptor *desc = msg.GetDescriptor();
 
   if (REDIS_REPLY_ARRAY != reply->type) {
     FWLOGDEBUG("unpack message {} failed, reply type {} is not a array.", msg.GetDescriptor()->full_name(),
@@ -578,134 +589,187 @@ int unpack_message_with_field(::google::protobuf::Message &msg, const redisReply
     std::string_view key = fields[i];
 
     if (!version_found && 0 == UTIL_STRFUNC_STRNCMP(RPC_DB_VERSION_NAME, key.data(), RPC_DB_VERSION_LENGTH)) {
-      if (REDIS_REPLY_INTEGER == value->type) {
-        char intval[24] = {0};
-        UTIL_STRFUNC_SNPRINTF(intval, sizeof(intval), "%lld", value->integer);
-        version = static_cast<uint64_t>(value->integer);
-      } else if (nullptr != value->str) {
-        version = atfw::util::string::to_int<uint64_t>(value->str);
-      } else {
-        version = 0;
-      }
+      unpack_version(value, version);
       version_found = true;
       continue;
     }
 
-    const ::google::protobuf::FieldDescriptor *fd = desc->FindFieldByName(key);
-    // 老版本的服务器用新的数据
-    if (nullptr == fd) {
-      FWLOGERROR("unpack message {} failed, field name {} not found, maybe deleted", msg.GetDescriptor()->full_name(),
-                 key);
-      continue;
-    }
+    unpack_field_value(msg, key, value, unpack_field_fn, has_failed);
+  }
 
-#define CASE_REDIS_DATA_TO_PB_INT(pbtype, cpptype, func)                                                         \
-  case pbtype: {                                                                                                 \
-    if (REDIS_REPLY_NIL == value->type) {                                                                        \
-      break;                                                                                                     \
-    }                                                                                                            \
-    if (REDIS_REPLY_INTEGER == value->type) {                                                                    \
-      reflect->func(&msg, fd, static_cast<cpptype>(value->integer));                                             \
-    } else if (REDIS_REPLY_STRING == value->type && nullptr != value->str) {                                     \
-      cpptype v = 0;                                                                                             \
-      if (value->len <= 1) {                                                                                     \
-        has_failed = true;                                                                                       \
-        break;                                                                                                   \
-      }                                                                                                          \
-      atfw::util::string::str2int(v, value->str + 1);                                                            \
-      reflect->func(&msg, fd, v);                                                                                \
-    } else {                                                                                                     \
-      FWLOGERROR(                                                                                                \
-          "unpack message {} failed, type of {} in pb is a message, but the redis reply type is not string nor " \
-          "integer(reply type={}).",                                                                             \
-          msg.GetDescriptor()->full_name(), key, value->type);                                                   \
-      has_failed = true;                                                                                         \
-    }                                                                                                            \
-    break;                                                                                                       \
+  if (has_failed) {
+    FWLOGERROR("unpack message {} finished, but not all data fields success: {}", msg.GetDescriptor()->full_name(),
+               msg.DebugString());
+    return PROJECT_NAMESPACE_ID::err::EN_SYS_UNPACK;
   }
 
-    switch (fd->cpp_type()) {
-      case google::protobuf::FieldDescriptor::CPPTYPE_STRING: {
-        if (REDIS_REPLY_NIL == value->type) {
-          break;
-        }
+  return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+}
 
-        if (REDIS_REPLY_STRING != value->type || nullptr == value->str) {
-          FWLOGERROR(
-              "unpack message {} failed, type of {} in pb is a string, but the redis reply type is not(reply type={}).",
-              msg.GetDescriptor()->full_name(), key, value->type);
-          has_failed = true;
-        } else {
-          if (value->len <= 1) {
-            FWLOGERROR("unpack message {} failed, type of {} in pb is a string, but the redis reply len error(len{}).",
-                       msg.GetDescriptor()->full_name(), key, value->len);
-            has_failed = true;
-            break;
-          }
-          reflect->SetString(&msg, fd, value->str + 1);
-        }
-        break;
-      }
-      case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE: {
-        if (REDIS_REPLY_NIL == value->type) {
-          break;
-        }
+redis_message_packer::redis_message_packer(redis_args &args, std::ostream *debug_message)
+    : args_(args), debug_message_(debug_message), stat_sum_len_(0) {}
 
-        if (REDIS_REPLY_STRING != value->type || nullptr == value->str) {
-          FWLOGERROR(
-              "unpack message {} failed, type of {} in pb is a message, but the redis reply type is not string(reply "
-              "type={}).",
-              msg.GetDescriptor()->full_name(), key, value->type);
-          has_failed = true;
-        } else {
-          if (value->len <= 1) {
-            FWLOGERROR("unpack message {} failed, type of {} in pb is a string, but the redis reply len error(len{}).",
-                       msg.GetDescriptor()->full_name(), key, value->type);
-            has_failed = true;
-            break;
-          }
-          ::google::protobuf::Message *data_msg = reflect->MutableMessage(&msg, fd);
-          if (nullptr == data_msg) {
-            has_failed = true;
-            FWLOGERROR("mutable message {}.{} failed", msg.GetDescriptor()->full_name(), key);
-            continue;
-          }
-
-          if (false == data_msg->ParseFromArray(value->str + 1, static_cast<int>(value->len) - 1)) {
-            has_failed = true;
-            FWLOGERROR("message field [{}] unpack error failed", key);
-            FWLOGDEBUG("{}", data_msg->InitializationErrorString());
-          }
-        }
+bool redis_message_packer::pack_version(uint64_t version) {
+  char *d = args_.alloc(RPC_DB_VERSION_LENGTH);
+  if (nullptr == d) {
+    return false;
+  }
+  memcpy(d, RPC_DB_VERSION_NAME, RPC_DB_VERSION_LENGTH);
 
-        break;
-      }
+  char version_buffer[32] = {0};
+  size_t version_buffer_size = atfw::util::string::int2str(version_buffer, sizeof(version_buffer), version);
+  d = args_.alloc(version_buffer_size);
+  if (nullptr == d) {
+    args_.dealloc();
+    return false;
+  }
+  memcpy(d, version_buffer, version_buffer_size);
+  return true;
+}
 
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_INT32, google::protobuf::int32, SetInt32)
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_INT64, google::protobuf::int64, SetInt64)
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_UINT32, google::protobuf::uint32,
-                                  SetUInt32)
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_UINT64, google::protobuf::uint64,
-                                  SetUInt64)
-        CASE_REDIS_DATA_TO_PB_INT(google::protobuf::FieldDescriptor::CPPTYPE_ENUM, int, SetEnumValue)
+bool redis_message_packer::pack_field(std::string_view name, std::string_view value) {
+  if (!pack_field_name(name)) {
+    return false;
+  }
 
-      default: {
-        FWLOGERROR("message {} field {}(type={}) invalid", msg.GetDescriptor()->full_name(), fd->name(),
-                   fd->cpp_type_name());
-        break;
-      }
-    }
+  char *d = args_.alloc(value.size() + 1);
+  if (nullptr == d) {
+    args_.dealloc();
+    return false;
   }
+  d[0] = '&';
+  memcpy(d + 1, value.data(), value.size());
 
-#undef CASE_REDIS_DATA_TO_PB_INT
+  stat_sum_len_ += value.size();
+  if (nullptr != debug_message_) {
+    (*debug_message_) << name << "=" << value << ",";
+  }
+  return true;
+}
 
-  if (has_failed) {
-    FWLOGERROR("unpack message {} finished, but not all data fields success: {}", msg.GetDescriptor()->full_name(),
-               msg.DebugString());
-    return PROJECT_NAMESPACE_ID::err::EN_SYS_UNPACK;
+bool redis_message_packer::pack_field(std::string_view name, const ::google::protobuf::MessageLite &value) {
+  if (!pack_field_name(name)) {
+    return false;
   }
 
-  return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+  size_t dump_len = value.ByteSizeLong();
+  char *d = args_.alloc(dump_len + 1);
+  if (nullptr == d) {
+    args_.dealloc();
+    return false;
+  }
+  d[0] = '&';
+  value.SerializeWithCachedSizesToArray(reinterpret_cast<::google::protobuf::uint8 *>(d + 1));
+
+  stat_sum_len_ += dump_len;
+  if (nullptr != debug_message_) {
+    (*debug_message_) << name << "=" << dump_len << " bytes,";
+  }
+  return true;
+}
+
+bool redis_message_packer::pack_field(std::string_view name, int32_t value) {
+  char vstr[24] = {0};
+  size_t len = atfw::util::string::int2str(vstr, sizeof(vstr) - 1, value);
+  return pack_integer(name, vstr, len);
+}
+
+bool redis_message_packer::pack_field(std::string_view name, uint32_t value) {
+  char vstr[24] = {0};
+  size_t len = atfw::util::string::int2str(vstr, sizeof(vstr) - 1, value);
+  return pack_integer(name, vstr, len);
+}
+
+bool redis_message_packer::pack_field(std::string_view name, int64_t value) {
+  char vstr[24] = {0};
+  size_t len = atfw::util::string::int2str(vstr, sizeof(vstr) - 1, value);
+  return pack_integer(name, vstr, len);
+}
+
+bool redis_message_packer::pack_field(std::string_view name, uint64_t value) {
+  char vstr[24] = {0};
+  size_t len = atfw::util::string::int2str(vstr, sizeof(vstr) - 1, value);
+  return pack_integer(name, vstr, len);
+}
+
+void redis_message_packer::finish() {
+  if (nullptr != debug_message_) {
+    (*debug_message_) << ". total value length=" << stat_sum_len_ << " bytes";
+  }
+}
+
+bool redis_message_packer::pack_field_name(std::string_view name) {
+  char *d = args_.alloc(name.size());
+  if (nullptr == d) {
+    return false;
+  }
+  memcpy(d, name.data(), name.size());
+  return true;
+}
+
+bool redis_message_packer::pack_integer(std::string_view name, const char *value, size_t value_len) {
+  if (!pack_field_name(name)) {
+    return false;
+  }
+
+  char *d = args_.alloc(value_len + 1);
+  if (nullptr == d) {
+    args_.dealloc();
+    return false;
+  }
+  d[0] = '&';
+  memcpy(d + 1, value, value_len);
+
+  stat_sum_len_ += value_len;
+  if (nullptr != debug_message_) {
+    (*debug_message_) << name << "=" << std::string_view{value, value_len} << ",";
+  }
+  return true;
+}
+
+bool unpack_field(const redisReply *value, std::string &out) {
+  if (REDIS_REPLY_STRING != value->type || nullptr == value->str || value->len <= 1) {
+    return false;
+  }
+
+  out.assign(value->str + 1, value->len - 1);
+  return true;
+}
+
+bool unpack_field(const redisReply *value, ::google::protobuf::MessageLite &out) {
+  if (REDIS_REPLY_STRING != value->type || nullptr == value->str || value->len <= 1) {
+    return false;
+  }
+
+  return out.ParseFromArray(value->str + 1, static_cast<int>(value->len) - 1);
+}
+
+bool unpack_field(const redisReply *value, int64_t &out) {
+  if (REDIS_REPLY_INTEGER == value->type) {
+    out = static_cast<int64_t>(value->integer);
+    return true;
+  }
+
+  if (REDIS_REPLY_STRING != value->type || nullptr == value->str || value->len <= 1) {
+    return false;
+  }
+
+  atfw::util::string::str2int(out, value->str + 1);
+  return true;
+}
+
+bool unpack_field(const redisReply *value, uint64_t &out) {
+  if (REDIS_REPLY_INTEGER == value->type) {
+    out = static_cast<uint64_t>(value->integer);
+    return true;
+  }
+
+  if (REDIS_REPLY_STRING != value->type || nullptr == value->str || value->len <= 1) {
+    return false;
+  }
+
+  atfw::util::string::str2int(out, value->str + 1);
+  return true;
 }
 
 int pack_message(const ::google::protobuf::Message &msg, redis_args &args,
@@ -978,5 +1042,29 @@ int32_t unpack_list_message_with_index(
   return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
 }
 
+SERVER_FRAME_API uint16_t get_cluster_hash_slot(std::string_view key) {
+  size_t tag_begin = key.find('{');
+  if (tag_begin != std::string_view::npos) {
+    size_t tag_end = key.find('}', tag_begin + 1);
+    if (tag_end != std::string_view::npos && tag_end > tag_begin + 1) {
+      key = key.substr(tag_begin + 1, tag_end - tag_begin - 1);
+    }
+  }
+
+  uint16_t crc = 0;
+  for (char c : key) {
+    crc ^= static_cast<uint16_t>(static_cast<uint16_t>(static_cast<unsigned char>(c)) << 8);
+    for (int i = 0; i < 8; ++i) {
+      if (crc & 0x8000) {
+        crc = static_cast<uint16_t>((crc << 1) ^ 0x1021);
+      } else {
+        crc = static_cast<uint16_t>(crc << 1);
+      }
+    }
+  }
+
+  return static_cast<uint16_t>(crc & 16383);
+}
+
 }  // namespace db
 }  // namespace rpc
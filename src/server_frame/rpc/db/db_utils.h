@@ -13,7 +13,9 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <cstddef>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "dispatcher/db_msg_dispatcher.h"
@@ -148,10 +150,70 @@ class redis_args {
   char* free_buffer_;
 };
 
-int unpack_message(::google::protobuf::Message& msg, const redisReply* reply, uint64_t& version, bool& record_existed);
+/**
+ * 打包消息到redis参数的函数，生成代码会为每个表生成一个不走反射的版本
+ * @param msg message
+ * @param args where to store arguments
+ * @param version version if need
+ * @param debug_message debug message if need
+ * @return 0 or error code
+ */
+using pack_message_fn_t = int (*)(const ::google::protobuf::Message& msg, redis_args& args, uint64_t* version,
+                                  std::ostream* debug_message);
+
+/**
+ * 解包单个字段的函数，生成代码会为每个表生成一个不走反射的版本
+ * @note 调用前已经跳过了REDIS_REPLY_NIL的值
+ * @param msg message
+ * @param field_name 字段名
+ * @param value 字段值
+ * @param has_failed 解包失败时设置为true
+ * @return 找到并处理了字段时返回true，否则返回false并由调用方走反射流程
+ */
+using unpack_field_fn_t = bool (*)(::google::protobuf::Message& msg, std::string_view field_name,
+                                   const redisReply* value, bool& has_failed);
+
+/**
+ * @brief 按字段类型直接打包到redis参数，给生成代码使用
+ * @note 格式和pack_message保持一致，字段值都以'&'开头
+ */
+class redis_message_packer {
+ public:
+  redis_message_packer(redis_args& args, std::ostream* debug_message);
+
+  bool pack_version(uint64_t version);
+
+  bool pack_field(std::string_view name, std::string_view value);
+  bool pack_field(std::string_view name, const ::google::protobuf::MessageLite& value);
+  bool pack_field(std::string_view name, int32_t value);
+  bool pack_field(std::string_view name, uint32_t value);
+  bool pack_field(std::string_view name, int64_t value);
+  bool pack_field(std::string_view name, uint64_t value);
+
+  void finish();
+
+ private:
+  bool pack_field_name(std::string_view name);
+  bool pack_integer(std::string_view name, const char* value, size_t value_len);
+
+ private:
+  redis_args& args_;
+  std::ostream* debug_message_;
+  size_t stat_sum_len_;
+};
+
+// 字段值都以'&'开头，和反射流程一致，只有前缀没有内容的值也视为解包失败
+bool unpack_field(const redisReply* value, std::string& out);
+bool unpack_field(const redisReply* value, ::google::protobuf::MessageLite& out);
+bool unpack_field(const redisReply* value, int64_t& out);
+bool unpack_field(const redisReply* value, uint64_t& out);
+
+int unpack_message(::google::protobuf::Message& msg, const redisReply* reply, uint64_t& version, bool& record_existed,
+                   unpack_field_fn_t unpack_field_fn = nullptr);
 
 int unpack_message_with_field(::google::protobuf::Message& msg, const redisReply* reply, std::string_view* fields,
-                              int32_t length, uint64_t& version, bool& record_existed);
+                              int32_t length, uint64_t& version, bool& record_existed,
+                              unpack_field_fn_t unpack_field_fn = nullptr);
 
 std::string get_list_value_field(uint64_t index);
 
@@ -178,6 +240,14 @@ int unpack_list_message_with_index(
 int pack_message(const ::google::protobuf::Message& msg, redis_args& args,
                  std::vector<const ::google::protobuf::FieldDescriptor*> fds, uint64_t* version,
                  std::ostream* debug_message);
+
+/**
+ * 计算key在Redis Cluster中的slot，和服务端的算法一致: CRC16(XMODEM) % 16384
+ * @note key中第一对{}之间不为空时，只计算{}中的部分(hash tag)，hash tag相同的key一定在同一个slot
+ * @param key key
+ * @return slot
+ */
+SERVER_FRAME_API uint16_t get_cluster_hash_slot(std::string_view key);
 }  // namespace db
 }  // namespace rpc
 
@@ -14,6 +14,7 @@
 #include <opentelemetry/semconv/incubating/db_attributes.h>
 #include <opentelemetry/semconv/incubating/rpc_attributes.h>
 
+#include <common/string_oprs.h>
 #include <log/log_wrapper.h>
 
 #include <hiredis_happ.h>
@@ -31,6 +32,62 @@ namespace rpc {
 namespace db {
 namespace hash_table {
 namespace key_value {
+namespace {
+static bool is_same_cluster_hash_slot(uint32_t channel, gsl::string_view l, gsl::string_view r) {
+  if (channel <= db_msg_dispatcher::channel_t::CLUSTER_BOUND ||
+      channel >= db_msg_dispatcher::channel_t::SENTINEL_BOUND) {
+    return true;
+  }
+
+  return rpc::db::get_cluster_hash_slot(l) == rpc::db::get_cluster_hash_slot(r);
+}
+
+static int32_t get_cas_pack_args_size(const google::protobuf::Message &store, pack_message_fn_t pack_fn,
+                                      std::vector<const ::google::protobuf::FieldDescriptor *> &fds) {
+  if (nullptr != pack_fn) {
+    // 生成的打包函数最多打包所有字段 + 版本号字段
+    return store.GetDescriptor()->field_count() * 2 + 2;
+  }
+
+  const google::protobuf::Reflection *reflect = store.GetReflection();
+  if (nullptr == reflect) {
+    FWLOGERROR("pack message {} failed, get reflection failed", store.GetDescriptor()->full_name());
+    return PROJECT_NAMESPACE_ID::err::EN_SYS_PACK;
+  }
+  reflect->ListFields(store, &fds);
+  return static_cast<int32_t>(fds.size()) * 2 + 2;
+}
+
+static int32_t unpack_cas_guard_result(rpc::context *, db_message_t &msg, const redisReply *reply) {
+  if (nullptr == reply || REDIS_REPLY_ARRAY != reply->type || reply->elements < 3) {
+    FWLOGERROR("{}", "unpack cas guard result failed, invalid reply");
+    return PROJECT_NAMESPACE_ID::err::EN_DB_REPLY_ERROR;
+  }
+
+  uint64_t values[3] = {0, 0, 0};
+  for (size_t i = 0; i < 3; ++i) {
+    const redisReply *element = reply->element[i];
+    if (nullptr == element) {
+      continue;
+    }
+    if (REDIS_REPLY_INTEGER == element->type) {
+      values[i] = static_cast<uint64_t>(element->integer);
+    } else if (REDIS_REPLY_STRING == element->type && nullptr != element->str) {
+      values[i] = atfw::util::string::to_int<uint64_t>(element->str);
+    }
+  }
+
+  // response_int: cas_guard_status
+  msg.head_message.set_response_int(values[0]);
+  msg.body_message_list.resize(2);
+  msg.body_message_list[0].list_index = 0;
+  msg.body_message_list[0].version = values[1];
+  msg.body_message_list[1].list_index = 1;
+  msg.body_message_list[1].version = values[2];
+  return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+}
+}  // namespace
+
 SERVER_FRAME_API result_type get_all(rpc::context &ctx, uint32_t channel, gsl::string_view key,
                                      atfw::util::memory::strong_rc_ptr<db_key_value_message_result_t> output,
                                      db_msg_dispatcher::unpack_fn_t unpack_fn) {
@@ -335,7 +392,8 @@ batch_partly_get(rpc::context &ctx, uint32_t channel, gsl::span<std::string> key
 }
 
 SERVER_FRAME_API result_type set(rpc::context &ctx, uint32_t channel, gsl::string_view key,
-                                 shared_abstract_message<google::protobuf::Message> &&store, uint64_t *version) {
+                                 shared_abstract_message<google::protobuf::Message> &&store, uint64_t *version,
+                                 pack_message_fn_t pack_fn) {
   rpc::context __child_ctx(ctx);
   rpc::telemetry::trace_attribute_pair_type __trace_attributes[] = {
       {opentelemetry::semconv::rpc::kRpcSystem, "atrpc.db"},
@@ -359,14 +417,19 @@ SERVER_FRAME_API result_type set(rpc::context &ctx, uint32_t channel, gsl::strin
   std::stringstream segs_debug_info;
 
   std::vector<const ::google::protobuf::FieldDescriptor *> fds;
-  const google::protobuf::Reflection *reflect = store->GetReflection();
-  if (nullptr == reflect) {
-    FWLOGERROR("pack message {} failed, get reflection failed", store->GetDescriptor()->full_name());
-    RPC_DB_RETURN_CODE(__tracer.finish({PROJECT_NAMESPACE_ID::err::EN_SYS_PACK, __trace_attributes}));
+  int32_t args_size;
+  if (nullptr != pack_fn) {
+    // 生成的打包函数最多打包所有字段
+    args_size = store->GetDescriptor()->field_count() * 2;
+  } else {
+    const google::protobuf::Reflection *reflect = store->GetReflection();
+    if (nullptr == reflect) {
+      FWLOGERROR("pack message {} failed, get reflection failed", store->GetDescriptor()->full_name());
+      RPC_DB_RETURN_CODE(__tracer.finish({PROJECT_NAMESPACE_ID::err::EN_SYS_PACK, __trace_attributes}));
+    }
+    reflect->ListFields(*store, &fds);
+    args_size = static_cast<int32_t>(fds.size()) * 2;
   }
-  reflect->ListFields(*store, &fds);
-
-  int32_t args_size = static_cast<int32_t>(fds.size()) * 2;
   if (version != nullptr) {
     // EVALSHA
     // sha1
@@ -389,7 +452,12 @@ SERVER_FRAME_API result_type set(rpc::context &ctx, uint32_t channel, gsl::strin
     args.push(key.data(), key.size());
   }
 
-  int res = rpc::db::pack_message(*store, args, fds, version, &segs_debug_info);
+  int res;
+  if (nullptr != pack_fn) {
+    res = pack_fn(*store, args, version, &segs_debug_info);
+  } else {
+    res = rpc::db::pack_message(*store, args, fds, version, &segs_debug_info);
+  }
   if (res < 0) {
     RPC_DB_RETURN_CODE(__tracer.finish({res, __trace_attributes}));
   }
@@ -438,6 +506,175 @@ SERVER_FRAME_API result_type set(rpc::context &ctx, uint32_t channel, gsl::strin
   RPC_DB_RETURN_CODE(__tracer.finish({PROJECT_NAMESPACE_ID::err::EN_SUCCESS, __trace_attributes}));
 }
 
+SERVER_FRAME_API int32_t apply_cas_guard_result(int64_t status, uint64_t guard_version, uint64_t data_version,
+                                                cas_guard_t &guard, uint64_t &version) {
+  guard.version = guard_version;
+  version = data_version;
+  switch (status) {
+    case static_cast<int64_t>(cas_guard_status::kSuccess):
+      guard.cas_failed = false;
+      guard.saved = true;
+      return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+    case static_cast<int64_t>(cas_guard_status::kGuardVersionMismatch):
+      guard.cas_failed = true;
+      guard.saved = false;
+      return PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION;
+    case static_cast<int64_t>(cas_guard_status::kDataVersionMismatch):
+      guard.cas_failed = false;
+      guard.saved = true;
+      return PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION;
+    default:
+      guard.cas_failed = false;
+      guard.saved = false;
+      return PROJECT_NAMESPACE_ID::err::EN_DB_REPLY_ERROR;
+  }
+}
+
+SERVER_FRAME_API result_type set_with_cas_guard(rpc::context &ctx, uint32_t channel, cas_guard_t &guard,
+                                                gsl::string_view key,
+                                                shared_abstract_message<google::protobuf::Message> &&store,
+                                                uint64_t &version, pack_message_fn_t pack_fn) {
+  guard.cas_failed = false;
+  guard.saved = false;
+  if (!guard.store) {
+    FWLOGERROR("table [key={}] save with cas guard {} failed, guard store is empty", key, guard.key);
+    RPC_DB_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SYS_PARAM);
+  }
+
+  // 集群模式下跨slot的脚本会返回CROSSSLOT错误，这时候退化为两次往返
+  if (!is_same_cluster_hash_slot(channel, guard.key, key)) {
+    FWLOGDEBUG("table [key={}] and cas guard [key={}] are not in the same slot, save them separately", key, guard.key);
+    auto res = RPC_AWAIT_CODE_RESULT(set(ctx, channel, guard.key,
+                                         shared_abstract_message<google::protobuf::Message>{*guard.store},
+                                         &guard.version, guard.pack_fn));
+    if (res < 0) {
+      guard.cas_failed = PROJECT_NAMESPACE_ID::err::EN_DB_OLD_VERSION == res;
+      RPC_DB_RETURN_CODE(res);
+    }
+    guard.saved = true;
+
+    res = RPC_AWAIT_CODE_RESULT(set(ctx, channel, key, std::move(store), &version, pack_fn));
+    RPC_DB_RETURN_CODE(res);
+  }
+
+  rpc::context __child_ctx(ctx);
+  rpc::telemetry::trace_attribute_pair_type __trace_attributes[] = {
+      {opentelemetry::semconv::rpc::kRpcSystem, "atrpc.db"},
+      {opentelemetry::semconv::rpc::kRpcService, "rpc.db.redis"},
+      {opentelemetry::semconv::rpc::kRpcMethod, "rpc.db.hash_table.key_value.set_with_cas_guard"},
+      {opentelemetry::semconv::db::kDbSystemName, opentelemetry::semconv::db::DbSystemValues::kRedis}};
+  rpc::telemetry::trace_start_option __trace_option;
+  __trace_option.dispatcher = std::static_pointer_cast<dispatcher_implement>(db_msg_dispatcher::me());
+  __trace_option.is_remote = true;
+  __trace_option.kind = atframework::RpcTraceSpan::SPAN_KIND_CLIENT;
+  __trace_option.attributes = __trace_attributes;
+
+  rpc::telemetry::tracer __tracer =
+      __child_ctx.make_tracer("rpc.db.hash_table.key_value.set_with_cas_guard", std::move(__trace_option));
+
+  if (ctx.get_task_context().task_id == 0) {
+    FWLOGERROR("current not in a task");
+    RPC_DB_RETURN_CODE(__tracer.finish({PROJECT_NAMESPACE_ID::err::EN_SYS_RPC_NO_TASK, __trace_attributes}));
+  }
+
+  std::stringstream segs_debug_info;
+
+  std::vector<const ::google::protobuf::FieldDescriptor *> guard_fds;
+  std::vector<const ::google::protobuf::FieldDescriptor *> fds;
+  int32_t guard_args_size = get_cas_pack_args_size(**guard.store, guard.pack_fn, guard_fds);
+  if (guard_args_size < 0) {
+    RPC_DB_RETURN_CODE(__tracer.finish({guard_args_size, __trace_attributes}));
+  }
+  int32_t data_args_size = get_cas_pack_args_size(*store, pack_fn, fds);
+  if (data_args_size < 0) {
+    RPC_DB_RETURN_CODE(__tracer.finish({data_args_size, __trace_attributes}));
+  }
+
+  // EVALSHA
+  // sha1
+  // numkeys
+  // guard key + key
+  // guard fields + data fields
+  // guard fields count
+  redis_args args(static_cast<size_t>(guard_args_size + data_args_size + 6));
+  args.push("EVALSHA");
+  args.push(
+      db_msg_dispatcher::me()->get_db_script_sha1(db_msg_dispatcher::script_type::kCompareAndSetHashTableWithGuard));
+  args.push(2);
+  args.push(guard.key);
+  args.push(key.data(), key.size());
+
+  size_t guard_args_begin = args.size();
+  int res;
+  if (nullptr != guard.pack_fn) {
+    res = guard.pack_fn(**guard.store, args, &guard.version, &segs_debug_info);
+  } else {
+    res = rpc::db::pack_message(**guard.store, args, guard_fds, &guard.version, &segs_debug_info);
+  }
+  if (res < 0) {
+    RPC_DB_RETURN_CODE(__tracer.finish({res, __trace_attributes}));
+  }
+  uint32_t guard_args_count = static_cast<uint32_t>(args.size() - guard_args_begin);
+
+  if (nullptr != pack_fn) {
+    res = pack_fn(*store, args, &version, &segs_debug_info);
+  } else {
+    res = rpc::db::pack_message(*store, args, fds, &version, &segs_debug_info);
+  }
+  if (res < 0) {
+    RPC_DB_RETURN_CODE(__tracer.finish({res, __trace_attributes}));
+  }
+  args.push(guard_args_count);
+
+  FWLOGDEBUG("table [key={}] start to save data with cas guard [key={}], expect version: {}, guard version: {}", key,
+             guard.key, version, guard.version);
+
+  uint64_t rpc_sequence = 0;
+  res = db_msg_dispatcher::me()->send_msg(
+      static_cast<db_msg_dispatcher::channel_t::type>(channel), key.data(), key.size(), ctx.get_task_context().task_id,
+      logic_config::me()->get_local_server_id(), unpack_cas_guard_result, rpc_sequence, static_cast<int>(args.size()),
+      args.get_args_values(), args.get_args_lengths());
+
+  // args unavailable now
+
+  if (res < 0) {
+    RPC_DB_RETURN_CODE(__tracer.finish({res, __trace_attributes}));
+  }
+
+  dispatcher_await_options await_options = dispatcher_make_default<dispatcher_await_options>();
+  await_options.sequence = rpc_sequence;
+  await_options.timeout =
+      rpc::make_duration_or_default(logic_config::me()->get_server_cfg().task().csmsg().timeout(), std::chrono::seconds{6});
+
+  // 协程操作
+  db_message_t db_message;
+  res = RPC_AWAIT_CODE_RESULT(rpc::wait(ctx, db_message, await_options));
+  if (res < 0) {
+    RPC_DB_RETURN_CODE(__tracer.finish({res, __trace_attributes}));
+  }
+
+  if (db_message.body_message_list.size() < 2) {
+    FWLOGERROR("table [key={}] save with cas guard [key={}] failed, result count {} is invalid", key, guard.key,
+               db_message.body_message_list.size());
+    RPC_DB_RETURN_CODE(__tracer.finish({PROJECT_NAMESPACE_ID::err::EN_DB_REPLY_ERROR, __trace_attributes}));
+  }
+
+  // 和 set 一致，版本号不匹配时也返回当前的版本号
+  res = apply_cas_guard_result(static_cast<int64_t>(db_message.head_message.response_int()),
+                               db_message.body_message_list[0].version, db_message.body_message_list[1].version, guard,
+                               version);
+  if (res < 0) {
+    FWLOGINFO("table [key={}] save with cas guard [key={}] failed, result: {}, {} version mismatch, real version: {}, "
+              "guard: {}",
+              key, guard.key, res, guard.cas_failed ? "guard" : "table", version, guard.version);
+    RPC_DB_RETURN_CODE(__tracer.finish({res, __trace_attributes}));
+  }
+
+  FWLOGINFO("table [key={}] data saved with cas guard [key={}], new cas_version: {}, guard cas_version: {}, detail: {}",
+            key, guard.key, version, guard.version, segs_debug_info.str());
+  RPC_DB_RETURN_CODE(__tracer.finish({PROJECT_NAMESPACE_ID::err::EN_SUCCESS, __trace_attributes}));
+}
+
 SERVER_FRAME_API result_type inc_field(rpc::context &ctx, uint32_t channel, gsl::string_view key,
                                        gsl::string_view inc_field,
                                        shared_abstract_message<google::protobuf::Message> &message,
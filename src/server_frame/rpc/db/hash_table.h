@@ -29,6 +29,40 @@ class context;
 namespace db {
 namespace hash_table {
 namespace key_value {
+/**
+ * @brief 保存数据表时一起校验并续期的守护表(比如登入锁)，必须开启CAS
+ */
+struct cas_guard_t {
+  std::string key;
+  atfw::util::memory::strong_rc_ptr<shared_abstract_message<google::protobuf::Message>> store;
+  uint64_t version;
+  pack_message_fn_t pack_fn;
+  // 返回 EN_DB_OLD_VERSION 时，标记是否是守护表的版本号不匹配
+  bool cas_failed;
+  // 守护表是否已经写入(数据表版本号不匹配或者退化为两次往返时，数据表没保存成功守护表也可能已经写入)
+  bool saved;
+};
+
+/**
+ * @brief 校验守护表时脚本返回的状态
+ */
+enum class cas_guard_status : int32_t {
+  kSuccess = 0,               // 守护表和数据表都已写入
+  kGuardVersionMismatch = 1,  // 守护表版本号不匹配，都没有写入
+  kDataVersionMismatch = 2,   // 数据表版本号不匹配，只写入了守护表
+};
+
+/**
+ * @brief 根据脚本返回的状态更新守护表和数据表的版本号
+ * @param status 脚本返回的状态，参考 cas_guard_status
+ * @param guard_version 守护表的版本号
+ * @param data_version 数据表的版本号
+ * @return 成功返回0，版本号不匹配返回 EN_DB_OLD_VERSION，未知状态返回 EN_DB_REPLY_ERROR
+ */
+EXPLICIT_NODISCARD_ATTR SERVER_FRAME_API int32_t apply_cas_guard_result(int64_t status, uint64_t guard_version,
+                                                                        uint64_t data_version, cas_guard_t &guard,
+                                                                        uint64_t &version);
+
 EXPLICIT_NODISCARD_ATTR SERVER_FRAME_API result_type get_all(
     rpc::context &ctx, uint32_t channel, gsl::string_view key,
     atfw::util::memory::strong_rc_ptr<db_key_value_message_result_t> output, db_msg_dispatcher::unpack_fn_t unpack_fn);
@@ -49,9 +83,25 @@ batch_partly_get(rpc::context &ctx, uint32_t channel, gsl::span<std::string> key
                  std::vector<atfw::util::memory::strong_rc_ptr<db_key_value_message_result_t>> &output,
                  db_msg_dispatcher::unpack_fn_t unpack_fn);
 
+/**
+ * @brief 保存整个表
+ * @param pack_fn 生成代码提供的打包函数，为空时使用反射打包所有已设置的字段
+ */
 EXPLICIT_NODISCARD_ATTR SERVER_FRAME_API result_type set(rpc::context &ctx, uint32_t channel, gsl::string_view key,
                                                          shared_abstract_message<google::protobuf::Message> &&store,
-                                                         uint64_t *version);
+                                                         uint64_t *version, pack_message_fn_t pack_fn = nullptr);
+
+/**
+ * @brief 校验并续期守护表，同时保存整个表。两个表的CAS在同一个脚本里原子执行，只需要一次往返
+ * @note 数据表版本号不匹配时守护表仍然会续期(guard.saved 为 true)，调用方只需要重试数据表。
+ *       集群模式下两个key不在同一个slot时，退化为先保存守护表再保存数据表
+ * @param guard 守护表，成功或版本号不匹配时会更新 guard.version
+ * @param version 数据表的期望版本号，成功或版本号不匹配时返回新的版本号
+ * @param pack_fn 生成代码提供的打包函数，为空时使用反射打包所有已设置的字段
+ */
+EXPLICIT_NODISCARD_ATTR SERVER_FRAME_API result_type set_with_cas_guard(
+    rpc::context &ctx, uint32_t channel, cas_guard_t &guard, gsl::string_view key,
+    shared_abstract_message<google::protobuf::Message> &&store, uint64_t &version, pack_message_fn_t pack_fn = nullptr);
 
 EXPLICIT_NODISCARD_ATTR SERVER_FRAME_API result_type
 inc_field(rpc::context &ctx, uint32_t channel, gsl::string_view key, gsl::string_view inc_field,
@@ -26,6 +26,23 @@
 #include "rpc/telemetry/rpc_global_service.h"
 #include "rpc/telemetry/rpc_trace.h"
 
+#include <algorithm>
+#include <atomic>
+
+// 每个线程缓存的Arena最大数量
+#ifndef PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MAX_COUNT
+#  define PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MAX_COUNT 128
+#endif
+
+// 预分配的初始块大小范围，根据最近的使用量在这个范围内按2的幂次调整
+#ifndef PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MIN_BLOCK_SIZE
+#  define PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MIN_BLOCK_SIZE 512
+#endif
+
+#ifndef PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MAX_BLOCK_SIZE
+#  define PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MAX_BLOCK_SIZE 16384
+#endif
+
 namespace rpc {
 
 namespace {
@@ -55,6 +72,135 @@ static rpc_context_mertrics_data &get_rpc_context_mertrics_data() noexcept {
   return g_rpc_context_mertrics_data;
 }
 
+// Arena池的统计数据，各个线程共享
+struct ATFW_UTIL_SYMBOL_LOCAL rpc_arena_pool_mertrics_data {
+  std::atomic<int64_t> hit_count{0};
+  std::atomic<int64_t> miss_count{0};
+  std::atomic<int64_t> reserved_bytes{0};
+  std::atomic<int64_t> pooled_count{0};
+};
+
+static rpc_arena_pool_mertrics_data &get_rpc_arena_pool_mertrics_data() noexcept {
+  static rpc_arena_pool_mertrics_data g_rpc_arena_pool_mertrics_data;
+  return g_rpc_arena_pool_mertrics_data;
+}
+
+struct ATFW_UTIL_SYMBOL_LOCAL rpc_arena_pool_entry {
+  size_t initial_block_size;
+  std::unique_ptr<char[]> initial_block;
+  ::google::protobuf::Arena arena;
+
+  static ::google::protobuf::ArenaOptions make_options(char *block, size_t block_size) noexcept {
+    ::google::protobuf::ArenaOptions arena_options;
+    arena_options.start_block_size = 512;  // 链路跟踪可能就占了200字节，起始可以大一点
+    arena_options.max_block_size = 65536;  // 数据库的数据块比较大。最大值可以大一点
+    // 使用外部提供的初始块，Reset()后会保留这个块，复用时不需要再分配
+    arena_options.initial_block = block;
+    arena_options.initial_block_size = block_size;
+    return arena_options;
+  }
+
+  explicit rpc_arena_pool_entry(size_t block_size)
+      : initial_block_size(block_size),
+        initial_block(new char[block_size]),
+        arena(make_options(initial_block.get(), block_size)) {
+    get_rpc_arena_pool_mertrics_data().reserved_bytes.fetch_add(static_cast<int64_t>(initial_block_size),
+                                                                std::memory_order_relaxed);
+  }
+
+  ~rpc_arena_pool_entry() {
+    get_rpc_arena_pool_mertrics_data().reserved_bytes.fetch_sub(static_cast<int64_t>(initial_block_size),
+                                                                std::memory_order_relaxed);
+  }
+};
+
+/**
+ * @brief 每个线程一个的Arena池
+ * @note Arena在最后一个引用释放时回收到当前线程的池里，初始块的大小跟随最近的使用量调整
+ */
+class ATFW_UTIL_SYMBOL_LOCAL rpc_arena_pool {
+ public:
+  rpc_arena_pool() noexcept : recent_space_used_(PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MIN_BLOCK_SIZE) {}
+
+  ~rpc_arena_pool() {
+    get_rpc_arena_pool_mertrics_data().pooled_count.fetch_sub(static_cast<int64_t>(free_entries_.size()),
+                                                              std::memory_order_relaxed);
+    free_entries_.clear();
+    destroyed_ = true;
+  }
+
+  static rpc_arena_pool *get_current() noexcept {
+    if (destroyed_) {
+      return nullptr;
+    }
+
+    static thread_local rpc_arena_pool current;
+    return &current;
+  }
+
+  std::shared_ptr<::google::protobuf::Arena> acquire() {
+    std::unique_ptr<rpc_arena_pool_entry> entry;
+    if (!free_entries_.empty()) {
+      entry = std::move(free_entries_.back());
+      free_entries_.pop_back();
+      get_rpc_arena_pool_mertrics_data().pooled_count.fetch_sub(1, std::memory_order_relaxed);
+      get_rpc_arena_pool_mertrics_data().hit_count.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      entry.reset(new rpc_arena_pool_entry(get_suggest_block_size()));
+      get_rpc_arena_pool_mertrics_data().miss_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ::google::protobuf::Arena *arena = &entry->arena;
+    return std::shared_ptr<::google::protobuf::Arena>(arena, [entry = entry.release()](::google::protobuf::Arena *) {
+      recycle(std::unique_ptr<rpc_arena_pool_entry>{entry});
+    });
+  }
+
+ private:
+  static void recycle(std::unique_ptr<rpc_arena_pool_entry> entry) {
+    rpc_arena_pool *pool = get_current();
+    // 线程退出以后直接释放
+    if (nullptr == pool) {
+      return;
+    }
+
+    pool->push(std::move(entry));
+  }
+
+  void push(std::unique_ptr<rpc_arena_pool_entry> entry) {
+    // 滑动平均，避免偶尔的大消息导致初始块过大
+    size_t space_used = static_cast<size_t>(entry->arena.SpaceUsed());
+    recent_space_used_ = recent_space_used_ - recent_space_used_ / 8 + space_used / 8;
+
+    // 和当前建议大小差距过大的直接释放，下次按新的大小分配
+    size_t suggest_block_size = get_suggest_block_size();
+    if (free_entries_.size() >= PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MAX_COUNT ||
+        entry->initial_block_size * 2 < suggest_block_size || entry->initial_block_size > suggest_block_size * 2) {
+      return;
+    }
+
+    entry->arena.Reset();
+    free_entries_.emplace_back(std::move(entry));
+    get_rpc_arena_pool_mertrics_data().pooled_count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  size_t get_suggest_block_size() const noexcept {
+    size_t expect = recent_space_used_ + recent_space_used_ / 4;
+    size_t ret = PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MIN_BLOCK_SIZE;
+    while (ret < expect && ret < PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MAX_BLOCK_SIZE) {
+      ret <<= 1;
+    }
+    return (std::min)(ret, static_cast<size_t>(PROJECT_SERVER_FRAME_RPC_ARENA_POOL_MAX_BLOCK_SIZE));
+  }
+
+ private:
+  static thread_local bool destroyed_;
+  size_t recent_space_used_;
+  std::vector<std::unique_ptr<rpc_arena_pool_entry>> free_entries_;
+};
+
+thread_local bool rpc_arena_pool::destroyed_ = false;
+
 static void calculate_trace_span_permillage(time_t now) {
   int64_t current_rate = 0x1000000;
   auto &trace_configure = logic_config::me()->get_server_cfg().task().trace();
@@ -279,6 +425,12 @@ SERVER_FRAME_API std::shared_ptr<::google::protobuf::Arena> context::mutable_pro
     return allocator_;
   }
 
+  rpc_arena_pool *pool = rpc_arena_pool::get_current();
+  if (nullptr != pool) {
+    allocator_ = pool->acquire();
+    return allocator_;
+  }
+
   ::google::protobuf::ArenaOptions arena_options;
   arena_options.start_block_size = 512;  // 链路跟踪可能就占了200字节，起始可以大一点
   arena_options.max_block_size = 65536;  // 数据库的数据块比较大。最大值可以大一点
@@ -391,6 +543,52 @@ SERVER_FRAME_API void context::set_current_service(atfw::atapp::app &app,
           rpc::telemetry::opentelemetry_utility::global_metics_observe_record(
               result, get_rpc_context_mertrics_data().total_drop_trace_span_count);
         });
+
+    rpc::telemetry::opentelemetry_utility::add_global_metics_observable_int64(
+        rpc::telemetry::metrics_observable_type::kGauge, "atframework_rpc_context",
+        {"atframework_rpc_context_arena_pool_hit_count", "", ""},
+        [](rpc::telemetry::opentelemetry_utility::metrics_observer &result) {
+          rpc::telemetry::opentelemetry_utility::global_metics_observe_record(
+              result, get_rpc_arena_pool_mertrics_data().hit_count.load(std::memory_order_relaxed));
+        });
+
+    rpc::telemetry::opentelemetry_utility::add_global_metics_observable_int64(
+        rpc::telemetry::metrics_observable_type::kGauge, "atframework_rpc_context",
+        {"atframework_rpc_context_arena_pool_miss_count", "", ""},
+        [](rpc::telemetry::opentelemetry_utility::metrics_observer &result) {
+          rpc::telemetry::opentelemetry_utility::global_metics_observe_record(
+              result, get_rpc_arena_pool_mertrics_data().miss_count.load(std::memory_order_relaxed));
+        });
+
+    // 命中率(千分比)
+    rpc::telemetry::opentelemetry_utility::add_global_metics_observable_int64(
+        rpc::telemetry::metrics_observable_type::kGauge, "atframework_rpc_context",
+        {"atframework_rpc_context_arena_pool_hit_permillage", "", ""},
+        [](rpc::telemetry::opentelemetry_utility::metrics_observer &result) {
+          int64_t hit_count = get_rpc_arena_pool_mertrics_data().hit_count.load(std::memory_order_relaxed);
+          int64_t miss_count = get_rpc_arena_pool_mertrics_data().miss_count.load(std::memory_order_relaxed);
+          int64_t permillage = 0;
+          if (hit_count + miss_count > 0) {
+            permillage = hit_count * 1000 / (hit_count + miss_count);
+          }
+          rpc::telemetry::opentelemetry_utility::global_metics_observe_record(result, permillage);
+        });
+
+    rpc::telemetry::opentelemetry_utility::add_global_metics_observable_int64(
+        rpc::telemetry::metrics_observable_type::kGauge, "atframework_rpc_context",
+        {"atframework_rpc_context_arena_pool_reserved_bytes", "", ""},
+        [](rpc::telemetry::opentelemetry_utility::metrics_observer &result) {
+          rpc::telemetry::opentelemetry_utility::global_metics_observe_record(
+              result, get_rpc_arena_pool_mertrics_data().reserved_bytes.load(std::memory_order_relaxed));
+        });
+
+    rpc::telemetry::opentelemetry_utility::add_global_metics_observable_int64(
+        rpc::telemetry::metrics_observable_type::kGauge, "atframework_rpc_context",
+        {"atframework_rpc_context_arena_pool_pooled_count", "", ""},
+        [](rpc::telemetry::opentelemetry_utility::metrics_observer &result) {
+          rpc::telemetry::opentelemetry_utility::global_metics_observe_record(
+              result, get_rpc_arena_pool_mertrics_data().pooled_count.load(std::memory_order_relaxed));
+        });
   }
 }
 
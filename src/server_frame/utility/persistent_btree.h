@@ -2,11 +2,15 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <memory>
+#include <new>
 #include <numeric>
 #include <stack>
+#include <utility>
 #include <vector>
 
 #include "memory/rc_ptr.h"
@@ -14,11 +18,139 @@
 template <typename Type, typename Alloc>
 class persistent_btree;
 
-template <typename Type>
+/**
+ * @brief 节点内的定长数组，内存由节点统一分配，不会扩容
+ * @note B树的节点大小有上限(key最多2T-1个，子节点最多2T个)，所以不需要std::vector的扩容能力
+ */
+template <typename Element>
+class btree_node_array {
+ public:
+  using value_type = Element;
+  using iterator = Element*;
+  using const_iterator = const Element*;
+  using reference = Element&;
+  using const_reference = const Element&;
+
+  btree_node_array() noexcept : data_(nullptr), size_(0), capacity_(0) {}
+  ~btree_node_array() { clear(); }
+
+  btree_node_array(const btree_node_array&) = delete;
+  btree_node_array& operator=(const btree_node_array&) = delete;
+
+  void reset_storage(Element* data, size_t capacity) noexcept {
+    assert(0 == size_);
+    data_ = data;
+    capacity_ = capacity;
+  }
+
+  inline size_t size() const noexcept { return size_; }
+  inline size_t capacity() const noexcept { return capacity_; }
+  inline bool empty() const noexcept { return 0 == size_; }
+  inline Element* data() noexcept { return data_; }
+
+  inline iterator begin() noexcept { return data_; }
+  inline iterator end() noexcept { return data_ + size_; }
+  inline const_iterator begin() const noexcept { return data_; }
+  inline const_iterator end() const noexcept { return data_ + size_; }
+
+  inline reference operator[](size_t pos) noexcept { return data_[pos]; }
+  inline const_reference operator[](size_t pos) const noexcept { return data_[pos]; }
+  inline reference front() noexcept { return data_[0]; }
+  inline reference back() noexcept { return data_[size_ - 1]; }
+  inline const_reference front() const noexcept { return data_[0]; }
+  inline const_reference back() const noexcept { return data_[size_ - 1]; }
+
+  void push_back(Element value) {
+    assert(size_ < capacity_);
+    new (data_ + size_) Element(std::move(value));
+    ++size_;
+  }
+
+  void pop_back() noexcept {
+    assert(size_ > 0);
+    --size_;
+    data_[size_].~Element();
+  }
+
+  iterator insert(const_iterator pos, Element value) {
+    size_t offset = static_cast<size_t>(pos - data_);
+    resize(size_ + 1);
+    std::move_backward(data_ + offset, data_ + size_ - 1, data_ + size_);
+    data_[offset] = std::move(value);
+    return data_ + offset;
+  }
+
+  template <class InputIt>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    size_t offset = static_cast<size_t>(pos - data_);
+    size_t count = static_cast<size_t>(std::distance(first, last));
+    size_t old_size = size_;
+    resize(size_ + count);
+    std::move_backward(data_ + offset, data_ + old_size, data_ + size_);
+    std::copy(first, last, data_ + offset);
+    return data_ + offset;
+  }
+
+  iterator erase(const_iterator pos) {
+    size_t offset = static_cast<size_t>(pos - data_);
+    std::move(data_ + offset + 1, data_ + size_, data_ + offset);
+    pop_back();
+    return data_ + offset;
+  }
+
+  template <class InputIt>
+  void assign(InputIt first, InputIt last) {
+    clear();
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+
+  void resize(size_t sz) {
+    assert(sz <= capacity_);
+    while (size_ > sz) {
+      pop_back();
+    }
+    while (size_ < sz) {
+      new (data_ + size_) Element();
+      ++size_;
+    }
+  }
+
+  void clear() noexcept {
+    while (size_ > 0) {
+      pop_back();
+    }
+  }
+
+ private:
+  Element* data_;
+  size_t size_;
+  size_t capacity_;
+};
+
+/**
+ * @brief B树节点
+ * @note keys和children的定长数组放在同一块内存里，每个节点只有节点本身和数组两次分配，叶子节点不分配children
+ * @note 所有内存都通过树的分配器分配，配合persistent_btree_slab_allocator可以避免大量小对象的malloc/free
+ */
+template <typename Type, typename Alloc = std::allocator<Type>>
 struct btree_node {
   using value_type = Type;
-  using btree_node_pointer = util::memory::strong_rc_ptr<btree_node<Type>>;
+  using allocator_type = Alloc;
+  using value_pointer = util::memory::strong_rc_ptr<value_type>;
+  using btree_node_pointer = util::memory::strong_rc_ptr<btree_node<Type, Alloc>>;
+  using key_array = btree_node_array<value_pointer>;
+  using child_array = btree_node_array<btree_node_pointer>;
 
+ private:
+  using storage_unit = std::max_align_t;
+  using storage_allocator_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<storage_unit>;
+  using storage_allocator_traits = std::allocator_traits<storage_allocator_type>;
+
+  static_assert(alignof(btree_node_pointer) <= alignof(value_pointer), "children must be aligned after keys");
+
+ public:
   bool is_leaf() { return leaf_; }
 
   int32_t last_child_pos() { return static_cast<int32_t>(keys.size()); }
@@ -52,28 +184,90 @@ struct btree_node {
     }
   }
 
-  btree_node(bool leaf, size_t sz) : leaf_(leaf), tree_sz_(0) {
-    keys.reserve(sz);
-    children.reserve(sz);
+  btree_node(const allocator_type& alloc, bool leaf, size_t sz)
+      : leaf_(leaf), tree_sz_(0), allocator_(alloc), storage_(nullptr), storage_units_(0) {
+    allocate_storage(sz, leaf ? 0 : sz + 1);
   }
 
-  btree_node(const util::memory::strong_rc_ptr<btree_node<value_type>>& node, size_t sz) {
+  btree_node(const allocator_type& alloc, const btree_node_pointer& node, size_t sz)
+      : leaf_(true), tree_sz_(0), allocator_(alloc), storage_(nullptr), storage_units_(0) {
     if (!node) {
+      allocate_storage(sz, 0);
       return;
     }
-    keys.reserve(sz);
-    children.reserve(sz);
     leaf_ = node->leaf_;
     tree_sz_ = node->tree_sz_;
+    allocate_storage(sz, leaf_ ? 0 : sz + 1);
     keys.assign(node->keys.begin(), node->keys.end());
     children.assign(node->children.begin(), node->children.end());
   }
+
+  btree_node(const btree_node&) = delete;
+
+  // 合并根节点时会整体覆盖节点内容
+  btree_node& operator=(const btree_node& other) {
+    if (this == &other) {
+      return *this;
+    }
+
+    if (other.children.size() > children.capacity()) {
+      size_t key_capacity = keys.capacity() > other.keys.capacity() ? keys.capacity() : other.keys.capacity();
+      keys.clear();
+      children.clear();
+      deallocate_storage();
+      allocate_storage(key_capacity, other.children.capacity());
+    }
+
+    leaf_ = other.leaf_;
+    tree_sz_ = other.tree_sz_;
+    keys.assign(other.keys.begin(), other.keys.end());
+    children.assign(other.children.begin(), other.children.end());
+    return *this;
+  }
+
+  ~btree_node() {
+    keys.clear();
+    children.clear();
+    deallocate_storage();
+  }
+
   // friend class btree_iterator;
 
   bool leaf_;
   size_t tree_sz_;  // 子树key大小
-  std::vector<util::memory::strong_rc_ptr<value_type>> keys;
-  std::vector<util::memory::strong_rc_ptr<btree_node<value_type>>> children;
+  key_array keys;
+  child_array children;
+
+ private:
+  void allocate_storage(size_t key_capacity, size_t child_capacity) {
+    size_t bytes = key_capacity * sizeof(value_pointer) + child_capacity * sizeof(btree_node_pointer);
+    storage_units_ = (bytes + sizeof(storage_unit) - 1) / sizeof(storage_unit);
+
+    storage_allocator_type storage_allocator(allocator_);
+    storage_ = storage_units_ > 0 ? storage_allocator_traits::allocate(storage_allocator, storage_units_) : nullptr;
+
+    unsigned char* base = reinterpret_cast<unsigned char*>(storage_);
+    keys.reset_storage(reinterpret_cast<value_pointer*>(base), key_capacity);
+    children.reset_storage(
+        child_capacity > 0 ? reinterpret_cast<btree_node_pointer*>(base + key_capacity * sizeof(value_pointer))
+                           : nullptr,
+        child_capacity);
+  }
+
+  void deallocate_storage() noexcept {
+    if (nullptr != storage_) {
+      storage_allocator_type storage_allocator(allocator_);
+      storage_allocator_traits::deallocate(storage_allocator, storage_, storage_units_);
+    }
+    storage_ = nullptr;
+    storage_units_ = 0;
+    keys.reset_storage(nullptr, 0);
+    children.reset_storage(nullptr, 0);
+  }
+
+  allocator_type allocator_;
+  storage_unit* storage_;
+  size_t storage_units_;
 };
 
 template <typename Node>
@@ -218,7 +412,7 @@ class btree_mirror {
   using reference = value_type&;
   using const_reference = const value_type&;
 
-  using node_type = btree_node<value_type>;
+  using node_type = btree_node<value_type, allocator_type>;
   using const_node = const node_type;
   using btree_node_pointer = util::memory::strong_rc_ptr<node_type>;
   using btree_pointer = util::memory::strong_rc_ptr<persistent_btree<Type, Alloc>>;
@@ -260,6 +454,18 @@ class btree_mirror {
 
   size_t size() { return root_->tree_sz_; }
 
+  /**
+   * @brief 按顺序访问镜像中从第from名(从1开始)开始的最多count个元素
+   * @note 镜像持有创建时的根节点，不受之后的更新影响。分页导出时用下一页的起始排名作为游标，
+   *       每页只做一次从根到叶子的查找，不需要保存迭代器，也不会复制整棵树
+   * @param fn 回调，参数为(size_t 排名, const value_pointer& 元素)，返回false时停止
+   * @return 访问的元素个数
+   */
+  template <class TFn>
+  size_t visit_range(size_t from, size_t count, TFn&& fn) {
+    return tree_->visit_range(root_, from, count, std::forward<TFn>(fn));
+  }
+
   friend class persistent_btree<Type, Alloc>;
 
  private:
@@ -277,7 +483,7 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
   using reference = value_type&;
   using const_reference = const value_type&;
 
-  using node_type = btree_node<value_type>;
+  using node_type = btree_node<value_type, allocator_type>;
   using btree_node_pointer = util::memory::strong_rc_ptr<node_type>;
   using const_btree_node_pointer = const util::memory::strong_rc_ptr<node_type>;
 
@@ -294,11 +500,22 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
     compare_fn_ = std::less<value_type>();
   }
 
-  persistent_btree(size_t degree, size_t max_version_sz, compare_fn_t compare_fn)
-      : T(degree), max_root_version_size_(max_version_sz), compare_fn_(compare_fn) {
+  persistent_btree(size_t degree, size_t max_version_sz, compare_fn_t compare_fn,
+                   const allocator_type& alloc = allocator_type())
+      : T(degree), max_root_version_size_(max_version_sz), compare_fn_(compare_fn), allocator_(alloc) {
     root_ = allocator_new_node(true);
   }
 
+  /**
+   * @brief 用已经排好序的数据批量建树
+   * @note values必须按compare_fn有序，key会和调用方共享，复杂度为O(n)
+   */
+  persistent_btree(size_t degree, size_t max_version_sz, compare_fn_t compare_fn,
+                   const std::vector<value_pointer>& values, const allocator_type& alloc = allocator_type())
+      : T(degree), max_root_version_size_(max_version_sz), compare_fn_(compare_fn), allocator_(alloc) {
+    assign_sorted(values);
+  }
+
   iterator begin() {
     btree_node_pointer node = root_;
     std::stack<std::pair<btree_node_pointer, size_t>> path;
@@ -356,9 +573,8 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
   const util::memory::strong_rc_ptr<value_type> get_min_key() { return get_min_key(root_); }
 
   mirror_pointer create_mirror() {
-    using alloc_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<mirror_type>;
     auto ptr = this->shared_from_this();
-    return util::memory::allocate_strong_rc<mirror_type>(alloc_type(), ptr, root_);
+    return util::memory::allocate_strong_rc<mirror_type>(allocator_, ptr, root_);
   }
 
   const util::memory::strong_rc_ptr<value_type> get_min_key(btree_node_pointer node) {
@@ -376,6 +592,39 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
     root_->leaf_ = true;
   }
 
+  /**
+   * @brief 用已经排好序的数据替换整棵树
+   * @note 不走逐个插入的分裂流程，按层直接打包节点，每个节点只分配一次，复杂度为O(n)
+   * @note values必须按compare_fn有序，调用方可以用is_sorted检查
+   */
+  void assign_sorted(const std::vector<value_pointer>& values) {
+    if (values.empty()) {
+      clear();
+      return;
+    }
+
+    // max_sizes[h - 1]为高度h的子树最多能放的key数量: (2T)^h - 1
+    std::vector<size_t> max_sizes;
+    max_sizes.push_back(2 * T - 1);
+    while (max_sizes.back() < values.size()) {
+      max_sizes.push_back(max_sizes.back() * 2 * T + 2 * T - 1);
+    }
+
+    root_ = build_sorted_subtree(values, 0, values.size(), max_sizes, max_sizes.size());
+  }
+
+  /**
+   * @brief 检查数据是否按树的顺序排列，相等的元素允许相邻
+   */
+  bool is_sorted(const std::vector<value_pointer>& values) {
+    for (size_t i = 1; i < values.size(); ++i) {
+      if (!values[i - 1] || !values[i] || compare_fn_(*values[i], *values[i - 1])) {
+        return false;
+      }
+    }
+    return values.empty() || values[0];
+  }
+
   bool contains(const value_type& key) { return contains(root_, key); }
 
   bool value_comp(const value_type& l, const value_type& r) { return compare_fn_(l, r); }
@@ -433,7 +682,76 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
     return;
   }
 
-  void insert(const value_type& key) { root_ = insert_not_full(root_, key); }
+  void insert(const value_type& key) { root_ = insert_not_full(root_, allocator_key_ptr(key)); }
+
+  /**
+   * @brief 直接插入已经分配好的key，key会和调用方共享
+   * @note 插入后key的排序字段不能再修改，否则会破坏所有版本的树结构
+   */
+  void insert(const value_pointer& key) { root_ = insert_not_full(root_, key); }
+
+  /**
+   * @brief 使用树的分配器创建key，用于和insert(const value_pointer&)配合
+   */
+  value_pointer make_value(const value_type& key) { return allocator_key_ptr(key); }
+
+  /**
+   * @brief 统计排在最前面的满足is_before的元素个数
+   * @note is_before必须和树的顺序一致，即满足条件的元素都排在不满足条件的元素之前
+   * @note 只做一次从根到叶子的查找，每层二分查找，复杂度为O(log(n))
+   * @param is_before 判定函数，参数为const value_type&
+   * @return 满足条件的元素个数，也就是第一个不满足条件的元素的排名-1
+   */
+  template <class TPred>
+  size_t count_prefix(TPred&& is_before) {
+    size_t ret = 0;
+    node_type* node = root_.get();
+    while (nullptr != node) {
+      size_t st = 0;
+      size_t ed = node->keys.size();
+      while (st < ed) {
+        size_t mid = (st + ed) >> 1;
+        if (is_before(*node->keys[mid])) {
+          st = mid + 1;
+        } else {
+          ed = mid;
+        }
+      }
+
+      if (node->leaf_) {
+        return ret + st;
+      }
+      for (size_t i = 0; i < st; ++i) {
+        ret += node->children[i]->tree_sz_ + 1;
+      }
+      node = node->children[st].get();
+    }
+    return ret;
+  }
+
+  /**
+   * @brief 按顺序访问从第from名(从1开始)开始的最多count个元素
+   * @note 利用子树大小跳过前面的子树，只做一次从根到叶子的查找，然后按中序遍历，不分配内存
+   * @param fn 回调，参数为(size_t 排名, const value_pointer& 元素)，返回false时停止
+   * @return 访问的元素个数
+   */
+  template <class TFn>
+  size_t visit_range(size_t from, size_t count, TFn&& fn) {
+    return visit_range(root_, from, count, std::forward<TFn>(fn));
+  }
+
+  template <class TFn>
+  size_t visit_range(const btree_node_pointer& root, size_t from, size_t count, TFn&& fn) {
+    if (!root || 0 == from || 0 == count || from > root->tree_sz_) {
+      return 0;
+    }
+
+    size_t skip = from - 1;
+    size_t remain = count;
+    size_t rank_no = from;
+    visit_range_inner(root.get(), skip, remain, rank_no, fn);
+    return rank_no - from;
+  }
 
   void traverse(btree_node_pointer btree_node, int32_t level = 1) {
     if (!btree_node) return;
@@ -483,6 +801,8 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
 
   const_btree_node_pointer get_root() { return root_; }
 
+  const allocator_type& get_allocator() const noexcept { return allocator_; }
+
  private:
   void split_child(btree_node_pointer btree_node, size_t i) {
     assert(i < btree_node->children.size());
@@ -508,7 +828,44 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
     btree_node->tree_sz_ = origin_tree_sz;
   }
 
-  btree_node_pointer insert_not_full(btree_node_pointer btree_node, const value_type& key) {
+  // 把values[begin, begin + count)打包成高度为height的子树，每个子节点平均分配key，保证满足B树的最少key数量
+  btree_node_pointer build_sorted_subtree(const std::vector<value_pointer>& values, size_t begin, size_t count,
+                                          const std::vector<size_t>& max_sizes, size_t height) {
+    if (height <= 1) {
+      btree_node_pointer leaf = allocator_new_node(true);
+      for (size_t i = 0; i < count; ++i) {
+        leaf->keys.push_back(values[begin + i]);
+      }
+      leaf->tree_sz_ = count;
+      return leaf;
+    }
+
+    // 子节点数量取最少的那个，这样每个子树都尽可能满
+    size_t child_max_size = max_sizes[height - 2];
+    size_t child_count = (count + child_max_size + 1) / (child_max_size + 1);
+    if (child_count < 2) {
+      child_count = 2;
+    }
+    assert(child_count <= 2 * T);
+
+    size_t child_total_keys = count - (child_count - 1);
+    btree_node_pointer node = allocator_new_node(false);
+    size_t offset = begin;
+    for (size_t i = 0; i < child_count; ++i) {
+      size_t child_size = child_total_keys / child_count + (i < child_total_keys % child_count ? 1 : 0);
+      node->children.push_back(build_sorted_subtree(values, offset, child_size, max_sizes, height - 1));
+      offset += child_size;
+
+      if (i + 1 < child_count) {
+        node->keys.push_back(values[offset]);
+        ++offset;
+      }
+    }
+    node->tree_sz_ = count;
+    return node;
+  }
+
+  btree_node_pointer insert_not_full(btree_node_pointer btree_node, const value_pointer& key) {
     btree_node_pointer new_node = nullptr;
 
     if (btree_node->keys.size() == 2 * T - 1) {
@@ -523,26 +880,26 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
     if (new_node->leaf_) {
       if (new_node->keys.size() == 0) {
         // 为空直接插入
-        new_node->keys.push_back(allocator_key_ptr(key));
+        new_node->keys.push_back(key);
         new_node->tree_sz_++;
         return new_node;
       }
       new_node->keys.push_back(nullptr);
       size_t i = new_node->keys.size() - 1;
 
-      while (i > 0 && compare_fn_(key, *new_node->keys[i - 1])) {
+      while (i > 0 && compare_fn_(*key, *new_node->keys[i - 1])) {
         new_node->keys[i] = new_node->keys[i - 1];
         i--;
       }
-      new_node->keys[i] = allocator_key_ptr(key);
+      new_node->keys[i] = key;
       new_node->tree_sz_++;
       return new_node;
     }
 
-    size_t i = binary_search(new_node->keys, key);
+    size_t i = binary_search(new_node->keys, *key);
     if (new_node->children[i]->keys.size() == 2 * T - 1) {
       split_child(new_node, i);
-      if (compare_fn_(*new_node->keys[i], key)) {
+      if (compare_fn_(*new_node->keys[i], *key)) {
         i++;
       }
     }
@@ -770,24 +1127,68 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
     return end();
   }
 
-  size_t index_inner_(btree_node_pointer node, const value_type& key) {
-    if (!node) {
-      return 0;
-    }
+  // 返回key的排名(从1开始)，key不存在时返回排在它前面的元素个数
+  size_t index_inner_(btree_node_pointer root, const value_type& key) {
     size_t pos = 0;
-    size_t i = 0;
-    while (i < node->keys.size() && compare_fn_(*node->keys[i], key)) {
-      pos += (node->leaf_ ? 1 : node->children[i]->tree_sz_ + 1);
-      i++;
+    node_type* node = root.get();
+    while (nullptr != node) {
+      size_t i = binary_search(node->keys, key);
+      if (node->leaf_) {
+        pos += i;
+      } else {
+        for (size_t j = 0; j < i; ++j) {
+          pos += node->children[j]->tree_sz_ + 1;
+        }
+      }
+
+      if (i < node->keys.size() && !compare_fn_(key, *node->keys[i])) {
+        return pos + (node->leaf_ ? 1 : node->children[i]->tree_sz_ + 1);
+      }
+      if (node->leaf_) {
+        return pos;
+      }
+      node = node->children[i].get();
     }
-    if (i < node->keys.size() && !compare_fn_(key, *node->keys[i]) && !compare_fn_(*node->keys[i], key)) {
-      pos += (node->leaf_ ? 1 : node->children[i]->tree_sz_ + 1);
-      return pos;
+    return pos;
+  }
+
+  template <class TFn>
+  bool visit_range_inner(node_type* node, size_t& skip, size_t& remain, size_t& rank_no, TFn& fn) {
+    if (node->leaf_) {
+      if (skip >= node->keys.size()) {
+        skip -= node->keys.size();
+        return true;
+      }
+      for (size_t i = skip; i < node->keys.size() && remain > 0; ++i) {
+        --remain;
+        if (!fn(rank_no++, node->keys[i])) {
+          return false;
+        }
+      }
+      skip = 0;
+      return true;
     }
-    if (!node->leaf_) {
-      return pos + index_inner_(node->children[i], key);
+
+    for (size_t i = 0; i < node->children.size() && remain > 0; ++i) {
+      node_type* child = node->children[i].get();
+      if (skip >= child->tree_sz_) {
+        skip -= child->tree_sz_;
+      } else if (!visit_range_inner(child, skip, remain, rank_no, fn)) {
+        return false;
+      }
+
+      if (i < node->keys.size() && remain > 0) {
+        if (skip > 0) {
+          --skip;
+        } else {
+          --remain;
+          if (!fn(rank_no++, node->keys[i])) {
+            return false;
+          }
+        }
+      }
     }
-    return pos;
+    return true;
   }
 
   void get_postorder_traversal(btree_node_pointer node, std::vector<util::memory::strong_rc_ptr<value_type>>& result) {
@@ -824,7 +1225,7 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
     return contains(node->children[pos], target);
   }
 
-  size_t binary_search(const std::vector<util::memory::strong_rc_ptr<value_type>>& key, const value_type& target) {
+  size_t binary_search(const typename node_type::key_array& key, const value_type& target) {
     int32_t st = 0, ed = static_cast<int32_t>(key.size()) - 1, i = static_cast<int32_t>(key.size());
     while (st <= ed) {
       int32_t mid = (st + ed) >> 1;
@@ -838,27 +1239,21 @@ class persistent_btree : public util::memory::enable_shared_rc_from_this<persist
     return static_cast<size_t>(i);
   }
 
-  value_pointer allocator_key_ptr(value_type key) {
-    using alloc_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<value_type>;
-    return util::memory::allocate_strong_rc<value_type>(allocator_type(), key);
+  value_pointer allocator_key_ptr(const value_type& key) {
+    return util::memory::allocate_strong_rc<value_type>(allocator_, key);
   }
 
   btree_node_pointer allocator_new_node(bool val) {
-    using alloc_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<node_type>;
-    return util::memory::allocate_strong_rc<node_type>(allocator_type(), val, 2 * T - 1);
+    return util::memory::allocate_strong_rc<node_type>(allocator_, allocator_, val, 2 * T - 1);
   }
 
-  btree_node_pointer allocator_new_node(btree_node_pointer node) {
-    // if (node == nullptr) {
-    using alloc_type = typename std::allocator_traits<allocator_type>::template rebind_alloc<node_type>;
-    auto ptr = util::memory::allocate_strong_rc<node_type>(alloc_type(), node, 2 * T - 1);
-    return ptr;
-    // }
-    // return node;
+  btree_node_pointer allocator_new_node(const btree_node_pointer& node) {
+    return util::memory::allocate_strong_rc<node_type>(allocator_, allocator_, node, 2 * T - 1);
   }
 
   size_t T;  // B树的最小度数
   size_t max_root_version_size_;
   compare_fn_t compare_fn_;
+  allocator_type allocator_;  // 节点、key和节点数组都从这里分配
   btree_node_pointer root_;
 };
\ No newline at end of file
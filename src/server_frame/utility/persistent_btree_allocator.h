@@ -0,0 +1,290 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief persistent_btree的节点分配器
+ * @note 按16字节分级的定长块，从大块内存中切分，释放后挂回空闲链表。完全空闲的大块内存需要调用trim归还给系统
+ * @note 所有分配器副本(包括节点和key的控制块里保存的副本)都会持有引用，最后一个版本的树释放后整体回收所有大块内存
+ * @note 非线程安全，和strong_rc_ptr一样只能在单线程中使用
+ */
+class persistent_btree_slab {
+ public:
+  static constexpr const size_t kDefaultChunkSize = 64 * 1024;
+
+ private:
+  struct free_block {
+    free_block* next;
+  };
+
+  static constexpr const size_t kBlockAlignment = alignof(std::max_align_t);
+
+ public:
+  explicit persistent_btree_slab(size_t chunk_size = kDefaultChunkSize)
+      : ref_count_(0),
+        chunk_size_(align_size(chunk_size < kBlockAlignment * 64 ? kBlockAlignment * 64 : chunk_size)),
+        chunk_cursor_(nullptr),
+        chunk_remain_(0),
+        used_bytes_(0),
+        large_bytes_(0) {
+    // 单个块超过大块内存的1/16时直接走operator new，避免大块内存的尾部浪费太多
+    free_lists_.resize(chunk_size_ / 16 / kBlockAlignment, nullptr);
+  }
+
+  persistent_btree_slab(const persistent_btree_slab&) = delete;
+  persistent_btree_slab& operator=(const persistent_btree_slab&) = delete;
+
+  void* allocate(size_t bytes) {
+    size_t index = get_size_class(bytes);
+    if (index >= free_lists_.size()) {
+      large_bytes_ += bytes;
+      return ::operator new(bytes);
+    }
+
+    size_t block_size = (index + 1) * kBlockAlignment;
+    used_bytes_ += block_size;
+    free_block* block = free_lists_[index];
+    if (nullptr != block) {
+      free_lists_[index] = block->next;
+      return block;
+    }
+
+    if (chunk_remain_ < block_size) {
+      // 大块内存的尾部挂到对应的空闲链表，这样每个大块内存都是完整切分的，trim时才能判定是否完全空闲
+      if (chunk_remain_ > 0) {
+        free_block* tail = reinterpret_cast<free_block*>(chunk_cursor_);
+        tail->next = free_lists_[get_size_class(chunk_remain_)];
+        free_lists_[get_size_class(chunk_remain_)] = tail;
+      }
+      chunks_.emplace_back(new std::max_align_t[chunk_size_ / sizeof(std::max_align_t)]);
+      chunk_cursor_ = reinterpret_cast<unsigned char*>(chunks_.back().get());
+      chunk_remain_ = chunk_size_;
+    }
+
+    void* ret = chunk_cursor_;
+    chunk_cursor_ += block_size;
+    chunk_remain_ -= block_size;
+    return ret;
+  }
+
+  void deallocate(void* p, size_t bytes) noexcept {
+    if (nullptr == p) {
+      return;
+    }
+
+    size_t index = get_size_class(bytes);
+    if (index >= free_lists_.size()) {
+      large_bytes_ -= bytes;
+      ::operator delete(p);
+      return;
+    }
+
+    used_bytes_ -= (index + 1) * kBlockAlignment;
+    free_block* block = reinterpret_cast<free_block*>(p);
+    block->next = free_lists_[index];
+    free_lists_[index] = block;
+  }
+
+  /**
+   * @brief 把完全空闲的大块内存归还给系统
+   * @note 需要遍历所有的空闲块，只适合在释放镜像这类低频的时机调用
+   * @param keep_free_chunks 最多保留的完全空闲的大块内存数量，留给接下来的分配使用
+   * @return 归还的大块内存数量
+   */
+  size_t trim(size_t keep_free_chunks = 0) {
+    if (chunks_.empty()) {
+      return 0;
+    }
+
+    // 按地址排序，用来查找空闲块所在的大块内存
+    std::vector<std::pair<const unsigned char*, size_t>> chunk_address;
+    chunk_address.reserve(chunks_.size());
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      chunk_address.emplace_back(reinterpret_cast<const unsigned char*>(chunks_[i].get()), i);
+    }
+    std::sort(chunk_address.begin(), chunk_address.end());
+
+    // 正在切分的大块内存是最后一个，未切分的部分也是空闲的
+    std::vector<size_t> free_bytes;
+    free_bytes.resize(chunks_.size(), 0);
+    free_bytes.back() = chunk_remain_;
+    for (size_t i = 0; i < free_lists_.size(); ++i) {
+      for (free_block* block = free_lists_[i]; nullptr != block; block = block->next) {
+        free_bytes[find_chunk(chunk_address, block)] += (i + 1) * kBlockAlignment;
+      }
+    }
+
+    // 优先保留正在切分的大块内存
+    std::vector<bool> released;
+    released.resize(chunks_.size(), false);
+    size_t release_count = 0;
+    for (size_t i = chunks_.size(); i > 0; --i) {
+      if (free_bytes[i - 1] != chunk_size_) {
+        continue;
+      }
+      if (keep_free_chunks > 0) {
+        --keep_free_chunks;
+        continue;
+      }
+      released[i - 1] = true;
+      ++release_count;
+    }
+    if (0 == release_count) {
+      return 0;
+    }
+
+    // 从空闲链表中摘掉要归还的大块内存中的块，保持链表原来的顺序
+    for (auto& head : free_lists_) {
+      free_block** next = &head;
+      while (nullptr != *next) {
+        if (released[find_chunk(chunk_address, *next)]) {
+          *next = (*next)->next;
+        } else {
+          next = &(*next)->next;
+        }
+      }
+    }
+
+    if (released.back()) {
+      chunk_cursor_ = nullptr;
+      chunk_remain_ = 0;
+    }
+    size_t keep_index = 0;
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      if (!released[i]) {
+        chunks_[keep_index++] = std::move(chunks_[i]);
+      }
+    }
+    chunks_.resize(keep_index);
+    return release_count;
+  }
+
+  inline void add_ref() noexcept { ++ref_count_; }
+
+  inline void release() noexcept {
+    assert(ref_count_ > 0);
+    if (0 == --ref_count_) {
+      delete this;
+    }
+  }
+
+  /**
+   * @brief 获取正在使用的内存大小(包含按块大小对齐的部分)
+   */
+  inline size_t get_used_bytes() const noexcept { return used_bytes_ + large_bytes_; }
+
+  /**
+   * @brief 获取占用系统的内存大小
+   */
+  inline size_t get_reserved_bytes() const noexcept { return chunks_.size() * chunk_size_ + large_bytes_; }
+
+  inline size_t get_chunk_count() const noexcept { return chunks_.size(); }
+
+ private:
+  ~persistent_btree_slab() = default;
+
+  static inline size_t align_size(size_t bytes) noexcept {
+    return (bytes + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+  }
+
+  static inline size_t get_size_class(size_t bytes) noexcept {
+    return bytes <= kBlockAlignment ? 0 : (bytes - 1) / kBlockAlignment;
+  }
+
+  static inline size_t find_chunk(const std::vector<std::pair<const unsigned char*, size_t>>& chunk_address,
+                                  const void* p) noexcept {
+    const unsigned char* address = reinterpret_cast<const unsigned char*>(p);
+    auto iter = std::upper_bound(chunk_address.begin(), chunk_address.end(), address,
+                                 [](const unsigned char* l, const std::pair<const unsigned char*, size_t>& r) {
+                                   return std::less<const unsigned char*>()(l, r.first);
+                                 });
+    assert(iter != chunk_address.begin());
+    return (--iter)->second;
+  }
+
+ private:
+  size_t ref_count_;
+  size_t chunk_size_;
+  std::vector<free_block*> free_lists_;
+  std::vector<std::unique_ptr<std::max_align_t[]>> chunks_;
+  unsigned char* chunk_cursor_;
+  size_t chunk_remain_;
+  size_t used_bytes_;
+  size_t large_bytes_;
+};
+
+/**
+ * @brief 使用persistent_btree_slab的分配器，rebind后的分配器共享同一个slab
+ * @note 默认构造会创建新的slab，所以每棵树有独立的slab
+ */
+template <class T>
+class persistent_btree_slab_allocator {
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned type is not supported");
+
+  template <class U>
+  struct rebind {
+    using other = persistent_btree_slab_allocator<U>;
+  };
+
+  persistent_btree_slab_allocator() : slab_(new persistent_btree_slab()) { slab_->add_ref(); }
+
+  explicit persistent_btree_slab_allocator(size_t chunk_size) : slab_(new persistent_btree_slab(chunk_size)) {
+    slab_->add_ref();
+  }
+
+  persistent_btree_slab_allocator(const persistent_btree_slab_allocator& other) noexcept : slab_(other.slab_) {
+    slab_->add_ref();
+  }
+
+  template <class U>
+  persistent_btree_slab_allocator(const persistent_btree_slab_allocator<U>& other) noexcept  // NOLINT: implicit
+      : slab_(other.get_slab()) {
+    slab_->add_ref();
+  }
+
+  persistent_btree_slab_allocator& operator=(const persistent_btree_slab_allocator& other) noexcept {
+    if (slab_ != other.slab_) {
+      other.slab_->add_ref();
+      slab_->release();
+      slab_ = other.slab_;
+    }
+    return *this;
+  }
+
+  ~persistent_btree_slab_allocator() { slab_->release(); }
+
+  T* allocate(size_t n) { return static_cast<T*>(slab_->allocate(n * sizeof(T))); }
+
+  void deallocate(T* p, size_t n) noexcept { slab_->deallocate(p, n * sizeof(T)); }
+
+  inline persistent_btree_slab* get_slab() const noexcept { return slab_; }
+
+  template <class U>
+  friend bool operator==(const persistent_btree_slab_allocator& l, const persistent_btree_slab_allocator<U>& r) {
+    return l.get_slab() == r.get_slab();
+  }
+
+  template <class U>
+  friend bool operator!=(const persistent_btree_slab_allocator& l, const persistent_btree_slab_allocator<U>& r) {
+    return l.get_slab() != r.get_slab();
+  }
+
+ private:
+  persistent_btree_slab* slab_;
+};
@@ -5,6 +5,7 @@
 #include <protocol/pbdesc/svr.struct.pb.h>
 
 #include <config/compiler/protobuf_suffix.h>
+#include <config/logic_config.h>
 #include <utility/protobuf_mini_dumper.h>
 
 PROJECT_NAMESPACE_BEGIN
@@ -85,4 +86,26 @@ void dump_rank_basic_board_from_rank_data(const PROJECT_NAMESPACE_ID::rank_stora
   protobuf_copy_message(*out.mutable_user_key(), in.sort_data().key());
 }
 
+bool is_slave_data_readable(int64_t data_version, int64_t main_data_version, int64_t max_staleness_version,
+                            time_t main_data_version_refresh_time, time_t now, time_t max_stale_seconds) {
+  if (max_staleness_version <= 0) {
+    return true;
+  }
+
+  // 网络分区或者被主节点流控跳过时，从节点收不到新的版本号，只按版本号判定会一直认为数据是新的
+  if (max_stale_seconds > 0 && now - main_data_version_refresh_time > max_stale_seconds) {
+    return false;
+  }
+
+  if (main_data_version <= data_version) {
+    return true;
+  }
+  return main_data_version - data_version <= max_staleness_version;
+}
+
+uint32_t get_rank_query_max_count() {
+  uint32_t ret = logic_config::me()->get_server_cfg().rank().query_max_count();
+  return ret > 0 ? ret : RANK_GET_TOP_MAX_COUNT;
+}
+
 }  // namespace rank_util
\ No newline at end of file
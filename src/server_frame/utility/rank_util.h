@@ -3,10 +3,15 @@
 #include <config/compiler/protobuf_prefix.h>
 
 #include <protocol/config/com.struct.rank.config.pb.h>
+#include <protocol/pbdesc/com.struct.rank.pb.h>
 #include <protocol/pbdesc/svr.struct.pb.h>
+#include <protocol/pbdesc/svr.struct.rank.pb.h>
 
 #include <config/server_frame_build_feature.h>
 
+#include <cstdint>
+#include <ctime>
+
 PROJECT_NAMESPACE_BEGIN
 bool operator<(const DRankInstanceKey& l, const DRankInstanceKey& r) noexcept;
 bool operator==(const DRankInstanceKey& l, const DRankInstanceKey& r) noexcept;
@@ -29,4 +34,40 @@ const uint32_t RANK_GET_TOP_MAX_COUNT = 100; //单次查询的某top排行榜的
 SERVER_FRAME_API void dump_rank_basic_board_from_rank_data(const PROJECT_NAMESPACE_ID::rank_storage_data& in,
                                                            PROJECT_NAMESPACE_ID::DRankUserBoardData& out);
 
+/**
+ * @brief 获取单次榜单查询的最大区间，未配置时使用RANK_GET_TOP_MAX_COUNT
+ */
+SERVER_FRAME_API uint32_t get_rank_query_max_count();
+
+/**
+ * @brief 判定从节点的数据落后主节点的程度是否在允许范围内
+ * @param data_version 从节点的数据版本号
+ * @param main_data_version 从节点已知的主节点数据版本号
+ * @param max_staleness_version 允许落后的最大版本数，<=0表示不限制
+ * @param main_data_version_refresh_time 最后一次收到主节点数据版本号的时间
+ * @param now 当前时间
+ * @param max_stale_seconds 允许多久没有收到主节点的数据版本号，<=0表示不限制。只在限制落后版本数时生效
+ * @return 可读时返回true
+ */
+SERVER_FRAME_API bool is_slave_data_readable(int64_t data_version, int64_t main_data_version,
+                                             int64_t max_staleness_version, time_t main_data_version_refresh_time,
+                                             time_t now, time_t max_stale_seconds);
+
+/**
+ * @brief 计算查询玩家前后各count名时的起始排名和查询数量
+ * @param rank_no 玩家的排名
+ * @param count 前后各查询的数量，两侧总和超过max_count时截断
+ * @param max_count 单次查询的最大区间
+ * @param start_no 输出起始排名
+ * @param real_count 输出查询数量
+ */
+inline void get_rank_front_back_range(uint32_t rank_no, uint32_t count, uint32_t max_count, uint32_t& start_no,
+                                      uint32_t& real_count) {
+  if (2 * count > max_count) {
+    count = max_count / 2;
+  }
+  start_no = rank_no > count ? rank_no - count : 1;
+  real_count = start_no == 1 ? (count + rank_no) : (2 * count + 1);
+}
+
 }  // namespace rank_util
\ No newline at end of file
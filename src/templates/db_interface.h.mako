@@ -30,6 +30,7 @@ if index_type_enum is None:
 #include <vector>
 
 #include "rpc/db/db_utils.h"
+#include "rpc/db/hash_table.h"
 #include "rpc/rpc_shared_message.h"
 #include <dispatcher/db_msg_dispatcher.h>
 
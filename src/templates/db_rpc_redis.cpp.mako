@@ -2,6 +2,7 @@
 <%!
 import time
 import sys
+from google.protobuf import descriptor_pb2 as pb2
 %><%page args="message_name,extension,message,index_type_enum" />
 % for field in message.fields:
 %     if not field.is_db_vaild_type():
@@ -9,6 +10,143 @@ import sys
 <% return %>
 %     endif
 % endfor
+<%
+    has_kv_index = False
+    for index in extension.index:
+        if index.type != index_type_enum.values_by_name["EN_ATFRAMEWORK_DB_INDEX_TYPE_KL"].descriptor.number:
+            has_kv_index = True
+
+    # 生成不走反射的打包/解包代码，bool/float/double等不支持的类型仍然走反射流程
+    codec_fields = []
+    codec_fields_by_length = dict()
+    for field in sorted(message.fields, key=lambda x: x.descriptor.number):
+        field_name = field.get_name()
+        field_type = field.descriptor.type
+        codec_field = {
+            "name": field_name,
+            "cpp_name": field.get_cpp_name(),
+            "number": field.descriptor.number,
+            "name_length": len(field_name.encode("utf-8")),
+        }
+        # 和反射流程的ListFields一致，有presence的字段按has判断，其他字段按是否为默认值判断
+        if field.has_presence():
+            codec_field["presence"] = "store.has_{0}()".format(codec_field["cpp_name"])
+        elif field_type in (pb2.FieldDescriptorProto.TYPE_STRING, pb2.FieldDescriptorProto.TYPE_BYTES):
+            codec_field["presence"] = "!store.{0}().empty()".format(codec_field["cpp_name"])
+        else:
+            codec_field["presence"] = "0 != store.{0}()".format(codec_field["cpp_name"])
+
+        if field_type in (pb2.FieldDescriptorProto.TYPE_STRING, pb2.FieldDescriptorProto.TYPE_BYTES,
+                          pb2.FieldDescriptorProto.TYPE_MESSAGE):
+            codec_field["kind"] = "bytes"
+            codec_field["cpp_type"] = ""
+        elif field_type in (pb2.FieldDescriptorProto.TYPE_INT32, pb2.FieldDescriptorProto.TYPE_SINT32):
+            codec_field["kind"] = "integer"
+            codec_field["cpp_type"] = "int32_t"
+            codec_field["storage_type"] = "int64_t"
+        elif field_type in (pb2.FieldDescriptorProto.TYPE_INT64, pb2.FieldDescriptorProto.TYPE_SINT64):
+            codec_field["kind"] = "integer"
+            codec_field["cpp_type"] = "int64_t"
+            codec_field["storage_type"] = "int64_t"
+        elif field_type == pb2.FieldDescriptorProto.TYPE_UINT32:
+            codec_field["kind"] = "integer"
+            codec_field["cpp_type"] = "uint32_t"
+            codec_field["storage_type"] = "uint64_t"
+        elif field_type == pb2.FieldDescriptorProto.TYPE_UINT64:
+            codec_field["kind"] = "integer"
+            codec_field["cpp_type"] = "uint64_t"
+            codec_field["storage_type"] = "uint64_t"
+        else:
+            codec_field["kind"] = "reflection"
+        codec_fields.append(codec_field)
+        if codec_field["kind"] != "reflection":
+            codec_fields_by_length.setdefault(codec_field["name_length"], []).append(codec_field)
+%>
+% if has_kv_index:
+namespace detail {
+static int pack_${message_name}(const ::google::protobuf::Message &msg, rpc::db::redis_args &args, uint64_t *version,
+                                std::ostream *debug_message) {
+  if (msg.GetDescriptor() != PROJECT_NAMESPACE_ID::${message_name}::descriptor()) {
+    FWLOGERROR("pack message {} failed, expect {}", msg.GetDescriptor()->full_name(),
+               PROJECT_NAMESPACE_ID::${message_name}::descriptor()->full_name());
+    return PROJECT_NAMESPACE_ID::err::EN_SYS_PACK;
+  }
+  const PROJECT_NAMESPACE_ID::${message_name} &store = static_cast<const PROJECT_NAMESPACE_ID::${message_name} &>(msg);
+  rpc::db::redis_message_packer packer{args, debug_message};
+  if (nullptr != version && !packer.pack_version(*version)) {
+    FWLOGERROR("pack message {} failed, alloc version failed", msg.GetDescriptor()->full_name());
+    return PROJECT_NAMESPACE_ID::err::EN_SYS_MALLOC;
+  }
+%   for codec_field in codec_fields:
+%     if codec_field["kind"] == "reflection":
+  if (${codec_field["presence"]}) {
+    int res = rpc::db::pack_message(msg, args, {msg.GetDescriptor()->FindFieldByNumber(${codec_field["number"]})}, nullptr,
+                                    nullptr);
+    if (res < 0) {
+      return res;
+    }
+  }
+%     elif codec_field["kind"] == "integer":
+  if (${codec_field["presence"]} &&
+      !packer.pack_field(std::string_view{"${codec_field["name"]}", ${codec_field["name_length"]}},
+                         static_cast<${codec_field["cpp_type"]}>(store.${codec_field["cpp_name"]}()))) {
+    FWLOGERROR("pack message {} failed, alloc ${codec_field["name"]} failed", msg.GetDescriptor()->full_name());
+    return PROJECT_NAMESPACE_ID::err::EN_SYS_MALLOC;
+  }
+%     else:
+  if (${codec_field["presence"]} &&
+      !packer.pack_field(std::string_view{"${codec_field["name"]}", ${codec_field["name_length"]}},
+                         store.${codec_field["cpp_name"]}())) {
+    FWLOGERROR("pack message {} failed, alloc ${codec_field["name"]} failed", msg.GetDescriptor()->full_name());
+    return PROJECT_NAMESPACE_ID::err::EN_SYS_MALLOC;
+  }
+%     endif
+%   endfor
+  packer.finish();
+  return PROJECT_NAMESPACE_ID::err::EN_SUCCESS;
+}
+
+static bool unpack_field_${message_name}(::google::protobuf::Message &msg, std::string_view field_name,
+                                         const redisReply *value, bool &has_failed) {
+  if (msg.GetDescriptor() != PROJECT_NAMESPACE_ID::${message_name}::descriptor()) {
+    return false;
+  }
+  PROJECT_NAMESPACE_ID::${message_name} &table = static_cast<PROJECT_NAMESPACE_ID::${message_name} &>(msg);
+  switch (field_name.size()) {
+%   for name_length, length_fields in sorted(codec_fields_by_length.items()):
+    case ${name_length}: {
+%     for codec_field in length_fields:
+      if (field_name == std::string_view{"${codec_field["name"]}", ${name_length}}) {
+%       if codec_field["kind"] == "integer":
+        ${codec_field["storage_type"]} field_value = 0;
+        if (rpc::db::unpack_field(value, field_value)) {
+          table.set_${codec_field["cpp_name"]}(static_cast<${codec_field["cpp_type"]}>(field_value));
+        } else {
+          FWLOGERROR("unpack message {} field ${codec_field["name"]} failed, reply type={}",
+                     msg.GetDescriptor()->full_name(), value->type);
+          has_failed = true;
+        }
+%       else:
+        if (!rpc::db::unpack_field(value, *table.mutable_${codec_field["cpp_name"]}())) {
+          FWLOGERROR("unpack message {} field ${codec_field["name"]} failed, reply type={}",
+                     msg.GetDescriptor()->full_name(), value->type);
+          has_failed = true;
+        }
+%       endif
+        return true;
+      }
+%     endfor
+      break;
+    }
+%   endfor
+    default:
+      break;
+  }
+  return false;
+}
+}  // namespace detail
+
+% endif
 % for index in extension.index:
 <%
     key_fields = []
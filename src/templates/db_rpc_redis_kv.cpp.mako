@@ -10,7 +10,8 @@ static int32_t unpack_${message_name}(rpc::context *ctx, db_message_t &msg, cons
   shared_message<PROJECT_NAMESPACE_ID::${message_name}> table_pb{*ctx};
   uint64_t version = 0;
   bool record_existed = false;
-  int32_t ret = rpc::db::unpack_message(*table_pb.get(), reply, version, record_existed);
+  int32_t ret = rpc::db::unpack_message(*table_pb.get(), reply, version, record_existed,
+                                         ::rpc::db::detail::unpack_field_${message_name});
   msg.head_message.set_response_int(version);
   if (record_existed) {
     msg.body_message =
@@ -114,16 +115,55 @@ SERVER_FRAME_API result_type replace(rpc::context &ctx,
                                                                 gsl::string_view{db_key, keylen},
                                                                 shared_abstract_message<google::protobuf::Message>{std::move(store)},
 % if index.enable_cas:
-                                                                &version));
+                                                                &version,
 % else:
-                                                                nullptr));
+                                                                nullptr,
 % endif
+                                                                ::rpc::db::detail::pack_${message_name}));
   if (res < 0) {
     RPC_DB_RETURN_CODE(res);
   }
   RPC_DB_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SUCCESS);
 }
 
+% if index.enable_cas:
+SERVER_FRAME_API rpc::db::hash_table::key_value::cas_guard_t make_cas_guard(shared_message<PROJECT_NAMESPACE_ID::${message_name}> &&store,
+                                                                           uint64_t version) {
+  rpc::db::hash_table::key_value::cas_guard_t ret;
+  char db_key[256];
+  size_t keylen = sizeof(db_key) - 1;
+  auto result = atfw::util::string::format_to_n(db_key, keylen, "${prefix_fmt_key}", ${prefix_fmt_value_from_pb});
+  db_key[result.size] = '\0';
+  ret.key.assign(db_key, keylen);
+  ret.store = atfw::util::memory::make_strong_rc<shared_abstract_message<google::protobuf::Message>>(std::move(store));
+  ret.version = version;
+  ret.pack_fn = ::rpc::db::detail::pack_${message_name};
+  ret.cas_failed = false;
+  ret.saved = false;
+  return ret;
+}
+
+SERVER_FRAME_API result_type replace_with_cas_guard(rpc::context &ctx,
+                                                         shared_message<PROJECT_NAMESPACE_ID::${message_name}> &&store
+                                                         ,uint64_t &version
+                                                         ,rpc::db::hash_table::key_value::cas_guard_t &guard) {
+  char db_key[256];
+  size_t keylen = sizeof(db_key) - 1;
+  auto result = atfw::util::string::format_to_n(db_key, keylen, "${prefix_fmt_key}", ${prefix_fmt_value_from_pb});
+  db_key[result.size] = '\0';
+  auto res = RPC_AWAIT_CODE_RESULT(rpc::db::hash_table::key_value::set_with_cas_guard(ctx, db_msg_dispatcher::channel_t::CLUSTER_DEFAULT,
+                                                                guard,
+                                                                gsl::string_view{db_key, keylen},
+                                                                shared_abstract_message<google::protobuf::Message>{std::move(store)},
+                                                                version,
+                                                                ::rpc::db::detail::pack_${message_name}));
+  if (res < 0) {
+    RPC_DB_RETURN_CODE(res);
+  }
+  RPC_DB_RETURN_CODE(PROJECT_NAMESPACE_ID::err::EN_SUCCESS);
+}
+
+% endif
 % if len(atomic_inc_fields) > 0:
 %     for inc_field in atomic_inc_fields:
 SERVER_FRAME_API result_type inc_field_${inc_field["raw_name"]}(rpc::context &ctx
@@ -200,7 +240,8 @@ static int32_t unpack_${message_name}_${partly_field_name}(rpc::context *ctx, db
   shared_message<PROJECT_NAMESPACE_ID::${message_name}> table_pb{*ctx};
   uint64_t version = 0;
   bool record_existed = false;
-  int32_t ret = rpc::db::unpack_message_with_field(*table_pb.get(), reply, partly_get_field, ${partly_field_len}, version, record_existed);
+  int32_t ret = rpc::db::unpack_message_with_field(*table_pb.get(), reply, partly_get_field, ${partly_field_len}, version,
+                                                    record_existed, ::rpc::db::detail::unpack_field_${message_name});
   msg.head_message.set_response_int(version);
   if (record_existed) {
     msg.body_message =
@@ -36,6 +36,18 @@ EXPLICIT_NODISCARD_ATTR SERVER_FRAME_API result_type replace(rpc::context &ctx,
                                                          );
 % endif
 
+% if index.enable_cas:
+// 生成保存其他表时一起校验并续期的守护数据
+SERVER_FRAME_API rpc::db::hash_table::key_value::cas_guard_t make_cas_guard(shared_message<PROJECT_NAMESPACE_ID::${message_name}> &&store,
+                                                                           uint64_t version);
+
+// 校验并续期守护表，同时保存数据，只需要一次往返
+EXPLICIT_NODISCARD_ATTR SERVER_FRAME_API result_type replace_with_cas_guard(rpc::context &ctx,
+                                                         shared_message<PROJECT_NAMESPACE_ID::${message_name}> &&store
+                                                         ,uint64_t &version
+                                                         ,rpc::db::hash_table::key_value::cas_guard_t &guard);
+
+% endif
 % if len(atomic_inc_fields) > 0:
 %     for inc_field in atomic_inc_fields:
 EXPLICIT_NODISCARD_ATTR SERVER_FRAME_API result_type inc_field_${inc_field["raw_name"]}(rpc::context &ctx
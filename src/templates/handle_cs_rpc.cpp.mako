@@ -45,7 +45,7 @@ ${service_dllexport_decl} int register_handles_for_${service.get_name_lower_rule
   int ret = 0;
 % for rpc in rpcs.values():
 %   if not rpc.get_request_descriptor().full_name == "google.protobuf.Empty":
-  REG_TASK_RPC_HANDLE(cs_msg_dispatcher, ret, task_action_${rpc.get_name()}, ${service.get_cpp_class_name()}::descriptor(), "${rpc.get_full_name()}");
+  REG_TASK_RPC_HANDLE_WITH_ID(cs_msg_dispatcher, ret, task_action_${rpc.get_name()}, ${service.get_cpp_class_name()}::descriptor(), "${rpc.get_full_name()}", ${rpc.get_method_id_literal()});
 %   endif
 % endfor
   return ret;
@@ -73,7 +73,7 @@ inline static int __pack_body(const TBodyType &body, std::string *output, atfw::
 
 % if rpc_common_codes_enable_stream_header:
 inline static int __setup_rpc_stream_header(atframework::CSMsgHead &head, atfw::util::nostd::string_view rpc_full_name,
-                                            atfw::util::nostd::string_view type_full_name) {
+                                            uint32_t rpc_method_id, atfw::util::nostd::string_view type_full_name) {
   atframework::RpcStreamMeta* stream_meta = head.mutable_rpc_stream();
   if (nullptr == stream_meta) {
     return ${project_namespace}::EN_ERR_SYSTEM;
@@ -82,6 +82,7 @@ inline static int __setup_rpc_stream_header(atframework::CSMsgHead &head, atfw::
   stream_meta->set_caller("client_simulator");
   stream_meta->set_callee("${service.get_full_name()}");
   stream_meta->set_rpc_name(rpc_full_name.data(), rpc_full_name.size());
+  stream_meta->set_rpc_method_id(rpc_method_id);
   stream_meta->set_type_url(type_full_name.data(), type_full_name.size());
   stream_meta->mutable_caller_timestamp()->set_seconds(util::time::time_utility::get_sys_now());
   stream_meta->mutable_caller_timestamp()->set_nanos(util::time::time_utility::get_now_nanos());
@@ -93,7 +94,7 @@ inline static int __setup_rpc_stream_header(atframework::CSMsgHead &head, atfw::
 
 % if rpc_common_codes_enable_request_header:
 inline static int __setup_rpc_request_header(atframework::CSMsgHead &head, atfw::util::nostd::string_view rpc_full_name,
-                                            atfw::util::nostd::string_view type_full_name) {
+                                            uint32_t rpc_method_id, atfw::util::nostd::string_view type_full_name) {
   atframework::RpcRequestMeta* request_meta = head.mutable_rpc_request();
   if (nullptr == request_meta) {
     return ${project_namespace}::EN_ERR_SYSTEM;
@@ -102,6 +103,7 @@ inline static int __setup_rpc_request_header(atframework::CSMsgHead &head, atfw:
   request_meta->set_caller("client_simulator");
   request_meta->set_callee("${service.get_full_name()}");
   request_meta->set_rpc_name(rpc_full_name.data(), rpc_full_name.size());
+  request_meta->set_rpc_method_id(rpc_method_id);
   request_meta->set_type_url(type_full_name.data(), type_full_name.size());
 
   return ${project_namespace}::EN_SUCCESS;
@@ -127,10 +129,10 @@ ${rpc_dllexport_decl} int package_${rpc.get_name()}(${', '.join(rpc_params)}) {
   auto request_full_name = __to_string_view(${rpc.get_request().get_cpp_class_name()}::descriptor()->full_name());
 % if rpc.is_request_stream():
   int res = __setup_rpc_stream_header(
-    *__output.mutable_head(), "${rpc.get_full_name()}", request_full_name);
+    *__output.mutable_head(), "${rpc.get_full_name()}", ${rpc.get_method_id_literal()}, request_full_name);
 % else:
   int res = __setup_rpc_request_header(
-    *__output.mutable_head(), "${rpc.get_full_name()}", request_full_name);
+    *__output.mutable_head(), "${rpc.get_full_name()}", ${rpc.get_method_id_literal()}, request_full_name);
 % endif
 
   if (res < 0) {
@@ -179,7 +179,7 @@ inline static rpc::telemetry::tracer::span_ptr_type __setup_tracer(rpc::context
 % endif
 % if rpc_common_codes_enable_stream_header:
 inline static int __setup_rpc_stream_header(atframework::SSMsgHead &head, atfw::util::nostd::string_view rpc_full_name,
-                                            atfw::util::nostd::string_view type_full_name) {
+                                            uint32_t rpc_method_id, atfw::util::nostd::string_view type_full_name) {
   atframework::RpcStreamMeta* stream_meta = head.mutable_rpc_stream();
   if (nullptr == stream_meta) {
     return ${project_namespace}::err::EN_SYS_MALLOC;
@@ -188,6 +188,7 @@ inline static int __setup_rpc_stream_header(atframework::SSMsgHead &head, atfw::
   stream_meta->set_caller(static_cast<std::string>(logic_config::me()->get_local_server_name()));
   stream_meta->set_callee("${service.get_full_name()}");
   stream_meta->set_rpc_name(static_cast<std::string>(rpc_full_name));
+  stream_meta->set_rpc_method_id(rpc_method_id);
   stream_meta->set_type_url(type_full_name.data(), type_full_name.size());
   stream_meta->mutable_caller_timestamp()->set_seconds(util::time::time_utility::get_sys_now());
   stream_meta->mutable_caller_timestamp()->set_nanos(util::time::time_utility::get_now_nanos());
@@ -197,7 +198,7 @@ inline static int __setup_rpc_stream_header(atframework::SSMsgHead &head, atfw::
 % endif
 % if rpc_common_codes_enable_request_header:
 inline static int __setup_rpc_request_header(atframework::SSMsgHead &head, task_type_trait::id_type task_id,
-                                             atfw::util::nostd::string_view rpc_full_name,
+                                             atfw::util::nostd::string_view rpc_full_name, uint32_t rpc_method_id,
                                              atfw::util::nostd::string_view type_full_name) {
   head.set_source_task_id(task_id);
   atframework::RpcRequestMeta* request_meta = head.mutable_rpc_request();
@@ -208,6 +209,7 @@ inline static int __setup_rpc_request_header(atframework::SSMsgHead &head, task_
   request_meta->set_caller(static_cast<std::string>(logic_config::me()->get_local_server_name()));
   request_meta->set_callee("${service.get_full_name()}");
   request_meta->set_rpc_name(static_cast<std::string>(rpc_full_name));
+  request_meta->set_rpc_method_id(rpc_method_id);
   request_meta->set_type_url(type_full_name.data(), type_full_name.size());
   request_meta->mutable_caller_timestamp()->set_seconds(util::time::time_utility::get_sys_now());
   request_meta->mutable_caller_timestamp()->set_nanos(util::time::time_utility::get_now_nanos());
@@ -398,7 +400,7 @@ ${rpc_dllexport_decl} ${rpc_return_type} ${rpc.get_name()}(
     logic_config::me()->get_local_server_name());
 
   ${rpc_request_meta_pretty_prefix}res = __setup_rpc_stream_header(
-    ${rpc_request_meta_pretty_prefix}*req_msg.mutable_head(), "${rpc.get_full_name()}",
+    ${rpc_request_meta_pretty_prefix}*req_msg.mutable_head(), "${rpc.get_full_name()}", ${rpc.get_method_id_literal()},
     __to_string_view(${rpc_request_meta_pretty_prefix}${rpc.get_request().get_cpp_class_name()}::descriptor()->full_name())
   ${rpc_request_meta_pretty_prefix});
 
@@ -506,7 +508,7 @@ static ${rpc_return_type} __${rpc.get_name()}(
 %   endif
 %   if rpc_is_stream_mode or rpc_allow_no_wait:
   ${rpc_request_meta_pretty_prefix}res = __setup_rpc_stream_header(
-    ${rpc_request_meta_pretty_prefix}*req_msg.mutable_head(), "${rpc.get_full_name()}",
+    ${rpc_request_meta_pretty_prefix}*req_msg.mutable_head(), "${rpc.get_full_name()}", ${rpc.get_method_id_literal()},
     __to_string_view(${rpc_request_meta_pretty_prefix}${rpc.get_request().get_cpp_class_name()}::descriptor()->full_name())
   ${rpc_request_meta_pretty_prefix});
 %   endif
@@ -516,7 +518,7 @@ static ${rpc_return_type} __${rpc.get_name()}(
 %   if not rpc_is_stream_mode:
   ${rpc_request_meta_pretty_prefix}res = __setup_rpc_request_header(
     ${rpc_request_meta_pretty_prefix}*req_msg.mutable_head(), __ctx.get_task_context().task_id,
-    "${rpc.get_full_name()}",
+    "${rpc.get_full_name()}", ${rpc.get_method_id_literal()},
     __to_string_view(${rpc_request_meta_pretty_prefix}${rpc.get_request().get_cpp_class_name()}::descriptor()->full_name())
   ${rpc_request_meta_pretty_prefix});
 %   endif
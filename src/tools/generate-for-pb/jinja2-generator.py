@@ -475,6 +475,18 @@ class PbRpc(PbObjectBase):
             return False
         return raw_sym.server_streaming
 
+    def get_method_id(self):
+        # FNV-1a 32 of full name, must be the same as dispatcher_implement::make_rpc_method_id
+        ret = 0x811C9DC5
+        for c in self.get_full_name().encode("utf-8"):
+            ret = ((ret ^ c) * 0x01000193) & 0xFFFFFFFF
+        if ret == 0:
+            ret = 1
+        return ret
+
+    def get_method_id_literal(self):
+        return "0x{0:08x}U".format(self.get_method_id())
+
 
 class PbService(PbObjectBase):
 
@@ -100,6 +100,24 @@ pb_msg_go_fmt_map = {
     pb2.FieldDescriptorProto.TYPE_MESSAGE: "%s",
 }
 
+# protoc appends "_" to field names which are C++ keywords
+pb_cpp_keywords = frozenset([
+    "NULL", "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand",
+    "bitor", "bool", "break", "case", "catch", "char", "char8_t", "char16_t",
+    "char32_t", "class", "co_await", "co_return", "co_yield", "compl",
+    "concept", "const", "consteval", "constexpr", "constinit", "const_cast",
+    "continue", "decltype", "default", "delete", "do", "double",
+    "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+    "float", "for", "friend", "goto", "if", "inline", "int", "long",
+    "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr",
+    "operator", "or", "or_eq", "private", "protected", "public", "register",
+    "reinterpret_cast", "requires", "return", "short", "signed", "sizeof",
+    "static", "static_assert", "static_cast", "struct", "switch", "template",
+    "this", "thread_local", "throw", "true", "try", "typedef", "typeid",
+    "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "wchar_t", "while", "xor", "xor_eq"
+])
+
 def print_exception_with_traceback(e: Exception, fmt: str = None, *args):
     import traceback
     from print_color import print_style, cprintf_stderr
@@ -430,6 +448,25 @@ class PbField(PbObjectBase):
             return pb_msg_go_fmt_map[self.descriptor.type]
         return self.descriptor.type
 
+    def get_cpp_name(self):
+        # the same as FieldName() in protoc's cpp generator
+        global pb_cpp_keywords
+        ret = self.descriptor.name.lower()
+        if ret in pb_cpp_keywords:
+            ret = ret + "_"
+        return ret
+
+    def has_presence(self):
+        if self.descriptor.label == pb2.FieldDescriptorProto.LABEL_REPEATED:
+            return False
+        if hasattr(self.descriptor, "has_presence"):
+            return self.descriptor.has_presence
+        # proto3 optional fields are in a synthetic oneof
+        if (self.descriptor.type == pb2.FieldDescriptorProto.TYPE_MESSAGE
+                or self.descriptor.containing_oneof is not None):
+            return True
+        return getattr(self.file.descriptor, "syntax", "proto3") != "proto3"
+
 class PbOneof(PbObjectBase):
 
     def __init__(self, container_message, fields, descriptor, refer_database):
@@ -573,6 +610,18 @@ class PbRpc(PbObjectBase):
             return False
         return raw_sym.server_streaming
 
+    def get_method_id(self):
+        # FNV-1a 32 of full name, must be the same as dispatcher_implement::make_rpc_method_id
+        ret = 0x811C9DC5
+        for c in self.get_full_name().encode("utf-8"):
+            ret = ((ret ^ c) * 0x01000193) & 0xFFFFFFFF
+        if ret == 0:
+            ret = 1
+        return ret
+
+    def get_method_id_literal(self):
+        return "0x{0:08x}U".format(self.get_method_id())
+
 
 class PbService(PbObjectBase):
 